@@ -405,8 +405,17 @@ class BaseOnieUpgrade(BaseUpgrade):
         onl.grub.onie_fwpkg("add %s" % pkg)
         onl.grub.onie_fwpkg("show")
 
+    def clear_sysinfo_cache(self):
+        # The cached platform information (CPLD and firmware versions)
+        # is stale once the update has been applied.
+        onlpdump = self.platform.basedir_onl("bin", "onlpdump")
+        if os.path.exists(onlpdump):
+            if subprocess.call([onlpdump, "sysinfo", "clear"]) != 0:
+                self.logger.warn("Could not clear the cached system information.")
+
     def initiate_onie_update(self):
         self.logger.info("Initiating %s Update." % self.Name)
+        self.clear_sysinfo_cache()
 
         if self.arch == 'ppc':
             # Initiate update
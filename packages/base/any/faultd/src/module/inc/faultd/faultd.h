@@ -142,6 +142,29 @@ int faultd_server_process(faultd_server_t* fso, faultd_sid_t sid,
                           int count, aim_pvs_t* pvs, int decode);
 
 
+/**
+ * Shared memory ring counters.
+ */
+typedef struct faultd_ring_stats_s {
+    /** Reports delivered through the ring. */
+    uint32_t reports;
+    /** Reports which did not fit in the ring. */
+    uint32_t overflows;
+    /** Reservations skipped because their client died or stalled. */
+    uint32_t abandoned;
+} faultd_ring_stats_t;
+
+/**
+ * @brief Get the shared memory ring counters for a service.
+ * @param fso The faultd server object.
+ * @param sid The service id.
+ * @param stats Receives the counters.
+ * @returns -1 if the service has no ring.
+ */
+int faultd_server_ring_stats(faultd_server_t* fso, faultd_sid_t sid,
+                             faultd_ring_stats_t* stats);
+
+
 /**************************************************************************//**
  *
  * faultd Clients
@@ -165,6 +188,9 @@ int faultd_client_create(faultd_client_t** fco, const char* pipename);
  * @note If backtrace_symbols is not NULL, the
  * backtrace_symbols_fd() will be called on the backtrace 
  * and included in the report. 
+ * @note The report is written to the server's shared memory ring
+ * if it is available and not full, otherwise to the named pipe. 
+ * This function is async-signal-safe. 
  */
 int faultd_client_write(faultd_client_t* fco, faultd_info_t* info); 
 
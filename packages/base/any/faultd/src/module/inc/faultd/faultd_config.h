@@ -188,6 +188,46 @@
 #define FAULTD_CONFIG_MAIN_PIPENAME "/var/run/faultd.fifo"
 #endif
 
+/**
+ * FAULTD_CONFIG_INCLUDE_RING
+ *
+ * Include the shared memory ring transport. */
+
+
+#ifndef FAULTD_CONFIG_INCLUDE_RING
+#define FAULTD_CONFIG_INCLUDE_RING 1
+#endif
+
+/**
+ * FAULTD_CONFIG_RING_ENTRIES
+ *
+ * Number of fault reports in each shared memory ring. Must be a power of 2. */
+
+
+#ifndef FAULTD_CONFIG_RING_ENTRIES
+#define FAULTD_CONFIG_RING_ENTRIES 64
+#endif
+
+/**
+ * FAULTD_CONFIG_RING_BATCH
+ *
+ * Maximum number of fault reports the server drains from the rings at once. */
+
+
+#ifndef FAULTD_CONFIG_RING_BATCH
+#define FAULTD_CONFIG_RING_BATCH 16
+#endif
+
+/**
+ * FAULTD_CONFIG_RING_POLL_MS
+ *
+ * Interval (ms) at which the server polls the rings for reports which were not signaled. */
+
+
+#ifndef FAULTD_CONFIG_RING_POLL_MS
+#define FAULTD_CONFIG_RING_POLL_MS 1000
+#endif
+
 
 
 /**
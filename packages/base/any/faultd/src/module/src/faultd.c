@@ -28,6 +28,7 @@
 #include <errno.h>
 
 #include <execinfo.h>
+#include "faultd_int.h"
 #include "faultd_log.h"
 
 
@@ -64,6 +65,17 @@ typedef struct faultd_service_s {
      */
     int writefd;         
 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+    /** The shared memory ring, if available. */
+    faultd_ring_t* ring;
+
+    /** The doorbell eventfd. Clients ring it after writing to the ring. */
+    int bellfd;
+
+    /** The socket which hands the doorbell to clients. Server only. */
+    int listenfd;
+#endif
+
 } faultd_service_t; 
 
 
@@ -76,6 +88,14 @@ struct faultd_server_s {
     faultd_service_t services[FAULTD_CONFIG_SERVICE_PIPES_MAX]; 
     /** The last service from which we read a message */
     int sid_last;
+
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+    /** Reports drained from the rings which have not been returned yet. */
+    faultd_info_t batch[FAULTD_CONFIG_RING_BATCH];
+    int batch_sid[FAULTD_CONFIG_RING_BATCH];
+    int batch_count;
+    int batch_next;
+#endif
 }; /* faultd_server_t */
 
 
@@ -102,6 +122,13 @@ faultd_server_destroy(faultd_server_t* fso)
         for(i = 0; i < AIM_ARRAYSIZE(fso->services); i++) { 
             faultd_server_remove(fso, NULL, i); 
         }
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+        for(i = fso->batch_next; i < fso->batch_count; i++) { 
+            if(fso->batch[i].backtrace_symbols) { 
+                AIM_FREE(fso->batch[i].backtrace_symbols); 
+            }
+        }
+#endif
         AIM_FREE(fso); 
     }
 }
@@ -119,10 +146,43 @@ faultd_service_destroy__(faultd_service_t* sp)
         if(sp->writefd) { 
             close(sp->writefd); 
         }
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+        faultd_ring_close(sp->ring); 
+        if(sp->bellfd) { 
+            close(sp->bellfd); 
+        }
+        if(sp->listenfd) { 
+            close(sp->listenfd); 
+        }
+#endif
         AIM_MEMSET(sp, 0, sizeof(*sp)); 
     }
 }
 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+/**
+ * Attach the shared memory ring and doorbell for a service. 
+ * The named pipe still works if either is unavailable. 
+ */
+static void
+faultd_service_ring_init__(faultd_service_t* sp, int server)
+{
+    int fd; 
+
+    sp->ring = faultd_ring_open(sp->pipename, server); 
+    if(sp->ring == NULL) { 
+        return; 
+    }
+    if(server) { 
+        fd = faultd_ring_doorbell_create(sp->pipename, &sp->listenfd); 
+    }
+    else {
+        fd = faultd_ring_doorbell_connect(sp->pipename); 
+    }
+    sp->bellfd = (fd > 0) ? fd : 0; 
+}
+#endif
+
 int 
 faultd_server_add(faultd_server_t* fso, char* pipename)
 {
@@ -189,6 +249,10 @@ faultd_server_add(faultd_server_t* fso, char* pipename)
                 goto server_add_failed;
             }
 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+            faultd_service_ring_init__(sp, 1); 
+#endif
+
             /* Good to go. 'i' is the service id.  */
             return i;
         }
@@ -235,6 +299,23 @@ faultd_server_process(faultd_server_t* fdo, faultd_sid_t sid,
     return 0; 
 }
 
+int
+faultd_server_ring_stats(faultd_server_t* fso, faultd_sid_t sid, 
+                         faultd_ring_stats_t* stats)
+{
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+    if(fso == NULL || stats == NULL || 
+       sid < 0 || sid >= AIM_ARRAYSIZE(fso->services) || 
+       fso->services[sid].ring == NULL) { 
+        return -1; 
+    }
+    faultd_ring_stats_get(fso->services[sid].ring, stats); 
+    return 0; 
+#else
+    return -1; 
+#endif
+}
+
 struct faultd_client_s { 
     faultd_service_t s;
 }; /* faultd_client_t */
@@ -260,10 +341,23 @@ faultd_client_create(faultd_client_t** rfco, const char* pipename)
      * Open the fifo. 
      */
     rv = open(fco->s.pipename, O_WRONLY | O_NONBLOCK); 
+    if(rv >= 0) { 
+        fco->s.pipefd = rv; 
+    }
+
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+    /**
+     * The ring is preferred. The fifo is used when the ring is full. 
+     */
+    faultd_service_ring_init__(&fco->s, 0); 
+    if(rv < 0 && fco->s.ring == NULL) { 
+        goto client_create_failed; 
+    }
+#else
     if(rv < 0) { 
         goto client_create_failed; 
     }
-    fco->s.pipefd = rv; 
+#endif
 
     *rfco = fco; 
     return 0; 
@@ -380,11 +474,40 @@ write_size__(int fd, char* src, int size)
     return size; 
 }
 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+/**
+ * Add a service's doorbell descriptors to the select set. 
+ * Returns whether the service has a ring, which must also be
+ * polled periodically for reports whose doorbell was missed. 
+ */
+static int
+faultd_ring_fd_set__(faultd_service_t* sp, fd_set* rfds, int* maxfd)
+{
+    int fds[2] = { sp->bellfd, sp->listenfd }; 
+    int i; 
+
+    if(sp->ring == NULL) { 
+        return 0; 
+    }
+    for(i = 0; i < AIM_ARRAYSIZE(fds); i++) { 
+        if(fds[i]) { 
+            FD_SET(fds[i], rfds); 
+            if(fds[i] > *maxfd) { 
+                *maxfd = fds[i]; 
+            }
+        }
+    }
+    return 1; 
+}
+#endif
+
 int 
 faultd_wait_services__(faultd_server_t* fso, int sid, fd_set* rfds)
 {
     int rv; 
     int maxfd; 
+    int poll = 0; 
+    struct timeval tv; 
 
     FD_ZERO(rfds); 
 
@@ -402,6 +525,9 @@ faultd_wait_services__(faultd_server_t* fso, int sid, fd_set* rfds)
                 if(fso->services[i].pipefd > maxfd) { 
                     maxfd = fso->services[i].pipefd; 
                 }
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+                poll |= faultd_ring_fd_set__(fso->services+i, rfds, &maxfd); 
+#endif
             }
         }
     }
@@ -414,18 +540,99 @@ faultd_wait_services__(faultd_server_t* fso, int sid, fd_set* rfds)
         else {
             FD_SET(fso->services[sid].pipefd, rfds); 
             maxfd = fso->services[sid].pipefd; 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+            poll |= faultd_ring_fd_set__(fso->services+sid, rfds, &maxfd); 
+#endif
         }
     }
 
     /* Wait on configured services */
     do { 
-        rv = select(maxfd+1, rfds, NULL, NULL, NULL); 
+        tv.tv_sec = FAULTD_CONFIG_RING_POLL_MS / 1000; 
+        tv.tv_usec = (FAULTD_CONFIG_RING_POLL_MS % 1000) * 1000; 
+        rv = select(maxfd+1, rfds, NULL, NULL, poll ? &tv : NULL); 
     } while(rv == -1 && errno == EINTR); 
 
     return rv; 
 }
 
 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+/**
+ * Drain up to FAULTD_CONFIG_RING_BATCH reports from the rings. 
+ */
+static int
+faultd_ring_drain__(faultd_server_t* fso, int sid)
+{
+    int i; 
+    int count; 
+
+    fso->batch_count = fso->batch_next = 0; 
+    for(i = fso->sid_last+1, count = 0; 
+        count < AIM_ARRAYSIZE(fso->services); 
+        i++, count++) { 
+        int s = i % AIM_ARRAYSIZE(fso->services); 
+        faultd_service_t* sp = fso->services + s; 
+
+        if(sp->ring == NULL || (sid != -1 && sid != s)) { 
+            continue; 
+        }
+        while(fso->batch_count < FAULTD_CONFIG_RING_BATCH && 
+              faultd_ring_read(sp->ring, fso->batch + fso->batch_count) > 0) { 
+            fso->batch_sid[fso->batch_count++] = s; 
+        }
+    }
+    return fso->batch_count; 
+}
+
+/**
+ * Return the next report from the rings, or -1 if there are none. 
+ */
+static int
+faultd_ring_next__(faultd_server_t* fso, faultd_info_t* info, int sid)
+{
+    int s; 
+
+    if(fso->batch_next >= fso->batch_count && 
+       faultd_ring_drain__(fso, sid) == 0) { 
+        return -1; 
+    }
+
+    s = fso->batch_sid[fso->batch_next]; 
+    *info = fso->batch[fso->batch_next++]; 
+    info->pipename = fso->services[s].pipename; 
+    fso->sid_last = s; 
+    return s; 
+}
+
+/**
+ * Service the doorbells. Returns whether any pipe is readable. 
+ */
+static int
+faultd_ring_doorbells__(faultd_server_t* fso, fd_set* rfds)
+{
+    int i; 
+    int pipes = 0; 
+
+    for(i = 0; i < AIM_ARRAYSIZE(fso->services); i++) { 
+        faultd_service_t* sp = fso->services + i; 
+        if(sp->pipefd == 0) { 
+            continue; 
+        }
+        if(FD_ISSET(sp->pipefd, rfds)) { 
+            pipes = 1; 
+        }
+        if(sp->bellfd && FD_ISSET(sp->bellfd, rfds)) { 
+            faultd_ring_doorbell_clear(sp->bellfd); 
+        }
+        if(sp->listenfd && FD_ISSET(sp->listenfd, rfds)) { 
+            faultd_ring_doorbell_accept(sp->listenfd, sp->bellfd); 
+        }
+    }
+    return pipes; 
+}
+#endif
+
 int 
 faultd_server_read(faultd_server_t* fso, faultd_info_t* info, int sid)
 {
@@ -434,12 +641,32 @@ faultd_server_read(faultd_server_t* fso, faultd_info_t* info, int sid)
     fd_set rfds;
     int count; 
 
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+    for(;;) { 
+        /* Reports in the rings are returned first. */
+        if((rv = faultd_ring_next__(fso, info, sid)) >= 0) { 
+            return rv; 
+        }
+
+        rv = faultd_wait_services__(fso, sid, &rfds); 
+        if(rv < 0) { 
+            /* Error on select or sid */
+            return rv; 
+        }
+
+        /* Doorbells and timeouts send us back to the rings. */
+        if(faultd_ring_doorbells__(fso, &rfds)) { 
+            break; 
+        }
+    }
+#else
     rv = faultd_wait_services__(fso, sid, &rfds); 
     
     if(rv < 0) { 
         /* Error on select or sid */
         return rv; 
     }
+#endif
 
     /** 
      * Read message on a ready descriptor.
@@ -489,7 +716,23 @@ faultd_server_read(faultd_server_t* fso, faultd_info_t* info, int sid)
 int
 faultd_client_write(faultd_client_t* fco, faultd_info_t* info)
 {
-    int rv = write_size__(fco->s.pipefd, (char*)info, sizeof(*info)); 
+    int rv; 
+
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+    if(fco->s.ring && faultd_ring_write(fco->s.ring, info) == 0) { 
+        if(fco->s.bellfd) { 
+            faultd_ring_doorbell_ring(fco->s.bellfd); 
+        }
+        return 0; 
+    }
+    /* The ring is full or not available. Use the fifo. */
+#endif
+
+    if(fco->s.pipefd == 0) { 
+        return -1; 
+    }
+
+    rv = write_size__(fco->s.pipefd, (char*)info, sizeof(*info)); 
     
     if(rv < 0) { 
         return rv; 
@@ -99,6 +99,26 @@ faultd_config_settings_t faultd_config_settings[] =
     { __faultd_config_STRINGIFY_NAME(FAULTD_CONFIG_MAIN_PIPENAME), __faultd_config_STRINGIFY_VALUE(FAULTD_CONFIG_MAIN_PIPENAME) },
 #else
 { FAULTD_CONFIG_MAIN_PIPENAME(__faultd_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef FAULTD_CONFIG_INCLUDE_RING
+    { __faultd_config_STRINGIFY_NAME(FAULTD_CONFIG_INCLUDE_RING), __faultd_config_STRINGIFY_VALUE(FAULTD_CONFIG_INCLUDE_RING) },
+#else
+{ FAULTD_CONFIG_INCLUDE_RING(__faultd_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef FAULTD_CONFIG_RING_ENTRIES
+    { __faultd_config_STRINGIFY_NAME(FAULTD_CONFIG_RING_ENTRIES), __faultd_config_STRINGIFY_VALUE(FAULTD_CONFIG_RING_ENTRIES) },
+#else
+{ FAULTD_CONFIG_RING_ENTRIES(__faultd_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef FAULTD_CONFIG_RING_BATCH
+    { __faultd_config_STRINGIFY_NAME(FAULTD_CONFIG_RING_BATCH), __faultd_config_STRINGIFY_VALUE(FAULTD_CONFIG_RING_BATCH) },
+#else
+{ FAULTD_CONFIG_RING_BATCH(__faultd_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef FAULTD_CONFIG_RING_POLL_MS
+    { __faultd_config_STRINGIFY_NAME(FAULTD_CONFIG_RING_POLL_MS), __faultd_config_STRINGIFY_VALUE(FAULTD_CONFIG_RING_POLL_MS) },
+#else
+{ FAULTD_CONFIG_RING_POLL_MS(__faultd_config_STRINGIFY_NAME), "__undefined__" },
 #endif
     { NULL, NULL }
 };
@@ -25,6 +25,88 @@
 #define __FAULTD_INT_H__
 
 #include <faultd/faultd_config.h>
+#include <faultd/faultd.h>
+
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+
+/**
+ * Shared memory ring transport.
+ *
+ * Each service pipe has a companion ring file (<pipename>.ring) which
+ * clients map and write fault reports into directly, and a domain
+ * socket (<pipename>.bell) from which clients receive the server's
+ * eventfd doorbell.
+ *
+ * Any number of clients reserve slots with a compare-and-swap on the
+ * ring head and commit them by advancing the slot sequence number.
+ * Writing a report is lock-free and async-signal-safe. When the ring
+ * is full the overflow counter is incremented and the client falls
+ * back to the named pipe.
+ */
+typedef struct faultd_ring_s faultd_ring_t;
+
+/**
+ * @brief Map the ring for the given pipe.
+ * @param pipename The service pipe name.
+ * @param server Create and (re)initialize the ring if necessary.
+ */
+faultd_ring_t* faultd_ring_open(const char* pipename, int server);
+
+/**
+ * @brief Unmap a ring.
+ */
+void faultd_ring_close(faultd_ring_t* ring);
+
+/**
+ * @brief Write a fault report into the ring.
+ * @note Async-signal-safe.
+ * @returns 0 if the report was committed, -1 otherwise.
+ */
+int faultd_ring_write(faultd_ring_t* ring, faultd_info_t* info);
+
+/**
+ * @brief Read the next committed fault report.
+ * @returns 1 if a report was read, 0 if there are none.
+ * @note info->backtrace_symbols is allocated if the report has symbols.
+ */
+int faultd_ring_read(faultd_ring_t* ring, faultd_info_t* info);
+
+/**
+ * @brief Get the ring counters.
+ */
+void faultd_ring_stats_get(faultd_ring_t* ring, faultd_ring_stats_t* stats);
+
+/**
+ * @brief Create the server doorbell.
+ * @param pipename The service pipe name.
+ * @param listenfd Receives the doorbell socket.
+ * @returns The doorbell eventfd, or -1.
+ */
+int faultd_ring_doorbell_create(const char* pipename, int* listenfd);
+
+/**
+ * @brief Hand the doorbell to waiting clients.
+ */
+void faultd_ring_doorbell_accept(int listenfd, int bellfd);
+
+/**
+ * @brief Get the server's doorbell.
+ * @returns The doorbell eventfd, or -1.
+ */
+int faultd_ring_doorbell_connect(const char* pipename);
+
+/**
+ * @brief Ring the doorbell.
+ * @note Async-signal-safe.
+ */
+void faultd_ring_doorbell_ring(int bellfd);
+
+/**
+ * @brief Clear the doorbell.
+ */
+void faultd_ring_doorbell_clear(int bellfd);
+
+#endif /* FAULTD_CONFIG_INCLUDE_RING */
 
 
 #endif /* __FAULTD_INT_H__ */
@@ -0,0 +1,533 @@
+/**************************************************************************//**
+ * <bsn.cl fy=2013 v=onl>
+ *
+ *        Copyright 2013, 2014 BigSwitch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ *
+ * faultd Shared Memory Ring Transport
+ *
+ *****************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pipe2(), accept4() */
+#endif
+#include <faultd/faultd_config.h>
+
+#if FAULTD_CONFIG_INCLUDE_RING == 1
+
+#include "faultd_int.h"
+#include "faultd_log.h"
+
+#include <AIM/aim.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#define FAULTD_RING_MAGIC   0x46445247
+#define FAULTD_RING_VERSION 1
+
+#define FAULTD_RING_MASK (FAULTD_CONFIG_RING_ENTRIES - 1)
+
+#if (FAULTD_CONFIG_RING_ENTRIES & FAULTD_RING_MASK) != 0
+#error FAULTD_CONFIG_RING_ENTRIES must be a power of 2.
+#endif
+
+#if FAULTD_CONFIG_RING_ENTRIES < 4
+#error FAULTD_CONFIG_RING_ENTRIES must be at least 4.
+#endif
+
+/**
+ * A slot is free for position 'pos' when seq == pos, holds a committed
+ * report when seq == pos + 1 and is released for the next lap by
+ * setting seq = pos + FAULTD_CONFIG_RING_ENTRIES.
+ *
+ * A slot whose live writer has stalled is poisoned instead by setting
+ * seq = pos + FAULTD_CONFIG_RING_ENTRIES - 1. Clients see it as unread
+ * for the next lap, and the writer's commit fails. The slot stays
+ * poisoned until the writer releases it after its failed commit, or
+ * the server finds that the writer no longer exists. Until then the
+ * writer may still be copying into it.
+ */
+typedef struct faultd_ring_slot_s {
+    volatile uint32_t seq;
+    /** The writer, for detecting abandoned reservations. */
+    volatile pid_t pid;
+    /** Size of the backtrace symbols, including the terminator. */
+    uint32_t symbols_size;
+    faultd_info_t info;
+    char symbols[FAULTD_CONFIG_BACKTRACE_SYMBOLS_SIZE];
+} faultd_ring_slot_t;
+
+/**
+ * A reservation whose writer is still alive but has not committed
+ * after this long (ms) is skipped and its slot poisoned until the
+ * writer releases it or exits.
+ */
+#define FAULTD_RING_STALL_MS 5000
+
+struct faultd_ring_s {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entries;
+    uint32_t slot_size;
+
+    /** Next reservation. Written by clients. */
+    volatile uint32_t head __attribute__((aligned(64)));
+
+    /** Next report to read. Written by the server only. */
+    volatile uint32_t tail __attribute__((aligned(64)));
+    uint32_t stalled_pos;
+    uint64_t stalled_since;     /* ms, 0 if not stalled */
+
+    /** Counters, see faultd_ring_stats_t */
+    volatile uint32_t reports __attribute__((aligned(64)));
+    volatile uint32_t overflows;
+    volatile uint32_t abandoned;
+
+    faultd_ring_slot_t slots[FAULTD_CONFIG_RING_ENTRIES] __attribute__((aligned(64)));
+};
+
+static char*
+faultd_ring_path__(const char* pipename, const char* suffix)
+{
+    return aim_fstrdup("%s.%s", pipename, suffix);
+}
+
+faultd_ring_t*
+faultd_ring_open(const char* pipename, int server)
+{
+    int fd;
+    faultd_ring_t* ring;
+    char* path = faultd_ring_path__(pipename, "ring");
+
+    fd = open(path, server ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDWR | O_CLOEXEC), 0644);
+    if(fd < 0) {
+        if(server) {
+            AIM_LOG_ERROR("open(%s): %s", path, strerror(errno));
+        }
+        aim_free(path);
+        return NULL;
+    }
+
+    if(server && ftruncate(fd, sizeof(*ring)) < 0) {
+        AIM_LOG_ERROR("ftruncate(%s): %s", path, strerror(errno));
+        close(fd);
+        aim_free(path);
+        return NULL;
+    }
+
+    ring = mmap(NULL, sizeof(*ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(ring == MAP_FAILED) {
+        AIM_LOG_ERROR("mmap(%s): %s", path, strerror(errno));
+        aim_free(path);
+        return NULL;
+    }
+    aim_free(path);
+
+    if(ring->magic == FAULTD_RING_MAGIC &&
+       ring->version == FAULTD_RING_VERSION &&
+       ring->entries == FAULTD_CONFIG_RING_ENTRIES &&
+       ring->slot_size == sizeof(faultd_ring_slot_t)) {
+        /*
+         * Compatible ring. The server keeps any reports written
+         * while it was not running.
+         */
+        return ring;
+    }
+
+    if(server) {
+        uint32_t i;
+        ring->magic = 0;
+        __sync_synchronize();
+        FAULTD_MEMSET((char*)ring + sizeof(ring->magic), 0,
+                      sizeof(*ring) - sizeof(ring->magic));
+        for(i = 0; i < FAULTD_CONFIG_RING_ENTRIES; i++) {
+            ring->slots[i].seq = i;
+        }
+        ring->version = FAULTD_RING_VERSION;
+        ring->entries = FAULTD_CONFIG_RING_ENTRIES;
+        ring->slot_size = sizeof(faultd_ring_slot_t);
+        __sync_synchronize();
+        ring->magic = FAULTD_RING_MAGIC;
+        return ring;
+    }
+
+    munmap(ring, sizeof(*ring));
+    return NULL;
+}
+
+void
+faultd_ring_close(faultd_ring_t* ring)
+{
+    if(ring) {
+        munmap(ring, sizeof(*ring));
+    }
+}
+
+/**
+ * Collect the backtrace symbols into the slot.
+ * backtrace_symbols_fd() is the only async-signal-safe interface,
+ * so the symbols are passed through a pipe.
+ */
+static uint32_t
+faultd_ring_symbols__(faultd_info_t* info, char* dst, int size)
+{
+    int fds[2];
+    int count = 0;
+    int rv;
+
+    if(pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        return 0;
+    }
+    backtrace_symbols_fd(info->backtrace, info->backtrace_size, fds[1]);
+    close(fds[1]);
+
+    while(count < size - 1) {
+        rv = read(fds[0], dst + count, size - 1 - count);
+        if(rv < 0 && errno == EINTR) {
+            continue;
+        }
+        if(rv <= 0) {
+            break;
+        }
+        count += rv;
+    }
+    close(fds[0]);
+    dst[count] = 0;
+    return count + 1;
+}
+
+int
+faultd_ring_write(faultd_ring_t* ring, faultd_info_t* info)
+{
+    uint32_t pos;
+    faultd_ring_slot_t* slot;
+
+    if(ring == NULL || ring->magic != FAULTD_RING_MAGIC) {
+        return -1;
+    }
+
+    /* Reserve */
+    for(;;) {
+        int32_t diff;
+        pos = ring->head;
+        slot = ring->slots + (pos & FAULTD_RING_MASK);
+        diff = (int32_t)(slot->seq - pos);
+        if(diff == 0) {
+            if(__sync_bool_compare_and_swap(&ring->head, pos, pos + 1)) {
+                break;
+            }
+        }
+        else if(diff < 0) {
+            /* The server has not read this slot's previous report. */
+            __sync_fetch_and_add(&ring->overflows, 1);
+            return -1;
+        }
+        /* Otherwise another client reserved 'pos' first. */
+    }
+
+    slot->pid = getpid();
+    FAULTD_MEMCPY(&slot->info, info, sizeof(*info));
+    slot->symbols_size = 0;
+    if(info->backtrace_symbols) {
+        slot->symbols_size = faultd_ring_symbols__(info, slot->symbols,
+                                                   sizeof(slot->symbols));
+    }
+
+    /* Commit, unless the server has given up on us. */
+    __sync_synchronize();
+    if(!__sync_bool_compare_and_swap(&slot->seq, pos, pos + 1)) {
+        /* Poisoned. We are done with the slot; release it for the next lap. */
+        __sync_bool_compare_and_swap(&slot->seq,
+                                     pos + FAULTD_CONFIG_RING_ENTRIES - 1,
+                                     pos + FAULTD_CONFIG_RING_ENTRIES);
+        return -1;
+    }
+    __sync_fetch_and_add(&ring->reports, 1);
+    return 0;
+}
+
+static uint64_t
+faultd_ring_now__(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+#define FAULTD_RING_STALL_WAIT   0
+#define FAULTD_RING_STALL_DEAD   1
+#define FAULTD_RING_STALL_POISON 2
+
+/**
+ * What to do with the uncommitted reservation at 'pos'.
+ *
+ * Only a reservation whose writer no longer exists can be freed. A
+ * live writer may still be copying into the slot, so after
+ * FAULTD_RING_STALL_MS its slot is poisoned rather than reused.
+ */
+static int
+faultd_ring_stalled__(faultd_ring_t* ring, uint32_t pos,
+                      faultd_ring_slot_t* slot)
+{
+    uint64_t now = faultd_ring_now__();
+    pid_t pid = slot->pid;
+
+    if(ring->stalled_since == 0 || ring->stalled_pos != pos) {
+        ring->stalled_pos = pos;
+        ring->stalled_since = now;
+        return FAULTD_RING_STALL_WAIT;
+    }
+
+    if(pid && kill(pid, 0) < 0 && errno == ESRCH) {
+        /* The writer died between reserve and commit. */
+        return FAULTD_RING_STALL_DEAD;
+    }
+    if(now - ring->stalled_since >= FAULTD_RING_STALL_MS) {
+        return FAULTD_RING_STALL_POISON;
+    }
+    return FAULTD_RING_STALL_WAIT;
+}
+
+int
+faultd_ring_read(faultd_ring_t* ring, faultd_info_t* info)
+{
+    for(;;) {
+        uint32_t pos = ring->tail;
+        faultd_ring_slot_t* slot = ring->slots + (pos & FAULTD_RING_MASK);
+
+        if(pos == ring->head) {
+            /*
+             * A slot poisoned on the previous lap is free again once
+             * its writer has gone. A live writer releases it itself.
+             */
+            if(slot->seq == pos - 1) {
+                pid_t pid = slot->pid;
+                if(pid && kill(pid, 0) < 0 && errno == ESRCH) {
+                    __sync_bool_compare_and_swap(&slot->seq, pos - 1, pos);
+                }
+            }
+            return 0;
+        }
+
+        if(slot->seq == pos + 1) {
+            __sync_synchronize();
+            FAULTD_MEMCPY(info, &slot->info, sizeof(*info));
+            info->pipename = NULL;
+            info->backtrace_symbols = NULL;
+            if(slot->symbols_size) {
+                info->backtrace_symbols = aim_zmalloc(FAULTD_CONFIG_BACKTRACE_SYMBOLS_SIZE);
+                FAULTD_MEMCPY(info->backtrace_symbols, slot->symbols,
+                              FAULTD_CONFIG_BACKTRACE_SYMBOLS_SIZE);
+                info->backtrace_symbols[FAULTD_CONFIG_BACKTRACE_SYMBOLS_SIZE-1] = 0;
+            }
+            slot->pid = 0;
+            __sync_synchronize();
+            slot->seq = pos + FAULTD_CONFIG_RING_ENTRIES;
+            ring->tail = pos + 1;
+            ring->stalled_since = 0;
+            return 1;
+        }
+
+        /* Reserved but not yet committed. */
+        switch(faultd_ring_stalled__(ring, pos, slot))
+            {
+            case FAULTD_RING_STALL_DEAD:
+                if(__sync_bool_compare_and_swap(&slot->seq, pos,
+                                                pos + FAULTD_CONFIG_RING_ENTRIES)) {
+                    AIM_LOG_ERROR("Abandoning uncommitted fault report from pid %d",
+                                  slot->pid);
+                    __sync_fetch_and_add(&ring->abandoned, 1);
+                    slot->pid = 0;
+                    ring->tail = pos + 1;
+                    ring->stalled_since = 0;
+                }
+                /* Otherwise it was committed just now. */
+                break;
+
+            case FAULTD_RING_STALL_POISON:
+                if(__sync_bool_compare_and_swap(&slot->seq, pos,
+                                                pos + FAULTD_CONFIG_RING_ENTRIES - 1)) {
+                    AIM_LOG_ERROR("Skipping stalled fault report from pid %d",
+                                  slot->pid);
+                    __sync_fetch_and_add(&ring->abandoned, 1);
+                    ring->tail = pos + 1;
+                    ring->stalled_since = 0;
+                }
+                break;
+
+            default:
+                return 0;
+            }
+    }
+}
+
+void
+faultd_ring_stats_get(faultd_ring_t* ring, faultd_ring_stats_t* stats)
+{
+    stats->reports = ring->reports;
+    stats->overflows = ring->overflows;
+    stats->abandoned = ring->abandoned;
+}
+
+
+/**
+ * The doorbell is an eventfd owned by the server. Clients receive it
+ * over the <pipename>.bell domain socket when they are created.
+ */
+int
+faultd_ring_doorbell_create(const char* pipename, int* listenfd)
+{
+    int bellfd, fd;
+    struct sockaddr_un addr;
+    char* path = faultd_ring_path__(pipename, "bell");
+
+    FAULTD_MEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    aim_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+    aim_free(path);
+
+    if((bellfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        AIM_LOG_ERROR("eventfd: %s", strerror(errno));
+        return -1;
+    }
+
+    if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        AIM_LOG_ERROR("socket: %s", strerror(errno));
+        close(bellfd);
+        return -1;
+    }
+    unlink(addr.sun_path);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+       listen(fd, 16) < 0) {
+        AIM_LOG_ERROR("bind(%s): %s", addr.sun_path, strerror(errno));
+        close(fd);
+        close(bellfd);
+        return -1;
+    }
+
+    *listenfd = fd;
+    return bellfd;
+}
+
+void
+faultd_ring_doorbell_accept(int listenfd, int bellfd)
+{
+    int fd;
+
+    while((fd = accept4(listenfd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+        char c = 0;
+        struct iovec iov = { &c, 1 };
+        char cbuf[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg;
+        struct cmsghdr* cmsg;
+
+        FAULTD_MEMSET(&msg, 0, sizeof(msg));
+        FAULTD_MEMSET(cbuf, 0, sizeof(cbuf));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = cbuf;
+        msg.msg_controllen = sizeof(cbuf);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        FAULTD_MEMCPY(CMSG_DATA(cmsg), &bellfd, sizeof(int));
+
+        if(sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+            AIM_LOG_ERROR("doorbell sendmsg: %s", strerror(errno));
+        }
+        close(fd);
+    }
+}
+
+int
+faultd_ring_doorbell_connect(const char* pipename)
+{
+    int fd, bellfd = -1;
+    char c;
+    struct iovec iov = { &c, 1 };
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    struct cmsghdr* cmsg;
+    struct sockaddr_un addr;
+    struct timeval tv = { 1, 0 };
+    char* path = faultd_ring_path__(pipename, "bell");
+
+    FAULTD_MEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    aim_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+    aim_free(path);
+
+    if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    FAULTD_MEMSET(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    if(recvmsg(fd, &msg, MSG_CMSG_CLOEXEC) > 0) {
+        cmsg = CMSG_FIRSTHDR(&msg);
+        if(cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+           cmsg->cmsg_type == SCM_RIGHTS) {
+            FAULTD_MEMCPY(&bellfd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    close(fd);
+    return bellfd;
+}
+
+void
+faultd_ring_doorbell_ring(int bellfd)
+{
+    uint64_t v = 1;
+    if(bellfd >= 0) {
+        /* EAGAIN means the server has plenty of notice already. */
+        if(write(bellfd, &v, sizeof(v)) < 0) {
+            return;
+        }
+    }
+}
+
+void
+faultd_ring_doorbell_clear(int bellfd)
+{
+    uint64_t v;
+    if(read(bellfd, &v, sizeof(v)) < 0) {
+        return;
+    }
+}
+
+#else
+int __faultd_ring_not_empty__;
+#endif /* FAULTD_CONFIG_INCLUDE_RING */
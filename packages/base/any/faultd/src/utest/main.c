@@ -29,6 +29,7 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <execinfo.h>
+#include <sys/wait.h>
 
 #define LOCALNAME "faultd.pipe"
 
@@ -111,11 +112,134 @@ server_main(int argc, char* argv[])
     return 0; 
 }
 
+#define UTEST_PIPENAME "faultd.utest.pipe"
+#define UTEST_CLIENTS 8
+#define UTEST_REPORTS 64
+
+/**
+ * A crash storm: many clients reporting at once while the server drains. 
+ * Clients retry when both the ring and the pipe are full. 
+ *
+ * Backtrace symbols are only requested when 'symbols' is set, as they
+ * can be interleaved with other clients' reports in the pipe. 
+ */
+static void
+utest_client__(int symbols)
+{
+    faultd_client_t* fco; 
+    faultd_info_t info; 
+    int r; 
+    int retries = 0; 
+
+    if(faultd_client_create(&fco, UTEST_PIPENAME) < 0) { 
+        _exit(1); 
+    }
+    for(r = 0; r < UTEST_REPORTS; r++) { 
+        memset(&info, 0, sizeof(info)); 
+        strcpy(info.binary, "utest"); 
+        info.pid = getpid(); 
+        info.signal = SIGSEGV; 
+        info.signal_code = r; 
+        info.backtrace_size = backtrace(info.backtrace, AIM_ARRAYSIZE(info.backtrace)); 
+        info.backtrace_symbols = symbols ? (void*)1 : NULL; 
+        while(faultd_client_write(fco, &info) < 0) { 
+            if(++retries > 10000) { 
+                _exit(2); 
+            }
+            usleep(100); 
+        }
+    }
+    faultd_client_destroy(fco); 
+    _exit(0); 
+}
+
 int
 utest_main(int argc, char* argv[])
 {
-    fprintf(stderr, "No standalone unit test implemented.\n"); 
-    return 0; 
+    faultd_server_t* fso; 
+    faultd_info_t info; 
+    faultd_ring_stats_t stats; 
+    int sid; 
+    int i; 
+    int status; 
+    int rv = 0; 
+    int received = 0; 
+
+    if(faultd_server_create(&fso) < 0 || 
+       (sid = faultd_server_add(fso, UTEST_PIPENAME)) < 0) { 
+        fprintf(stderr, "faultd server setup failed.\n"); 
+        return 1; 
+    }
+
+    for(i = 0; i < UTEST_CLIENTS; i++) { 
+        if(fork() == 0) { 
+            utest_client__(0); 
+        }
+    }
+
+    /* A lost report ends the test here. */
+    alarm(30); 
+    while(received < UTEST_CLIENTS * UTEST_REPORTS) { 
+        memset(&info, 0, sizeof(info)); 
+        if(faultd_server_read(fso, &info, sid) < 0) { 
+            continue; 
+        }
+        if(info.signal != SIGSEGV || strcmp(info.binary, "utest")) { 
+            fprintf(stderr, "corrupt report received.\n"); 
+            rv = 1; 
+        }
+        if(info.backtrace_symbols) { 
+            aim_free(info.backtrace_symbols); 
+        }
+        received++; 
+    }
+    alarm(0); 
+
+    for(i = 0; i < UTEST_CLIENTS; i++) { 
+        if(wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) { 
+            fprintf(stderr, "client failed.\n"); 
+            rv = 1; 
+        }
+    }
+
+    /* A single report with symbols. */
+    if(fork() == 0) { 
+        utest_client__(1); 
+    }
+    alarm(30); 
+    for(i = 0; i < UTEST_REPORTS; i++) { 
+        memset(&info, 0, sizeof(info)); 
+        if(faultd_server_read(fso, &info, sid) < 0) { 
+            i--; 
+            continue; 
+        }
+        if(info.backtrace_symbols == NULL || info.backtrace_symbols[0] == 0) { 
+            fprintf(stderr, "backtrace symbols missing.\n"); 
+            rv = 1; 
+        }
+        if(info.backtrace_symbols) { 
+            aim_free(info.backtrace_symbols); 
+        }
+    }
+    alarm(0); 
+    if(wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) { 
+        fprintf(stderr, "client failed.\n"); 
+        rv = 1; 
+    }
+
+    if(faultd_server_ring_stats(fso, sid, &stats) == 0) { 
+        printf("received %d reports: ring=%u overflows=%u abandoned=%u\n", 
+               received, stats.reports, stats.overflows, stats.abandoned); 
+        if(stats.abandoned) { 
+            rv = 1; 
+        }
+    }
+
+    faultd_server_destroy(fso); 
+    unlink(UTEST_PIPENAME); 
+    unlink(UTEST_PIPENAME ".ring"); 
+    unlink(UTEST_PIPENAME ".bell"); 
+    return rv; 
 }
 
 int
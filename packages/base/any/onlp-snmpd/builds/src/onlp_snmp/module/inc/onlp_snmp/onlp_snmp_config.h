@@ -121,6 +121,46 @@
 #define ONLP_SNMP_CONFIG_UPDATE_PERIOD 5
 #endif
 
+/**
+ * ONLP_SNMP_CONFIG_TEMP_UPDATE_PERIOD
+ *
+ * Temperature sensor update period in seconds. */
+
+
+#ifndef ONLP_SNMP_CONFIG_TEMP_UPDATE_PERIOD
+#define ONLP_SNMP_CONFIG_TEMP_UPDATE_PERIOD ONLP_SNMP_CONFIG_UPDATE_PERIOD
+#endif
+
+/**
+ * ONLP_SNMP_CONFIG_FAN_UPDATE_PERIOD
+ *
+ * Fan sensor update period in seconds. */
+
+
+#ifndef ONLP_SNMP_CONFIG_FAN_UPDATE_PERIOD
+#define ONLP_SNMP_CONFIG_FAN_UPDATE_PERIOD ONLP_SNMP_CONFIG_UPDATE_PERIOD
+#endif
+
+/**
+ * ONLP_SNMP_CONFIG_PSU_UPDATE_PERIOD
+ *
+ * PSU sensor update period in seconds. */
+
+
+#ifndef ONLP_SNMP_CONFIG_PSU_UPDATE_PERIOD
+#define ONLP_SNMP_CONFIG_PSU_UPDATE_PERIOD ONLP_SNMP_CONFIG_UPDATE_PERIOD
+#endif
+
+/**
+ * ONLP_SNMP_CONFIG_DISCOVERY_PERIOD
+ *
+ * Sensor rediscovery period in seconds. Discovery also runs when a presence change or update failure is detected. */
+
+
+#ifndef ONLP_SNMP_CONFIG_DISCOVERY_PERIOD
+#define ONLP_SNMP_CONFIG_DISCOVERY_PERIOD 60
+#endif
+
 /**
  * ONLP_SNMP_CONFIG_DEV_BASE_INDEX
  *
@@ -201,6 +241,16 @@
 #define ONLP_SNMP_CONFIG_RESOURCE_UPDATE_SECONDS 5
 #endif
 
+/**
+ * ONLP_SNMP_CONFIG_MAX_CPUS
+ *
+ * Maximum number of CPUs reported in the per-CPU resource table. */
+
+
+#ifndef ONLP_SNMP_CONFIG_MAX_CPUS
+#define ONLP_SNMP_CONFIG_MAX_CPUS 256
+#endif
+
 
 
 /**
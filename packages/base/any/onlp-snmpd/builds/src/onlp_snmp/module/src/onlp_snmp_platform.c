@@ -26,14 +26,17 @@
 #include "onlp_snmp_log.h"
 
 #include <AIM/aim_time.h>
-#include <cjson/cJSON.h>
-#include <cjson_util/cjson_util.h>
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 #include <onlp/sys.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 static void
@@ -77,7 +80,7 @@ platform_int_register(int index, char* desc, int value)
 
 static void
 resource_int_register(int index, const char* desc,
-                      Netsnmp_Node_Handler *handler)
+                      Netsnmp_Node_Handler *handler, size_t offset)
 {
     oid tree[] = { 1, 3, 6, 1, 4, 1, 42623, 1, 3, 1, 1 };
     tree[10] = index;
@@ -86,6 +89,8 @@ resource_int_register(int index, const char* desc,
         netsnmp_create_handler_registration(desc, handler,
                                             tree, OID_LENGTH(tree),
                                             HANDLER_CAN_RONLY);
+    /* the handler reads the resources_t field at this offset */
+    reg->my_reg_void = (void *) offset;
     if (netsnmp_register_instance(reg) != MIB_REGISTERED_OK) {
         AIM_LOG_ERROR("registering handler for %s failed", desc);
     }
@@ -98,6 +103,18 @@ static pthread_t update_thread_handle;
 typedef struct {
     uint32_t utilization_percent;
     uint32_t idle_percent;
+} cpu_resources_t;
+
+typedef struct {
+    uint32_t utilization_percent;
+    uint32_t idle_percent;
+    uint32_t load_average_1min;
+    uint32_t load_average_5min;
+    uint32_t load_average_15min;
+    uint32_t mem_total;
+    uint32_t mem_available;
+    uint32_t cpu_count;
+    cpu_resources_t cpu[ONLP_SNMP_CONFIG_MAX_CPUS];
 } resources_t;
 
 #define NUM_RESOURCE_BUFFERS (2)
@@ -125,6 +142,173 @@ swap_curr_next_resources(void)
     curr_resource = next_resource();
 }
 
+/*
+ * The /proc files are opened once and re-read from the start on
+ * each update. Percentages are multiplied by 100, as mpstat reported them.
+ */
+typedef struct {
+    uint64_t total;
+    uint64_t idle;
+} cpu_ticks_t;
+
+static int proc_stat_fd = -1;
+static int proc_loadavg_fd = -1;
+static int proc_meminfo_fd = -1;
+
+/* previous sample; slot 0 is the aggregate, slot n+1 is cpu n */
+static cpu_ticks_t cpu_ticks[ONLP_SNMP_CONFIG_MAX_CPUS+1];
+static bool cpu_ticks_valid;
+
+/* the cpu lines are at the start of /proc/stat */
+static char proc_stat_buf[1024 + ONLP_SNMP_CONFIG_MAX_CPUS*128];
+
+static int
+proc_read(int *fd, const char *path, char *buf, int size)
+{
+    int len;
+
+    if (*fd < 0 && (*fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+        AIM_LOG_ERROR("failed to open %s: %{errno}", path, errno);
+        return -1;
+    }
+
+    len = pread(*fd, buf, size - 1, 0);
+    if (len < 0) {
+        AIM_LOG_ERROR("failed to read %s: %{errno}", path, errno);
+        close(*fd);
+        *fd = -1;
+        return -1;
+    }
+    buf[len] = 0;
+    return len;
+}
+
+static void
+cpu_percent(cpu_ticks_t *prev, cpu_ticks_t *curr, cpu_resources_t *res)
+{
+    uint64_t total = curr->total - prev->total;
+    uint64_t idle = curr->idle - prev->idle;
+
+    if (total == 0 || idle > total) {
+        res->idle_percent = 100*100;
+    } else {
+        res->idle_percent = (idle * 100*100 + total/2) / total;
+    }
+    res->utilization_percent = 100*100 - res->idle_percent;
+}
+
+static int
+cpu_update(resources_t *next)
+{
+    char *line, *save = NULL;
+    uint32_t count = 0;
+
+    if (proc_read(&proc_stat_fd, "/proc/stat",
+                  proc_stat_buf, sizeof(proc_stat_buf)) < 0) {
+        return -1;
+    }
+
+    memset(next->cpu, 0, sizeof(next->cpu));
+
+    for (line = strtok_r(proc_stat_buf, "\n", &save);
+         line && !strncmp(line, "cpu", 3);
+         line = strtok_r(NULL, "\n", &save)) {
+        unsigned long long v[8] = { 0 };
+        cpu_ticks_t ticks;
+        cpu_resources_t res;
+        int slot = 0;
+        int i;
+
+        if (line[3] != ' ') {
+            slot = atoi(line + 3) + 1;
+            if (slot > ONLP_SNMP_CONFIG_MAX_CPUS) {
+                continue;
+            }
+        }
+
+        /* user nice system idle iowait irq softirq steal */
+        if (sscanf(line + 3 + strcspn(line + 3, " "),
+                   "%llu %llu %llu %llu %llu %llu %llu %llu",
+                   &v[0], &v[1], &v[2], &v[3],
+                   &v[4], &v[5], &v[6], &v[7]) < 4) {
+            continue;
+        }
+
+        ticks.total = 0;
+        for (i = 0; i < 8; i++) {
+            ticks.total += v[i];
+        }
+        ticks.idle = v[3];
+
+        if (cpu_ticks_valid) {
+            cpu_percent(&cpu_ticks[slot], &ticks, &res);
+        } else {
+            cpu_ticks_t zero = { 0, 0 };
+            cpu_percent(&zero, &ticks, &res);
+        }
+        cpu_ticks[slot] = ticks;
+
+        if (slot == 0) {
+            next->utilization_percent = res.utilization_percent;
+            next->idle_percent = res.idle_percent;
+        } else {
+            next->cpu[slot-1] = res;
+            if (slot > count) {
+                count = slot;
+            }
+        }
+    }
+
+    next->cpu_count = count;
+    cpu_ticks_valid = true;
+    return 0;
+}
+
+static void
+load_update(resources_t *next)
+{
+    char buf[128];
+    double load[3];
+
+    if (proc_read(&proc_loadavg_fd, "/proc/loadavg", buf, sizeof(buf)) < 0) {
+        return;
+    }
+    if (sscanf(buf, "%lf %lf %lf", &load[0], &load[1], &load[2]) == 3) {
+        next->load_average_1min = load[0]*100 + 0.5;
+        next->load_average_5min = load[1]*100 + 0.5;
+        next->load_average_15min = load[2]*100 + 0.5;
+    }
+}
+
+static void
+mem_update(resources_t *next)
+{
+    char buf[4096];
+    char *line, *save = NULL;
+    unsigned long kb;
+    unsigned long mem_free = 0, mem_available = 0;
+    bool have_available = false;
+
+    if (proc_read(&proc_meminfo_fd, "/proc/meminfo", buf, sizeof(buf)) < 0) {
+        return;
+    }
+
+    for (line = strtok_r(buf, "\n", &save); line;
+         line = strtok_r(NULL, "\n", &save)) {
+        if (sscanf(line, "MemTotal: %lu", &kb) == 1) {
+            next->mem_total = kb;
+        } else if (sscanf(line, "MemFree: %lu", &kb) == 1) {
+            mem_free = kb;
+        } else if (sscanf(line, "MemAvailable: %lu", &kb) == 1) {
+            mem_available = kb;
+            have_available = true;
+        }
+    }
+
+    /* MemAvailable is not provided before 3.14 */
+    next->mem_available = have_available ? mem_available : mem_free;
+}
+
 static void
 resource_update(void)
 {
@@ -133,45 +317,30 @@ resource_update(void)
         (ONLP_SNMP_CONFIG_RESOURCE_UPDATE_SECONDS * 1000 * 1000)) {
         last_resource_update_time = now;
 
-        /* invoke mpstat collection script for json output */
-        FILE *fp = popen("/usr/bin/onl-snmp-mpstat", "r");
-        if (fp == NULL) {
-            AIM_LOG_ERROR("failed invoking onl-snmp-mpstat");
+        resources_t *next = get_next_resources();
+        if (cpu_update(next) < 0) {
             return;
         }
+        load_update(next);
+        mem_update(next);
 
-        /* parse json output */
-        char line[1024];
-        while (fgets(line, sizeof(line), fp) != NULL) {
-            cJSON *root = cJSON_Parse(line);
-            int result;
-            int rv = cjson_util_lookup_int(root, &result, "all.%%idle");
-            if (rv == 0) {
-                resources_t *next = get_next_resources();
-                /* save it */
-                next->idle_percent = result;
-                next->utilization_percent = 100*100 - result;
-                /* swap buffers */
-                swap_curr_next_resources();
-            }
-            cJSON_Delete(root);
-        }
-
-        pclose(fp);
+        /* swap buffers */
+        swap_curr_next_resources();
     }
 }
 
 static int
-utilization_handler(netsnmp_mib_handler *handler,
-             netsnmp_handler_registration *reginfo,
-             netsnmp_agent_request_info *reqinfo,
-             netsnmp_request_info *requests)
+resource_gauge_handler(netsnmp_mib_handler *handler,
+                       netsnmp_handler_registration *reginfo,
+                       netsnmp_agent_request_info *reqinfo,
+                       netsnmp_request_info *requests)
 {
     if (MODE_GET == reqinfo->mode) {
         resources_t *curr = get_curr_resources();
+        uint32_t *value = (uint32_t *)
+            ((char *) curr + (size_t) reginfo->my_reg_void);
         snmp_set_var_typed_value(requests->requestvb, ASN_GAUGE,
-                                 (u_char *) &curr->utilization_percent,
-                                 sizeof(curr->utilization_percent));
+                                 (u_char *) value, sizeof(*value));
     } else {
         netsnmp_assert("bad mode in RO handler");
     }
@@ -183,19 +352,58 @@ utilization_handler(netsnmp_mib_handler *handler,
     return SNMP_ERR_NOERROR;
 }
 
+/**
+ * Per-CPU table; rows are indexed by cpu number + 1.
+ */
+typedef struct {
+    uint32_t index;
+} cpu_row_t;
+
+static cpu_row_t cpu_rows[ONLP_SNMP_CONFIG_MAX_CPUS];
+
 static int
-idle_handler(netsnmp_mib_handler *handler,
-             netsnmp_handler_registration *reginfo,
-             netsnmp_agent_request_info *reqinfo,
-             netsnmp_request_info *requests)
+cpu_table_handler(netsnmp_mib_handler *handler,
+                  netsnmp_handler_registration *reginfo,
+                  netsnmp_agent_request_info *reqinfo,
+                  netsnmp_request_info *requests)
 {
-    if (MODE_GET == reqinfo->mode) {
-        resources_t *curr = get_curr_resources();
-        snmp_set_var_typed_value(requests->requestvb, ASN_GAUGE,
-                                 (u_char *) &curr->idle_percent,
-                                 sizeof(curr->idle_percent));
-    } else {
-        netsnmp_assert("bad mode in RO handler");
+    netsnmp_request_info *req;
+
+    if (reqinfo->mode != MODE_GET && reqinfo->mode != MODE_GETNEXT) {
+        return SNMP_ERR_NOERROR;
+    }
+
+    for (req = requests; req; req = req->next) {
+        cpu_row_t *row = (cpu_row_t *) netsnmp_tdata_extract_entry(req);
+        netsnmp_table_request_info *table_info =
+            netsnmp_extract_table_info(req);
+        cpu_resources_t *cpu;
+
+        if (row == NULL) {
+            netsnmp_set_request_error(reqinfo, req, SNMP_NOSUCHINSTANCE);
+            continue;
+        }
+        cpu = &get_curr_resources()->cpu[row->index-1];
+
+        switch (table_info->colnum) {
+        case 1:
+            snmp_set_var_typed_integer(req->requestvb, ASN_INTEGER,
+                                       row->index);
+            break;
+        case 2:
+            snmp_set_var_typed_value(req->requestvb, ASN_GAUGE,
+                                     (u_char *) &cpu->utilization_percent,
+                                     sizeof(cpu->utilization_percent));
+            break;
+        case 3:
+            snmp_set_var_typed_value(req->requestvb, ASN_GAUGE,
+                                     (u_char *) &cpu->idle_percent,
+                                     sizeof(cpu->idle_percent));
+            break;
+        default:
+            netsnmp_set_request_error(reqinfo, req, SNMP_NOSUCHINSTANCE);
+            break;
+        }
     }
 
     if (handler->next && handler->next->access_method) {
@@ -205,6 +413,53 @@ idle_handler(netsnmp_mib_handler *handler,
     return SNMP_ERR_NOERROR;
 }
 
+static void
+cpu_table_register(void)
+{
+    oid tree[] = { 1, 3, 6, 1, 4, 1, 42623, 1, 3, 2 };
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    netsnmp_tdata *table;
+    netsnmp_table_registration_info *table_info;
+    netsnmp_handler_registration *reg;
+    int i;
+
+    if (ncpus > ONLP_SNMP_CONFIG_MAX_CPUS) {
+        ncpus = ONLP_SNMP_CONFIG_MAX_CPUS;
+    }
+
+    table = netsnmp_tdata_create_table("CpuTable", 0);
+    table_info = SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
+    if (table == NULL || table_info == NULL) {
+        AIM_LOG_ERROR("failed to create CpuTable");
+        return;
+    }
+    netsnmp_table_helper_add_indexes(table_info, ASN_INTEGER, 0);
+    table_info->min_column = 1;
+    table_info->max_column = 3;
+
+    reg = netsnmp_create_handler_registration("CpuTable", cpu_table_handler,
+                                              tree, OID_LENGTH(tree),
+                                              HANDLER_CAN_RONLY);
+    if (reg == NULL ||
+        netsnmp_tdata_register(reg, table, table_info) != MIB_REGISTERED_OK) {
+        AIM_LOG_ERROR("failed to register CpuTable");
+        return;
+    }
+
+    for (i = 0; i < ncpus; i++) {
+        netsnmp_tdata_row *row = netsnmp_tdata_create_row();
+        if (row == NULL) {
+            AIM_LOG_ERROR("failed to allocate CpuTable row");
+            return;
+        }
+        cpu_rows[i].index = i + 1;
+        row->data = &cpu_rows[i];
+        netsnmp_tdata_row_add_index(row, ASN_INTEGER, &cpu_rows[i].index,
+                                    sizeof(cpu_rows[i].index));
+        netsnmp_tdata_add_row(table, row);
+    }
+}
+
 void
 onlp_snmp_platform_init(void)
 {
@@ -246,8 +501,20 @@ onlp_snmp_platform_init(void)
         REGISTER_STR(15, onie_version);
     }
 
-    resource_int_register(1, "CpuAllPercentUtilization", utilization_handler);
-    resource_int_register(2, "CpuAllPercentIdle", idle_handler);
+#define REGISTER_RESOURCE(_index, _name, _field)                        \
+        resource_int_register(_index, _name, resource_gauge_handler,    \
+                              offsetof(resources_t, _field))
+
+    REGISTER_RESOURCE(1, "CpuAllPercentUtilization", utilization_percent);
+    REGISTER_RESOURCE(2, "CpuAllPercentIdle", idle_percent);
+    REGISTER_RESOURCE(3, "LoadAverage1Min", load_average_1min);
+    REGISTER_RESOURCE(4, "LoadAverage5Min", load_average_5min);
+    REGISTER_RESOURCE(5, "LoadAverage15Min", load_average_15min);
+    REGISTER_RESOURCE(6, "MemTotal", mem_total);
+    REGISTER_RESOURCE(7, "MemAvailable", mem_available);
+    REGISTER_RESOURCE(8, "CpuCount", cpu_count);
+
+    cpu_table_register();
 }
 
 #define MIN(a,b) ((a)<(b)? (a): (b))
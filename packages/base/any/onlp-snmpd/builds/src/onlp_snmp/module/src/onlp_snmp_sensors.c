@@ -58,8 +58,11 @@ typedef struct sensor_info_s {
  * Individual Sensor Control structure.
  * The valid field in the sensor_info_t structure above
  * is used snmp table maintenance:
- * - A table row is added when previously invalid sensor is now valid.
- * - A table row is deleted when previously valid sensor is now invalid
+ * - A table row is added when a sensor without a row is now valid.
+ * - A table row is deleted when a sensor with a row is now invalid
+ *
+ * Each sensor is refreshed on its own schedule. The update
+ * is written to the back buffer, which is then made current.
  */
 typedef struct onlp_snmp_sensor_s {
     list_links_t links;  /* for tracking sensors of the same type */
@@ -69,38 +72,50 @@ typedef struct onlp_snmp_sensor_s {
     onlp_snmp_sensor_type_t sensor_type;
     uint32_t index;      /* snmp table column */
     sensor_info_t sensor_info[NUM_SENSOR_INFO];
+    int curr_info;       /* sensor_info entry served to snmp requests */
+    bool discovered;     /* found by the last discovery */
+    bool row;            /* table row exists; snmp thread only */
+    bool present;        /* presence reported by the last update */
+    uint64_t next_update; /* monotonic time of the next update */
 } onlp_snmp_sensor_t;
 
-static int curr_info;
 static int
-next_info(void)
+next_info(onlp_snmp_sensor_t *ss)
 {
-    return (curr_info+1) % NUM_SENSOR_INFO;
+    return (ss->curr_info+1) % NUM_SENSOR_INFO;
 }
 static sensor_info_t *
 get_curr_info(onlp_snmp_sensor_t *ss)
 {
-    return &ss->sensor_info[curr_info];
+    return &ss->sensor_info[ss->curr_info];
 }
 static sensor_info_t *
 get_next_info(onlp_snmp_sensor_t *ss)
 {
-    return &ss->sensor_info[next_info()];
+    return &ss->sensor_info[next_info(ss)];
 }
 static void
-swap_curr_next_info(void)
+swap_curr_next_info(onlp_snmp_sensor_t *ss)
 {
-    curr_info = next_info();
+    ss->curr_info = next_info(ss);
 }
 
-/* timestamp used to trigger sensor update */
-static uint64_t last_sensor_update_time;
+/* timestamp used to trigger sensor discovery */
+static uint64_t next_discovery_time;
+
+/* true if discovery is to happen on the next update pass;
+ * set when a presence change or update failure is seen */
+static bool discovery_trigger;
 
 /* true if table restructuring is to happen;
- * set after all tables updated;
+ * set when a sensor changes validity or disappears;
  * cleared after all tables restructured */
 static bool restructure_trigger;
 
+/* protects the sensor lists and the triggers.
+ * the snmp thread never waits on this lock. */
+static pthread_mutex_t sensor_lock__ = PTHREAD_MUTEX_INITIALIZER;
+
 /* updates happen in this pthread */
 static pthread_t update_thread_handle;
 
@@ -879,6 +894,32 @@ static update_handler_fn all_update_handler_fns__[] = {
     psu_update_handler__,
 };
 
+/*
+ * Update periods, in seconds
+ */
+static const uint32_t update_periods__[] = {
+    0,
+    ONLP_SNMP_CONFIG_TEMP_UPDATE_PERIOD,
+    ONLP_SNMP_CONFIG_FAN_UPDATE_PERIOD,
+    ONLP_SNMP_CONFIG_PSU_UPDATE_PERIOD,
+};
+
+static bool
+sensor_present__(int sensor_type, sensor_info_t *si)
+{
+    switch(sensor_type)
+        {
+        case ONLP_SNMP_SENSOR_TYPE_TEMP:
+            return (si->data.ti.status & ONLP_THERMAL_STATUS_PRESENT) != 0;
+        case ONLP_SNMP_SENSOR_TYPE_FAN:
+            return (si->data.fi.status & ONLP_FAN_STATUS_PRESENT) != 0;
+        case ONLP_SNMP_SENSOR_TYPE_PSU:
+            return (si->data.pi.status & ONLP_PSU_STATUS_PRESENT) != 0;
+        default:
+            return false;
+        }
+}
+
 
 /*
  * Add a sensor to the appropriate type-specific control structure.
@@ -902,7 +943,7 @@ add_sensor__(int sensor_type, onlp_snmp_sensor_t *new_sensor)
         if (new_sensor->sensor_id == ss->sensor_id) {
             /* no need to add sensor */
             AIM_LOG_TRACE("skipping existing sensor %08x", ss->sensor_id);
-            get_next_info(ss)->valid = true;
+            ss->discovered = true;
             return;
         }
     }
@@ -911,7 +952,9 @@ add_sensor__(int sensor_type, onlp_snmp_sensor_t *new_sensor)
     AIM_TRUE_OR_DIE(ss);
     AIM_MEMCPY(ss, new_sensor, sizeof(*new_sensor));
     ss->sensor_type = sensor_type;
-    get_next_info(ss)->valid = true;
+    ss->discovered = true;
+    /* update immediately */
+    ss->next_update = 0;
 
     /* finally add sensor */
     list_push(&ctrl->sensors, &ss->links);
@@ -975,69 +1018,148 @@ collect_sensors__(onlp_oid_t oid, void* cookie)
 /*
  * sensor table is updated in two parts:
  * 1. sensor update, performed in separate thread by calling update_tables__.
- *    once update is complete, front-back buffers will be switched
- *    and flag set to indicate table restructuring can occur
+ *    each sensor class is refreshed on its own period, and each sensor
+ *    at its own phase within that period, so hardware accesses are spread
+ *    out instead of happening in bursts. an update is written to the
+ *    sensor's back buffer which is then made current.
+ *    discovery re-runs only when a presence change or update failure
+ *    is seen, or when the discovery period expires.
+ *    if a sensor changes validity, a flag is set to indicate
+ *    table restructuring can occur
  * 2. sensor table restructuring, performed in snmp callback
  *    by calling restructure_tables__.
  */
 
+/* the phase of the sensor within its update period */
+static uint64_t
+sensor_phase__(onlp_snmp_sensor_t *ss, uint64_t period)
+{
+    uint32_t hash = (uint32_t)ss->sensor_id * 2654435761U;
+    return ((uint64_t)hash * period) >> 32;
+}
+
 static void
-update_tables__(void)
+discover_sensors__(uint64_t now)
 {
     int i;
     onlp_snmp_sensor_ctrl_t *ctrl;
     list_links_t *curr;
     onlp_snmp_sensor_t *ss;
 
-    uint64_t now = aim_time_monotonic();
-    if (now - last_sensor_update_time <
-        (ONLP_SNMP_CONFIG_UPDATE_PERIOD * 1000 * 1000)) {
-        return;
-    }
+    AIM_LOG_TRACE("discover sensor objects");
 
-    if (restructure_trigger) {
-        AIM_LOG_INFO("restructure has not happened, skip sensor update");
-        return;
+    /* for each table: mark sensors undiscovered */
+    for (i = ONLP_SNMP_SENSOR_TYPE_TEMP; i <= ONLP_SNMP_SENSOR_TYPE_MAX; i++) {
+        ctrl = get_sensor_ctrl__(i);
+        LIST_FOREACH(&ctrl->sensors, curr) {
+            ss = container_of(curr, links, onlp_snmp_sensor_t);
+            ss->discovered = false;
+        }
     }
 
-    last_sensor_update_time = now;
-    AIM_LOG_TRACE("update sensor objects");
+    /* discover new sensors for all tables */
+    onlp_oid_iterate(ONLP_OID_SYS, 0, collect_sensors__, NULL);
 
-    /* for each table: mark next_info invalid */
+    /* sensors which have disappeared are invalidated now */
     for (i = ONLP_SNMP_SENSOR_TYPE_TEMP; i <= ONLP_SNMP_SENSOR_TYPE_MAX; i++) {
         ctrl = get_sensor_ctrl__(i);
         LIST_FOREACH(&ctrl->sensors, curr) {
             ss = container_of(curr, links, onlp_snmp_sensor_t);
-            get_next_info(ss)->valid = false;
+            if (!ss->discovered) {
+                ss->next_update = 0;
+            }
         }
     }
 
-    /* discover new sensors for all tables,
-     * writing validity into next_info for all sensors */
-    onlp_oid_iterate(ONLP_OID_SYS, 0, collect_sensors__, NULL);
+    discovery_trigger = false;
+    next_discovery_time = now +
+        (uint64_t)ONLP_SNMP_CONFIG_DISCOVERY_PERIOD * 1000 * 1000;
+}
 
-    /* for each table: update all sensor info */
+static void
+update_sensor__(int sensor_type, onlp_snmp_sensor_t *ss, uint64_t now)
+{
+    uint64_t period = (uint64_t)update_periods__[sensor_type] * 1000 * 1000;
+    sensor_info_t *si = get_next_info(ss);
+    bool previously_valid = get_curr_info(ss)->valid;
+
+    si->valid = false;
+    if (ss->discovered) {
+        AIM_LOG_INFO("update sensor %s%s", ss->name, ss->desc);
+        /* invoke update handler */
+        if ((*all_update_handler_fns__[sensor_type])(ss) == ONLP_STATUS_OK) {
+            bool present = sensor_present__(sensor_type, si);
+            if (previously_valid && present != ss->present) {
+                /* presence change may add or remove other sensors */
+                discovery_trigger = true;
+            }
+            ss->present = present;
+            si->valid = true;
+        } else {
+            AIM_LOG_ERROR("failed to update %s%s", ss->name, ss->desc);
+            if (previously_valid) {
+                discovery_trigger = true;
+            }
+        }
+    }
+
+    /* make the update current */
+    swap_curr_next_info(ss);
+
+    if (previously_valid != si->valid || !ss->discovered) {
+        restructure_trigger = true;
+    }
+
+    /* schedule the next update at this sensor's phase */
+    if (period == 0) {
+        ss->next_update = now;
+    } else {
+        ss->next_update = now - (now % period) + sensor_phase__(ss, period);
+        while (ss->next_update <= now) {
+            ss->next_update += period;
+        }
+    }
+}
+
+/* returns the time of the next scheduled update */
+static uint64_t
+update_tables__(void)
+{
+    int i;
+    onlp_snmp_sensor_ctrl_t *ctrl;
+    list_links_t *curr;
+    onlp_snmp_sensor_t *ss;
+    uint64_t now = aim_time_monotonic();
+    uint64_t next;
+
+    pthread_mutex_lock(&sensor_lock__);
+
+    if (discovery_trigger || now >= next_discovery_time) {
+        discover_sensors__(now);
+    }
+
+    /* for each table: update sensors which are due */
+    next = next_discovery_time;
     for (i = ONLP_SNMP_SENSOR_TYPE_TEMP; i <= ONLP_SNMP_SENSOR_TYPE_MAX; i++) {
         ctrl = get_sensor_ctrl__(i);
         LIST_FOREACH(&ctrl->sensors, curr) {
             ss = container_of(curr, links, onlp_snmp_sensor_t);
-            if (get_next_info(ss)->valid) {
-                AIM_LOG_INFO("update sensor %s%s", ss->name, ss->desc);
-                /* invoke update handler */
-                if ((*all_update_handler_fns__[i])(ss) != ONLP_STATUS_OK) {
-                    AIM_LOG_ERROR("failed to update %s%s", ss->name, ss->desc);
-                    get_next_info(ss)->valid = false;
-                }
+            if (now >= ss->next_update) {
+                update_sensor__(i, ss, aim_time_monotonic());
+            }
+            if (ss->next_update < next) {
+                next = ss->next_update;
             }
         }
     }
 
-    /* swap front and back buffers */
-    swap_curr_next_info();
+    if (discovery_trigger) {
+        /* rediscover on the next pass */
+        next = now;
+    }
 
-    /* trigger table restructuring */
-    AIM_LOG_TRACE("trigger restructure");
-    restructure_trigger = true;
+    pthread_mutex_unlock(&sensor_lock__);
+    return next;
 }
 
 /*
@@ -1054,10 +1176,16 @@ restructure_tables__(unsigned int reg, void *clientarg)
     list_links_t *curr;
     list_links_t *next;
     onlp_snmp_sensor_t *ss;
-    bool previously_valid;
     bool now_valid;
 
+    /* do not stall the agent behind a hardware access;
+     * restructuring is retried on the next alarm. */
+    if (pthread_mutex_trylock(&sensor_lock__) != 0) {
+        return;
+    }
+
     if (!restructure_trigger) {
+        pthread_mutex_unlock(&sensor_lock__);
         return;
     }
 
@@ -1068,20 +1196,24 @@ restructure_tables__(unsigned int reg, void *clientarg)
         ctrl = get_sensor_ctrl__(i);
         LIST_FOREACH_SAFE(&ctrl->sensors, curr, next) {
             ss = container_of(curr, links, onlp_snmp_sensor_t);
-            previously_valid = get_next_info(ss)->valid;
             now_valid = get_curr_info(ss)->valid;
-            if (!previously_valid && now_valid) {
+            if (!ss->row && now_valid) {
                 snmp_log(LOG_INFO, "Adding %s%s, id=%08x",
                          ss->name, ss->desc, ss->sensor_id);
                 AIM_LOG_INFO("add row %d to %s for %s%s",
                                 ss->index, ctrl->name, ss->name, ss->desc);
-                add_table_row__(sensor_table__[i], ss);
-            } else if (previously_valid && !now_valid) {
+                if (add_table_row__(sensor_table__[i], ss) == 0) {
+                    ss->row = true;
+                }
+            } else if (ss->row && !now_valid) {
                 snmp_log(LOG_INFO, "Deleting %s%s, id=%08x",
                          ss->name, ss->desc, ss->sensor_id);
                 AIM_LOG_INFO("delete row %d from %s for %s%s",
                                 ss->index, ctrl->name, ss->name, ss->desc);
                 delete_table_row__(sensor_table__[i], ss->index);
+                ss->row = false;
+            }
+            if (!ss->row && !ss->discovered) {
                 list_remove(curr);
                 aim_free(ss);
             }
@@ -1091,6 +1223,7 @@ restructure_tables__(unsigned int reg, void *clientarg)
     AIM_LOG_INFO("restructuring complete");
 
     restructure_trigger = false;
+    pthread_mutex_unlock(&sensor_lock__);
 }
 
 
@@ -1171,21 +1304,16 @@ onlp_snmp_sensors_init(void)
     return 0;
 }
 
-#define MIN(a,b) ((a)<(b)? (a): (b))
-static unsigned int
-us_to_next_update(void)
-{
-    uint64_t deltat = aim_time_monotonic() - last_sensor_update_time;
-    uint64_t period = ONLP_SNMP_CONFIG_UPDATE_PERIOD * 1000 * 1000;
-    return MIN(period - deltat, period);
-}
-
 static void *
 do_update(void *arg)
 {
     for (;;) {
-        update_tables__();
-        usleep(us_to_next_update());
+        uint64_t next = update_tables__();
+        uint64_t now = aim_time_monotonic();
+        if (next > now) {
+            /* wake at least once per second to pick up triggers */
+            usleep((next - now) < 1000000 ? (next - now) : 1000000);
+        }
     }
 
     return NULL;
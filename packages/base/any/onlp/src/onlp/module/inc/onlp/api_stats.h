@@ -0,0 +1,93 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * ONLP API Statistics
+ *
+ * Every locked ONLP API entry point counts its calls and errors
+ * and keeps log2 histograms of the time spent waiting for the API
+ * lock and in the call itself. The statistics are kept in shared
+ * memory and are common to all ONLP clients on the system.
+ *
+ ***********************************************************/
+#ifndef __ONLP_API_STATS_H__
+#define __ONLP_API_STATS_H__
+
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+
+/** Number of histogram buckets */
+#define ONLP_API_STATS_BUCKETS 32
+
+/** Maximum API name length */
+#define ONLP_API_STATS_NAME_SIZE 64
+
+/**
+ * Statistics for a single API.
+ */
+typedef struct onlp_api_stats_s {
+    /** API name */
+    char name[ONLP_API_STATS_NAME_SIZE];
+
+    /** Number of calls */
+    uint64_t calls;
+
+    /** Number of calls which returned an error other than unsupported */
+    uint64_t errors;
+
+    /** Total and maximum lock wait time (us) */
+    uint64_t lock_total;
+    uint64_t lock_max;
+
+    /** Total and maximum function time (us) */
+    uint64_t func_total;
+    uint64_t func_max;
+
+    /**
+     * Histograms of lock wait and function time.
+     * Bucket 0 counts calls under 1us. Bucket N counts
+     * calls taking [2^(N-1), 2^N) us.
+     */
+    uint64_t lock_hist[ONLP_API_STATS_BUCKETS];
+    uint64_t func_hist[ONLP_API_STATS_BUCKETS];
+} onlp_api_stats_t;
+
+/**
+ * @brief Get the statistics for all APIs.
+ * @param stats Receives the statistics.
+ * @param max The number of entries in stats.
+ * @returns The number of entries populated, or an error.
+ */
+int onlp_api_stats_get(onlp_api_stats_t* stats, int max);
+
+/**
+ * @brief Reset the statistics for all APIs.
+ * @note Calls in progress may be partially counted.
+ */
+int onlp_api_stats_reset(void);
+
+/**
+ * @brief Show the statistics for all APIs which have been called.
+ * @param pvs The output pvs.
+ * @param histograms Include the histograms.
+ */
+void onlp_api_stats_show(aim_pvs_t* pvs, int histograms);
+
+#endif /* __ONLP_API_STATS_H__ */
@@ -113,6 +113,16 @@ int onlp_fan_init(void);
  */
 int onlp_fan_info_get(onlp_oid_t id, onlp_fan_info_t* rv);
 
+/**
+ * @brief Retrieve fan information through the information cache.
+ * @param id The fan OID.
+ * @param rv [out] Receives the fan information.
+ * @param max_age The maximum acceptable age of a cached result in
+ * milliseconds. Zero always queries the platform.
+ */
+int onlp_fan_info_get_cached(onlp_oid_t id, onlp_fan_info_t* rv,
+                             uint32_t max_age);
+
 /**
  * @brief Retrieve the fan's operational status.
  * @param id The fan OID.
@@ -0,0 +1,115 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * Fan Policy Engine
+ *
+ * A data-driven replacement for hand-written
+ * onlp_sysi_platform_manage_fans() implementations.
+ *
+ * A policy is described in JSON:
+ *
+ * {
+ *   "fans":    [ 1, 2, 3, 4, 5, 6 ],   Fans checked by the failure rules.
+ *   "control": [ 1 ],                  Fans whose duty cycle is set.
+ *   "failure": {                       Duty cycle when ... (default 100)
+ *     "fan_failed": 100,               ... a fan has failed
+ *     "fan_missing": 100,              ... a fan is not present
+ *     "sensor_failed": 100             ... a thermal cannot be read
+ *   },
+ *   "groups": [
+ *     {
+ *       "name": "ambient",
+ *       "thermals": [ 2, 3, 4 ],
+ *       "aggregate": "sum",            max, min, avg or sum
+ *       "direction": "f2b",            Optional; f2b or b2f.
+ *       "steps": [                     [ duty, down, up ] (mC)
+ *         [ 32,      0, 174000 ],
+ *         [ 38, 170000, 182000 ],
+ *         [ 50, 178000,      0 ]
+ *       ]
+ *     },
+ *     {
+ *       "name": "asic",
+ *       "thermals": [ 5 ],
+ *       "pid": { "setpoint": 85000, "kp": 2.0, "ki": 0.1, "kd": 0,
+ *                "min": 30, "max": 100 }
+ *     }
+ *   ]
+ * }
+ *
+ * Each group moves between its steps using the down/up hysteresis
+ * thresholds (0 means none), at most one step per evaluation, or runs
+ * a PID loop on the aggregate value. The duty cycle is the maximum demanded by the groups which
+ * apply to the current airflow direction and the failure rules.
+ *
+ * Every referenced fan and thermal is read once per evaluation and
+ * the duty cycle is only written when it differs from the duty cycle
+ * reported by the first control fan.
+ *
+ * The policy is taken from the "fan_policy" key of the ONLP
+ * configuration file (an object, or the name of a file containing
+ * one) or loaded by the platform with onlp_fan_policy_load().
+ * When a policy is loaded the platform manager uses it instead of
+ * onlp_sysi_platform_manage_fans().
+ *
+ ***********************************************************/
+#ifndef __ONLP_FAN_POLICY_H__
+#define __ONLP_FAN_POLICY_H__
+
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+
+/**
+ * @brief Load a fan policy.
+ * @param json The JSON policy description.
+ * @note Replaces any policy which is already loaded.
+ */
+int onlp_fan_policy_load(const char* json);
+
+/**
+ * @brief Load a fan policy from a file.
+ * @param fname The JSON policy file.
+ */
+int onlp_fan_policy_load_file(const char* fname);
+
+/**
+ * @brief Unload the current fan policy.
+ */
+void onlp_fan_policy_unload(void);
+
+/**
+ * @brief Returns whether a fan policy is loaded.
+ */
+int onlp_fan_policy_loaded(void);
+
+/**
+ * @brief Evaluate the fan policy once.
+ * @returns The duty cycle in effect, or an error.
+ */
+int onlp_fan_policy_run(void);
+
+/**
+ * @brief Show the fan policy and its current state.
+ * @param pvs The output pvs.
+ */
+void onlp_fan_policy_show(aim_pvs_t* pvs);
+
+#endif /* __ONLP_FAN_POLICY_H__ */
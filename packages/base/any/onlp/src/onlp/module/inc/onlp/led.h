@@ -112,6 +112,16 @@ int onlp_led_init(void);
  */
 int onlp_led_info_get(onlp_oid_t id, onlp_led_info_t* rv);
 
+/**
+ * @brief Retrieve led information through the information cache.
+ * @param id The led OID.
+ * @param rv [out] Receives the led information.
+ * @param max_age The maximum acceptable age of a cached result in
+ * milliseconds. Zero always queries the platform.
+ */
+int onlp_led_info_get_cached(onlp_oid_t id, onlp_led_info_t* rv,
+                             uint32_t max_age);
+
 /**
  * @brief Get the LED operational status.
  * @param id The LED OID
@@ -193,6 +193,29 @@ int onlp_oid_iterate(onlp_oid_t oid, onlp_oid_type_t type,
  */
 int onlp_oid_hdr_get(onlp_oid_t oid, onlp_oid_hdr_t* hdr);
 
+/**
+ * @brief Invalidate cached information for an OID.
+ * @param oid The oid. Zero invalidates all cached information,
+ * including the OID tree.
+ */
+int onlp_oid_cache_invalidate(onlp_oid_t oid);
+
+/**
+ * @brief Get the OID tree generation.
+ * @returns A number which changes whenever the set of platform OIDs
+ * (as walked by onlp_oid_iterate()) changes.
+ * @note onlp_oid_iterate() walks a cached copy of the OID tree.
+ * The tree is rebuilt after a PSU or Fan presence transition is
+ * observed or after onlp_oid_tree_invalidate().
+ */
+uint32_t onlp_oid_tree_generation(void);
+
+/**
+ * @brief Invalidate the cached OID tree.
+ * @note It will be rebuilt on next use.
+ */
+void onlp_oid_tree_invalidate(void);
+
 
 
 
@@ -174,6 +174,16 @@
 #define ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES 1
 #endif
 
+/**
+ * ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD
+ *
+ * Reload the platform overrides when the configuration file changes. */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD
+#define ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD 1
+#endif
+
 /**
  * ONLP_CONFIG_CONFIGURATION_FILENAME
  *
@@ -224,6 +234,26 @@
 #define ONLP_CONFIG_API_LOCK_TIMEOUT 60000000
 #endif
 
+/**
+ * ONLP_CONFIG_API_LOCK_DOMAINS
+ *
+ * If 1, the API lock is split into per-subsystem shared reader/writer locks for platforms which opt in with onlp_sysi_api_lock_flags_get(). Other platforms use a single platform-wide domain. If 0, the single API lock selected by ONLP_CONFIG_API_LOCK_GLOBAL_SHARED is used. */
+
+
+#ifndef ONLP_CONFIG_API_LOCK_DOMAINS
+#define ONLP_CONFIG_API_LOCK_DOMAINS 1
+#endif
+
+/**
+ * ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS
+ *
+ * If 1, read-only APIs take their domain lock shared on platforms which opt in with ONLP_SYSI_API_LOCK_F_SHARED_READS. Only applicable when ONLP_CONFIG_API_LOCK_DOMAINS is enabled. */
+
+
+#ifndef ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS
+#define ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS 1
+#endif
+
 /**
  * ONLP_CONFIG_INFO_STR_MAX
  *
@@ -254,6 +284,176 @@
 #define ONLP_CONFIG_INCLUDE_API_PROFILING 0
 #endif
 
+/**
+ * ONLP_CONFIG_INCLUDE_API_TIMING
+ *
+ * Include runtime enabled API lock and function timing (used by the onlpdump benchmark). */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_API_TIMING
+#define ONLP_CONFIG_INCLUDE_API_TIMING 1
+#endif
+
+/**
+ * ONLP_CONFIG_INCLUDE_API_STATS
+ *
+ * Include always-on per-API call statistics in shared memory. */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_API_STATS
+#define ONLP_CONFIG_INCLUDE_API_STATS 1
+#endif
+
+/**
+ * ONLP_CONFIG_API_STATS_MAX
+ *
+ * The maximum number of APIs tracked by the API statistics. */
+
+
+#ifndef ONLP_CONFIG_API_STATS_MAX
+#define ONLP_CONFIG_API_STATS_MAX 256
+#endif
+
+/**
+ * ONLP_CONFIG_INCLUDE_API_CACHE
+ *
+ * Include the OID information cache. */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_API_CACHE
+#define ONLP_CONFIG_INCLUDE_API_CACHE 1
+#endif
+
+/**
+ * ONLP_CONFIG_API_CACHE_TTL_DEFAULT
+ *
+ * The default lifetime (in milliseconds) of cached OID information. Zero disables caching unless a lifetime is specified in the configuration file. */
+
+
+#ifndef ONLP_CONFIG_API_CACHE_TTL_DEFAULT
+#define ONLP_CONFIG_API_CACHE_TTL_DEFAULT 0
+#endif
+
+/**
+ * ONLP_CONFIG_API_CACHE_ID_MAX
+ *
+ * The maximum OID ID which can be cached for each OID type. */
+
+
+#ifndef ONLP_CONFIG_API_CACHE_ID_MAX
+#define ONLP_CONFIG_API_CACHE_ID_MAX 256
+#endif
+
+/**
+ * ONLP_CONFIG_INCLUDE_OID_TREE_CACHE
+ *
+ * Include the OID tree cache used by onlp_oid_iterate(). */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_OID_TREE_CACHE
+#define ONLP_CONFIG_INCLUDE_OID_TREE_CACHE 1
+#endif
+
+/**
+ * ONLP_CONFIG_OID_TREE_MAX
+ *
+ * The maximum number of nodes in the cached OID tree. */
+
+
+#ifndef ONLP_CONFIG_OID_TREE_MAX
+#define ONLP_CONFIG_OID_TREE_MAX 1024
+#endif
+
+/**
+ * ONLP_CONFIG_SFP_BULK_THREADS_MAX
+ *
+ * The maximum number of worker threads used by the bulk SFP read functions. */
+
+
+#ifndef ONLP_CONFIG_SFP_BULK_THREADS_MAX
+#define ONLP_CONFIG_SFP_BULK_THREADS_MAX 8
+#endif
+
+/**
+ * ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE
+ *
+ * Include the SFP EEPROM cache. */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE
+#define ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE 1
+#endif
+
+/**
+ * ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL
+ *
+ * The maximum age (in milliseconds) of the last presence observation before a cached SFP EEPROM is revalidated against the port presence and the module serial number. */
+
+
+#ifndef ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL
+#define ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL 1000
+#endif
+
+/**
+ * ONLP_CONFIG_SFP_PRESENCE_POLL_MS
+ *
+ * The interval (in milliseconds) at which the shared presence monitor polls platforms which cannot notify presence changes. */
+
+
+#ifndef ONLP_CONFIG_SFP_PRESENCE_POLL_MS
+#define ONLP_CONFIG_SFP_PRESENCE_POLL_MS 1000
+#endif
+
+/**
+ * ONLP_CONFIG_INCLUDE_TELEMETRY
+ *
+ * Include the platform telemetry service and client. */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_TELEMETRY
+#define ONLP_CONFIG_INCLUDE_TELEMETRY 1
+#endif
+
+/**
+ * ONLP_CONFIG_TELEMETRY_SOCKET
+ *
+ * The domain socket path of the platform telemetry service. */
+
+
+#ifndef ONLP_CONFIG_TELEMETRY_SOCKET
+#define ONLP_CONFIG_TELEMETRY_SOCKET "/var/run/onlp/telemetry"
+#endif
+
+/**
+ * ONLP_CONFIG_TELEMETRY_INTERVAL_MS
+ *
+ * The default interval (in milliseconds) at which the telemetry service collects a snapshot. Clients accept snapshots up to twice this age. */
+
+
+#ifndef ONLP_CONFIG_TELEMETRY_INTERVAL_MS
+#define ONLP_CONFIG_TELEMETRY_INTERVAL_MS 1000
+#endif
+
+/**
+ * ONLP_CONFIG_INCLUDE_ONIE_CACHE
+ *
+ * Include the ONIE system information cache. */
+
+
+#ifndef ONLP_CONFIG_INCLUDE_ONIE_CACHE
+#define ONLP_CONFIG_INCLUDE_ONIE_CACHE 1
+#endif
+
+/**
+ * ONLP_CONFIG_ONIE_CACHE_FILENAME
+ *
+ * The file in which the decoded system information is persisted. It should reside on a tmpfs so it does not outlive the hardware it describes. */
+
+
+#ifndef ONLP_CONFIG_ONIE_CACHE_FILENAME
+#define ONLP_CONFIG_ONIE_CACHE_FILENAME "/var/run/onlp/onie"
+#endif
+
 
 
 /**
@@ -58,6 +58,16 @@ int onlp_sfpi_is_present(int port);
  */
 int onlp_sfpi_presence_bitmap_get(onlp_sfp_bitmap_t* dst);
 
+/**
+ * @brief Return a descriptor which signals presence changes.
+ * @param fd Receives the descriptor.
+ * @note The descriptor must raise POLLPRI (e.g. a sysfs attribute
+ * which the kernel driver sysfs_notify()s) whenever the presence
+ * of any port changes. The caller owns and closes it.
+ * @returns ONLP_STATUS_E_UNSUPPORTED if presence changes must be polled.
+ */
+int onlp_sfpi_presence_notify_fd_get(int* fd);
+
 /**
  * @brief Return the RX_LOS bitmap for all SFP ports.
  * @param dst Receives the RX_LOS bitmap.
@@ -165,6 +175,45 @@ int onlp_sfpi_control_get(int port, onlp_sfp_control_t control, int* value);
  */
 int onlp_sfpi_port_map(int port, int* rport);
 
+/**
+ * @brief Get the access segment for the given port.
+ * @param port The port number.
+ * @param [out] segment Receives the segment identifier.
+ * @note Ports in different segments (for example on separate i2c buses
+ * or separate mux trees) are independent and may be accessed concurrently
+ * by the bulk read functions. This function is optional. If it is not
+ * supported all ports are accessed serially.
+ */
+int onlp_sfpi_port_segment_get(int port, int* segment);
+
+/**
+ * @brief Read a range of transceiver memory.
+ * @param port The port number.
+ * @param devaddr The device address (0x50 or 0x51).
+ * @param page The upper page to select, or -1 for no page selection.
+ * @param offset The starting offset (0-255).
+ * @param len The number of bytes to read.
+ * @param [out] buf Receives the data.
+ * @note This function is optional. If it is not supported the
+ * SFP layer performs page selection and the partial read using
+ * onlp_sfpi_dev_writeb() and onlp_sfpi_dev_read().
+ */
+int onlp_sfpi_mem_read(int port, uint8_t devaddr, int page, int offset,
+                       int len, uint8_t* buf);
+
+/**
+ * @brief Write a range of transceiver memory.
+ * @param port The port number.
+ * @param devaddr The device address (0x50 or 0x51).
+ * @param page The upper page to select, or -1 for no page selection.
+ * @param offset The starting offset (0-255).
+ * @param len The number of bytes to write.
+ * @param buf The data.
+ * @note This function is optional. See onlp_sfpi_mem_read().
+ */
+int onlp_sfpi_mem_write(int port, uint8_t devaddr, int page, int offset,
+                        int len, uint8_t* buf);
+
 /**
  * @brief Deinitialize the SFP driver.
  */
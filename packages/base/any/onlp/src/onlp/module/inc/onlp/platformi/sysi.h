@@ -159,6 +159,20 @@ int onlp_sysi_platform_info_get(onlp_platform_info_t* info);
  */
 void onlp_sysi_platform_info_free(onlp_platform_info_t* info);
 
+/** The drivers for different FRU types may be called concurrently. */
+#define ONLP_SYSI_API_LOCK_F_DOMAINS      0x1
+/** Read-only calls for the same FRU type may be called concurrently. */
+#define ONLP_SYSI_API_LOCK_F_SHARED_READS 0x2
+
+/**
+ * @brief Report the API concurrency the platform drivers support.
+ * @param [out] flags Receives the ONLP_SYSI_API_LOCK_F_* flags.
+ * @note Optional. Without it all API calls are serialized. Only set
+ * these flags once the drivers have been audited for shared I2C mux
+ * state and static buffers.
+ */
+int onlp_sysi_api_lock_flags_get(uint32_t* flags);
+
 /**
  * @brief Builtin platform debug tool.
  */
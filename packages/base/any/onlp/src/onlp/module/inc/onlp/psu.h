@@ -96,6 +96,16 @@ int onlp_psu_init(void);
  */
 int onlp_psu_info_get(onlp_oid_t id, onlp_psu_info_t* rv);
 
+/**
+ * @brief Retrieve psu information through the information cache.
+ * @param id The psu OID.
+ * @param rv [out] Receives the psu information.
+ * @param max_age The maximum acceptable age of a cached result in
+ * milliseconds. Zero always queries the platform.
+ */
+int onlp_psu_info_get_cached(onlp_oid_t id, onlp_psu_info_t* rv,
+                             uint32_t max_age);
+
 /**
  * @brief Get the PSU's operational status.
  * @param id The PSU OID.
@@ -108,16 +108,59 @@ int onlp_sfp_is_present(int port);
  */
 int onlp_sfp_presence_bitmap_get(onlp_sfp_bitmap_t* dst);
 
+/**
+ * @brief Wait for the presence bitmap to change.
+ * @param prev The presence bitmap the caller last observed.
+ * @param timeout_ms The maximum time to wait in milliseconds.
+ * A negative value waits forever and zero does not wait.
+ * @param dst Receives the current presence bitmap.
+ * @returns 1 if the presence bitmap differs from prev.
+ * @returns 0 on timeout.
+ * @returns <0 on error.
+ * @note Presence is read by a single process on the system and
+ * shared with all other processes through shared memory. That process
+ * waits on the platform's presence notification descriptor
+ * (see onlp_sfpi_presence_notify_fd_get()) if one is available
+ * and polls the presence bitmap every ONLP_CONFIG_SFP_PRESENCE_POLL_MS
+ * milliseconds otherwise. Another process takes over if it exits.
+ */
+int onlp_sfp_presence_wait(onlp_sfp_bitmap_t* prev, int timeout_ms,
+                           onlp_sfp_bitmap_t* dst);
+
+/**
+ * @brief Open a presence change event descriptor.
+ * @returns A nonblocking eventfd which becomes readable whenever
+ * the presence monitor observes a presence change, or <0 on error.
+ * @note The descriptor can be added to the caller's own poll or
+ * epoll loop. Read it to clear the event, then call
+ * onlp_sfp_presence_bitmap_get() for the new state.
+ */
+int onlp_sfp_presence_eventfd_open(void);
+
+/**
+ * @brief Close a presence change event descriptor.
+ * @param fd The descriptor returned by onlp_sfp_presence_eventfd_open().
+ */
+int onlp_sfp_presence_eventfd_close(int fd);
+
 /**
  * @brief Read IEEE standard EEPROM data from the given port.
  * @param port The SFP Port
  * @param rv Receives a buffer containing the EEPROM data.
  * @notes The buffer must be freed after use.
+ * @notes The data is cached until a presence transition is observed
+ * on the port or the port is post-inserted.
  * @returns The size of the eeprom data, if successful
  * @returns -1 on error.
  */
 int onlp_sfp_eeprom_read(int port, uint8_t** rv);
 
+/**
+ * @brief Invalidate the cached EEPROM data for the given port.
+ * @param port The SFP Port, or -1 for all ports.
+ */
+int onlp_sfp_eeprom_cache_invalidate(int port);
+
 
 /**
  * @brief Read the DOM data from the given port.
@@ -131,6 +174,37 @@ int onlp_sfp_eeprom_read(int port, uint8_t** rv);
  */
 int onlp_sfp_dom_read(int port, uint8_t** rv);
 
+/**
+ * A single 256 byte EEPROM or DOM page.
+ */
+typedef uint8_t onlp_sfp_data_t[256];
+
+/**
+ * @brief Read IEEE standard EEPROM data from a set of ports.
+ * @param ports The ports to read.
+ * @param data Receives the EEPROM data. This array is indexed by
+ * port number and must be large enough for the highest port in the set.
+ * @param status Receives the status of each port's read. This array is
+ * indexed by port number.
+ * @returns ONLP_STATUS_OK if all ports were read successfully.
+ * @returns The status of the first failed port otherwise.
+ * @note Ports on independent access segments (see onlp_sfpi_port_segment_get())
+ * are read concurrently, ports within a segment serially. Cached EEPROM
+ * data is returned without a hardware read.
+ */
+int onlp_sfp_eeprom_read_bulk(onlp_sfp_bitmap_t* ports, onlp_sfp_data_t* data,
+                              int* status);
+
+/**
+ * @brief Read the DOM data from a set of ports.
+ * @param ports The ports to read.
+ * @param data Receives the DOM data, indexed by port number.
+ * @param status Receives the status of each port's read, indexed by port number.
+ * @note See onlp_sfp_eeprom_read_bulk()
+ */
+int onlp_sfp_dom_read_bulk(onlp_sfp_bitmap_t* ports, onlp_sfp_data_t* data,
+                           int* status);
+
 /**
  * @brief Deinitialize the SFP subsystem.
  */
@@ -172,6 +246,38 @@ int onlp_sfp_dev_readw(int port, uint8_t devaddr, uint8_t addr);
  */
 int onlp_sfp_dev_writew(int port, uint8_t devaddr, uint8_t addr, uint16_t value);
 
+/**
+ * @brief Read a range of transceiver memory.
+ * @param port The port number.
+ * @param devaddr The device address (0x50 or 0x51).
+ * @param page The upper page to select, or -1 for no page selection.
+ * Offsets below 128 always address the lower page.
+ * @param offset The starting offset (0-255).
+ * @param len The number of bytes to read.
+ * @param [out] buf Receives the data.
+ * @note Only the requested bytes are transferred when the platform
+ * supports partial device reads.
+ * @note Upper pages are only selected on SFF-8636 and CMIS modules
+ * with paged memory (0x50) and on SFF-8472 modules which implement
+ * paging (0x51). Other modules only support page 0. Page 0 is
+ * selected again before the call returns, including on failure.
+ */
+int onlp_sfp_mem_read(int port, uint8_t devaddr, int page, int offset,
+                      int len, uint8_t* buf);
+
+/**
+ * @brief Write a range of transceiver memory.
+ * @param port The port number.
+ * @param devaddr The device address (0x50 or 0x51).
+ * @param page The upper page to select, or -1 for no page selection.
+ * @param offset The starting offset (0-255).
+ * @param len The number of bytes to write.
+ * @param buf The data.
+ * @note See onlp_sfp_mem_read() for page selection.
+ */
+int onlp_sfp_mem_write(int port, uint8_t devaddr, int page, int offset,
+                       int len, uint8_t* buf);
+
 
 
 
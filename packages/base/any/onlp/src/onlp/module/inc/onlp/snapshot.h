@@ -0,0 +1,123 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ *
+ * Platform Snapshot
+ *
+ * A single call which collects the information for every platform
+ * OID and the SFP presence into one contiguous, fixed-layout
+ * structure. Intended for language bindings, where each individual
+ * API call carries a significant marshalling cost.
+ *
+ ***********************************************************/
+#ifndef __ONLP_SNAPSHOT_H__
+#define __ONLP_SNAPSHOT_H__
+
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+#include <onlp/oids.h>
+#include <onlp/thermal.h>
+#include <onlp/fan.h>
+#include <onlp/psu.h>
+#include <onlp/led.h>
+#include <onlp/sfp.h>
+
+/**
+ * The snapshot layout version.
+ * Bumped whenever the layout of onlp_snapshot_t changes.
+ */
+#define ONLP_SNAPSHOT_VERSION 2
+
+/** The maximum number of OIDs of each type in a snapshot. */
+#define ONLP_SNAPSHOT_OID_MAX 64
+
+/** The number of SFP ports covered by a snapshot. */
+#define ONLP_SNAPSHOT_SFP_PORTS 256
+
+/** Snapshot flags. */
+#define ONLP_SNAPSHOT_F_EEPROM (1 << 0)
+#define ONLP_SNAPSHOT_F_DOM    (1 << 1)
+
+/**
+ * Information for all OIDs of one type.
+ * The status array receives the status of each info_get call.
+ */
+#define ONLP_SNAPSHOT_OID_TABLE(_info_t)          \
+    struct {                                      \
+        uint32_t count;                           \
+        int status[ONLP_SNAPSHOT_OID_MAX];        \
+        _info_t info[ONLP_SNAPSHOT_OID_MAX];      \
+    }
+
+typedef struct onlp_snapshot_s {
+    /** ONLP_SNAPSHOT_VERSION */
+    uint32_t version;
+    /** sizeof(onlp_snapshot_t) */
+    uint32_t size;
+    /** The ONLP_SNAPSHOT_F_* flags used to collect the snapshot. */
+    uint32_t flags;
+    /** Monotonic time (us) at which collection started. */
+    uint64_t timestamp;
+
+    /** The system OID header. */
+    onlp_oid_hdr_t sys;
+
+    ONLP_SNAPSHOT_OID_TABLE(onlp_thermal_info_t) thermals;
+    ONLP_SNAPSHOT_OID_TABLE(onlp_fan_info_t) fans;
+    ONLP_SNAPSHOT_OID_TABLE(onlp_psu_info_t) psus;
+    ONLP_SNAPSHOT_OID_TABLE(onlp_led_info_t) leds;
+
+    /**
+     * SFP port and presence bitmaps, one bit per port
+     * (bit (port % 32) of word (port / 32)).
+     */
+    int presence_status;
+    uint32_t ports[ONLP_SNAPSHOT_SFP_PORTS / 32];
+    uint32_t presence[ONLP_SNAPSHOT_SFP_PORTS / 32];
+    int rx_los_status;
+    uint32_t rx_los[ONLP_SNAPSHOT_SFP_PORTS / 32];
+
+    /**
+     * EEPROM and DOM data, indexed by port number.
+     * Only collected for present ports with ONLP_SNAPSHOT_F_EEPROM
+     * and ONLP_SNAPSHOT_F_DOM respectively. The status is
+     * ONLP_STATUS_E_MISSING for ports which were not read.
+     */
+    int eeprom_status[ONLP_SNAPSHOT_SFP_PORTS];
+    int dom_status[ONLP_SNAPSHOT_SFP_PORTS];
+    onlp_sfp_data_t eeprom[ONLP_SNAPSHOT_SFP_PORTS];
+    onlp_sfp_data_t dom[ONLP_SNAPSHOT_SFP_PORTS];
+
+} onlp_snapshot_t;
+
+/**
+ * @brief Collect a platform snapshot.
+ * @param snapshot Receives the snapshot.
+ * @param flags ONLP_SNAPSHOT_F_* flags.
+ * @returns ONLP_STATUS_OK if the OID walk completed.
+ * Failures of individual OIDs and ports are reported in
+ * the status fields of the snapshot.
+ * @note The ONIE and platform information is not included as it is
+ * variably sized and does not change. Use onlp_sys_info_get().
+ */
+int onlp_snapshot_get(onlp_snapshot_t* snapshot, uint32_t flags);
+
+#endif /* __ONLP_SNAPSHOT_H__ */
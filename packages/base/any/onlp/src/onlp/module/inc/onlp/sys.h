@@ -62,6 +62,15 @@ int onlp_sys_info_get(onlp_sys_info_t* rv);
  */
 void onlp_sys_info_free(onlp_sys_info_t* info);
 
+/**
+ * @brief Clear the system information cache.
+ * @note The ONIE and platform information are read from the platform
+ * once and cached in ONLP_CONFIG_ONIE_CACHE_FILENAME. This forces
+ * them to be read again. It must be called after a CPLD or firmware
+ * upgrade ("onlpdump sysinfo clear").
+ */
+int onlp_sys_info_cache_clear(void);
+
 /**
  * @brief Get the system header.
  */
@@ -122,6 +131,87 @@ int onlp_sys_platform_manage_join(void);
 
 void onlp_sys_platform_manage_now(void);
 
+/**
+ * A platform management task.
+ * @param cookie The cookie given at registration.
+ * @returns < 0 on error (counted in the task statistics).
+ */
+typedef int (*onlp_sys_platform_manage_f)(void* cookie);
+
+/**
+ * @brief Register a platform management task.
+ * @param name The unique task name.
+ * @param manage The task function.
+ * @param cookie Passed to the task function.
+ * @param rate The task period in microseconds.
+ * @param jitter A random delay in microseconds (up to this amount)
+ * added to each period.
+ * @note The rate and jitter can be overridden in the configuration file
+ * using platform_manager.<name>.rate and platform_manager.<name>.jitter
+ * (in milliseconds).
+ * @note The first run of each task is offset by a name-derived phase
+ * so tasks with the same rate do not run on the same tick.
+ */
+int onlp_sys_platform_manage_register(const char* name,
+                                      onlp_sys_platform_manage_f manage,
+                                      void* cookie,
+                                      uint64_t rate, uint64_t jitter);
+
+/**
+ * @brief Unregister a platform management task.
+ * @param name The task name.
+ */
+int onlp_sys_platform_manage_unregister(const char* name);
+
+/**
+ * @brief Change the rate of a platform management task.
+ * @param name The task name.
+ * @param rate The new task period in microseconds.
+ * @param jitter The new jitter in microseconds.
+ * @note The task is rescheduled relative to the current time.
+ */
+int onlp_sys_platform_manage_retune(const char* name,
+                                    uint64_t rate, uint64_t jitter);
+
+/**
+ * Platform management task statistics.
+ */
+typedef struct onlp_sys_platform_manage_stats_s {
+    /** Task name */
+    char name[32];
+
+    /** Period and jitter (usecs) */
+    uint64_t rate;
+    uint64_t jitter;
+
+    /** Number of calls */
+    uint64_t calls;
+
+    /** Number of calls which returned an error */
+    uint64_t errors;
+
+    /** Total, maximum, and most recent run times (usecs) */
+    uint64_t total_time;
+    uint64_t max_time;
+    uint64_t last_time;
+
+} onlp_sys_platform_manage_stats_t;
+
+/**
+ * @brief Get the statistics for all platform management tasks.
+ * @param stats [out] Receives the statistics.
+ * @param max The size of the stats array.
+ * @returns The number of tasks.
+ */
+int onlp_sys_platform_manage_stats_get(onlp_sys_platform_manage_stats_t* stats,
+                                       int max);
+
+/**
+ * @brief Show the platform management task statistics.
+ * @param pvs The output pvs.
+ */
+void onlp_sys_platform_manage_stats_show(aim_pvs_t* pvs);
+
 int onlp_sys_debug(aim_pvs_t* pvs, int argc, char** argv);
 
 #endif /* __ONLP_SYS_H_ */
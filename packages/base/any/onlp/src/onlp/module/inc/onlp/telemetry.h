@@ -0,0 +1,168 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ *
+ * Platform Telemetry Service
+ *
+ * A single process (normally onlpd) polls the platform and publishes
+ * versioned snapshots (see onlp/snapshot.h) on a unix domain socket.
+ * Other ONLP clients read the published snapshot instead of touching
+ * the hardware themselves, so N clients cost one set of I2C
+ * transactions per interval instead of N.
+ *
+ * Protocol
+ *
+ * Each connection carries one onlp_telemetry_request_t. The service
+ * answers with an onlp_telemetry_reply_t:
+ *
+ *   GET       The reply is followed by 'size' bytes of onlp_snapshot_t.
+ *             If the request generation matches the current generation
+ *             the snapshot is not sent and 'size' is 0.
+ *
+ *   SUBSCRIBE The connection is kept open. The service sends a NOTIFY
+ *             reply immediately and again whenever a new generation
+ *             is published. Subscribers which do not keep up with the
+ *             notifications are disconnected.
+ *
+ * The generation changes only when the content of the snapshot changes.
+ * The reply timestamp is the (monotonic) time of the latest collection,
+ * which is updated every interval even if the content is unchanged.
+ *
+ * Client Mode
+ *
+ * When the service is reachable, libonlp serves the thermal, fan, psu
+ * and led information, the SFP presence and rx_los bitmaps and the
+ * SFP EEPROM and DOM data from the published snapshot, refreshing its
+ * copy at most once per interval. The copy is refreshed before an API
+ * call takes its locks, so a slow service never delays other callers.
+ * Anything the snapshot does not cover,
+ * and all writes, go to the platform as before. Client mode can be
+ * disabled with "telemetry": { "client": false } in the ONLP
+ * configuration file and is always disabled in the service process.
+ *
+ * Service configuration (ONLP configuration file):
+ *
+ *    "telemetry" : {
+ *        "interval" : 1000,       Collection interval (ms).
+ *        "eeprom" : true,         Collect the SFP EEPROMs.
+ *        "dom" : true             Collect the SFP DOM data.
+ *    }
+ *
+ ***********************************************************/
+#ifndef __ONLP_TELEMETRY_H__
+#define __ONLP_TELEMETRY_H__
+
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+#include <onlp/snapshot.h>
+
+#define ONLP_TELEMETRY_MAGIC    0x4F4E4C54
+#define ONLP_TELEMETRY_VERSION  1
+
+/** Telemetry operations. */
+#define ONLP_TELEMETRY_OP_GET        1
+#define ONLP_TELEMETRY_OP_SUBSCRIBE  2
+#define ONLP_TELEMETRY_OP_NOTIFY     3
+
+typedef struct onlp_telemetry_request_s {
+    /** ONLP_TELEMETRY_MAGIC */
+    uint32_t magic;
+    /** ONLP_TELEMETRY_VERSION */
+    uint32_t version;
+    /** ONLP_TELEMETRY_OP_* */
+    uint32_t op;
+    /** The generation the client already has, or 0. */
+    uint32_t generation;
+} onlp_telemetry_request_t;
+
+typedef struct onlp_telemetry_reply_s {
+    /** ONLP_TELEMETRY_MAGIC */
+    uint32_t magic;
+    /** ONLP_TELEMETRY_VERSION */
+    uint32_t version;
+    /** ONLP_TELEMETRY_OP_* */
+    uint32_t op;
+    /** ONLP_STATUS_OK or an error. */
+    int32_t status;
+    /** The current snapshot generation. */
+    uint32_t generation;
+    /** The number of snapshot bytes which follow. */
+    uint32_t size;
+    /** Monotonic time (us) of the latest collection. */
+    uint64_t timestamp;
+} onlp_telemetry_reply_t;
+
+/**
+ * @brief Start the telemetry service in this process.
+ * @note The first snapshot is collected before this returns.
+ */
+int onlp_telemetry_server_start(void);
+
+/**
+ * @brief Stop the telemetry service.
+ */
+int onlp_telemetry_server_stop(void);
+
+/**
+ * @brief Change what the telemetry service collects.
+ * @param flags ONLP_SNAPSHOT_F_EEPROM and/or ONLP_SNAPSHOT_F_DOM.
+ * @note A snapshot is collected and published immediately.
+ */
+int onlp_telemetry_server_flags_set(uint32_t flags);
+
+/**
+ * @brief Get the current snapshot from the telemetry service.
+ * @param snapshot Receives the snapshot.
+ * @param generation The generation of the snapshot already held by the
+ * caller, or 0. Receives the current generation.
+ * @returns 1 if a new snapshot was received.
+ * @returns 0 if the caller's snapshot is current.
+ * @returns ONLP_STATUS_E_MISSING if the service is not running.
+ */
+int onlp_telemetry_get(onlp_snapshot_t* snapshot, uint32_t* generation);
+
+/**
+ * @brief Subscribe to snapshot notifications.
+ * @returns A descriptor which becomes readable when a new
+ * generation is published, or an error.
+ */
+int onlp_telemetry_subscribe(void);
+
+/**
+ * @brief Read a notification from a subscription.
+ * @param fd The descriptor returned by onlp_telemetry_subscribe().
+ * @param generation Receives the new generation.
+ */
+int onlp_telemetry_notify_read(int fd, uint32_t* generation);
+
+/**
+ * @brief Enable or disable client mode in this process.
+ * @param enable Whether client mode is enabled.
+ */
+void onlp_telemetry_client_enable(int enable);
+
+/**
+ * @brief Show the state of the telemetry service and client.
+ * @param pvs The output pvs.
+ */
+void onlp_telemetry_show(aim_pvs_t* pvs);
+
+#endif /* __ONLP_TELEMETRY_H__ */
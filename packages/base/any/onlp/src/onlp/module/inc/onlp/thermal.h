@@ -115,6 +115,16 @@ int onlp_thermal_init(void);
  */
 int onlp_thermal_info_get(onlp_oid_t id, onlp_thermal_info_t* rv);
 
+/**
+ * @brief Retrieve thermal information through the information cache.
+ * @param id The thermal OID.
+ * @param rv [out] Receives the thermal information.
+ * @param max_age The maximum acceptable age of a cached result in
+ * milliseconds. Zero always queries the platform.
+ */
+int onlp_thermal_info_get_cached(onlp_oid_t id, onlp_thermal_info_t* rv,
+                                 uint32_t max_age);
+
 /**
  * @brief Retrieve the thermal's operational status.
  * @param id The thermal oid.
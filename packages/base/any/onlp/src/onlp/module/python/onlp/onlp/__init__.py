@@ -230,7 +230,7 @@ ONLP_OID_SYS = (ONLP_OID_TYPE.SYS<<24) | 1
 # XXX not a config option
 
 ONLP_OID_DESC_SIZE = 128
-ONLP_OID_TABLE_SIZE = 32
+ONLP_OID_TABLE_SIZE = 128
 # XXX not a config option
 
 class OidTableIterator(object):
@@ -636,6 +636,118 @@ def onlp_sfp_init_prototypes():
     libonlp.onlp_sfp_control_flags_get.restype = ctypes.c_int
     libonlp.onlp_sfp_control_flags_get.argtyeps = (ctypes.c_int, ctypes.POINTER(ctypes.c_uint32),)
 
+# onlp/snapshot.h
+
+ONLP_SNAPSHOT_VERSION = 2
+ONLP_SNAPSHOT_OID_MAX = 64
+ONLP_SNAPSHOT_SFP_PORTS = 256
+
+ONLP_SNAPSHOT_F_EEPROM = (1<<0)
+ONLP_SNAPSHOT_F_DOM = (1<<1)
+
+def onlp_snapshot_oid_table(infoClass):
+    """Define the snapshot table for one OID type."""
+
+    class onlp_snapshot_oid_table(ctypes.Structure):
+        _fields_ = [("count", ctypes.c_uint32,),
+                    ("status", ctypes.c_int * ONLP_SNAPSHOT_OID_MAX,),
+                    ("info", infoClass * ONLP_SNAPSHOT_OID_MAX,),]
+
+        def __len__(self):
+            return self.count
+
+        def __iter__(self):
+            """Generate (status, info) for each OID."""
+            for idx in range(self.count):
+                yield self.status[idx], self.info[idx]
+
+    return onlp_snapshot_oid_table
+
+def onlp_snapshot_words2list(words):
+    """Convert a snapshot bitmap to a list of port numbers."""
+    ports = []
+    for idx, word in enumerate(words):
+        bit = 0
+        while word:
+            if word & 1:
+                ports.append(idx*32 + bit)
+            word >>= 1
+            bit += 1
+    return ports
+
+class onlp_snapshot(ctypes.Structure):
+    """Platform snapshot, see onlp_snapshot_get().
+
+    The arrays support the buffer protocol, so e.g.
+    numpy.frombuffer(snap.eeprom, dtype=numpy.uint8).reshape(256, 256)
+    yields the EEPROM data without copying.
+    """
+
+    _fields_ = [("version", ctypes.c_uint32,),
+                ("size", ctypes.c_uint32,),
+                ("flags", ctypes.c_uint32,),
+                ("timestamp", ctypes.c_uint64,),
+                ("sys", onlp_oid_hdr,),
+                ("thermals", onlp_snapshot_oid_table(onlp_thermal_info),),
+                ("fans", onlp_snapshot_oid_table(onlp_fan_info),),
+                ("psus", onlp_snapshot_oid_table(onlp_psu_info),),
+                ("leds", onlp_snapshot_oid_table(onlp_led_info),),
+                ("presence_status", ctypes.c_int,),
+                ("ports", ctypes.c_uint32 * (ONLP_SNAPSHOT_SFP_PORTS // 32),),
+                ("presence", ctypes.c_uint32 * (ONLP_SNAPSHOT_SFP_PORTS // 32),),
+                ("rx_los_status", ctypes.c_int,),
+                ("rx_los", ctypes.c_uint32 * (ONLP_SNAPSHOT_SFP_PORTS // 32),),
+                ("eeprom_status", ctypes.c_int * ONLP_SNAPSHOT_SFP_PORTS,),
+                ("dom_status", ctypes.c_int * ONLP_SNAPSHOT_SFP_PORTS,),
+                ("eeprom", (ctypes.c_ubyte * 256) * ONLP_SNAPSHOT_SFP_PORTS,),
+                ("dom", (ctypes.c_ubyte * 256) * ONLP_SNAPSHOT_SFP_PORTS,),]
+
+    def portList(self):
+        return onlp_snapshot_words2list(self.ports)
+
+    def presentList(self):
+        return onlp_snapshot_words2list(self.presence)
+
+    def eepromData(self, port):
+        """Return the EEPROM data for a port as a string, or None."""
+        if self.eeprom_status[port] < 0:
+            return None
+        return ctypes.string_at(ctypes.addressof(self.eeprom[port]), 256)
+
+    def domData(self, port):
+        """Return the DOM data for a port as a string, or None."""
+        if self.dom_status[port] < 0:
+            return None
+        return ctypes.string_at(ctypes.addressof(self.dom[port]), 256)
+
+def onlp_snapshot_init_prototypes():
+
+    libonlp.onlp_snapshot_get.restype = ctypes.c_int
+    libonlp.onlp_snapshot_get.argtypes = (ctypes.POINTER(onlp_snapshot), ctypes.c_uint32,)
+
+def snapshot(eeprom=False, dom=False, snap=None):
+    """Collect a platform snapshot with a single library call.
+
+    Pass a previous snapshot as 'snap' to reuse its storage.
+    """
+
+    if snap is None:
+        snap = onlp_snapshot()
+    flags = 0
+    if eeprom:
+        flags |= ONLP_SNAPSHOT_F_EEPROM
+    if dom:
+        flags |= ONLP_SNAPSHOT_F_DOM
+    sts = libonlp.onlp_snapshot_get(ctypes.byref(snap), flags)
+    if sts < 0:
+        raise RuntimeError("onlp_snapshot_get failed: %s"
+                           % ONLP_STATUS.name(sts))
+    if (snap.version != ONLP_SNAPSHOT_VERSION
+        or snap.size != ctypes.sizeof(onlp_snapshot)):
+        raise AssertionError("onlp_snapshot layout changed (version %d, size %d)"
+                             % (snap.version, snap.size,))
+    return snap
+
 # onlp/onlp.h
 
 def init_prototypes():
@@ -658,5 +770,6 @@ def init_prototypes():
     onlp_psu_init_prototypes()
     sff_init_prototypes()
     onlp_sfp_init_prototypes()
+    onlp_snapshot_init_prototypes()
 
 init_prototypes()
@@ -1536,6 +1536,71 @@ class SfpTest(OnlpTestMixin,
         else:
             self.log.warn("RESET not supported by this SFP")
 
+class SnapshotTest(OnlpTestMixin,
+                   unittest.TestCase):
+    """Test interfaces in onlp/snapshot.h."""
+
+    def setUp(self):
+        OnlpTestMixin.setUp(self)
+
+        libonlp.onlp_sfp_init()
+
+    def tearDown(self):
+        OnlpTestMixin.tearDown(self)
+
+        libonlp.onlp_sfp_denit()
+
+    def testSnapshot(self):
+        """Verify that the snapshot agrees with the individual APIs."""
+
+        snap = onlp.onlp.snapshot()
+        self.assertEqual(onlp.onlp.ONLP_SNAPSHOT_VERSION, snap.version)
+        self.assertEqual(onlp.onlp.ONLP_OID_SYS, snap.sys._id)
+        self.assertEqual(0, snap.flags)
+
+        for sts, info in snap.thermals:
+            ref = onlp.onlp.onlp_thermal_info()
+            self.assertEqual(sts, libonlp.onlp_thermal_info_get(info.hdr._id, ctypes.byref(ref)))
+            self.assertEqual(ref.hdr.description, info.hdr.description)
+            self.assertEqual(ref.caps, info.caps)
+
+        for sts, info in snap.psus:
+            ref = onlp.onlp.onlp_psu_info()
+            self.assertEqual(sts, libonlp.onlp_psu_info_get(info.hdr._id, ctypes.byref(ref)))
+            self.assertEqual(ref.model, info.model)
+
+        bitmap = onlp.onlp.aim_bitmap256()
+        libonlp.onlp_sfp_bitmap_get(ctypes.byref(bitmap))
+        ports = [p for p in range(256) if onlp.onlp.aim_bitmap_get(bitmap.hdr, p)]
+        self.assertEqual(ports, snap.portList())
+
+        for port in range(256):
+            self.assertIsNone(snap.eepromData(port))
+            self.assertIsNone(snap.domData(port))
+
+    def testSnapshotEeprom(self):
+        """Verify that EEPROMs are collected for the present ports."""
+
+        snap = onlp.onlp.snapshot(eeprom=True)
+        self.assertEqual(onlp.onlp.ONLP_SNAPSHOT_F_EEPROM, snap.flags)
+        if snap.presence_status == onlp.onlp.ONLP_STATUS.E_UNSUPPORTED:
+            self.log.warn("presence bitmap not supported")
+            return
+        self.assertStatusOK(snap.presence_status)
+
+        for port in snap.presentList():
+            self.assertIn(port, snap.portList())
+            if snap.eeprom_status[port] < 0:
+                self.log.warn("port %d: eeprom read failed", port)
+                continue
+            data = snap.eepromData(port)
+            self.assertEqual(256, len(data))
+
+        # reuse the same storage
+        snap2 = onlp.onlp.snapshot(snap=snap)
+        self.assertIs(snap, snap2)
+        self.assertEqual(0, snap2.flags)
+
 if __name__ == "__main__":
     logging.basicConfig()
     unittest.main()
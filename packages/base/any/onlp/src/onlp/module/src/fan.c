@@ -26,9 +26,11 @@
 #include <onlp/platformi/fani.h>
 #include <onlp/oids.h>
 #include "onlp_int.h"
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_FAN
 #include "onlp_locks.h"
 #include "onlp_log.h"
-#include "onlp_json.h"
+#include "onlp_cache.h"
+#include "onlp_overrides.h"
 
 #define VALIDATE(_id)                           \
     do {                                        \
@@ -53,61 +55,21 @@ onlp_fan_init_locked__(void)
 ONLP_LOCKED_API0(onlp_fan_init)
 
 
-#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES == 1
-
 static int
-onlp_fani_info_from_json__(cJSON* data, onlp_fan_info_t* fip, int errorcheck)
+onlp_fan_info_get__(onlp_oid_t oid, onlp_fan_info_t* fip)
 {
     int rv;
 
-    if(data == NULL) {
-        return (errorcheck) ? ONLP_STATUS_E_PARAM : 0;
-    }
-
-    rv = cjson_util_lookup_int(data, (int*) &fip->status, "status");
-    if(rv < 0 && errorcheck) return rv;
-
-    rv = cjson_util_lookup_int(data, (int*) &fip->caps, "caps");
-    if(rv < 0 && errorcheck) return rv;
-
-    rv = cjson_util_lookup_int(data, (int*) &fip->rpm, "rpm");
-    if(rv < 0 && errorcheck) return rv;
-
-    rv = cjson_util_lookup_int(data, (int*) &fip->percentage, "percentage");
-    if(rv < 0 && errorcheck) return rv;
-
-    rv = cjson_util_lookup_int(data, (int*) &fip->mode, "mode");
-    if(rv < 0 && errorcheck) return rv;
-
-    return 0;
-}
-
-#endif
-
-static int
-onlp_fan_info_get_locked__(onlp_oid_t oid, onlp_fan_info_t* fip)
-{
-    int rv;
-
-    VALIDATE(oid);
-
     /* Get the information struct from the platform */
     rv = onlp_fani_info_get(oid, fip);
 
     if(rv >= 0) {
 
-#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES == 1
         /*
          * Optional override from the config file.
          * This is usually just for testing.
          */
-        int id = ONLP_OID_ID_GET(oid);
-        cJSON* entry = NULL;
-
-
-        cjson_util_lookup(onlp_json_get(0), &entry, "overrides.fan.%d", id);
-        onlp_fani_info_from_json__(entry, fip, 0);
-#endif
+        ONLP_OVERRIDES_APPLY(oid, fip);
 
         if(fip->percentage && fip->rpm == 0) {
             /* Approximate RPM based on a 10,000 RPM Maximum */
@@ -117,7 +79,44 @@ onlp_fan_info_get_locked__(onlp_oid_t oid, onlp_fan_info_t* fip)
 
     return rv;
 }
-ONLP_LOCKED_API2(onlp_fan_info_get, onlp_oid_t, oid, onlp_fan_info_t*, fip);
+
+static int
+onlp_fan_info_get_cached_locked__(onlp_oid_t oid, onlp_fan_info_t* fip,
+                                  uint32_t max_age)
+{
+    int rv;
+
+    VALIDATE(oid);
+
+    if(onlp_cache_get(oid, fip, sizeof(*fip), max_age)) {
+        rv = ONLP_STATUS_OK;
+    }
+    else if((rv = onlp_fan_info_get__(oid, fip)) >= 0) {
+        onlp_cache_put(oid, fip, sizeof(*fip));
+    }
+
+    if(rv >= 0) {
+        /* Cached data may have been read by another process. */
+        onlp_oid_tree_presence_observe__(oid, fip->status & ONLP_FAN_STATUS_PRESENT);
+    }
+    return rv;
+}
+ONLP_LOCKED_RAPI3(onlp_fan_info_get_cached, onlp_oid_t, oid, onlp_fan_info_t*, fip,
+                 uint32_t, max_age);
+
+static int
+onlp_fan_info_get_locked__(onlp_oid_t oid, onlp_fan_info_t* fip)
+{
+    int rv = onlp_telemetry_info_get__(oid, fip, sizeof(*fip));
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        if(rv >= 0) {
+            onlp_oid_tree_presence_observe__(oid, fip->status & ONLP_FAN_STATUS_PRESENT);
+        }
+        return rv;
+    }
+    return onlp_fan_info_get_cached_locked__(oid, fip, onlp_cache_ttl_get(oid));
+}
+ONLP_LOCKED_RAPI2(onlp_fan_info_get, onlp_oid_t, oid, onlp_fan_info_t*, fip);
 
 static int
 onlp_fan_status_get_locked__(onlp_oid_t oid, uint32_t* status)
@@ -133,7 +132,7 @@ onlp_fan_status_get_locked__(onlp_oid_t oid, uint32_t* status)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_fan_status_get, onlp_oid_t, oid, uint32_t*, status);
+ONLP_LOCKED_RAPI2(onlp_fan_status_get, onlp_oid_t, oid, uint32_t*, status);
 
 static int
 onlp_fan_hdr_get_locked__(onlp_oid_t oid, onlp_oid_hdr_t* hdr)
@@ -149,7 +148,7 @@ onlp_fan_hdr_get_locked__(onlp_oid_t oid, onlp_oid_hdr_t* hdr)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_fan_hdr_get, onlp_oid_t, oid, onlp_oid_hdr_t*, hdr);
+ONLP_LOCKED_RAPI2(onlp_fan_hdr_get, onlp_oid_t, oid, onlp_oid_hdr_t*, hdr);
 
 static int
 onlp_fan_present__(onlp_oid_t id, onlp_fan_info_t* info)
@@ -176,6 +175,18 @@ onlp_fan_present__(onlp_oid_t id, onlp_fan_info_t* info)
         }                                               \
     } while(0)
 
+/*
+ * Any successful write makes the cached information stale.
+ */
+static int
+onlp_fan_set_result__(onlp_oid_t id, int rv)
+{
+    if(rv >= 0) {
+        onlp_cache_invalidate(id);
+    }
+    return rv;
+}
+
 
 static int
 onlp_fan_rpm_set_locked__(onlp_oid_t id, int rpm)
@@ -183,7 +194,7 @@ onlp_fan_rpm_set_locked__(onlp_oid_t id, int rpm)
     onlp_fan_info_t info;
     ONLP_FAN_PRESENT_OR_RETURN(id, &info);
     if(info.caps & ONLP_FAN_CAPS_SET_RPM) {
-        return onlp_fani_rpm_set(id, rpm);
+        return onlp_fan_set_result__(id, onlp_fani_rpm_set(id, rpm));
     }
     else {
         return ONLP_STATUS_E_UNSUPPORTED;
@@ -197,7 +208,7 @@ onlp_fan_percentage_set_locked__(onlp_oid_t id, int p)
     onlp_fan_info_t info;
     ONLP_FAN_PRESENT_OR_RETURN(id, &info);
     if(info.caps & ONLP_FAN_CAPS_SET_PERCENTAGE) {
-        return onlp_fani_percentage_set(id, p);
+        return onlp_fan_set_result__(id, onlp_fani_percentage_set(id, p));
     }
     else {
         return ONLP_STATUS_E_UNSUPPORTED;
@@ -210,7 +221,7 @@ onlp_fan_mode_set_locked__(onlp_oid_t id, onlp_fan_mode_t mode)
 {
     onlp_fan_info_t info;
     ONLP_FAN_PRESENT_OR_RETURN(id, &info);
-    return onlp_fani_mode_set(id, mode);
+    return onlp_fan_set_result__(id, onlp_fani_mode_set(id, mode));
 }
 ONLP_LOCKED_API2(onlp_fan_mode_set, onlp_oid_t, id, onlp_fan_mode_t, mode);
 
@@ -221,7 +232,7 @@ onlp_fan_dir_set_locked__(onlp_oid_t id, onlp_fan_dir_t dir)
     ONLP_FAN_PRESENT_OR_RETURN(id, &info);
     if( (info.caps & ONLP_FAN_CAPS_B2F) &&
         (info.caps & ONLP_FAN_CAPS_F2B) ) {
-        return onlp_fani_dir_set(id, dir);
+        return onlp_fan_set_result__(id, onlp_fani_dir_set(id, dir));
     }
     else {
         return ONLP_STATUS_E_UNSUPPORTED;
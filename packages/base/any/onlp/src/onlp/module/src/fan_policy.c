@@ -0,0 +1,724 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * Fan Policy Engine.
+ *
+ ***********************************************************/
+#include <onlp/onlp_config.h>
+#include <onlp/fan_policy.h>
+#include <onlp/fan.h>
+#include <onlp/thermal.h>
+#include <cjson_util/cjson_util.h>
+#include <OS/os_time.h>
+#include <AIM/aim.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include "onlp_log.h"
+#include "onlp_int.h"
+#include "onlp_json.h"
+
+#define FAN_POLICY_MAX_FANS      32
+#define FAN_POLICY_MAX_THERMALS  32
+#define FAN_POLICY_MAX_GROUPS    16
+#define FAN_POLICY_MAX_STEPS     16
+
+typedef enum aggregate_e {
+    AGGREGATE_MAX,
+    AGGREGATE_MIN,
+    AGGREGATE_AVG,
+    AGGREGATE_SUM,
+} aggregate_t;
+
+static const char* aggregate_names__[] = { "max", "min", "avg", "sum" };
+
+typedef struct step_s {
+    int duty;
+    /** Move down at or below this value (mC). 0 for none. */
+    int down;
+    /** Move up at or above this value (mC). 0 for none. */
+    int up;
+} step_t;
+
+typedef struct group_s {
+    char name[32];
+
+    /** Indexes into the thermal snapshot */
+    int thermals[FAN_POLICY_MAX_THERMALS];
+    int nthermals;
+
+    aggregate_t aggregate;
+
+    /** Airflow this group applies to, or 0 for all */
+    uint32_t direction;
+
+    step_t steps[FAN_POLICY_MAX_STEPS];
+    int nsteps;
+    int step;
+
+    int pid;
+    double setpoint;
+    double kp, ki, kd;
+    double min, max;
+    double integral;
+    double last_error;
+    int primed;
+
+    /** Last evaluation */
+    int active;
+    int value;
+    int duty;
+} group_t;
+
+typedef struct policy_s {
+    int fans[FAN_POLICY_MAX_FANS];
+    int nfans;
+
+    int control[FAN_POLICY_MAX_FANS];
+    int ncontrol;
+
+    int fan_failed;
+    int fan_missing;
+    int sensor_failed;
+
+    group_t groups[FAN_POLICY_MAX_GROUPS];
+    int ngroups;
+
+    /** Thermal snapshot, one entry per referenced thermal */
+    int thermal_ids[FAN_POLICY_MAX_THERMALS];
+    int thermal_mc[FAN_POLICY_MAX_THERMALS];
+    int thermal_ok[FAN_POLICY_MAX_THERMALS];
+    int nthermals;
+
+    /** The duty cycle last written, or -1 */
+    int duty;
+    const char* reason;
+    uint64_t last_run;
+    uint64_t runs;
+    uint64_t writes;
+} policy_t;
+
+static policy_t* policy__ = NULL;
+static pthread_mutex_t policy_lock__ = PTHREAD_MUTEX_INITIALIZER;
+
+#define JSON_TYPE(_item) ((_item)->type & 0xFF)
+
+static int
+int_array_parse__(cJSON* array, int* dst, int max, const char* what)
+{
+    int i, n;
+
+    if(array == NULL || JSON_TYPE(array) != cJSON_Array) {
+        AIM_LOG_ERROR("fan policy: '%s' must be an array.", what);
+        return ONLP_STATUS_E_PARAM;
+    }
+    n = cJSON_GetArraySize(array);
+    if(n > max) {
+        AIM_LOG_ERROR("fan policy: too many entries in '%s' (%d > %d).",
+                      what, n, max);
+        return ONLP_STATUS_E_PARAM;
+    }
+    for(i = 0; i < n; i++) {
+        cJSON* item = cJSON_GetArrayItem(array, i);
+        if(JSON_TYPE(item) != cJSON_Number) {
+            AIM_LOG_ERROR("fan policy: '%s' entries must be numbers.", what);
+            return ONLP_STATUS_E_PARAM;
+        }
+        dst[i] = item->valueint;
+    }
+    return n;
+}
+
+static int
+number_get__(cJSON* obj, const char* key, double* value)
+{
+    cJSON* item = cJSON_GetObjectItem(obj, key);
+    if(item == NULL) {
+        return 0;
+    }
+    if(JSON_TYPE(item) != cJSON_Number) {
+        AIM_LOG_ERROR("fan policy: '%s' must be a number.", key);
+        return ONLP_STATUS_E_PARAM;
+    }
+    *value = item->valuedouble;
+    return 1;
+}
+
+static int
+int_get__(cJSON* obj, const char* key, int* value)
+{
+    double d;
+    int rv = number_get__(obj, key, &d);
+    if(rv > 0) {
+        *value = (int)d;
+    }
+    return rv;
+}
+
+/*
+ * Returns the snapshot index of the given thermal, adding it if necessary.
+ */
+static int
+thermal_index__(policy_t* p, int id)
+{
+    int i;
+    for(i = 0; i < p->nthermals; i++) {
+        if(p->thermal_ids[i] == id) {
+            return i;
+        }
+    }
+    if(p->nthermals == FAN_POLICY_MAX_THERMALS) {
+        AIM_LOG_ERROR("fan policy: too many thermals.");
+        return ONLP_STATUS_E_PARAM;
+    }
+    p->thermal_ids[p->nthermals] = id;
+    return p->nthermals++;
+}
+
+static int
+group_parse__(policy_t* p, group_t* g, cJSON* obj, int index)
+{
+    int i, n, rv;
+    int ids[FAN_POLICY_MAX_THERMALS];
+    cJSON* item;
+
+    if(JSON_TYPE(obj) != cJSON_Object) {
+        AIM_LOG_ERROR("fan policy: groups must be objects.");
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    item = cJSON_GetObjectItem(obj, "name");
+    if(item && JSON_TYPE(item) == cJSON_String) {
+        aim_strlcpy(g->name, item->valuestring, sizeof(g->name));
+    }
+    else {
+        snprintf(g->name, sizeof(g->name), "group%d", index);
+    }
+
+    if((n = int_array_parse__(cJSON_GetObjectItem(obj, "thermals"), ids,
+                              FAN_POLICY_MAX_THERMALS, "thermals")) <= 0) {
+        AIM_LOG_ERROR("fan policy: group %s has no thermals.", g->name);
+        return ONLP_STATUS_E_PARAM;
+    }
+    for(i = 0; i < n; i++) {
+        if((rv = thermal_index__(p, ids[i])) < 0) {
+            return rv;
+        }
+        g->thermals[g->nthermals++] = rv;
+    }
+
+    g->aggregate = AGGREGATE_MAX;
+    item = cJSON_GetObjectItem(obj, "aggregate");
+    if(item) {
+        for(i = 0; i < AIM_ARRAYSIZE(aggregate_names__); i++) {
+            if(JSON_TYPE(item) == cJSON_String &&
+               !strcmp(item->valuestring, aggregate_names__[i])) {
+                break;
+            }
+        }
+        if(i == AIM_ARRAYSIZE(aggregate_names__)) {
+            AIM_LOG_ERROR("fan policy: group %s: bad aggregate.", g->name);
+            return ONLP_STATUS_E_PARAM;
+        }
+        g->aggregate = i;
+    }
+
+    item = cJSON_GetObjectItem(obj, "direction");
+    if(item) {
+        if(JSON_TYPE(item) == cJSON_String && !strcmp(item->valuestring, "f2b")) {
+            g->direction = ONLP_FAN_STATUS_F2B;
+        }
+        else if(JSON_TYPE(item) == cJSON_String && !strcmp(item->valuestring, "b2f")) {
+            g->direction = ONLP_FAN_STATUS_B2F;
+        }
+        else {
+            AIM_LOG_ERROR("fan policy: group %s: bad direction.", g->name);
+            return ONLP_STATUS_E_PARAM;
+        }
+    }
+
+    item = cJSON_GetObjectItem(obj, "steps");
+    if(item) {
+        if(JSON_TYPE(item) != cJSON_Array ||
+           (n = cJSON_GetArraySize(item)) == 0 || n > FAN_POLICY_MAX_STEPS) {
+            AIM_LOG_ERROR("fan policy: group %s: bad steps.", g->name);
+            return ONLP_STATUS_E_PARAM;
+        }
+        for(i = 0; i < n; i++) {
+            int step[3];
+            if(int_array_parse__(cJSON_GetArrayItem(item, i), step, 3,
+                                 "steps") != 3) {
+                AIM_LOG_ERROR("fan policy: group %s: steps are [ duty, down, up ].",
+                              g->name);
+                return ONLP_STATUS_E_PARAM;
+            }
+            g->steps[i].duty = step[0];
+            g->steps[i].down = step[1];
+            g->steps[i].up = step[2];
+        }
+        g->nsteps = n;
+    }
+
+    item = cJSON_GetObjectItem(obj, "pid");
+    if(item) {
+        if(JSON_TYPE(item) != cJSON_Object ||
+           number_get__(item, "setpoint", &g->setpoint) <= 0) {
+            AIM_LOG_ERROR("fan policy: group %s: pid requires a setpoint.", g->name);
+            return ONLP_STATUS_E_PARAM;
+        }
+        g->min = 0;
+        g->max = 100;
+        if(number_get__(item, "kp", &g->kp) < 0 ||
+           number_get__(item, "ki", &g->ki) < 0 ||
+           number_get__(item, "kd", &g->kd) < 0 ||
+           number_get__(item, "min", &g->min) < 0 ||
+           number_get__(item, "max", &g->max) < 0) {
+            return ONLP_STATUS_E_PARAM;
+        }
+        g->pid = 1;
+        g->integral = g->min;
+    }
+
+    if(g->pid == (g->nsteps > 0)) {
+        AIM_LOG_ERROR("fan policy: group %s needs either steps or pid.", g->name);
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    return ONLP_STATUS_OK;
+}
+
+static int
+policy_parse__(cJSON* root, policy_t* p)
+{
+    int i, rv;
+    cJSON* item;
+
+    if(root == NULL || JSON_TYPE(root) != cJSON_Object) {
+        AIM_LOG_ERROR("fan policy: not a JSON object.");
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    p->duty = -1;
+    p->fan_failed = p->fan_missing = p->sensor_failed = 100;
+
+    if((item = cJSON_GetObjectItem(root, "fans"))) {
+        if((rv = int_array_parse__(item, p->fans, FAN_POLICY_MAX_FANS, "fans")) < 0) {
+            return rv;
+        }
+        p->nfans = rv;
+    }
+
+    if((rv = int_array_parse__(cJSON_GetObjectItem(root, "control"), p->control,
+                               FAN_POLICY_MAX_FANS, "control")) <= 0) {
+        AIM_LOG_ERROR("fan policy: no control fans.");
+        return ONLP_STATUS_E_PARAM;
+    }
+    p->ncontrol = rv;
+
+    if((item = cJSON_GetObjectItem(root, "failure"))) {
+        if(int_get__(item, "fan_failed", &p->fan_failed) < 0 ||
+           int_get__(item, "fan_missing", &p->fan_missing) < 0 ||
+           int_get__(item, "sensor_failed", &p->sensor_failed) < 0) {
+            return ONLP_STATUS_E_PARAM;
+        }
+    }
+
+    item = cJSON_GetObjectItem(root, "groups");
+    if(item == NULL || JSON_TYPE(item) != cJSON_Array ||
+       (p->ngroups = cJSON_GetArraySize(item)) == 0) {
+        AIM_LOG_ERROR("fan policy: no groups.");
+        return ONLP_STATUS_E_PARAM;
+    }
+    if(p->ngroups > FAN_POLICY_MAX_GROUPS) {
+        AIM_LOG_ERROR("fan policy: too many groups.");
+        return ONLP_STATUS_E_PARAM;
+    }
+    for(i = 0; i < p->ngroups; i++) {
+        if((rv = group_parse__(p, p->groups + i, cJSON_GetArrayItem(item, i), i)) < 0) {
+            return rv;
+        }
+    }
+    return ONLP_STATUS_OK;
+}
+
+static int
+policy_install__(cJSON* root)
+{
+    int rv;
+    policy_t* p = aim_zmalloc(sizeof(*p));
+
+    if((rv = policy_parse__(root, p)) < 0) {
+        aim_free(p);
+        return rv;
+    }
+
+    pthread_mutex_lock(&policy_lock__);
+    aim_free(policy__);
+    policy__ = p;
+    pthread_mutex_unlock(&policy_lock__);
+    return ONLP_STATUS_OK;
+}
+
+int
+onlp_fan_policy_load(const char* json)
+{
+    int rv;
+    cJSON* root = cJSON_Parse(json);
+    if(root == NULL) {
+        AIM_LOG_ERROR("fan policy: JSON parse error.");
+        return ONLP_STATUS_E_PARAM;
+    }
+    rv = policy_install__(root);
+    cJSON_Delete(root);
+    return rv;
+}
+
+int
+onlp_fan_policy_load_file(const char* fname)
+{
+    int rv;
+    cJSON* root = NULL;
+
+    if(cjson_util_parse_file(fname, &root) < 0 || root == NULL) {
+        AIM_LOG_ERROR("fan policy: could not parse %s", fname);
+        return ONLP_STATUS_E_PARAM;
+    }
+    rv = policy_install__(root);
+    cJSON_Delete(root);
+    return rv;
+}
+
+void
+onlp_fan_policy_unload(void)
+{
+    pthread_mutex_lock(&policy_lock__);
+    aim_free(policy__);
+    policy__ = NULL;
+    pthread_mutex_unlock(&policy_lock__);
+}
+
+int
+onlp_fan_policy_loaded(void)
+{
+    return policy__ != NULL;
+}
+
+/*
+ * Load the policy from the configuration file, if one is specified.
+ * Called by the platform manager at initialization.
+ */
+void
+onlp_fan_policy_config__(void)
+{
+    cJSON* item = NULL;
+
+    cjson_util_lookup(onlp_json_get(0), &item, "fan_policy");
+    if(item == NULL) {
+        return;
+    }
+    if(JSON_TYPE(item) == cJSON_String) {
+        onlp_fan_policy_load_file(item->valuestring);
+    }
+    else {
+        policy_install__(item);
+    }
+}
+
+static int
+aggregate__(policy_t* p, group_t* g, int* value)
+{
+    int i, count = 0;
+    int64_t v = 0;
+
+    for(i = 0; i < g->nthermals; i++) {
+        int t = g->thermals[i];
+        int mc = p->thermal_mc[t];
+
+        if(!p->thermal_ok[t]) {
+            continue;
+        }
+        if(count == 0) {
+            v = mc;
+        }
+        else switch(g->aggregate)
+            {
+            case AGGREGATE_MAX: if(mc > v) v = mc; break;
+            case AGGREGATE_MIN: if(mc < v) v = mc; break;
+            case AGGREGATE_AVG:
+            case AGGREGATE_SUM: v += mc; break;
+            }
+        count++;
+    }
+
+    if(count == 0) {
+        return 0;
+    }
+    if(g->aggregate == AGGREGATE_AVG) {
+        v /= count;
+    }
+    *value = (int)v;
+    return 1;
+}
+
+/*
+ * Move at most one step per evaluation.
+ *
+ * The first evaluation starts from the highest step at or below the
+ * duty cycle the fans are running at, so a restart does not drop the
+ * fans to the lowest step and walk back up.
+ */
+static int
+steps_eval__(group_t* g, int current)
+{
+    int i;
+
+    if(!g->primed) {
+        g->primed = 1;
+        for(i = 0; current >= 0 && i < g->nsteps; i++) {
+            if(g->steps[i].duty <= current) {
+                g->step = i;
+            }
+        }
+    }
+
+    if(g->step < g->nsteps - 1 && g->steps[g->step].up &&
+       g->value >= g->steps[g->step].up) {
+        g->step++;
+    }
+    else if(g->step > 0 && g->steps[g->step].down &&
+            g->value <= g->steps[g->step].down) {
+        g->step--;
+    }
+    return g->steps[g->step].duty;
+}
+
+/*
+ * Returns the duty cycle currently reported by a control fan,
+ * or -1 if it is not available.
+ */
+static int
+fan_percentage__(onlp_fan_info_t* fi)
+{
+    if(!(fi->status & ONLP_FAN_STATUS_PRESENT) ||
+       !(fi->caps & ONLP_FAN_CAPS_GET_PERCENTAGE)) {
+        return -1;
+    }
+    return fi->percentage;
+}
+
+static int
+pid_eval__(group_t* g, double dt)
+{
+    double error = (g->value - g->setpoint) / 1000.0;
+    double derivative = 0;
+    double out;
+
+    g->integral += g->ki * error * dt;
+    if(g->integral < g->min) g->integral = g->min;
+    if(g->integral > g->max) g->integral = g->max;
+
+    if(g->primed && dt > 0) {
+        derivative = (error - g->last_error) / dt;
+    }
+    g->last_error = error;
+    g->primed = 1;
+
+    out = g->kp * error + g->integral + g->kd * derivative;
+    if(out < g->min) out = g->min;
+    if(out > g->max) out = g->max;
+    return (int)(out + 0.5);
+}
+
+#define DEMAND(_duty, _reason)                  \
+    do {                                        \
+        if((_duty) > duty) {                    \
+            duty = (_duty);                     \
+            p->reason = (_reason);              \
+        }                                       \
+    } while(0)
+
+int
+onlp_fan_policy_run(void)
+{
+    int i, rv;
+    int duty = -1;
+    int current = -1;
+    uint32_t direction = 0;
+    uint64_t now = os_time_monotonic();
+    double dt;
+    policy_t* p;
+
+    pthread_mutex_lock(&policy_lock__);
+    if( (p = policy__) == NULL) {
+        pthread_mutex_unlock(&policy_lock__);
+        return ONLP_STATUS_E_UNSUPPORTED;
+    }
+
+    dt = p->last_run ? (now - p->last_run) / 1000000.0 : 0;
+    p->last_run = now;
+    p->runs++;
+
+    /* Fan snapshot and failure rules */
+    for(i = 0; i < p->nfans; i++) {
+        onlp_fan_info_t fi;
+        if(onlp_fan_info_get(ONLP_FAN_ID_CREATE(p->fans[i]), &fi) < 0) {
+            DEMAND(p->fan_failed, "fan unreadable");
+            continue;
+        }
+        if(p->ncontrol && p->fans[i] == p->control[0]) {
+            current = fan_percentage__(&fi);
+        }
+        if(!(fi.status & ONLP_FAN_STATUS_PRESENT)) {
+            DEMAND(p->fan_missing, "fan missing");
+            continue;
+        }
+        if(fi.status & ONLP_FAN_STATUS_FAILED) {
+            DEMAND(p->fan_failed, "fan failed");
+        }
+        if(direction == 0) {
+            direction = fi.status & (ONLP_FAN_STATUS_F2B | ONLP_FAN_STATUS_B2F);
+        }
+    }
+
+    if(current < 0 && p->ncontrol) {
+        /* The control fan is not part of the fan snapshot. */
+        onlp_fan_info_t fi;
+        if(onlp_fan_info_get(ONLP_FAN_ID_CREATE(p->control[0]), &fi) >= 0) {
+            current = fan_percentage__(&fi);
+        }
+    }
+
+    /* Thermal snapshot */
+    for(i = 0; i < p->nthermals; i++) {
+        onlp_thermal_info_t ti;
+        rv = onlp_thermal_info_get(ONLP_THERMAL_ID_CREATE(p->thermal_ids[i]), &ti);
+        p->thermal_ok[i] = (rv >= 0 &&
+                            (ti.status & ONLP_THERMAL_STATUS_PRESENT) &&
+                            !(ti.status & ONLP_THERMAL_STATUS_FAILED));
+        p->thermal_mc[i] = p->thermal_ok[i] ? ti.mcelsius : 0;
+    }
+
+    for(i = 0; i < p->ngroups; i++) {
+        group_t* g = p->groups + i;
+        int t;
+
+        g->active = 0;
+        if(g->direction && direction && g->direction != direction) {
+            continue;
+        }
+
+        for(t = 0; t < g->nthermals; t++) {
+            if(!p->thermal_ok[g->thermals[t]]) {
+                DEMAND(p->sensor_failed, "thermal failed");
+            }
+        }
+        if(!aggregate__(p, g, &g->value)) {
+            continue;
+        }
+
+        g->active = 1;
+        g->duty = g->pid ? pid_eval__(g, dt) : steps_eval__(g, current);
+        DEMAND(g->duty, g->name);
+    }
+
+    if(duty < 0) {
+        /* No applicable group could be evaluated. */
+        DEMAND(p->sensor_failed, "no data");
+    }
+    if(duty > 100) {
+        duty = 100;
+    }
+
+    if(current < 0) {
+        /* The hardware duty cycle is not readable. */
+        current = p->duty;
+    }
+
+    /*
+     * Compare with the hardware so that changes made outside the
+     * policy (or a CPLD reset) are corrected on the next run.
+     */
+    rv = ONLP_STATUS_OK;
+    if(duty != current) {
+        for(i = 0; i < p->ncontrol; i++) {
+            int r = onlp_fan_percentage_set(ONLP_FAN_ID_CREATE(p->control[i]), duty);
+            if(r < 0) {
+                AIM_LOG_ERROR("fan policy: setting fan %d to %d%% failed: %{onlp_status}",
+                              p->control[i], duty, r);
+                rv = r;
+            }
+        }
+        if(rv >= 0) {
+            AIM_LOG_VERBOSE("fan policy: duty cycle %d%% -> %d%% (%s)",
+                            current, duty, p->reason);
+            p->duty = duty;
+            p->writes++;
+        }
+    }
+
+    pthread_mutex_unlock(&policy_lock__);
+    return (rv < 0) ? rv : duty;
+}
+
+void
+onlp_fan_policy_show(aim_pvs_t* pvs)
+{
+    int i, t;
+    policy_t* p;
+
+    pthread_mutex_lock(&policy_lock__);
+    if( (p = policy__) == NULL) {
+        pthread_mutex_unlock(&policy_lock__);
+        aim_printf(pvs, "No fan policy is loaded.\n");
+        return;
+    }
+
+    aim_printf(pvs, "Fan policy: duty %d%% (%s), %"PRIu64" runs, %"PRIu64" writes\n",
+               p->duty, p->reason ? p->reason : "-", p->runs, p->writes);
+    for(i = 0; i < p->ngroups; i++) {
+        group_t* g = p->groups + i;
+        aim_printf(pvs, "  %-16s %-3s %s", g->name, aggregate_names__[g->aggregate],
+                   g->direction == ONLP_FAN_STATUS_F2B ? "f2b " :
+                   g->direction == ONLP_FAN_STATUS_B2F ? "b2f " : "");
+        if(!g->active) {
+            aim_printf(pvs, "inactive\n");
+            continue;
+        }
+        aim_printf(pvs, "value %d duty %d%%", g->value, g->duty);
+        if(g->pid) {
+            aim_printf(pvs, " (pid integral %.2f)", g->integral);
+        }
+        else {
+            aim_printf(pvs, " (step %d)", g->step);
+        }
+        aim_printf(pvs, "\n");
+        for(t = 0; t < g->nthermals; t++) {
+            int s = g->thermals[t];
+            aim_printf(pvs, "    thermal %d: ", p->thermal_ids[s]);
+            if(p->thermal_ok[s]) {
+                aim_printf(pvs, "%d\n", p->thermal_mc[s]);
+            }
+            else {
+                aim_printf(pvs, "failed\n");
+            }
+        }
+    }
+    pthread_mutex_unlock(&policy_lock__);
+}
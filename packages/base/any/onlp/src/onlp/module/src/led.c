@@ -27,7 +27,9 @@
 #include <onlp/led.h>
 #include <onlp/platformi/ledi.h>
 #include "onlp_int.h"
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_LED
 #include "onlp_locks.h"
+#include "onlp_cache.h"
 
 #define VALIDATE(_id)                           \
     do {                                        \
@@ -69,6 +71,18 @@ onlp_led_present__(onlp_oid_t id, onlp_led_info_t* info)
         }                                               \
     } while(0)
 
+/*
+ * Any successful write makes the cached information stale.
+ */
+static int
+onlp_led_set_result__(onlp_oid_t id, int rv)
+{
+    if(rv >= 0) {
+        onlp_cache_invalidate(id);
+    }
+    return rv;
+}
+
 static int
 onlp_led_init_locked__(void)
 {
@@ -77,12 +91,35 @@ onlp_led_init_locked__(void)
 ONLP_LOCKED_API0(onlp_led_init);
 
 static int
-onlp_led_info_get_locked__(onlp_oid_t id, onlp_led_info_t* info)
+onlp_led_info_get_cached_locked__(onlp_oid_t id, onlp_led_info_t* info,
+                                  uint32_t max_age)
 {
+    int rv;
     VALIDATE(id);
-    return onlp_ledi_info_get(id, info);
+
+    if(onlp_cache_get(id, info, sizeof(*info), max_age)) {
+        return ONLP_STATUS_OK;
+    }
+
+    rv = onlp_ledi_info_get(id, info);
+    if(rv >= 0) {
+        onlp_cache_put(id, info, sizeof(*info));
+    }
+    return rv;
+}
+ONLP_LOCKED_RAPI3(onlp_led_info_get_cached, onlp_oid_t, id, onlp_led_info_t*, info,
+                 uint32_t, max_age);
+
+static int
+onlp_led_info_get_locked__(onlp_oid_t id, onlp_led_info_t* info)
+{
+    int rv = onlp_telemetry_info_get__(id, info, sizeof(*info));
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        return rv;
+    }
+    return onlp_led_info_get_cached_locked__(id, info, onlp_cache_ttl_get(id));
 }
-ONLP_LOCKED_API2(onlp_led_info_get, onlp_oid_t, id, onlp_led_info_t*, info);
+ONLP_LOCKED_RAPI2(onlp_led_info_get, onlp_oid_t, id, onlp_led_info_t*, info);
 
 static int
 onlp_led_status_get_locked__(onlp_oid_t id, uint32_t* status)
@@ -98,7 +135,7 @@ onlp_led_status_get_locked__(onlp_oid_t id, uint32_t* status)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_led_status_get, onlp_oid_t, id, uint32_t*, status);
+ONLP_LOCKED_RAPI2(onlp_led_status_get, onlp_oid_t, id, uint32_t*, status);
 
 static int
 onlp_led_hdr_get_locked__(onlp_oid_t id, onlp_oid_hdr_t* hdr)
@@ -114,7 +151,7 @@ onlp_led_hdr_get_locked__(onlp_oid_t id, onlp_oid_hdr_t* hdr)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_led_hdr_get, onlp_oid_t, id, onlp_oid_hdr_t*, hdr);
+ONLP_LOCKED_RAPI2(onlp_led_hdr_get, onlp_oid_t, id, onlp_oid_hdr_t*, hdr);
 
 static int
 onlp_led_set_locked__(onlp_oid_t id, int on_or_off)
@@ -122,7 +159,7 @@ onlp_led_set_locked__(onlp_oid_t id, int on_or_off)
     onlp_led_info_t info;
     ONLP_LED_PRESENT_OR_RETURN(id, &info);
     if(info.caps & ONLP_LED_CAPS_ON_OFF) {
-        return onlp_ledi_set(id, on_or_off);
+        return onlp_led_set_result__(id, onlp_ledi_set(id, on_or_off));
     }
     else {
         return ONLP_STATUS_E_UNSUPPORTED;
@@ -141,7 +178,7 @@ onlp_led_mode_set_locked__(onlp_oid_t id, onlp_led_mode_t mode)
      * the capability bit positions.
      */
     if(info.caps & (1 << mode)) {
-        return onlp_ledi_mode_set(id, mode);
+        return onlp_led_set_result__(id, onlp_ledi_mode_set(id, mode));
     }
     else {
         return ONLP_STATUS_E_UNSUPPORTED;
@@ -160,7 +197,7 @@ onlp_led_char_set_locked__(onlp_oid_t id, char c)
      * the capability bit positions.
      */
     if(info.caps & ONLP_LED_CAPS_CHAR) {
-        return onlp_ledi_char_set(id, c);
+        return onlp_led_set_result__(id, onlp_ledi_char_set(id, c));
     }
     else {
         return ONLP_STATUS_E_UNSUPPORTED;
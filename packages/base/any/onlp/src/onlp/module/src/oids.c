@@ -26,8 +26,10 @@
 #include <onlp/oids.h>
 #include "onlp_log.h"
 #include "onlp_int.h"
+#include "onlp_cache.h"
 #include <AIM/aim.h>
 #include <AIM/aim_printf.h>
+#include <pthread.h>
 
 #include <onlp/thermal.h>
 #include <onlp/fan.h>
@@ -198,18 +200,14 @@ onlp_oid_hdr_get(onlp_oid_t oid, onlp_oid_hdr_t* hdr)
     return ONLP_STATUS_E_INVALID;
 }
 
-int
-onlp_oid_iterate(onlp_oid_t oid, onlp_oid_type_t type,
-                 onlp_oid_iterate_f itf, void* cookie)
+static int
+onlp_oid_iterate_uncached__(onlp_oid_t oid, onlp_oid_type_t type,
+                            onlp_oid_iterate_f itf, void* cookie)
 {
     int rv;
     onlp_oid_hdr_t hdr;
     onlp_oid_t* oidp;
 
-    if(oid == 0) {
-        oid = ONLP_OID_SYS;
-    }
-
     rv = onlp_oid_hdr_get(oid, &hdr);
     if(rv < 0) {
         return rv;
@@ -221,7 +219,219 @@ onlp_oid_iterate(onlp_oid_t oid, onlp_oid_type_t type,
             if(rv < 0) {
                 return rv;
             }
-            rv = onlp_oid_iterate(*oidp, type, itf, cookie);
+            rv = onlp_oid_iterate_uncached__(*oidp, type, itf, cookie);
+            if(rv < 0) {
+                return rv;
+            }
+        }
+    }
+    return ONLP_STATUS_OK;
+}
+
+/**
+ * OID tree cache.
+ *
+ * The headers reachable from ONLP_OID_SYS are read once and stored
+ * breadth-first, so the children of each node are contiguous.
+ * onlp_oid_iterate() walks this copy instead of asking the platform
+ * for every header on every walk.
+ *
+ * The tree is rebuilt on first use after it has been invalidated,
+ * either explicitly or because a PSU or Fan presence transition was
+ * observed. Trees are immutable and reference counted so a walk in
+ * progress is unaffected by a concurrent rebuild.
+ *
+ * A failed header read is not cached: the walk reads that node again
+ * each time, and the tree is rebuilt once the read succeeds.
+ */
+typedef struct oid_tree_node_s {
+    onlp_oid_t oid;
+    /** Status of the header read at build time. Children are only valid if >= 0. */
+    int status;
+    /** Index of the first child and the number of children. */
+    int first;
+    int count;
+} oid_tree_node_t;
+
+typedef struct oid_tree_s {
+    int refs;
+    /** The invalidation epoch this tree was built in. */
+    uint32_t epoch;
+    int count;
+    oid_tree_node_t nodes[ONLP_CONFIG_OID_TREE_MAX];
+} oid_tree_t;
+
+static pthread_mutex_t oid_tree_lock__ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t oid_tree_build_lock__ = PTHREAD_MUTEX_INITIALIZER;
+static oid_tree_t* oid_tree__ = NULL;
+/** Bumped on every invalidation. */
+static uint32_t oid_tree_epoch__ = 1;
+/** Bumped whenever a rebuilt tree differs from its predecessor. */
+static uint32_t oid_tree_generation__ = 0;
+
+/** Last observed presence of each FRU. */
+static struct {
+    onlp_oid_t oid;
+    int present;
+} oid_tree_presence__[ONLP_OID_TABLE_SIZE];
+
+/*
+ * Record the presence of each FRU as the tree is built, so that
+ * a transition before the caller's first info_get() invalidates it.
+ * The info calls record the presence themselves.
+ */
+static void
+oid_tree_presence_seed__(onlp_oid_t oid)
+{
+    if(ONLP_OID_IS_FAN(oid)) {
+        onlp_fan_info_t fi;
+        onlp_fan_info_get(oid, &fi);
+    }
+    else if(ONLP_OID_IS_PSU(oid)) {
+        onlp_psu_info_t pi;
+        onlp_psu_info_get(oid, &pi);
+    }
+}
+
+static oid_tree_t*
+oid_tree_build__(void)
+{
+    int i;
+    oid_tree_t* t = aim_zmalloc(sizeof(*t));
+
+    t->nodes[0].oid = ONLP_OID_SYS;
+    t->count = 1;
+
+    for(i = 0; i < t->count; i++) {
+        onlp_oid_hdr_t hdr;
+        onlp_oid_t* oidp;
+        oid_tree_node_t* n = t->nodes + i;
+
+        n->first = t->count;
+        n->status = onlp_oid_hdr_get(n->oid, &hdr);
+        if(n->status < 0) {
+            continue;
+        }
+        oid_tree_presence_seed__(n->oid);
+        ONLP_OID_TABLE_ITER(hdr.coids, oidp) {
+            if(t->count >= ONLP_CONFIG_OID_TREE_MAX) {
+                AIM_LOG_ERROR("The OID tree exceeds %d nodes.",
+                              ONLP_CONFIG_OID_TREE_MAX);
+                aim_free(t);
+                return NULL;
+            }
+            t->nodes[t->count++].oid = *oidp;
+        }
+        n->count = t->count - n->first;
+    }
+    return t;
+}
+
+static int
+oid_tree_differs__(oid_tree_t* a, oid_tree_t* b)
+{
+    return a->count != b->count ||
+        memcmp(a->nodes, b->nodes, sizeof(a->nodes[0]) * a->count);
+}
+
+static void
+oid_tree_unref_locked__(oid_tree_t* t)
+{
+    if(t && --t->refs == 0) {
+        aim_free(t);
+    }
+}
+
+static void
+oid_tree_release__(oid_tree_t* t)
+{
+    pthread_mutex_lock(&oid_tree_lock__);
+    oid_tree_unref_locked__(t);
+    pthread_mutex_unlock(&oid_tree_lock__);
+}
+
+/*
+ * Returns a reference to the current tree, or NULL if no
+ * valid tree could be built.
+ */
+static oid_tree_t*
+oid_tree_get_locked__(void)
+{
+    if(oid_tree__ && oid_tree__->epoch == oid_tree_epoch__) {
+        oid_tree__->refs++;
+        return oid_tree__;
+    }
+    return NULL;
+}
+
+static oid_tree_t*
+oid_tree_acquire__(void)
+{
+    oid_tree_t* t;
+    uint32_t epoch;
+
+    pthread_mutex_lock(&oid_tree_lock__);
+    t = oid_tree_get_locked__();
+    pthread_mutex_unlock(&oid_tree_lock__);
+    if(t) {
+        return t;
+    }
+
+    /* Only one thread rebuilds. The others use its result. */
+    pthread_mutex_lock(&oid_tree_build_lock__);
+
+    pthread_mutex_lock(&oid_tree_lock__);
+    t = oid_tree_get_locked__();
+    epoch = oid_tree_epoch__;
+    pthread_mutex_unlock(&oid_tree_lock__);
+
+    if(t == NULL && (t = oid_tree_build__()) != NULL) {
+        /*
+         * An invalidation during the build leaves this tree
+         * stale so it will be rebuilt on the next use.
+         */
+        t->epoch = epoch;
+        t->refs = 2;
+
+        pthread_mutex_lock(&oid_tree_lock__);
+        if(oid_tree__ == NULL || oid_tree_differs__(oid_tree__, t)) {
+            oid_tree_generation__++;
+        }
+        oid_tree_unref_locked__(oid_tree__);
+        oid_tree__ = t;
+        pthread_mutex_unlock(&oid_tree_lock__);
+    }
+
+    pthread_mutex_unlock(&oid_tree_build_lock__);
+    return t;
+}
+
+static int
+oid_tree_iterate__(oid_tree_t* t, int idx, onlp_oid_type_t type,
+                   onlp_oid_iterate_f itf, void* cookie)
+{
+    int i;
+    oid_tree_node_t* n = t->nodes + idx;
+
+    if(n->status < 0) {
+        onlp_oid_hdr_t hdr;
+        int rv = onlp_oid_hdr_get(n->oid, &hdr);
+        if(rv < 0) {
+            return rv;
+        }
+        /* Readable now. Walk it live and pick it up in the next build. */
+        onlp_oid_tree_invalidate();
+        return onlp_oid_iterate_uncached__(n->oid, type, itf, cookie);
+    }
+
+    for(i = n->first; i < n->first + n->count; i++) {
+        onlp_oid_t oid = t->nodes[i].oid;
+        if(type == 0 || ONLP_OID_IS_TYPE(type, oid)) {
+            int rv = itf(oid, cookie);
+            if(rv < 0) {
+                return rv;
+            }
+            rv = oid_tree_iterate__(t, i, type, itf, cookie);
             if(rv < 0) {
                 return rv;
             }
@@ -229,3 +439,100 @@ onlp_oid_iterate(onlp_oid_t oid, onlp_oid_type_t type,
     }
     return ONLP_STATUS_OK;
 }
+
+int
+onlp_oid_iterate(onlp_oid_t oid, onlp_oid_type_t type,
+                 onlp_oid_iterate_f itf, void* cookie)
+{
+    int i;
+    int rv = ONLP_STATUS_OK;
+    oid_tree_t* t = NULL;
+
+    if(oid == 0) {
+        oid = ONLP_OID_SYS;
+    }
+
+    if(ONLP_CONFIG_INCLUDE_OID_TREE_CACHE) {
+        t = oid_tree_acquire__();
+    }
+
+    if(t) {
+        int found = 0;
+        for(i = 0; i < t->count; i++) {
+            if(t->nodes[i].oid == oid) {
+                rv = oid_tree_iterate__(t, i, type, itf, cookie);
+                found = 1;
+                break;
+            }
+        }
+        oid_tree_release__(t);
+        if(found) {
+            return rv;
+        }
+    }
+
+    /* Not in the tree. */
+    return onlp_oid_iterate_uncached__(oid, type, itf, cookie);
+}
+
+uint32_t
+onlp_oid_tree_generation(void)
+{
+    uint32_t generation;
+    oid_tree_t* t = NULL;
+
+    if(ONLP_CONFIG_INCLUDE_OID_TREE_CACHE) {
+        t = oid_tree_acquire__();
+    }
+
+    pthread_mutex_lock(&oid_tree_lock__);
+    if(t == NULL) {
+        /* Without a cached tree every call reports a change. */
+        oid_tree_generation__++;
+    }
+    generation = oid_tree_generation__;
+    oid_tree_unref_locked__(t);
+    pthread_mutex_unlock(&oid_tree_lock__);
+    return generation;
+}
+
+void
+onlp_oid_tree_invalidate(void)
+{
+    pthread_mutex_lock(&oid_tree_lock__);
+    oid_tree_epoch__++;
+    pthread_mutex_unlock(&oid_tree_lock__);
+}
+
+void
+onlp_oid_tree_presence_observe__(onlp_oid_t oid, int present)
+{
+    int i;
+    int changed = 0;
+
+    present = present ? 1 : 0;
+
+    pthread_mutex_lock(&oid_tree_lock__);
+    for(i = 0; i < AIM_ARRAYSIZE(oid_tree_presence__); i++) {
+        if(oid_tree_presence__[i].oid == oid) {
+            if(oid_tree_presence__[i].present != present) {
+                /* FRU insertion or removal. The tree may have changed. */
+                oid_tree_presence__[i].present = present;
+                oid_tree_epoch__++;
+                changed = 1;
+            }
+            break;
+        }
+        if(oid_tree_presence__[i].oid == 0) {
+            oid_tree_presence__[i].oid = oid;
+            oid_tree_presence__[i].present = present;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&oid_tree_lock__);
+
+    if(changed) {
+        /* Cached information about the FRU and its children is stale. */
+        onlp_cache_invalidate(0);
+    }
+}
@@ -35,6 +35,8 @@
 #include "onlp_int.h"
 #include "onlp_json.h"
 #include "onlp_locks.h"
+#include "onlp_cache.h"
+#include "onlp_overrides.h"
 
 int
 onlp_init(void)
@@ -54,6 +56,9 @@ onlp_init(void)
 
 
     onlp_json_init(cfile);
+    onlp_overrides_init(cfile);
+    onlp_telemetry_init__();
+    onlp_cache_init();
     onlp_sys_init();
     onlp_sfp_init();
     onlp_led_init();
@@ -70,6 +75,8 @@ onlp_denit(void)
     onlp_api_lock_denit();
 #endif
 
+    onlp_overrides_denit();
+    onlp_cache_denit();
     onlp_json_denit();
 
     return 0;
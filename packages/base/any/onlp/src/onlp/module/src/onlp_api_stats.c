@@ -0,0 +1,337 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * ONLP API Statistics.
+ *
+ * The statistics table lives in a shared memory segment so all
+ * ONLP clients on the system contribute to (and can read) the same
+ * counters. Entries are claimed by name with compare-and-swap and
+ * all counters are updated with atomic operations; no locks are
+ * taken on the API path.
+ *
+ ***********************************************************/
+#include <onlp/onlp_config.h>
+#include <onlp/api_stats.h>
+#include <onlplib/shlocks.h>
+#include <AIM/aim.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include "onlp_locks.h"
+#include "onlp_log.h"
+
+#if ONLP_CONFIG_INCLUDE_API_STATS == 1
+
+#define ONLP_API_STATS_SHM_KEY 0xF00DF200
+#define ONLP_API_STATS_MAGIC   0x41504953
+
+/**
+ * Entry states.
+ * A claimed entry records the claimer's pid so that an entry
+ * abandoned by a process which died during the claim can be reclaimed.
+ */
+#define ENTRY_FREE     0
+#define ENTRY_READY    2
+#define ENTRY_CLAIMED_FLAG 0x80000000
+#define ENTRY_CLAIMED(_pid) (ENTRY_CLAIMED_FLAG | (uint32_t)(_pid))
+#define ENTRY_CLAIMER(_state) ((pid_t)((_state) & ~ENTRY_CLAIMED_FLAG))
+
+struct onlp_api_stats_entry_s {
+    uint32_t state;
+    onlp_api_stats_t stats;
+};
+
+typedef struct stats_table_s {
+    uint32_t magic;
+    uint32_t size;
+    struct onlp_api_stats_entry_s entries[ONLP_CONFIG_API_STATS_MAX];
+} stats_table_t;
+
+static stats_table_t* table__ = NULL;
+static pthread_once_t table_once__ = PTHREAD_ONCE_INIT;
+
+static void
+table_init__(void)
+{
+    void* p = NULL;
+    int rv = onlp_shmem_create(ONLP_API_STATS_SHM_KEY, sizeof(stats_table_t), &p);
+    if(rv < 0 || p == NULL) {
+        AIM_LOG_ERROR("API statistics are not available.");
+        return;
+    }
+    if(rv == 1) {
+        ((stats_table_t*)p)->size = ONLP_CONFIG_API_STATS_MAX;
+        ((stats_table_t*)p)->magic = ONLP_API_STATS_MAGIC;
+    }
+    else if(((stats_table_t*)p)->magic == ONLP_API_STATS_MAGIC &&
+            ((stats_table_t*)p)->size != ONLP_CONFIG_API_STATS_MAX) {
+        AIM_LOG_ERROR("API statistics table size mismatch (%d != %d).",
+                      ((stats_table_t*)p)->size, ONLP_CONFIG_API_STATS_MAX);
+        return;
+    }
+    table__ = (stats_table_t*)p;
+}
+
+static stats_table_t*
+table_get__(void)
+{
+    pthread_once(&table_once__, table_init__);
+    return table__;
+}
+
+onlp_api_stats_entry_t*
+onlp_api_stats_entry__(const char* name)
+{
+    int i;
+    stats_table_t* t = table_get__();
+
+    if(t == NULL) {
+        return NULL;
+    }
+
+    for(i = 0; i < ONLP_CONFIG_API_STATS_MAX; i++) {
+        onlp_api_stats_entry_t* e = t->entries + i;
+        uint32_t state;
+
+        while((state = e->state) != ENTRY_READY) {
+            if(state == ENTRY_FREE) {
+                if(__sync_bool_compare_and_swap(&e->state, ENTRY_FREE,
+                                                ENTRY_CLAIMED(getpid()))) {
+                    aim_strlcpy(e->stats.name, name, sizeof(e->stats.name));
+                    __sync_synchronize();
+                    e->state = ENTRY_READY;
+                    return e;
+                }
+            }
+            else if(kill(ENTRY_CLAIMER(state), 0) < 0 && errno == ESRCH) {
+                /* The claimer died before publishing the entry. */
+                __sync_bool_compare_and_swap(&e->state, state, ENTRY_FREE);
+            }
+            else {
+                /* Wait for a concurrent claim to complete. */
+                sched_yield();
+            }
+        }
+
+        if(!strcmp(e->stats.name, name)) {
+            return e;
+        }
+    }
+
+    AIM_LOG_ERROR("API statistics table is full (%s)", name);
+    return NULL;
+}
+
+static int
+bucket__(uint64_t us)
+{
+    int b = us ? 64 - __builtin_clzll(us) : 0;
+    return (b < ONLP_API_STATS_BUCKETS) ? b : ONLP_API_STATS_BUCKETS - 1;
+}
+
+static void
+max__(uint64_t* dst, uint64_t value)
+{
+    uint64_t current;
+    while(value > (current = *dst)) {
+        if(__sync_bool_compare_and_swap(dst, current, value)) {
+            break;
+        }
+    }
+}
+
+void
+onlp_api_stats_update__(onlp_api_stats_entry_t* e, int rv,
+                        uint64_t ltime, uint64_t ftime)
+{
+    if(e == NULL) {
+        return;
+    }
+    __sync_fetch_and_add(&e->stats.calls, 1);
+    if(rv < 0 && rv != ONLP_STATUS_E_UNSUPPORTED) {
+        __sync_fetch_and_add(&e->stats.errors, 1);
+    }
+    __sync_fetch_and_add(&e->stats.lock_total, ltime);
+    __sync_fetch_and_add(&e->stats.func_total, ftime);
+    __sync_fetch_and_add(&e->stats.lock_hist[bucket__(ltime)], 1);
+    __sync_fetch_and_add(&e->stats.func_hist[bucket__(ftime)], 1);
+    max__(&e->stats.lock_max, ltime);
+    max__(&e->stats.func_max, ftime);
+}
+
+int
+onlp_api_stats_get(onlp_api_stats_t* stats, int max)
+{
+    int i;
+    int count = 0;
+    stats_table_t* t = table_get__();
+
+    if(stats == NULL || max < 0) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    if(t == NULL) {
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    for(i = 0; i < ONLP_CONFIG_API_STATS_MAX && count < max; i++) {
+        if(t->entries[i].state == ENTRY_READY) {
+            ONLP_MEMCPY(stats + count, &t->entries[i].stats, sizeof(*stats));
+            count++;
+        }
+    }
+    return count;
+}
+
+int
+onlp_api_stats_reset(void)
+{
+    int i, b;
+    stats_table_t* t = table_get__();
+
+    if(t == NULL) {
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    for(i = 0; i < ONLP_CONFIG_API_STATS_MAX; i++) {
+        onlp_api_stats_t* s = &t->entries[i].stats;
+        if(t->entries[i].state != ENTRY_READY) {
+            continue;
+        }
+        __sync_lock_test_and_set(&s->calls, 0);
+        __sync_lock_test_and_set(&s->errors, 0);
+        __sync_lock_test_and_set(&s->lock_total, 0);
+        __sync_lock_test_and_set(&s->lock_max, 0);
+        __sync_lock_test_and_set(&s->func_total, 0);
+        __sync_lock_test_and_set(&s->func_max, 0);
+        for(b = 0; b < ONLP_API_STATS_BUCKETS; b++) {
+            __sync_lock_test_and_set(&s->lock_hist[b], 0);
+            __sync_lock_test_and_set(&s->func_hist[b], 0);
+        }
+    }
+    return ONLP_STATUS_OK;
+}
+
+/*
+ * Estimate a percentile from a histogram.
+ * Returns the upper bound (us) of the bucket containing it.
+ */
+static uint64_t
+percentile__(uint64_t* hist, uint64_t calls, int pct)
+{
+    int b;
+    uint64_t sum = 0;
+    uint64_t target = (calls * pct + 99) / 100;
+
+    for(b = 0; b < ONLP_API_STATS_BUCKETS; b++) {
+        sum += hist[b];
+        if(sum >= target) {
+            break;
+        }
+    }
+    return (uint64_t)1 << ((b < ONLP_API_STATS_BUCKETS) ? b : ONLP_API_STATS_BUCKETS-1);
+}
+
+static void
+histogram_show__(aim_pvs_t* pvs, const char* title, uint64_t* hist)
+{
+    int b;
+    aim_printf(pvs, "    %s:", title);
+    for(b = 0; b < ONLP_API_STATS_BUCKETS; b++) {
+        if(hist[b]) {
+            aim_printf(pvs, " <%"PRIu64"us:%"PRIu64, (uint64_t)1 << b, hist[b]);
+        }
+    }
+    aim_printf(pvs, "\n");
+}
+
+void
+onlp_api_stats_show(aim_pvs_t* pvs, int histograms)
+{
+    int i, count;
+    onlp_api_stats_t* stats;
+
+    stats = aim_zmalloc(sizeof(*stats) * ONLP_CONFIG_API_STATS_MAX);
+    count = onlp_api_stats_get(stats, ONLP_CONFIG_API_STATS_MAX);
+    if(count < 0) {
+        aim_printf(pvs, "API statistics are not available: %{onlp_status}\n", count);
+        aim_free(stats);
+        return;
+    }
+
+    aim_printf(pvs, "%-36s %10s %8s %9s %9s %9s %9s %9s\n",
+               "API", "Calls", "Errors", "lock-avg", "lock-max",
+               "func-avg", "func-p99", "func-max");
+
+    for(i = 0; i < count; i++) {
+        onlp_api_stats_t* s = stats + i;
+        if(s->calls == 0) {
+            continue;
+        }
+        aim_printf(pvs, "%-36s %10"PRIu64" %8"PRIu64" %9"PRIu64" %9"PRIu64" %9"PRIu64" %9"PRIu64" %9"PRIu64"\n",
+                   s->name, s->calls, s->errors,
+                   s->lock_total / s->calls, s->lock_max,
+                   s->func_total / s->calls,
+                   percentile__(s->func_hist, s->calls, 99),
+                   s->func_max);
+        if(histograms) {
+            histogram_show__(pvs, "lock", s->lock_hist);
+            histogram_show__(pvs, "func", s->func_hist);
+        }
+    }
+    aim_free(stats);
+}
+
+#else
+
+onlp_api_stats_entry_t*
+onlp_api_stats_entry__(const char* name)
+{
+    return NULL;
+}
+
+void
+onlp_api_stats_update__(onlp_api_stats_entry_t* e, int rv,
+                        uint64_t ltime, uint64_t ftime)
+{
+}
+
+int
+onlp_api_stats_get(onlp_api_stats_t* stats, int max)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_api_stats_reset(void)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+void
+onlp_api_stats_show(aim_pvs_t* pvs, int histograms)
+{
+    aim_printf(pvs, "API statistics are not available in this build.\n");
+}
+
+#endif /* ONLP_CONFIG_INCLUDE_API_STATS */
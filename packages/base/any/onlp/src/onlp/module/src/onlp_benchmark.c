@@ -0,0 +1,396 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * ONLP API latency benchmark.
+ *
+ * Every OID and SFP API is called repeatedly and the latency
+ * distribution is reported per API, along with the average time
+ * spent waiting for the API lock and in the API itself.
+ *
+ * Multiple processes may be run concurrently to measure contention.
+ * Each child process returns its samples to the parent over a pipe.
+ *
+ ***********************************************************/
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+#include <onlp/oids.h>
+#include <onlp/fan.h>
+#include <onlp/thermal.h>
+#include <onlp/psu.h>
+#include <onlp/led.h>
+#include <onlp/sfp.h>
+#include <AIM/aim.h>
+#include <AIM/aim_time.h>
+#include "onlp_int.h"
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include "onlp_locks.h"
+#include "onlp_log.h"
+
+typedef enum bench_api_e {
+    BENCH_API_OID_HDR_GET,
+    BENCH_API_FAN_INFO_GET,
+    BENCH_API_FAN_STATUS_GET,
+    BENCH_API_THERMAL_INFO_GET,
+    BENCH_API_THERMAL_STATUS_GET,
+    BENCH_API_PSU_INFO_GET,
+    BENCH_API_PSU_STATUS_GET,
+    BENCH_API_LED_INFO_GET,
+    BENCH_API_LED_STATUS_GET,
+    BENCH_API_SFP_PRESENCE_BITMAP_GET,
+    BENCH_API_SFP_EEPROM_READ,
+    BENCH_API_SFP_DOM_READ,
+    BENCH_API_COUNT,
+} bench_api_t;
+
+static const char* bench_api_names__[] = {
+    "onlp_oid_hdr_get",
+    "onlp_fan_info_get",
+    "onlp_fan_status_get",
+    "onlp_thermal_info_get",
+    "onlp_thermal_status_get",
+    "onlp_psu_info_get",
+    "onlp_psu_status_get",
+    "onlp_led_info_get",
+    "onlp_led_status_get",
+    "onlp_sfp_presence_bitmap_get",
+    "onlp_sfp_eeprom_read",
+    "onlp_sfp_dom_read",
+};
+
+/**
+ * A single API call.
+ */
+typedef struct bench_sample_s {
+    uint16_t api;
+    uint16_t error;
+    /** Total, lock wait, and function time (us) */
+    uint32_t total;
+    uint32_t ltime;
+    uint32_t ftime;
+} bench_sample_t;
+
+typedef struct bench_s {
+    onlp_oid_t oids[1024];
+    int oid_count;
+
+    bench_sample_t* samples;
+    int count;
+    /** Maximum samples recorded by one process */
+    int size;
+    /** Total samples for all processes */
+    int capacity;
+} bench_t;
+
+static int
+bench_collect__(onlp_oid_t oid, void* cookie)
+{
+    bench_t* b = (bench_t*)cookie;
+    if(b->oid_count < AIM_ARRAYSIZE(b->oids)) {
+        b->oids[b->oid_count++] = oid;
+    }
+    return 0;
+}
+
+static void
+bench_record__(bench_t* b, int api, int rv, uint64_t t0)
+{
+    uint64_t ltime, ftime;
+    bench_sample_t* s;
+
+    if(b->count == b->size) {
+        return;
+    }
+    s = b->samples + b->count++;
+    s->api = api;
+    s->error = (rv < 0);
+    s->total = aim_time_monotonic() - t0;
+    onlp_api_timing_last(&ltime, &ftime);
+    s->ltime = ltime;
+    s->ftime = ftime;
+}
+
+#define BENCH_CALL(_b, _api, _call)                     \
+    do {                                                \
+        uint64_t _t0 = aim_time_monotonic();            \
+        int _rv = _call;                                \
+        bench_record__(_b, _api, _rv, _t0);             \
+    } while(0)
+
+static void
+bench_run__(bench_t* b, int loops)
+{
+    int i, l;
+
+    for(l = 0; l < loops; l++) {
+        for(i = 0; i < b->oid_count; i++) {
+            onlp_oid_t oid = b->oids[i];
+            onlp_oid_hdr_t hdr;
+            uint32_t status;
+
+            BENCH_CALL(b, BENCH_API_OID_HDR_GET, onlp_oid_hdr_get(oid, &hdr));
+
+            switch(ONLP_OID_TYPE_GET(oid))
+                {
+                case ONLP_OID_TYPE_FAN:
+                    {
+                        onlp_fan_info_t fi;
+                        BENCH_CALL(b, BENCH_API_FAN_INFO_GET, onlp_fan_info_get(oid, &fi));
+                        BENCH_CALL(b, BENCH_API_FAN_STATUS_GET, onlp_fan_status_get(oid, &status));
+                        break;
+                    }
+                case ONLP_OID_TYPE_THERMAL:
+                    {
+                        onlp_thermal_info_t ti;
+                        BENCH_CALL(b, BENCH_API_THERMAL_INFO_GET, onlp_thermal_info_get(oid, &ti));
+                        BENCH_CALL(b, BENCH_API_THERMAL_STATUS_GET, onlp_thermal_status_get(oid, &status));
+                        break;
+                    }
+                case ONLP_OID_TYPE_PSU:
+                    {
+                        onlp_psu_info_t pi;
+                        BENCH_CALL(b, BENCH_API_PSU_INFO_GET, onlp_psu_info_get(oid, &pi));
+                        BENCH_CALL(b, BENCH_API_PSU_STATUS_GET, onlp_psu_status_get(oid, &status));
+                        break;
+                    }
+                case ONLP_OID_TYPE_LED:
+                    {
+                        onlp_led_info_t li;
+                        BENCH_CALL(b, BENCH_API_LED_INFO_GET, onlp_led_info_get(oid, &li));
+                        BENCH_CALL(b, BENCH_API_LED_STATUS_GET, onlp_led_status_get(oid, &status));
+                        break;
+                    }
+                default:
+                    break;
+                }
+        }
+
+        {
+            int p;
+            onlp_sfp_bitmap_t present;
+            onlp_sfp_bitmap_t_init(&present);
+            BENCH_CALL(b, BENCH_API_SFP_PRESENCE_BITMAP_GET,
+                       onlp_sfp_presence_bitmap_get(&present));
+
+            AIM_BITMAP_ITER(&present, p) {
+                uint8_t* data = NULL;
+                BENCH_CALL(b, BENCH_API_SFP_EEPROM_READ, onlp_sfp_eeprom_read(p, &data));
+                aim_free(data);
+                data = NULL;
+                BENCH_CALL(b, BENCH_API_SFP_DOM_READ, onlp_sfp_dom_read(p, &data));
+                aim_free(data);
+            }
+        }
+    }
+}
+
+static int
+bench_u32_compare__(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void
+bench_report__(aim_pvs_t* pvs, bench_sample_t* samples, int count)
+{
+    int api, i;
+    uint32_t* totals = aim_zmalloc(sizeof(uint32_t) * (count + 1));
+
+    aim_printf(pvs, "%-30s %8s %6s %9s %9s %9s %9s %9s\n",
+               "API", "Calls", "Errors", "p50(us)", "p99(us)", "max(us)",
+               "lock(us)", "func(us)");
+
+    for(api = 0; api < BENCH_API_COUNT; api++) {
+        int n = 0;
+        int errors = 0;
+        uint64_t lsum = 0, fsum = 0;
+
+        for(i = 0; i < count; i++) {
+            if(samples[i].api == api) {
+                totals[n++] = samples[i].total;
+                errors += samples[i].error;
+                lsum += samples[i].ltime;
+                fsum += samples[i].ftime;
+            }
+        }
+        if(n == 0) {
+            continue;
+        }
+
+        qsort(totals, n, sizeof(uint32_t), bench_u32_compare__);
+        aim_printf(pvs, "%-30s %8d %6d %9u %9u %9u %9"PRIu64" %9"PRIu64"\n",
+                   bench_api_names__[api], n, errors,
+                   totals[(n-1)*50/100], totals[(n-1)*99/100], totals[n-1],
+                   lsum / n, fsum / n);
+    }
+
+    aim_free(totals);
+}
+
+static int
+bench_write__(int fd, void* data, int len)
+{
+    uint8_t* p = data;
+    while(len > 0) {
+        int rv = write(fd, p, len);
+        if(rv < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += rv;
+        len -= rv;
+    }
+    return 0;
+}
+
+static int
+bench_read__(int fd, void* data, int len)
+{
+    uint8_t* p = data;
+    while(len > 0) {
+        int rv = read(fd, p, len);
+        if(rv < 0 && errno == EINTR) {
+            continue;
+        }
+        if(rv <= 0) {
+            return -1;
+        }
+        p += rv;
+        len -= rv;
+    }
+    return 0;
+}
+
+int
+onlp_benchmark(aim_pvs_t* pvs, int loops, int procs)
+{
+    int p;
+    int ports;
+    int go[2];
+    int fds[64];
+    pid_t pids[64];
+    uint64_t t0, t1;
+    bench_t* b;
+    onlp_sfp_bitmap_t bmap;
+
+    if(loops <= 0 || procs <= 0 || procs > AIM_ARRAYSIZE(pids)) {
+        aim_printf(pvs, "Invalid benchmark parameters.\n");
+        return 1;
+    }
+
+#if ONLP_CONFIG_INCLUDE_API_TIMING == 0 && ONLP_CONFIG_INCLUDE_API_PROFILING == 0
+    aim_printf(pvs, "API timing is not available in this build. Lock and function times are not reported.\n");
+#endif
+
+    b = aim_zmalloc(sizeof(*b));
+    onlp_oid_iterate(ONLP_OID_SYS, 0, bench_collect__, b);
+
+    onlp_sfp_bitmap_t_init(&bmap);
+    onlp_sfp_bitmap_get(&bmap);
+    ports = AIM_BITMAP_COUNT(&bmap);
+
+    /* Upper bound on the number of calls made by one process. */
+    b->size = loops * (b->oid_count * 3 + 1 + ports * 2);
+    b->capacity = b->size * procs;
+    b->samples = aim_zmalloc(sizeof(bench_sample_t) * (b->capacity + 1));
+
+    if(pipe(go) < 0) {
+        AIM_LOG_ERROR("pipe: %{errno}", errno);
+        return 1;
+    }
+
+    for(p = 1; p < procs; p++) {
+        int fd[2];
+        if(pipe(fd) < 0) {
+            AIM_LOG_ERROR("pipe: %{errno}", errno);
+            break;
+        }
+        pids[p] = fork();
+        if(pids[p] < 0) {
+            AIM_LOG_ERROR("fork: %{errno}", errno);
+            close(fd[0]);
+            close(fd[1]);
+            break;
+        }
+        if(pids[p] == 0) {
+            char c;
+            /* Child: wait for the start signal, run, and return the samples. */
+            close(fd[0]);
+            close(go[1]);
+            if(read(go[0], &c, 1) < 0) {
+                /* Closed by the parent. */
+            }
+            onlp_api_timing_enable(1);
+            bench_run__(b, loops);
+            if(bench_write__(fd[1], &b->count, sizeof(b->count)) < 0 ||
+               bench_write__(fd[1], b->samples, sizeof(bench_sample_t) * b->count) < 0) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        close(fd[1]);
+        fds[p] = fd[0];
+    }
+    procs = p;
+
+    aim_printf(pvs, "Benchmark: %d OIDs, %d SFP ports, %d loops, %d process(es)\n",
+               b->oid_count, ports, loops, procs);
+
+    /* Start all processes. The parent is also a worker. */
+    close(go[0]);
+    close(go[1]);
+
+    onlp_api_timing_enable(1);
+    t0 = aim_time_monotonic();
+    bench_run__(b, loops);
+    onlp_api_timing_enable(0);
+
+    for(p = 1; p < procs; p++) {
+        int count = 0;
+        if(bench_read__(fds[p], &count, sizeof(count)) == 0 &&
+           count > 0 && b->count + count <= b->capacity) {
+            if(bench_read__(fds[p], b->samples + b->count,
+                            sizeof(bench_sample_t) * count) == 0) {
+                b->count += count;
+            }
+        }
+        else {
+            aim_printf(pvs, "Process %d: no results.\n", (int)pids[p]);
+        }
+        close(fds[p]);
+        waitpid(pids[p], NULL, 0);
+    }
+    t1 = aim_time_monotonic();
+
+    aim_printf(pvs, "Elapsed: %"PRIu64".%03"PRIu64" seconds\n\n",
+               (t1-t0) / 1000000, ((t1-t0) / 1000) % 1000);
+    bench_report__(pvs, b->samples, b->count);
+
+    aim_free(b->samples);
+    aim_free(b);
+    return 0;
+}
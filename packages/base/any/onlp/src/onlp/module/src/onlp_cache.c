@@ -0,0 +1,353 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * OID Information Cache.
+ *
+ ***********************************************************/
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+#include <onlp/oids.h>
+#include <AIM/aim.h>
+#include <AIM/aim_time.h>
+#include <onlp/thermal.h>
+#include <onlp/fan.h>
+#include <onlp/psu.h>
+#include <onlp/led.h>
+#include <onlplib/shlocks.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include "onlp_cache.h"
+#include "onlp_json.h"
+#include "onlp_log.h"
+
+#if ONLP_CONFIG_INCLUDE_API_CACHE == 1
+
+/**
+ * The cache lives in a shared memory segment so all ONLP clients
+ * on the system (onlpd, the SNMP agent, the CLI tools) share the
+ * same entries. Each entry is protected by a sequence counter:
+ * writers make it odd while they update the entry and readers retry
+ * or miss if it changed while they copied it. No locks are taken.
+ */
+
+#define ONLP_CACHE_SHM_KEY 0xF00DF300
+#define ONLP_CACHE_MAGIC   0x4F434348
+
+/** The largest cached information structure. */
+typedef union onlp_cache_data_u {
+    onlp_thermal_info_t thermal;
+    onlp_fan_info_t fan;
+    onlp_psu_info_t psu;
+    onlp_led_info_t led;
+} onlp_cache_data_t;
+
+/**
+ * A single cached information structure.
+ */
+typedef struct onlp_cache_entry_s {
+    /** Odd while an update is in progress. */
+    volatile uint32_t seq;
+
+    /**
+     * The process performing the update, zero if none. This is the
+     * update lock itself, so a locked entry always names its owner.
+     */
+    volatile pid_t writer;
+
+    /** Monotonic time of the last update. Zero if invalid. */
+    uint64_t updated;
+
+    /** The size of the cached data. */
+    int size;
+
+    /** The cached data. */
+    uint8_t data[sizeof(onlp_cache_data_t)];
+
+} onlp_cache_entry_t;
+
+/** The cached OID types. */
+#define ONLP_CACHE_TYPE_COUNT 4
+
+typedef struct onlp_cache_table_s {
+    uint32_t magic;
+    uint32_t id_max;
+    uint32_t data_max;
+    onlp_cache_entry_t entries[ONLP_CACHE_TYPE_COUNT][ONLP_CONFIG_API_CACHE_ID_MAX + 1];
+} onlp_cache_table_t;
+
+static onlp_cache_table_t* table__ = NULL;
+static pthread_once_t table_once__ = PTHREAD_ONCE_INIT;
+
+/** Lifetimes in milliseconds, indexed by OID type. */
+static uint32_t ttl__[ONLP_OID_TYPE_RTC + 1];
+
+static void
+table_init__(void)
+{
+    void* p = NULL;
+    int rv = onlp_shmem_create(ONLP_CACHE_SHM_KEY, sizeof(onlp_cache_table_t), &p);
+    onlp_cache_table_t* t = p;
+
+    if(rv == 1) {
+        t->id_max = ONLP_CONFIG_API_CACHE_ID_MAX;
+        t->data_max = sizeof(onlp_cache_data_t);
+        __sync_synchronize();
+        t->magic = ONLP_CACHE_MAGIC;
+    }
+    else if(rv < 0 || t == NULL ||
+            (t->magic == ONLP_CACHE_MAGIC &&
+             (t->id_max != ONLP_CONFIG_API_CACHE_ID_MAX ||
+              t->data_max != sizeof(onlp_cache_data_t)))) {
+        /* Not shareable. Cache for this process only. */
+        AIM_LOG_VERBOSE("The shared OID cache is not available. Using a private cache.");
+        t = aim_zmalloc(sizeof(*t));
+        t->magic = ONLP_CACHE_MAGIC;
+    }
+    table__ = t;
+}
+
+static onlp_cache_entry_t*
+entry_get__(onlp_oid_t oid)
+{
+    int type;
+    int id = ONLP_OID_ID_GET(oid);
+
+    switch(ONLP_OID_TYPE_GET(oid))
+        {
+        case ONLP_OID_TYPE_THERMAL: type = 0; break;
+        case ONLP_OID_TYPE_FAN: type = 1; break;
+        case ONLP_OID_TYPE_PSU: type = 2; break;
+        case ONLP_OID_TYPE_LED: type = 3; break;
+        default: return NULL;
+        }
+
+    if(id > ONLP_CONFIG_API_CACHE_ID_MAX) {
+        return NULL;
+    }
+
+    pthread_once(&table_once__, table_init__);
+    return &table__->entries[type][id];
+}
+
+/*
+ * Start an update. The lock is taken by swapping our pid into
+ * 'writer'. The lock of a process which no longer exists is taken
+ * over, discarding any update it left in progress.
+ */
+static int
+entry_lock__(onlp_cache_entry_t* e)
+{
+    int i;
+    pid_t pid = getpid();
+
+    for(i = 0; i < 1000; i++) {
+        pid_t writer = e->writer;
+        if(writer == 0 ||
+           (kill(writer, 0) < 0 && errno == ESRCH)) {
+            if(__sync_bool_compare_and_swap(&e->writer, writer, pid)) {
+                if(e->seq & 1) {
+                    /* The previous writer died during its update. */
+                    e->updated = 0;
+                }
+                else {
+                    __sync_fetch_and_add(&e->seq, 1);
+                }
+                __sync_synchronize();
+                return 1;
+            }
+            continue;
+        }
+        sched_yield();
+    }
+    return 0;
+}
+
+static void
+entry_unlock__(onlp_cache_entry_t* e)
+{
+    __sync_synchronize();
+    __sync_fetch_and_add(&e->seq, 1);
+    __sync_synchronize();
+    e->writer = 0;
+}
+
+void
+onlp_cache_init(void)
+{
+    static const struct {
+        onlp_oid_type_t type;
+        const char* name;
+    } types[] = {
+        { ONLP_OID_TYPE_THERMAL, "thermal" },
+        { ONLP_OID_TYPE_FAN, "fan" },
+        { ONLP_OID_TYPE_PSU, "psu" },
+        { ONLP_OID_TYPE_LED, "led" },
+    };
+
+    int i;
+    int ttl = ONLP_CONFIG_API_CACHE_TTL_DEFAULT;
+    cJSON* cfg = onlp_json_get(0);
+
+    cjson_util_lookup_int(cfg, &ttl, "cache.ttl.default");
+    for(i = 0; i < AIM_ARRAYSIZE(ttl__); i++) {
+        ttl__[i] = (ttl > 0) ? ttl : 0;
+    }
+
+    for(i = 0; i < AIM_ARRAYSIZE(types); i++) {
+        int v;
+        if(cjson_util_lookup_int(cfg, &v, "cache.ttl.%s", types[i].name) >= 0) {
+            ttl__[types[i].type] = (v > 0) ? v : 0;
+        }
+    }
+}
+
+void
+onlp_cache_denit(void)
+{
+    /* The entries are shared with other processes. */
+}
+
+uint32_t
+onlp_cache_ttl_get(onlp_oid_t oid)
+{
+    int type = ONLP_OID_TYPE_GET(oid);
+    return (type > 0 && type < AIM_ARRAYSIZE(ttl__)) ? ttl__[type] : 0;
+}
+
+int
+onlp_cache_get(onlp_oid_t oid, void* data, int size, uint32_t max_age)
+{
+    uint32_t seq;
+    uint64_t updated;
+    onlp_cache_entry_t* e;
+
+    if(max_age == 0 || size > sizeof(onlp_cache_data_t) ||
+       (e = entry_get__(oid)) == NULL) {
+        return 0;
+    }
+
+    seq = e->seq;
+    __sync_synchronize();
+    if((seq & 1) || e->size != size || (updated = e->updated) == 0) {
+        return 0;
+    }
+    ONLP_MEMCPY(data, e->data, size);
+    __sync_synchronize();
+    if(e->seq != seq) {
+        return 0;
+    }
+
+    return (aim_time_monotonic() - updated <= (uint64_t)max_age * 1000);
+}
+
+void
+onlp_cache_put(onlp_oid_t oid, const void* data, int size)
+{
+    onlp_cache_entry_t* e;
+
+    if(size > sizeof(onlp_cache_data_t) ||
+       (e = entry_get__(oid)) == NULL || !entry_lock__(e)) {
+        return;
+    }
+    e->size = size;
+    ONLP_MEMCPY(e->data, data, size);
+    e->updated = aim_time_monotonic();
+    entry_unlock__(e);
+}
+
+static void
+entry_invalidate__(onlp_cache_entry_t* e)
+{
+    if(e->updated && entry_lock__(e)) {
+        e->updated = 0;
+        entry_unlock__(e);
+    }
+}
+
+void
+onlp_cache_invalidate(onlp_oid_t oid)
+{
+    int type, id;
+
+    if(oid == 0) {
+        pthread_once(&table_once__, table_init__);
+        for(type = 0; type < ONLP_CACHE_TYPE_COUNT; type++) {
+            for(id = 0; id <= ONLP_CONFIG_API_CACHE_ID_MAX; id++) {
+                entry_invalidate__(&table__->entries[type][id]);
+            }
+        }
+    }
+    else {
+        onlp_cache_entry_t* e = entry_get__(oid);
+        if(e) {
+            entry_invalidate__(e);
+        }
+    }
+}
+
+#else
+
+void
+onlp_cache_init(void)
+{
+}
+
+void
+onlp_cache_denit(void)
+{
+}
+
+uint32_t
+onlp_cache_ttl_get(onlp_oid_t oid)
+{
+    return 0;
+}
+
+int
+onlp_cache_get(onlp_oid_t oid, void* data, int size, uint32_t max_age)
+{
+    return 0;
+}
+
+void
+onlp_cache_put(onlp_oid_t oid, const void* data, int size)
+{
+}
+
+void
+onlp_cache_invalidate(onlp_oid_t oid)
+{
+}
+
+#endif /* ONLP_CONFIG_INCLUDE_API_CACHE */
+
+int
+onlp_oid_cache_invalidate(onlp_oid_t oid)
+{
+    onlp_cache_invalidate(oid);
+    if(oid == 0) {
+        onlp_oid_tree_invalidate();
+    }
+    return ONLP_STATUS_OK;
+}
@@ -0,0 +1,100 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ * OID Information Cache.
+ *
+ ***********************************************************/
+#ifndef __ONLP_CACHE_H__
+#define __ONLP_CACHE_H__
+
+#include <onlp/onlp_config.h>
+#include <onlp/oids.h>
+
+/**
+ * The OID information cache.
+ *
+ * The *_info_get() entry points for Fans, Thermals, PSUs, and LEDs
+ * consult this cache before calling the platform driver. Entries
+ * are stored per OID and expire after a per-OID-type lifetime which
+ * can be specified in the ONLP configuration file:
+ *
+ *    "cache" : {
+ *        "ttl" : {
+ *            "default" : 0,
+ *            "fan" : 2000,
+ *            "thermal" : 2000,
+ *            "psu" : 5000,
+ *            "led" : 1000
+ *        }
+ *    }
+ *
+ * All lifetimes are in milliseconds. A lifetime of zero disables caching
+ * for that OID type.
+ *
+ * The entries are kept in shared memory so information read by one
+ * process is used by all of them. Each process applies its own
+ * lifetimes. All entries are invalidated when a FRU is inserted or
+ * removed.
+ */
+
+/**
+ * @brief Initialize the OID cache from the current ONLP configuration.
+ */
+void onlp_cache_init(void);
+
+/**
+ * @brief Release all OID cache resources.
+ */
+void onlp_cache_denit(void);
+
+/**
+ * @brief Get the configured cache lifetime for the given OID.
+ * @param oid The OID.
+ * @returns The lifetime in milliseconds.
+ */
+uint32_t onlp_cache_ttl_get(onlp_oid_t oid);
+
+/**
+ * @brief Retrieve cached information for the given OID.
+ * @param oid The OID.
+ * @param data [out] Receives the cached information.
+ * @param size The size of the information structure.
+ * @param max_age The maximum acceptable age of the data in milliseconds.
+ * @returns 1 if the data was retrieved from the cache.
+ * @returns 0 if the data is not available or is too old.
+ */
+int onlp_cache_get(onlp_oid_t oid, void* data, int size, uint32_t max_age);
+
+/**
+ * @brief Update the cached information for the given OID.
+ * @param oid The OID.
+ * @param data The information structure.
+ * @param size The size of the information structure.
+ */
+void onlp_cache_put(onlp_oid_t oid, const void* data, int size);
+
+/**
+ * @brief Invalidate the cached information for the given OID.
+ * @param oid The OID. All entries are invalidated if the OID is zero.
+ */
+void onlp_cache_invalidate(onlp_oid_t oid);
+
+#endif /* __ONLP_CACHE_H__ */
@@ -95,6 +95,11 @@ onlp_config_settings_t onlp_config_settings[] =
 #else
 { ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES(__onlp_config_STRINGIFY_NAME), "__undefined__" },
 #endif
+#ifdef ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD) },
+#else
+{ ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
 #ifdef ONLP_CONFIG_CONFIGURATION_FILENAME
     { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_CONFIGURATION_FILENAME), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_CONFIGURATION_FILENAME) },
 #else
@@ -120,6 +125,16 @@ onlp_config_settings_t onlp_config_settings[] =
 #else
 { ONLP_CONFIG_API_LOCK_TIMEOUT(__onlp_config_STRINGIFY_NAME), "__undefined__" },
 #endif
+#ifdef ONLP_CONFIG_API_LOCK_DOMAINS
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_API_LOCK_DOMAINS), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_API_LOCK_DOMAINS) },
+#else
+{ ONLP_CONFIG_API_LOCK_DOMAINS(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS) },
+#else
+{ ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
 #ifdef ONLP_CONFIG_INFO_STR_MAX
     { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INFO_STR_MAX), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INFO_STR_MAX) },
 #else
@@ -134,6 +149,91 @@ onlp_config_settings_t onlp_config_settings[] =
     { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_API_PROFILING), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_API_PROFILING) },
 #else
 { ONLP_CONFIG_INCLUDE_API_PROFILING(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_API_TIMING
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_API_TIMING), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_API_TIMING) },
+#else
+{ ONLP_CONFIG_INCLUDE_API_TIMING(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_API_STATS
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_API_STATS), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_API_STATS) },
+#else
+{ ONLP_CONFIG_INCLUDE_API_STATS(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_API_STATS_MAX
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_API_STATS_MAX), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_API_STATS_MAX) },
+#else
+{ ONLP_CONFIG_API_STATS_MAX(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_API_CACHE
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_API_CACHE), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_API_CACHE) },
+#else
+{ ONLP_CONFIG_INCLUDE_API_CACHE(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_API_CACHE_TTL_DEFAULT
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_API_CACHE_TTL_DEFAULT), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_API_CACHE_TTL_DEFAULT) },
+#else
+{ ONLP_CONFIG_API_CACHE_TTL_DEFAULT(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_API_CACHE_ID_MAX
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_API_CACHE_ID_MAX), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_API_CACHE_ID_MAX) },
+#else
+{ ONLP_CONFIG_API_CACHE_ID_MAX(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_OID_TREE_CACHE
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_OID_TREE_CACHE), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_OID_TREE_CACHE) },
+#else
+{ ONLP_CONFIG_INCLUDE_OID_TREE_CACHE(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_OID_TREE_MAX
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_OID_TREE_MAX), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_OID_TREE_MAX) },
+#else
+{ ONLP_CONFIG_OID_TREE_MAX(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_SFP_BULK_THREADS_MAX
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_SFP_BULK_THREADS_MAX), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_SFP_BULK_THREADS_MAX) },
+#else
+{ ONLP_CONFIG_SFP_BULK_THREADS_MAX(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE) },
+#else
+{ ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL) },
+#else
+{ ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_SFP_PRESENCE_POLL_MS
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_SFP_PRESENCE_POLL_MS), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_SFP_PRESENCE_POLL_MS) },
+#else
+{ ONLP_CONFIG_SFP_PRESENCE_POLL_MS(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_TELEMETRY
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_TELEMETRY), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_TELEMETRY) },
+#else
+{ ONLP_CONFIG_INCLUDE_TELEMETRY(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_TELEMETRY_SOCKET
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_TELEMETRY_SOCKET), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_TELEMETRY_SOCKET) },
+#else
+{ ONLP_CONFIG_TELEMETRY_SOCKET(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_TELEMETRY_INTERVAL_MS
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_TELEMETRY_INTERVAL_MS), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_TELEMETRY_INTERVAL_MS) },
+#else
+{ ONLP_CONFIG_TELEMETRY_INTERVAL_MS(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_INCLUDE_ONIE_CACHE
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_INCLUDE_ONIE_CACHE), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_INCLUDE_ONIE_CACHE) },
+#else
+{ ONLP_CONFIG_INCLUDE_ONIE_CACHE(__onlp_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLP_CONFIG_ONIE_CACHE_FILENAME
+    { __onlp_config_STRINGIFY_NAME(ONLP_CONFIG_ONIE_CACHE_FILENAME), __onlp_config_STRINGIFY_VALUE(ONLP_CONFIG_ONIE_CACHE_FILENAME) },
+#else
+{ ONLP_CONFIG_ONIE_CACHE_FILENAME(__onlp_config_STRINGIFY_NAME), "__undefined__" },
 #endif
     { NULL, NULL }
 };
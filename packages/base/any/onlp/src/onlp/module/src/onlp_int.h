@@ -29,6 +29,7 @@
 #include <onlp/onlp.h>
 #include <IOF/iof.h>
 #include <onlp/oids.h>
+#include <onlp/sfp.h>
 #include <cjson/cJSON.h>
 #include "onlp_json.h"
 
@@ -44,4 +45,29 @@ void onlp_oid_show_description(iof_t* iof, onlp_oid_hdr_t* hdr);
 /** Standard message when an OID is missing. */
 void onlp_oid_show_state_missing(iof_t* iof);
 
+/** Record the presence of a FRU. Transitions invalidate the OID tree. */
+void onlp_oid_tree_presence_observe__(onlp_oid_t oid, int present);
+
+/** Load the fan policy from the configuration file, if present. */
+void onlp_fan_policy_config__(void);
+
+/** Read the telemetry client configuration. */
+void onlp_telemetry_init__(void);
+
+/**
+ * Telemetry client mode. These return ONLP_STATUS_E_UNSUPPORTED
+ * when the request cannot be served from the telemetry snapshot
+ * and the caller must go to the platform.
+ */
+int onlp_telemetry_info_get__(onlp_oid_t oid, void* info, int size);
+
+#define ONLP_TELEMETRY_SFP_PRESENCE 0
+#define ONLP_TELEMETRY_SFP_RX_LOS   1
+int onlp_telemetry_sfp_bitmap_get__(int which, onlp_sfp_bitmap_t* dst);
+
+int onlp_telemetry_sfp_data_get__(int port, int dom, uint8_t* data);
+
+/** Run the API benchmark (onlpdump -B). */
+int onlp_benchmark(aim_pvs_t* pvs, int loops, int procs);
+
 #endif /* __ONLP_INT_H__ */
@@ -24,11 +24,162 @@
  ***********************************************************/
 #include <onlp/onlp_config.h>
 #include <onlp/onlp.h>
+#include <onlp/platformi/sysi.h>
 #include "onlp_locks.h"
 
 #if ONLP_CONFIG_INCLUDE_API_LOCK == 1
 
-#if ONLP_CONFIG_API_LOCK_GLOBAL_SHARED == 0
+#if ONLP_CONFIG_API_LOCK_DOMAINS == 1
+
+#include <onlplib/shlocks.h>
+
+/**
+ * Each lock domain is a shared memory reader/writer lock.
+ * Non-global domains are always taken while holding the
+ * global domain for reading.
+ *
+ * Platform drivers commonly share I2C mux state and static buffers
+ * across FRU types, so by default every domain maps to the GLOBAL
+ * domain and reads are exclusive. A platform opts in to per-domain
+ * concurrency and shared reads with onlp_sysi_api_lock_flags_get().
+ */
+#define ONLP_API_LOCK_DOMAIN_KEY(_domain) (0xF00DF100 + (_domain))
+
+static const char* domain_names__[ONLP_API_LOCK_DOMAIN_COUNT] = {
+    "global",
+    "sys",
+    "fan",
+    "thermal",
+    "psu",
+    "led",
+    "sfp",
+};
+
+static onlp_shrwlock_t* domains__[ONLP_API_LOCK_DOMAIN_COUNT];
+
+/** ONLP_SYSI_API_LOCK_F_* reported by the platform. */
+static uint32_t flags__ = 0;
+
+/**
+ * The number of holds of each domain by the calling thread. A domain
+ * is only taken by the outermost hold. Re-taking a writer-preferring
+ * lock the thread already holds (shared or not) would deadlock as
+ * soon as another writer is waiting.
+ */
+static __thread uint16_t held__[ONLP_API_LOCK_DOMAIN_COUNT];
+
+/**
+ * The domain each of the calling thread's nested API calls locked,
+ * so the release matches the acquire even if the platform flags
+ * change in between.
+ */
+#define LOCK_STACK_MAX__ 32
+static __thread uint8_t stack__[LOCK_STACK_MAX__];
+static __thread int stack_depth__;
+
+void
+onlp_api_lock_init(void)
+{
+    int d;
+    for(d = 0; d < ONLP_API_LOCK_DOMAIN_COUNT; d++) {
+        if(domains__[d] == NULL) {
+            onlp_shrwlock_create(ONLP_API_LOCK_DOMAIN_KEY(d), domains__ + d,
+                                 "onlp-%s-lock", domain_names__[d]);
+        }
+    }
+}
+
+void
+onlp_api_lock_denit(void)
+{
+    /* The shared memory segments persist. */
+}
+
+void
+onlp_api_lock_flags_set__(uint32_t flags)
+{
+#if ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS == 0
+    flags &= ~ONLP_SYSI_API_LOCK_F_SHARED_READS;
+#endif
+    if(flags != flags__) {
+        AIM_LOG_VERBOSE("API lock domains %s, shared reads %s.",
+                        (flags & ONLP_SYSI_API_LOCK_F_DOMAINS) ? "enabled" : "disabled",
+                        (flags & ONLP_SYSI_API_LOCK_F_SHARED_READS) ? "enabled" : "disabled");
+    }
+    flags__ = flags;
+}
+
+static void
+domain_take__(int domain, int shared, const char* api)
+{
+    int rv;
+
+    if(held__[domain]++) {
+        /* Already held by this thread. */
+        return;
+    }
+
+    if(shared) {
+        rv = onlp_shrwlock_rdlock(domains__[domain], ONLP_CONFIG_API_LOCK_TIMEOUT);
+    }
+    else {
+        rv = onlp_shrwlock_wrlock(domains__[domain], ONLP_CONFIG_API_LOCK_TIMEOUT, api);
+    }
+
+    if(rv < 0) {
+        AIM_DIE("The ONLP %s API lock in %s could not be acquired after %d microseconds. Its last exclusive owner was a call to %s. This is considered fatal.",
+                domain_names__[domain], api, ONLP_CONFIG_API_LOCK_TIMEOUT,
+                onlp_shrwlock_owner(domains__[domain]));
+    }
+}
+
+static void
+domain_give__(int domain)
+{
+    if(held__[domain] && --held__[domain] == 0) {
+        onlp_shrwlock_unlock(domains__[domain]);
+    }
+}
+
+void
+onlp_api_lock(int domain, int shared, const char* api)
+{
+    if(domains__[ONLP_API_LOCK_DOMAIN_GLOBAL] == NULL) {
+        onlp_api_lock_init();
+    }
+
+    if(!(flags__ & ONLP_SYSI_API_LOCK_F_SHARED_READS)) {
+        shared = 0;
+    }
+    if(!(flags__ & ONLP_SYSI_API_LOCK_F_DOMAINS)) {
+        domain = ONLP_API_LOCK_DOMAIN_GLOBAL;
+    }
+
+    if(domain != ONLP_API_LOCK_DOMAIN_GLOBAL) {
+        domain_take__(ONLP_API_LOCK_DOMAIN_GLOBAL, 1, api);
+    }
+    domain_take__(domain, shared, api);
+
+    if(stack_depth__ == LOCK_STACK_MAX__) {
+        AIM_DIE("ONLP API calls are nested too deeply in %s.", api);
+    }
+    stack__[stack_depth__++] = domain;
+}
+
+void
+onlp_api_unlock(int domain, int shared)
+{
+    if(stack_depth__ == 0) {
+        return;
+    }
+    domain = stack__[--stack_depth__];
+    domain_give__(domain);
+    if(domain != ONLP_API_LOCK_DOMAIN_GLOBAL) {
+        domain_give__(ONLP_API_LOCK_DOMAIN_GLOBAL);
+    }
+}
+
+#elif ONLP_CONFIG_API_LOCK_GLOBAL_SHARED == 0
 
 #include <OS/os_sem.h>
 
@@ -52,7 +203,13 @@ onlp_api_lock_denit(void)
 }
 
 void
-onlp_api_lock(const char* api)
+onlp_api_lock_flags_set__(uint32_t flags)
+{
+    /* There is only one lock. */
+}
+
+void
+onlp_api_lock(int domain, int shared, const char* api)
 {
     if(os_sem_take_timeout(api_sem__, ONLP_CONFIG_API_LOCK_TIMEOUT) != 0) {
         AIM_DIE("The ONLP API lock in %s could not be acquired after %d microseconds. It appears to be currently owned by call to %s. This is considered fatal.",
@@ -62,7 +219,7 @@ onlp_api_lock(const char* api)
 }
 
 void
-onlp_api_unlock(void)
+onlp_api_unlock(int domain, int shared)
 {
     os_sem_give(api_sem__);
 }
@@ -84,12 +241,18 @@ onlp_api_lock_denit(void)
 }
 
 void
-onlp_api_lock(const char* api)
+onlp_api_lock_flags_set__(uint32_t flags)
+{
+    /* There is only one lock. */
+}
+
+void
+onlp_api_lock(int domain, int shared, const char* api)
 {
     onlp_shlock_global_take();
 }
 void
-onlp_api_unlock(void)
+onlp_api_unlock(int domain, int shared)
 {
     onlp_shlock_global_give();
 }
@@ -97,6 +260,46 @@ onlp_api_unlock(void)
 #endif
 
 
+/* API nesting depth (see ONLP_API_ENTER__). */
+__thread int onlp_api_depth__ = 0;
+
+/*
+ * Runtime API timing.
+ *
+ * The last call timing is per thread so that calls made by
+ * background threads do not replace the caller's values.
+ */
+int onlp_api_timing_enabled__ = 0;
+static __thread uint64_t timing_ltime__;
+static __thread uint64_t timing_ftime__;
+static __thread int timing_valid__;
+
+void
+onlp_api_timing_enable(int enable)
+{
+    onlp_api_timing_enabled__ = enable;
+    timing_valid__ = 0;
+}
+
+void
+onlp_api_timing_record__(uint64_t ltime, uint64_t ftime)
+{
+    timing_ltime__ = ltime;
+    timing_ftime__ = ftime;
+    timing_valid__ = 1;
+}
+
+int
+onlp_api_timing_last(uint64_t* ltime, uint64_t* ftime)
+{
+    int rv = timing_valid__;
+    *ltime = rv ? timing_ltime__ : 0;
+    *ftime = rv ? timing_ftime__ : 0;
+    timing_valid__ = 0;
+    return rv;
+}
+
+
 /*
  * This function will perform a sanity test on the API locking implementation.
  */
@@ -27,6 +27,38 @@
 
 #include <onlp/onlp_config.h>
 
+/**
+ * API lock domains.
+ *
+ * When ONLP_CONFIG_API_LOCK_DOMAINS is enabled and the platform opts
+ * in (onlp_sysi_api_lock_flags_get()) each subsystem is protected by
+ * its own shared reader/writer lock so independent subsystems can be
+ * accessed concurrently. Every domain lock is taken under a shared
+ * hold of the GLOBAL domain, so exclusive GLOBAL calls still
+ * serialize against everything.
+ *
+ * Otherwise all domains map to the single platform-wide API lock.
+ * A thread never re-takes a domain it already holds.
+ */
+typedef enum onlp_api_lock_domain_e {
+    ONLP_API_LOCK_DOMAIN_GLOBAL,
+    ONLP_API_LOCK_DOMAIN_SYS,
+    ONLP_API_LOCK_DOMAIN_FAN,
+    ONLP_API_LOCK_DOMAIN_THERMAL,
+    ONLP_API_LOCK_DOMAIN_PSU,
+    ONLP_API_LOCK_DOMAIN_LED,
+    ONLP_API_LOCK_DOMAIN_SFP,
+    ONLP_API_LOCK_DOMAIN_COUNT,
+} onlp_api_lock_domain_t;
+
+/**
+ * Source files define ONLP_API_LOCK_DOMAIN to select the domain
+ * used by the ONLP_LOCKED_API macros below.
+ */
+#ifndef ONLP_API_LOCK_DOMAIN
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_GLOBAL
+#endif
+
 #if ONLP_CONFIG_INCLUDE_API_LOCK == 1
 
 /**
@@ -37,24 +69,34 @@ void onlp_api_lock_denit();
 
 /**
  * @brief Take the ONLP API lock.
+ * @param domain The lock domain.
+ * @param shared Take the domain lock for reading only.
+ * @param api The calling API (for diagnostics).
  */
-void onlp_api_lock(const char* api);
+void onlp_api_lock(int domain, int shared, const char* api);
 
 /**
  * @brief Give the ONLP API lock.
+ * @param domain The lock domain.
+ * @param shared Must match the value given to onlp_api_lock().
+ */
+void onlp_api_unlock(int domain, int shared);
+
+/**
+ * @brief Apply the platform's ONLP_SYSI_API_LOCK_F_* flags.
  */
-void onlp_api_unlock(void);
+void onlp_api_lock_flags_set__(uint32_t flags);
 
 
 #define ONLP_API_LOCK_INIT() onlp_api_lock_init()
-#define ONLP_API_LOCK(_api)      onlp_api_lock(_api)
-#define ONLP_API_UNLOCK()    onlp_api_unlock()
+#define ONLP_API_LOCK(_domain, _shared, _api) onlp_api_lock(_domain, _shared, _api)
+#define ONLP_API_UNLOCK(_domain, _shared)     onlp_api_unlock(_domain, _shared)
 
 #else
 
 #define ONLP_API_LOCK_INIT()
-#define ONLP_API_LOCK(_api)
-#define ONLP_API_UNLOCK()
+#define ONLP_API_LOCK(_domain, _shared, _api)
+#define ONLP_API_UNLOCK(_domain, _shared)
 
 #endif /** ONLP_CONFIG_INCLUDE_API_LOCK */
 
@@ -64,6 +106,12 @@ void onlp_api_unlock(void);
  * These macros are used the instantiate the public (and potentially locked)
  * ONLP API entry points.
  *
+ * ONLP_LOCKED_API*   Exclusive access to the file's lock domain.
+ * ONLP_LOCKED_RAPI*  Shared (read) access to the file's lock domain.
+ *                    Exclusive unless ONLP_CONFIG_API_LOCK_DOMAINS_SHARED_READS
+ *                    is enabled for the platform.
+ * ONLP_LOCKED_DAPI*  Explicit domain and access mode.
+ *
  ***************************************************************************/
 #include <inttypes.h>
 #include <AIM/aim_time.h>
@@ -71,7 +119,75 @@ void onlp_api_unlock(void);
 
 #define ONLP_LOCKED_API_NAME(_name) _name##_locked__
 
+/**
+ * Runtime API timing.
+ *
+ * When enabled, each locked API call records the time spent
+ * waiting for the API lock and the time spent in the call itself.
+ * The values for the most recently completed call in the calling
+ * thread can then be retrieved with onlp_api_timing_last().
+ */
+extern int onlp_api_timing_enabled__;
+
+/**
+ * @brief Enable or disable runtime API timing.
+ */
+void onlp_api_timing_enable(int enable);
+
+/**
+ * @brief Record the timing of a completed API call.
+ */
+void onlp_api_timing_record__(uint64_t ltime, uint64_t ftime);
+
+/**
+ * @brief Get the timing of the last completed API call.
+ * @param [out] ltime Receives the lock wait time (us).
+ * @param [out] ftime Receives the function time (us).
+ * @returns 1 if timing is available, 0 if not.
+ */
+int onlp_api_timing_last(uint64_t* ltime, uint64_t* ftime);
+
+/**
+ * API statistics (onlp_api_stats.c).
+ *
+ * Each API entry point resolves its shared memory statistics
+ * entry on first use and updates it on every call.
+ */
+typedef struct onlp_api_stats_entry_s onlp_api_stats_entry_t;
+
+/**
+ * @brief Get (or create) the statistics entry for the given API.
+ * @returns NULL if statistics are not available.
+ */
+onlp_api_stats_entry_t* onlp_api_stats_entry__(const char* name);
+
+/**
+ * @brief Update the statistics for a completed API call.
+ */
+void onlp_api_stats_update__(onlp_api_stats_entry_t* entry, int rv,
+                             uint64_t ltime, uint64_t ftime);
+
+#if ONLP_CONFIG_INCLUDE_API_STATS == 1
+#define ONLP_API_STATS__(_name, _rv, _ltime, _ftime)                    \
+    do {                                                                \
+        static onlp_api_stats_entry_t* _se = NULL;                      \
+        if(_se == NULL) {                                               \
+            _se = onlp_api_stats_entry__(#_name);                       \
+        }                                                               \
+        onlp_api_stats_update__(_se, _rv, _ltime, _ftime);              \
+    } while(0)
+#else
+#define ONLP_API_STATS__(_name, _rv, _ltime, _ftime)
+#endif
+
 #if ONLP_CONFIG_INCLUDE_API_PROFILING == 1
+#define ONLP_API_PROFILE__(_name, _t0, _t1, _t2)                         \
+    AIM_LOG_MSG("API '%s' : (total=%"PRId64", ltime=%"PRId64" ftime=%"PRId64")", #_name, _t2-_t0, _t1-_t0, _t2-_t1)
+#else
+#define ONLP_API_PROFILE__(_name, _t0, _t1, _t2)
+#endif
+
+#if ONLP_CONFIG_INCLUDE_API_STATS == 1 || ONLP_CONFIG_INCLUDE_API_PROFILING == 1
 
 #define ONLP_API_T0(_name)                              \
     uint64_t t0, t1, t2; t0 = aim_time_monotonic()
@@ -79,159 +195,193 @@ void onlp_api_unlock(void);
 #define ONLP_API_T1(_name)                      \
     t1 = aim_time_monotonic();
 
-#define ONLP_API_T2(_name)                                              \
+#define ONLP_API_T2(_name, _rv)                                         \
     do {                                                                \
         t2 = aim_time_monotonic();                                      \
-        AIM_LOG_MSG("API '%s' : (total=%"PRId64", ltime=%"PRId64" ftime=%"PRId64")", #_name, t2-t0, t1-t0, t2-t1); \
+        ONLP_API_STATS__(_name, _rv, t1-t0, t2-t1);                     \
+        if(onlp_api_timing_enabled__) {                                 \
+            onlp_api_timing_record__(t1-t0, t2-t1);                     \
+        }                                                               \
+        ONLP_API_PROFILE__(_name, t0, t1, t2);                          \
+    } while(0)
+
+#elif ONLP_CONFIG_INCLUDE_API_TIMING == 1
+
+#define ONLP_API_T0(_name)                                      \
+    uint64_t t0 = 0, t1 = 0;                                    \
+    if(onlp_api_timing_enabled__) { t0 = aim_time_monotonic(); }
+
+#define ONLP_API_T1(_name)                      \
+    if(t0) { t1 = aim_time_monotonic(); }
+
+#define ONLP_API_T2(_name, _rv)                                         \
+    do {                                                                \
+        if(t0) {                                                        \
+            onlp_api_timing_record__(t1-t0, aim_time_monotonic()-t1);   \
+        }                                                               \
     } while(0)
 
 #else
 
 #define ONLP_API_T0(_name)
 #define ONLP_API_T1(_name)
-#define ONLP_API_T2(_name)
+#define ONLP_API_T2(_name, _rv)
 
 #endif
 
-#define ONLP_LOCKED_API0(_name)                            \
-    int _name (void)                                       \
-    {                                                      \
-        ONLP_API_T0(_name);                                \
-        ONLP_API_LOCK(#_name);                             \
-        ONLP_API_T1(_name);                                \
-        int _rv = ONLP_LOCKED_API_NAME(_name)();           \
-        ONLP_API_UNLOCK();                                 \
-        ONLP_API_T2(_name);                                \
-        return _rv;                                        \
-    }
+/**
+ * API nesting depth in the calling thread.
+ *
+ * Work which may block on another process (refreshing the telemetry
+ * client snapshot) is done before the outermost API call takes its
+ * lock, never while API locks are held.
+ */
+extern __thread int onlp_api_depth__;
+
+/**
+ * @brief Refresh the telemetry client snapshot if it is due (telemetry.c).
+ */
+void onlp_telemetry_refresh__(void);
 
-#define ONLP_LOCKED_API1(_name, _t, _v)                         \
-    int _name (_t _v)                                           \
+#define ONLP_API_ENTER__()                              \
+    do {                                                \
+        if(onlp_api_depth__++ == 0) {                   \
+            onlp_telemetry_refresh__();                 \
+        }                                               \
+    } while(0)
+
+#define ONLP_API_EXIT__() onlp_api_depth__--
+
+#define ONLP_LOCKED_API_BODY__(_domain, _shared, _name, _call)  \
     {                                                           \
+        ONLP_API_ENTER__();                                     \
         ONLP_API_T0(_name);                                     \
-        ONLP_API_LOCK(#_name);                                  \
+        ONLP_API_LOCK(_domain, _shared, #_name);                \
         ONLP_API_T1(_name);                                     \
-        int _rv = ONLP_LOCKED_API_NAME(_name)(_v);              \
-        ONLP_API_UNLOCK();                                      \
-        ONLP_API_T2(_name);                                     \
+        int _rv = _call;                                        \
+        ONLP_API_UNLOCK(_domain, _shared);                      \
+        ONLP_API_T2(_name, _rv);                                \
+        ONLP_API_EXIT__();                                      \
         return _rv;                                             \
     }
 
-#define ONLP_LOCKED_API2(_name, _t1, _v1, _t2, _v2)                     \
-    int _name (_t1 _v1, _t2 _v2)                                        \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        int _rv = ONLP_LOCKED_API_NAME(_name) (_v1, _v2);               \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(_name);                                             \
-        return _rv;                                                     \
-    }
-
-#define ONLP_LOCKED_API3(_name, _t1, _v1, _t2, _v2, _t3, _v3)           \
-    int _name (_t1 _v1, _t2 _v2, _t3 _v3)                               \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        int _rv = ONLP_LOCKED_API_NAME(_name) (_v1, _v2, _v3);          \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(_name);                                             \
-        return _rv;                                                     \
+#define ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name, _call) \
+    {                                                           \
+        ONLP_API_ENTER__();                                     \
+        ONLP_API_T0(_name);                                     \
+        ONLP_API_LOCK(_domain, _shared, #_name);                \
+        ONLP_API_T1(_name);                                     \
+        _call;                                                  \
+        ONLP_API_UNLOCK(_domain, _shared);                      \
+        ONLP_API_T2(_name, 0);                                  \
+        ONLP_API_EXIT__();                                      \
     }
 
-#define ONLP_LOCKED_API4(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
-    int _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4)                      \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        int _rv = ONLP_LOCKED_API_NAME(_name) (_v1, _v2, _v3, _v4);     \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(_name);                                             \
-        return _rv;                                                     \
-    }
+#define ONLP_LOCKED_DAPI0(_domain, _shared, _name)                      \
+    int _name (void)                                                    \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)())
 
-#define ONLP_LOCKED_API5(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
-    int _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4, _t5 _v5)             \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        int _rv = ONLP_LOCKED_API_NAME(_name) (_v1, _v2, _v3, _v4, _v5); \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(_name);                                             \
-        return _rv;                                                     \
-    }
+#define ONLP_LOCKED_DAPI1(_domain, _shared, _name, _t, _v)              \
+    int _name (_t _v)                                                   \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)(_v))
 
-#define ONLP_LOCKED_VAPI0(_name)                                 \
-    void _name (void)                                            \
-    {                                                            \
-        ONLP_API_T0(_name);                                      \
-        ONLP_API_LOCK(#_name);                                   \
-        ONLP_API_T1(_name);                                      \
-        ONLP_LOCKED_API_NAME(_name)();                           \
-        ONLP_API_UNLOCK();                                       \
-        ONLP_API_T2(_name);                                      \
-    }
+#define ONLP_LOCKED_DAPI2(_domain, _shared, _name, _t1, _v1, _t2, _v2)  \
+    int _name (_t1 _v1, _t2 _v2)                                        \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)(_v1, _v2))
 
-#define ONLP_LOCKED_VAPI1(_name, _t, _v)                  \
-    void _name (_t _v)                                    \
-    {                                                     \
-        ONLP_API_T0(_name);                               \
-        ONLP_API_LOCK(#_name);                            \
-        ONLP_API_T1(_name);                               \
-        ONLP_LOCKED_API_NAME(_name)(_v);                  \
-        ONLP_API_UNLOCK();                                \
-        ONLP_API_T2(_name);                               \
-    }
+#define ONLP_LOCKED_DAPI3(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3) \
+    int _name (_t1 _v1, _t2 _v2, _t3 _v3)                               \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3))
 
-#define ONLP_LOCKED_VAPI2(_name, _t1, _v1, _t2, _v2)              \
-    void _name (_t1 _v1, _t2 _v2)                                 \
-    {                                                             \
-        ONLP_API_T0(_name);                                       \
-        ONLP_API_LOCK(#_name);                                    \
-        ONLP_API_T1(_name);                                       \
-        ONLP_LOCKED_API_NAME(_name) (_v1, _v2);                   \
-        ONLP_API_UNLOCK();                                        \
-        ONLP_API_T2(_name);                                       \
-    }
+#define ONLP_LOCKED_DAPI4(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
+    int _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4)                      \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3, _v4))
 
-#define ONLP_LOCKED_VAPI3(_name, _t1, _v1, _t2, _v2, _t3, _v3)          \
+#define ONLP_LOCKED_DAPI5(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
+    int _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4, _t5 _v5)             \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3, _v4, _v5))
+
+#define ONLP_LOCKED_DAPI6(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5, _t6, _v6) \
+    int _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4, _t5 _v5, _t6 _v6)    \
+    ONLP_LOCKED_API_BODY__(_domain, _shared, _name,                     \
+                           ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3, _v4, _v5, _v6))
+
+#define ONLP_LOCKED_DVAPI0(_domain, _shared, _name)                     \
+    void _name (void)                                                   \
+    ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name,                    \
+                            ONLP_LOCKED_API_NAME(_name)())
+
+#define ONLP_LOCKED_DVAPI1(_domain, _shared, _name, _t, _v)             \
+    void _name (_t _v)                                                  \
+    ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name,                    \
+                            ONLP_LOCKED_API_NAME(_name)(_v))
+
+#define ONLP_LOCKED_DVAPI2(_domain, _shared, _name, _t1, _v1, _t2, _v2) \
+    void _name (_t1 _v1, _t2 _v2)                                       \
+    ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name,                    \
+                            ONLP_LOCKED_API_NAME(_name)(_v1, _v2))
+
+#define ONLP_LOCKED_DVAPI3(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3) \
     void _name (_t1 _v1, _t2 _v2, _t3 _v3)                              \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        ONLP_LOCKED_API_NAME(_name) (_v1, _v2, _v3);                    \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(name);                                              \
-    }
+    ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name,                    \
+                            ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3))
 
-#define ONLP_LOCKED_VAPI4(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
+#define ONLP_LOCKED_DVAPI4(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
     void _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4)                     \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        ONLP_LOCKED_API_NAME(_name) (_v1, _v2, _v3, _v4);               \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(_name);                                             \
-    }
+    ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name,                    \
+                            ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3, _v4))
 
-#define ONLP_LOCKED_VAPI5(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
+#define ONLP_LOCKED_DVAPI5(_domain, _shared, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
     void _name (_t1 _v1, _t2 _v2, _t3 _v3, _t4 _v4, _t5 _v5)            \
-    {                                                                   \
-        ONLP_API_T0(_name);                                             \
-        ONLP_API_LOCK(#_name);                                          \
-        ONLP_API_T1(_name);                                             \
-        ONLP_LOCKED_API_NAME(_name) (_v1, _v2, _v3, _v4, _v5);          \
-        ONLP_API_UNLOCK();                                              \
-        ONLP_API_T2(_name);                                             \
-    }
-
-
+    ONLP_LOCKED_VAPI_BODY__(_domain, _shared, _name,                    \
+                            ONLP_LOCKED_API_NAME(_name)(_v1, _v2, _v3, _v4, _v5))
+
+#define ONLP_LOCKED_API0(_name) \
+    ONLP_LOCKED_DAPI0(ONLP_API_LOCK_DOMAIN, 0, _name)
+#define ONLP_LOCKED_API1(_name, _t1, _v1) \
+    ONLP_LOCKED_DAPI1(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1)
+#define ONLP_LOCKED_API2(_name, _t1, _v1, _t2, _v2) \
+    ONLP_LOCKED_DAPI2(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2)
+#define ONLP_LOCKED_API3(_name, _t1, _v1, _t2, _v2, _t3, _v3) \
+    ONLP_LOCKED_DAPI3(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3)
+#define ONLP_LOCKED_API4(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
+    ONLP_LOCKED_DAPI4(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4)
+#define ONLP_LOCKED_API5(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
+    ONLP_LOCKED_DAPI5(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5)
+#define ONLP_LOCKED_API6(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5, _t6, _v6) \
+    ONLP_LOCKED_DAPI6(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5, _t6, _v6)
+
+#define ONLP_LOCKED_RAPI0(_name) \
+    ONLP_LOCKED_DAPI0(ONLP_API_LOCK_DOMAIN, 1, _name)
+#define ONLP_LOCKED_RAPI1(_name, _t1, _v1) \
+    ONLP_LOCKED_DAPI1(ONLP_API_LOCK_DOMAIN, 1, _name, _t1, _v1)
+#define ONLP_LOCKED_RAPI2(_name, _t1, _v1, _t2, _v2) \
+    ONLP_LOCKED_DAPI2(ONLP_API_LOCK_DOMAIN, 1, _name, _t1, _v1, _t2, _v2)
+#define ONLP_LOCKED_RAPI3(_name, _t1, _v1, _t2, _v2, _t3, _v3) \
+    ONLP_LOCKED_DAPI3(ONLP_API_LOCK_DOMAIN, 1, _name, _t1, _v1, _t2, _v2, _t3, _v3)
+#define ONLP_LOCKED_RAPI4(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
+    ONLP_LOCKED_DAPI4(ONLP_API_LOCK_DOMAIN, 1, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4)
+#define ONLP_LOCKED_RAPI5(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
+    ONLP_LOCKED_DAPI5(ONLP_API_LOCK_DOMAIN, 1, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5)
+
+#define ONLP_LOCKED_VAPI0(_name) \
+    ONLP_LOCKED_DVAPI0(ONLP_API_LOCK_DOMAIN, 0, _name)
+#define ONLP_LOCKED_VAPI1(_name, _t1, _v1) \
+    ONLP_LOCKED_DVAPI1(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1)
+#define ONLP_LOCKED_VAPI2(_name, _t1, _v1, _t2, _v2) \
+    ONLP_LOCKED_DVAPI2(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2)
+#define ONLP_LOCKED_VAPI3(_name, _t1, _v1, _t2, _v2, _t3, _v3) \
+    ONLP_LOCKED_DVAPI3(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3)
+#define ONLP_LOCKED_VAPI4(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4) \
+    ONLP_LOCKED_DVAPI4(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4)
+#define ONLP_LOCKED_VAPI5(_name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5) \
+    ONLP_LOCKED_DVAPI5(ONLP_API_LOCK_DOMAIN, 0, _name, _t1, _v1, _t2, _v2, _t3, _v3, _t4, _v4, _t5, _v5)
 
 
 #endif /* __ONLP_LOCKS_H__ */
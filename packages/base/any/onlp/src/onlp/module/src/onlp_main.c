@@ -27,11 +27,15 @@
 #include <unistd.h>
 #include <onlp/sys.h>
 #include <onlp/sfp.h>
+#include <onlp/api_stats.h>
+#include <onlp/fan_policy.h>
+#include <onlp/telemetry.h>
 #include <sff/sff.h>
 #include <sff/sff_db.h>
 #include <AIM/aim_log_handler.h>
 #include <syslog.h>
 #include <onlp/platformi/sysi.h>
+#include "onlp_int.h"
 
 static void platform_manager_daemon__(const char* pidfile, char** argv);
 
@@ -44,6 +48,10 @@ show_inventory__(aim_pvs_t* pvs, int database)
 {
     int port;
     onlp_sfp_bitmap_t bitmap;
+    onlp_sfp_bitmap_t present;
+    onlp_sfp_data_t* eeproms;
+    int* port_status;
+    int ports = 0;
 
     onlp_sfp_bitmap_t_init(&bitmap);
     onlp_sfp_bitmap_get(&bitmap);
@@ -57,13 +65,32 @@ show_inventory__(aim_pvs_t* pvs, int database)
             aim_printf(pvs, "----  --------------  ------  ------  -----  ----------------  ----------------  ----------------\n");
         }
 
+        /* The per-port arrays are indexed by port number. */
         AIM_BITMAP_ITER(&bitmap, port) {
-            int rv;
-            uint8_t* data;
+            ports = port + 1;
+        }
+        port_status = aim_zmalloc(sizeof(int) * ports);
+        eeproms = aim_zmalloc(sizeof(onlp_sfp_data_t) * ports);
+
+        /*
+         * Determine presence for all ports and read
+         * all present EEPROMs in a single operation.
+         */
+        onlp_sfp_bitmap_t_init(&present);
+        AIM_BITMAP_ITER(&bitmap, port) {
+            port_status[port] = onlp_sfp_is_present(port);
+            if(port_status[port] > 0) {
+                AIM_BITMAP_SET(&present, port);
+            }
+        }
 
-            rv = onlp_sfp_is_present(port);
+        onlp_sfp_eeprom_read_bulk(&present, eeproms, port_status);
 
-            if(rv == 0) {
+        AIM_BITMAP_ITER(&bitmap, port) {
+            int rv = port_status[port];
+            uint8_t* data = eeproms[port];
+
+            if(rv == 0 && !AIM_BITMAP_GET(&present, port)) {
                 if(!database) {
                     aim_printf(pvs, "%4d  NONE\n", port);
                 }
@@ -75,13 +102,6 @@ show_inventory__(aim_pvs_t* pvs, int database)
                 continue;
             }
 
-            rv = onlp_sfp_eeprom_read(port, &data);
-
-            if(rv < 0) {
-                aim_printf(pvs, "%4d  Error %{onlp_status}\n", port, rv);
-                continue;
-            }
-
             sff_eeprom_t sff;
             char status_str[32] = {0};
 
@@ -123,6 +143,9 @@ show_inventory__(aim_pvs_t* pvs, int database)
                        sff.info.model,
                        sff.info.serial);
         }
+
+        aim_free(eeproms);
+        aim_free(port_status);
     }
 }
 
@@ -181,11 +204,42 @@ onlpdump_main(int argc, char* argv[])
     int l = 0;
     int M = 0;
     int b = 0;
+    int B = 0;
+    int N = 1;
     char* pidfile = NULL;
     const char* O = NULL;
     const char* t = NULL;
     const char* J = NULL;
 
+    /**
+     * API statistics
+     */
+    if(argc > 1 && !strcmp(argv[1], "stats")) {
+        if(argc > 2 && !strcmp(argv[2], "reset")) {
+            return (onlp_api_stats_reset() < 0) ? 1 : 0;
+        }
+        onlp_api_stats_show(&aim_pvs_stdout,
+                            argc > 2 && !strcmp(argv[2], "hist"));
+        return 0;
+    }
+
+    /**
+     * Telemetry service status
+     */
+    if(argc > 1 && !strcmp(argv[1], "telemetry")) {
+        onlp_init();
+        onlp_telemetry_show(&aim_pvs_stdout);
+        return 0;
+    }
+
+    /**
+     * Cached system information
+     */
+    if(argc > 2 && !strcmp(argv[1], "sysinfo") && !strcmp(argv[2], "clear")) {
+        onlp_init();
+        return (onlp_sys_info_cache_clear() < 0) ? 1 : 0;
+    }
+
     /**
      * debug trap
      */
@@ -199,7 +253,7 @@ onlpdump_main(int argc, char* argv[])
         }
     }
 
-    while( (c = getopt(argc, argv, "srehdojmyM:ipxlSt:O:bJ:")) != -1) {
+    while( (c = getopt(argc, argv, "srehdojmyM:ipxlSt:O:bJ:B:N:")) != -1) {
         switch(c)
             {
             case 's': show=1; break;
@@ -220,6 +274,8 @@ onlpdump_main(int argc, char* argv[])
             case 'l': l=1; break;
             case 'b': b=1; break;
             case 'J': J = optarg; break;
+            case 'B': B = atoi(optarg); break;
+            case 'N': N = atoi(optarg); break;
             case 'y': show=1; showflags |= ONLP_OID_SHOW_YAML; break;
             default: help=1; rv = 1; break;
             }
@@ -235,7 +291,7 @@ onlpdump_main(int argc, char* argv[])
         printf("  -o   Dump ONIE data only.\n");
         printf("  -x   Dump Platform Info only.\n");
         printf("  -j   Dump ONIE data in JSON format.\n");
-        printf("  -m   Run platform manager.\n");
+        printf("  -m   Run platform manager. Task statistics are shown every minute.\n");
         printf("  -M   Run as platform manager daemon.\n");
         printf("  -i   Iterate OIDs.\n");
         printf("  -p   Show SFP presence.\n");
@@ -245,6 +301,13 @@ onlpdump_main(int argc, char* argv[])
         printf("  -b   Decode SFP Inventory into SFF database entries.\n");
         printf("  -l   API Lock test.\n");
         printf("  -J   Decode ONIE JSON data.\n");
+        printf("  -B   <loops> Benchmark all OID and SFP APIs.\n");
+        printf("  -N   <procs> Number of concurrent benchmark processes.\n");
+        printf("\n");
+        printf("  %s stats [hist]  Show API statistics.\n", argv[0]);
+        printf("  %s stats reset   Reset API statistics.\n", argv[0]);
+        printf("  %s telemetry     Show the telemetry service status.\n", argv[0]);
+        printf("  %s sysinfo clear Clear the cached ONIE and platform information.\n", argv[0]);
         return rv;
     }
 
@@ -296,6 +359,10 @@ onlpdump_main(int argc, char* argv[])
         }
     }
 
+    if(B) {
+        return onlp_benchmark(&aim_pvs_stdout, B, N);
+    }
+
     if(S) {
         show_inventory__(&aim_pvs_stdout, b);
         return 0;
@@ -359,9 +426,16 @@ onlpdump_main(int argc, char* argv[])
 
 
     if(m) {
+        int s;
         printf("Running the platform manager for 600 seconds...\n");
         onlp_sys_platform_manage_start(0);
-        sleep(600);
+        for(s = 0; s < 600; s += 60) {
+            sleep(60);
+            onlp_sys_platform_manage_stats_show(&aim_pvs_stdout);
+            if(onlp_fan_policy_loaded()) {
+                onlp_fan_policy_show(&aim_pvs_stdout);
+            }
+        }
         printf("Stopping the platform manager.\n");
         onlp_sys_platform_manage_stop(1);
     }
@@ -434,11 +508,15 @@ platform_manager_daemon__(const char* pidfile, char** argv)
     /** Signal handler for terminating the platform manager */
     signal(SIGTERM, sighandler__);
 
+    /** Serve the platform telemetry to other ONLP clients. */
+    onlp_telemetry_server_start();
+
     /** Start and block in platform manager. */
     onlp_sys_platform_manage_start(1);
 
     /** Terminated via signal. Cleanup and exit. */
     onlp_sys_platform_manage_stop(1);
+    onlp_telemetry_server_stop();
 
     aim_log_handler_basic_denit_all();
     exit(0);
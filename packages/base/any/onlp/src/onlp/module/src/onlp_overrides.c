@@ -0,0 +1,434 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ *
+ * Platform OID Overrides.
+ *
+ ***********************************************************/
+#include <onlp/onlp_config.h>
+#include <onlp/onlp.h>
+#include <onlp/oids.h>
+#include <onlp/fan.h>
+#include <onlp/thermal.h>
+#include <AIM/aim.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include "onlp_overrides.h"
+#include "onlp_cache.h"
+#include "onlp_json.h"
+#include "onlp_log.h"
+
+void* volatile onlp_overrides__ = NULL;
+
+#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES == 1
+
+/**
+ * The integer fields which can be overridden for each OID type.
+ */
+typedef struct override_field_s {
+    const char* name;
+    int offset;
+} override_field_t;
+
+#define OVERRIDE_FIELDS_MAX 8
+
+static const struct {
+    onlp_oid_type_t type;
+    const char* name;
+    override_field_t fields[OVERRIDE_FIELDS_MAX];
+} types__[] = {
+    { ONLP_OID_TYPE_FAN, "fan",
+      {
+          { "status", offsetof(onlp_fan_info_t, status) },
+          { "caps", offsetof(onlp_fan_info_t, caps) },
+          { "rpm", offsetof(onlp_fan_info_t, rpm) },
+          { "percentage", offsetof(onlp_fan_info_t, percentage) },
+          { "mode", offsetof(onlp_fan_info_t, mode) },
+      }
+    },
+    { ONLP_OID_TYPE_THERMAL, "thermal",
+      {
+          { "status", offsetof(onlp_thermal_info_t, status) },
+          { "mcelsius", offsetof(onlp_thermal_info_t, mcelsius) },
+      }
+    },
+};
+
+#define OVERRIDE_TYPE_COUNT AIM_ARRAYSIZE(types__)
+
+/** The overrides for a single OID. */
+typedef struct override_s {
+    /** Bit N is set if fields[N] is overridden. */
+    uint32_t mask;
+    int values[OVERRIDE_FIELDS_MAX];
+} override_t;
+
+/** The compiled overrides, indexed by type and OID ID. */
+typedef struct override_index_s {
+    int count[OVERRIDE_TYPE_COUNT];
+    override_t* entries[OVERRIDE_TYPE_COUNT];
+} override_index_t;
+
+static pthread_mutex_t lock__ = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void
+override_index_free__(override_index_t* ix)
+{
+    int t;
+    if(ix) {
+        for(t = 0; t < OVERRIDE_TYPE_COUNT; t++) {
+            aim_free(ix->entries[t]);
+        }
+        aim_free(ix);
+    }
+}
+
+/*
+ * Compile the overrides section.
+ * Returns NULL if there are no overrides.
+ */
+static override_index_t*
+override_index_compile__(cJSON* root)
+{
+    int t, f;
+    int total = 0;
+    override_index_t* ix = aim_zmalloc(sizeof(*ix));
+
+    for(t = 0; t < OVERRIDE_TYPE_COUNT; t++) {
+        cJSON* section = NULL;
+        cJSON* entry;
+
+        if(cjson_util_lookup(root, &section, "overrides.%s", types__[t].name) < 0 ||
+           section == NULL || section->type != cJSON_Object) {
+            continue;
+        }
+
+        /* Size the table by the largest ID. */
+        for(entry = section->child; entry; entry = entry->next) {
+            int id = atoi(entry->string);
+            if(id > 0 && id >= ix->count[t]) {
+                ix->count[t] = id + 1;
+            }
+        }
+        if(ix->count[t] == 0) {
+            continue;
+        }
+        ix->entries[t] = aim_zmalloc(sizeof(override_t) * ix->count[t]);
+
+        for(entry = section->child; entry; entry = entry->next) {
+            int id = atoi(entry->string);
+            override_t* o;
+
+            if(id <= 0) {
+                AIM_LOG_ERROR("Ignoring invalid %s override '%s'",
+                              types__[t].name, entry->string);
+                continue;
+            }
+            o = ix->entries[t] + id;
+            for(f = 0; f < OVERRIDE_FIELDS_MAX && types__[t].fields[f].name; f++) {
+                if(cjson_util_lookup_int(entry, o->values + f, "%s",
+                                         types__[t].fields[f].name) >= 0) {
+                    o->mask |= (1 << f);
+                    total++;
+                }
+            }
+        }
+    }
+
+    if(total == 0) {
+        override_index_free__(ix);
+        return NULL;
+    }
+    return ix;
+}
+
+static void
+override_index_set__(override_index_t* ix)
+{
+    override_index_t* old;
+
+    pthread_mutex_lock(&lock__);
+    old = onlp_overrides__;
+    onlp_overrides__ = ix;
+    pthread_mutex_unlock(&lock__);
+
+    override_index_free__(old);
+}
+
+void
+onlp_overrides_apply__(onlp_oid_t oid, void* info)
+{
+    int t;
+    int id = ONLP_OID_ID_GET(oid);
+
+    onlp_overrides_watch_start();
+
+    pthread_mutex_lock(&lock__);
+    override_index_t* ix = onlp_overrides__;
+    for(t = 0; ix && t < OVERRIDE_TYPE_COUNT; t++) {
+        if(ONLP_OID_IS_TYPE(types__[t].type, oid)) {
+            if(id < ix->count[t]) {
+                override_t* o = ix->entries[t] + id;
+                uint32_t mask = o->mask;
+                while(mask) {
+                    int f = __builtin_ctz(mask);
+                    *(int*)((uint8_t*)info + types__[t].fields[f].offset) = o->values[f];
+                    mask &= mask - 1;
+                }
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock__);
+}
+
+#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD == 1
+
+/**
+ * Configuration file watcher.
+ *
+ * The directory is watched rather than the file so that editors
+ * which replace the file are handled.
+ *
+ * The watcher is started by the platform manager or by the first
+ * overrides lookup rather than by onlp_init(), so daemons which fork
+ * after onlp_init() start it in the child. The pid records which
+ * process owns the thread.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_t thread;
+    pid_t pid;
+    int inotifyfd;
+    int stopfd;
+    char* fname;
+} watch__ = { PTHREAD_MUTEX_INITIALIZER, 0, 0, -1, -1, NULL };
+
+static void
+overrides_reload__(void)
+{
+    cJSON* root = NULL;
+    override_index_t* ix = NULL;
+
+    if(cjson_util_parse_file(watch__.fname, &root) >= 0 && root) {
+        ix = override_index_compile__(root);
+        cJSON_Delete(root);
+    }
+    else {
+        AIM_LOG_ERROR("Failed to parse %s. Overrides removed.", watch__.fname);
+    }
+
+    override_index_set__(ix);
+
+    /* Cached information may contain the old overrides. */
+    onlp_cache_invalidate(0);
+}
+
+static void*
+overrides_watch_thread__(void* arg)
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    char* fcopy = aim_strdup(watch__.fname);
+    const char* base = basename(fcopy);
+
+    for(;;) {
+        struct pollfd pfds[2] = {
+            { watch__.inotifyfd, POLLIN, 0 },
+            { watch__.stopfd, POLLIN, 0 },
+        };
+        ssize_t len, i;
+        int reload = 0;
+
+        if(poll(pfds, 2, -1) < 0) {
+            continue;
+        }
+        if(pfds[1].revents) {
+            break;
+        }
+
+        len = read(watch__.inotifyfd, buf, sizeof(buf));
+        for(i = 0; i < len; ) {
+            struct inotify_event* e = (struct inotify_event*)(buf + i);
+            if(e->len && !strcmp(e->name, base)) {
+                reload = 1;
+            }
+            i += sizeof(*e) + e->len;
+        }
+
+        if(reload) {
+            AIM_LOG_INFO("%s changed. Reloading overrides.", watch__.fname);
+            overrides_reload__();
+        }
+    }
+
+    aim_free(fcopy);
+    return NULL;
+}
+
+/*
+ * Release the watcher descriptors. These may have been
+ * inherited from a parent process whose thread does not exist here.
+ */
+static void
+overrides_watch_close__(void)
+{
+    if(watch__.inotifyfd >= 0) {
+        close(watch__.inotifyfd);
+        watch__.inotifyfd = -1;
+    }
+    if(watch__.stopfd >= 0) {
+        close(watch__.stopfd);
+        watch__.stopfd = -1;
+    }
+    watch__.pid = 0;
+}
+
+/* Called with watch__.lock held. */
+static void
+overrides_watch_start__(void)
+{
+    char* dcopy = aim_strdup(watch__.fname);
+
+    overrides_watch_close__();
+
+    watch__.inotifyfd = inotify_init1(IN_CLOEXEC);
+    watch__.stopfd = eventfd(0, EFD_CLOEXEC);
+    if(watch__.inotifyfd < 0 || watch__.stopfd < 0 ||
+       inotify_add_watch(watch__.inotifyfd, dirname(dcopy),
+                         IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0 ||
+       pthread_create(&watch__.thread, NULL, overrides_watch_thread__, NULL) != 0) {
+        AIM_LOG_ERROR("Unable to watch %s. Overrides will not be reloaded.",
+                      watch__.fname);
+        overrides_watch_close__();
+        /* Do not retry on every lookup. */
+        aim_free(watch__.fname);
+        watch__.fname = NULL;
+    }
+    else {
+        watch__.pid = getpid();
+    }
+    aim_free(dcopy);
+}
+
+void
+onlp_overrides_watch_start(void)
+{
+    if(watch__.fname == NULL || watch__.pid == getpid()) {
+        return;
+    }
+    pthread_mutex_lock(&watch__.lock);
+    if(watch__.fname && watch__.pid != getpid()) {
+        overrides_watch_start__();
+    }
+    pthread_mutex_unlock(&watch__.lock);
+}
+
+static void
+overrides_watch_init__(const char* fname)
+{
+    pthread_mutex_lock(&watch__.lock);
+    watch__.fname = aim_strdup(fname);
+    pthread_mutex_unlock(&watch__.lock);
+}
+
+static void
+overrides_watch_stop__(void)
+{
+    pthread_mutex_lock(&watch__.lock);
+    if(watch__.pid == getpid()) {
+        uint64_t one = 1;
+        if(write(watch__.stopfd, &one, sizeof(one)) == sizeof(one)) {
+            pthread_join(watch__.thread, NULL);
+        }
+    }
+    overrides_watch_close__();
+    aim_free(watch__.fname);
+    watch__.fname = NULL;
+    pthread_mutex_unlock(&watch__.lock);
+}
+
+#else
+
+void
+onlp_overrides_watch_start(void)
+{
+}
+
+static void
+overrides_watch_init__(const char* fname)
+{
+}
+
+static void
+overrides_watch_stop__(void)
+{
+}
+
+#endif /* ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD */
+
+void
+onlp_overrides_init(const char* fname)
+{
+    onlp_overrides_denit();
+    override_index_set__(override_index_compile__(onlp_json_get(0)));
+    if(fname) {
+        overrides_watch_init__(fname);
+    }
+}
+
+void
+onlp_overrides_denit(void)
+{
+    overrides_watch_stop__();
+    override_index_set__(NULL);
+}
+
+#else
+
+void
+onlp_overrides_apply__(onlp_oid_t oid, void* info)
+{
+}
+
+void
+onlp_overrides_init(const char* fname)
+{
+}
+
+void
+onlp_overrides_watch_start(void)
+{
+}
+
+void
+onlp_overrides_denit(void)
+{
+}
+
+#endif /* ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES */
@@ -0,0 +1,98 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ *
+ * Platform OID Overrides.
+ *
+ ***********************************************************/
+#ifndef __ONLP_OVERRIDES_H__
+#define __ONLP_OVERRIDES_H__
+
+#include <onlp/onlp_config.h>
+#include <onlp/oids.h>
+
+/**
+ * Platform OID overrides.
+ *
+ * The "overrides" section of the ONLP configuration file replaces
+ * fields of the information returned by the platform (testing):
+ *
+ *    "overrides" : {
+ *        "fan" : {
+ *            "1" : { "status" : 1, "rpm" : 0 }
+ *        },
+ *        "thermal" : {
+ *            "3" : { "mcelsius" : 95000 }
+ *        }
+ *    }
+ *
+ * The section is compiled once into a per-OID table of field masks
+ * and values. When no overrides are configured applying them costs
+ * a single pointer test.
+ *
+ * With ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES_RELOAD the configuration
+ * file is watched with inotify. The table is recompiled and the OID
+ * information cache is invalidated whenever the file changes, so
+ * overrides may be added to a file which had none. The watcher is
+ * started by the platform manager in the process which runs it (e.g.
+ * after onlpd has daemonized), or by the first lookup in any other
+ * process which has overrides.
+ */
+
+/**
+ * @brief Compile the overrides and arm the configuration file watcher.
+ * @param fname The configuration filename.
+ */
+void onlp_overrides_init(const char* fname);
+
+/**
+ * @brief Start the configuration file watcher in the calling process.
+ * @note Does nothing if it is already running in this process.
+ */
+void onlp_overrides_watch_start(void);
+
+/**
+ * @brief Stop watching the configuration file and release the overrides.
+ */
+void onlp_overrides_denit(void);
+
+/** Non-NULL while any overrides are configured. */
+extern void* volatile onlp_overrides__;
+
+void onlp_overrides_apply__(onlp_oid_t oid, void* info);
+
+/**
+ * @brief Apply the overrides for the given OID.
+ * @param oid The OID.
+ * @param info The OID's information structure.
+ */
+#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES == 1
+#define ONLP_OVERRIDES_APPLY(_oid, _info)               \
+    do {                                                \
+        if(onlp_overrides__) {                          \
+            onlp_overrides_apply__((_oid), (_info));    \
+        }                                               \
+    } while(0)
+#else
+#define ONLP_OVERRIDES_APPLY(_oid, _info)
+#endif
+
+#endif /* __ONLP_OVERRIDES_H__ */
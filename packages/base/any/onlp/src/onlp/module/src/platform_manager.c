@@ -25,17 +25,23 @@
 #include <onlp/sys.h>
 #include <onlp/psu.h>
 #include <onlp/fan.h>
+#include <onlp/fan_policy.h>
 #include <onlp/platformi/sysi.h>
 #include <onlplib/mmap.h>
 #include <timer_wheel/timer_wheel.h>
+#include <cjson_util/cjson_util.h>
 #include <OS/os_time.h>
 #include <OS/os_thread.h>
 #include <AIM/aim.h>
 #include "onlp_log.h"
 #include "onlp_int.h"
+#include "onlp_json.h"
+#include "onlp_overrides.h"
 #include <sys/eventfd.h>
 #include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <inttypes.h>
 
 /**
  * Timer wheel callback entry.
@@ -44,17 +50,38 @@ typedef struct management_entry_s {
     /** Timer wheel for this entry */
     timer_wheel_entry_t twe;
 
+    /** Next registered entry */
+    struct management_entry_s* next;
+
     /** This is the callback for this timer */
-    int (*manage)(void);
+    onlp_sys_platform_manage_f manage;
+    void* cookie;
 
     /** This is the callback rate in microseconds */
     uint64_t rate;
 
-    /** The name of this callback (for debugging) */
-    const char* name;
+    /** Maximum random delay added to each period in microseconds */
+    uint64_t jitter;
+
+    /** The name of this callback */
+    char name[32];
 
     /** The number of times this has been called. */
-    int calls;
+    uint64_t calls;
+
+    /** The number of calls which returned an error. */
+    uint64_t errors;
+
+    /** Run times in microseconds. */
+    uint64_t total_time;
+    uint64_t max_time;
+    uint64_t last_time;
+
+    /** The callback is currently running (and not in the timer wheel). */
+    int running;
+
+    /** Unregistered while running. Free when it completes. */
+    int removed;
 
 } management_entry_t;
 
@@ -65,12 +92,25 @@ typedef struct management_ctrl_s {
     timer_wheel_t* tw;
 
     int eventfd;
+    int wakefd;
     pthread_t thread;
 
+    /** Protects the timer wheel and the entry list */
+    pthread_mutex_t lock;
+
+    /** Registered entries */
+    management_entry_t* entries;
+
+    /** Jitter seed */
+    unsigned int seed;
+
 } management_ctrl_t;
 
 /* This is the global control state */
-static management_ctrl_t control__ = { NULL };
+static management_ctrl_t control__ = {
+    .tw = NULL,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
 
 
 /*
@@ -87,46 +127,168 @@ static int platform_psus_notify__(void);
 static int platform_fans_notify__(void);
 
 
+static int
+platform_manage_fans__(void* cookie)
+{
+    if(onlp_fan_policy_loaded()) {
+        return onlp_fan_policy_run();
+    }
+    return onlp_sysi_platform_manage_fans();
+}
+
+static int
+platform_manage_leds__(void* cookie)
+{
+    return onlp_sysi_platform_manage_leds();
+}
+
+static int
+platform_psus_notify_task__(void* cookie)
+{
+    return platform_psus_notify__();
+}
+
+static int
+platform_fans_notify_task__(void* cookie)
+{
+    return platform_fans_notify__();
+}
 
 /*
- * First Version : Static callback rates.
- * TODO: Allow individual platform callbacks to reregister
- * themselves at whatever rate they want.
+ * Default tasks for all platforms.
+ * Rates can be changed in the configuration file or at runtime.
  */
-static management_entry_t management_entries[] =
+static const struct {
+    const char* name;
+    onlp_sys_platform_manage_f manage;
+    uint64_t rate;
+} default_entries__[] =
     {
-        {
-            { },
-            onlp_sysi_platform_manage_fans,
-            /* Every 10 seconds */
-            10*1000*1000,
-            "Fans",
-        },
-        {
-            { },
-            onlp_sysi_platform_manage_leds,
-            /* Every 2 seconds */
-            2*1000*1000,
-            "LEDs",
-
-        },
-        {
-            { },
-            platform_psus_notify__,
-            /* Every second */
-            1*1000*1000,
-            "PSUs",
-        },
-        {
-            { },
-            platform_fans_notify__,
-            /* Every second */
-            1*1000*1000,
-            "Fans",
-        }
+        /* Every 10 seconds */
+        { "Fans", platform_manage_fans__, 10*1000*1000 },
+        /* Every 2 seconds */
+        { "LEDs", platform_manage_leds__, 2*1000*1000 },
+        /* Every second */
+        { "PSUs", platform_psus_notify_task__, 1*1000*1000 },
+        /* Every second */
+        { "FanStatus", platform_fans_notify_task__, 1*1000*1000 },
     };
 
 
+/**
+ * Wake the management thread so it recomputes its next deadline.
+ */
+static void
+wake__(void)
+{
+    if(control__.wakefd > 0) {
+        uint64_t one = 1;
+        if(write(control__.wakefd, &one, sizeof(one)) < 0) {
+            /* Already pending. */
+        }
+    }
+}
+
+/**
+ * Insert an entry into the timer wheel one period after the given time.
+ * Must be called with the lock held.
+ */
+static void
+schedule__(management_entry_t* e, uint64_t base)
+{
+    uint64_t deadline = base + e->rate;
+    if(e->jitter) {
+        deadline += rand_r(&control__.seed) % (e->jitter + 1);
+    }
+    timer_wheel_insert(control__.tw, &e->twe, deadline);
+}
+
+static management_entry_t*
+find__(const char* name)
+{
+    management_entry_t* e;
+    for(e = control__.entries; e; e = e->next) {
+        if(!strcmp(e->name, name)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Apply configuration file rate overrides.
+ */
+static void
+config_rates__(const char* name, uint64_t* rate, uint64_t* jitter)
+{
+    int v;
+    cJSON* cfg = onlp_json_get(0);
+
+    if(cjson_util_lookup_int(cfg, &v, "platform_manager.%s.rate", name) >= 0 &&
+       v > 0) {
+        *rate = (uint64_t)v * 1000;
+    }
+    if(cjson_util_lookup_int(cfg, &v, "platform_manager.%s.jitter", name) >= 0 &&
+       v >= 0) {
+        *jitter = (uint64_t)v * 1000;
+    }
+}
+
+/**
+ * Name-derived offset of the first run within the first period.
+ */
+static uint64_t
+phase__(const char* name, uint64_t rate)
+{
+    uint32_t h = 5381;
+    while(*name) {
+        h = (h * 33) ^ (uint8_t)(*name++);
+    }
+    return h % rate;
+}
+
+static int
+register__(const char* name, onlp_sys_platform_manage_f manage,
+           void* cookie, uint64_t rate, uint64_t jitter)
+{
+    management_entry_t* e;
+    uint64_t now;
+
+    if(name == NULL || manage == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    config_rates__(name, &rate, &jitter);
+    if(rate == 0) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    pthread_mutex_lock(&control__.lock);
+    if(find__(name)) {
+        pthread_mutex_unlock(&control__.lock);
+        AIM_LOG_ERROR("Platform management task '%s' is already registered.",
+                      name);
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    e = aim_zmalloc(sizeof(*e));
+    aim_strlcpy(e->name, name, sizeof(e->name));
+    e->manage = manage;
+    e->cookie = cookie;
+    e->rate = rate;
+    e->jitter = jitter;
+    e->next = control__.entries;
+    control__.entries = e;
+
+    now = os_time_monotonic();
+    timer_wheel_insert(control__.tw, &e->twe, now + phase__(name, rate));
+    pthread_mutex_unlock(&control__.lock);
+
+    wake__();
+    return ONLP_STATUS_OK;
+}
+
+
 void
 onlp_sys_platform_manage_init(void)
 {
@@ -135,13 +297,135 @@ onlp_sys_platform_manage_init(void)
         uint64_t now = os_time_monotonic();
 
         onlp_sysi_platform_manage_init();
+        onlp_fan_policy_config__();
         control__.tw = timer_wheel_create(4, 512, now);
+        control__.seed = (unsigned int)now;
+
+        for(i = 0; i < AIM_ARRAYSIZE(default_entries__); i++) {
+            register__(default_entries__[i].name,
+                       default_entries__[i].manage, NULL,
+                       default_entries__[i].rate, 0);
+        }
+    }
+}
+
+int
+onlp_sys_platform_manage_register(const char* name,
+                                  onlp_sys_platform_manage_f manage,
+                                  void* cookie,
+                                  uint64_t rate, uint64_t jitter)
+{
+    onlp_sys_platform_manage_init();
+    return register__(name, manage, cookie, rate, jitter);
+}
+
+int
+onlp_sys_platform_manage_unregister(const char* name)
+{
+    management_entry_t** ep;
+
+    onlp_sys_platform_manage_init();
+
+    pthread_mutex_lock(&control__.lock);
+    for(ep = &control__.entries; *ep; ep = &(*ep)->next) {
+        management_entry_t* e = *ep;
+        if(!strcmp(e->name, name)) {
+            *ep = e->next;
+            if(e->running) {
+                /* Released when the callback returns. */
+                e->removed = 1;
+            }
+            else {
+                timer_wheel_remove(control__.tw, &e->twe);
+                aim_free(e);
+            }
+            pthread_mutex_unlock(&control__.lock);
+            return ONLP_STATUS_OK;
+        }
+    }
+    pthread_mutex_unlock(&control__.lock);
+    return ONLP_STATUS_E_PARAM;
+}
+
+int
+onlp_sys_platform_manage_retune(const char* name,
+                                uint64_t rate, uint64_t jitter)
+{
+    management_entry_t* e;
+
+    if(rate == 0) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    onlp_sys_platform_manage_init();
+
+    pthread_mutex_lock(&control__.lock);
+    if( (e = find__(name)) == NULL) {
+        pthread_mutex_unlock(&control__.lock);
+        return ONLP_STATUS_E_PARAM;
+    }
+    e->rate = rate;
+    e->jitter = jitter;
+    if(!e->running) {
+        /* Otherwise it is rescheduled with the new rate when it completes. */
+        timer_wheel_remove(control__.tw, &e->twe);
+        schedule__(e, os_time_monotonic());
+    }
+    pthread_mutex_unlock(&control__.lock);
+
+    wake__();
+    return ONLP_STATUS_OK;
+}
+
+int
+onlp_sys_platform_manage_stats_get(onlp_sys_platform_manage_stats_t* stats,
+                                   int max)
+{
+    int count = 0;
+    management_entry_t* e;
 
-        for(i = 0; i < AIM_ARRAYSIZE(management_entries); i++) {
-            management_entry_t* e = management_entries+i;
-            timer_wheel_insert(control__.tw,  &e->twe, now + e->rate);
+    onlp_sys_platform_manage_init();
+
+    pthread_mutex_lock(&control__.lock);
+    for(e = control__.entries; e; e = e->next, count++) {
+        if(stats && count < max) {
+            onlp_sys_platform_manage_stats_t* s = stats + count;
+            aim_strlcpy(s->name, e->name, sizeof(s->name));
+            s->rate = e->rate;
+            s->jitter = e->jitter;
+            s->calls = e->calls;
+            s->errors = e->errors;
+            s->total_time = e->total_time;
+            s->max_time = e->max_time;
+            s->last_time = e->last_time;
         }
     }
+    pthread_mutex_unlock(&control__.lock);
+    return count;
+}
+
+void
+onlp_sys_platform_manage_stats_show(aim_pvs_t* pvs)
+{
+    int i, count;
+    onlp_sys_platform_manage_stats_t* stats;
+
+    count = onlp_sys_platform_manage_stats_get(NULL, 0);
+    stats = aim_zmalloc(sizeof(*stats) * (count + 1));
+    count = onlp_sys_platform_manage_stats_get(stats, count);
+
+    aim_printf(pvs, "%-16s %10s %10s %10s %8s %10s %10s %10s\n",
+               "Task", "Rate(ms)", "Jitter(ms)", "Calls", "Errors",
+               "Avg(us)", "Max(us)", "Last(us)");
+    for(i = 0; i < count; i++) {
+        onlp_sys_platform_manage_stats_t* s = stats + i;
+        aim_printf(pvs, "%-16s %10"PRIu64" %10"PRIu64" %10"PRIu64" %8"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64"\n",
+                   s->name, s->rate / 1000, s->jitter / 1000,
+                   s->calls, s->errors,
+                   s->calls ? s->total_time / s->calls : 0,
+                   s->max_time, s->last_time);
+    }
+    aim_free(stats);
 }
 
 
@@ -152,14 +436,45 @@ onlp_sys_platform_manage_now(void)
 
     onlp_sys_platform_manage_init();
 
+    pthread_mutex_lock(&control__.lock);
     while( (e = (management_entry_t*) timer_wheel_next(control__.tw,
                                                        os_time_monotonic())) ) {
+        int rv = 0;
+        uint64_t t0, t1;
+
+        /*
+         * The lock is not held while running so the callback can
+         * register, unregister, or retune tasks (including itself).
+         */
+        e->running = 1;
+        pthread_mutex_unlock(&control__.lock);
+
+        t0 = os_time_monotonic();
         if(e->manage) {
-            e->manage();
+            rv = e->manage(e->cookie);
         }
+        t1 = os_time_monotonic();
+
+        pthread_mutex_lock(&control__.lock);
+        e->running = 0;
         e->calls++;
-        timer_wheel_insert(control__.tw, &e->twe, os_time_monotonic() + e->rate);
+        if(rv < 0) {
+            e->errors++;
+        }
+        e->last_time = t1 - t0;
+        e->total_time += e->last_time;
+        if(e->last_time > e->max_time) {
+            e->max_time = e->last_time;
+        }
+
+        if(e->removed) {
+            aim_free(e);
+        }
+        else {
+            schedule__(e, t1);
+        }
     }
+    pthread_mutex_unlock(&control__.lock);
 }
 
 static void*
@@ -176,17 +491,24 @@ onlp_sys_platform_manage_thread__(void* vctrl)
 
         fd_set fds;
         uint64_t now;
+        uint64_t deadline = 0;
         struct timeval tv;
         timer_wheel_entry_t* twe;
 
         FD_ZERO(&fds);
         FD_SET(ctrl->eventfd, &fds);
+        FD_SET(ctrl->wakefd, &fds);
 
         /*
          * Ask the timer wheel if there is an expiration in the next 2 seconds.
          */
         now = os_time_monotonic();
+        pthread_mutex_lock(&control__.lock);
         twe = timer_wheel_peek(ctrl->tw, now + 20000000);
+        if(twe) {
+            deadline = twe->deadline;
+        }
+        pthread_mutex_unlock(&control__.lock);
 
         if(twe == NULL) {
             /* Nothing in the next two seconds. */
@@ -194,10 +516,10 @@ onlp_sys_platform_manage_thread__(void* vctrl)
             tv.tv_usec = 0;
         }
         else {
-            if(twe->deadline > now) {
+            if(deadline > now) {
                 /* Sleep until next deadline */
-                tv.tv_sec = (twe->deadline - now) / 1000000;
-                tv.tv_usec = (twe->deadline - now) % 1000000;
+                tv.tv_sec = (deadline - now) / 1000000;
+                tv.tv_usec = (deadline - now) % 1000000;
             }
             else {
                 /* We have surpassed the current deadline */
@@ -206,8 +528,9 @@ onlp_sys_platform_manage_thread__(void* vctrl)
             }
         }
 
-        int rv = select(ctrl->eventfd+1, &fds, NULL, NULL, &tv);
-        if(rv == 1 && FD_ISSET(ctrl->eventfd, &fds)) {
+        int maxfd = (ctrl->eventfd > ctrl->wakefd) ? ctrl->eventfd : ctrl->wakefd;
+        int rv = select(maxfd+1, &fds, NULL, NULL, &tv);
+        if(rv > 0 && FD_ISSET(ctrl->eventfd, &fds)) {
             /* We've been asked to terminate. */
             AIM_LOG_MSG("Terminating.");
             /* Also signifies that we have exit */
@@ -215,6 +538,13 @@ onlp_sys_platform_manage_thread__(void* vctrl)
             ctrl->eventfd = -1;
             return NULL;
         }
+        if(rv > 0 && FD_ISSET(ctrl->wakefd, &fds)) {
+            /* Tasks have changed. Clear the wakeup. */
+            uint64_t count;
+            if(read(ctrl->wakefd, &count, sizeof(count)) < 0) {
+                /* Nothing pending */
+            }
+        }
         if(rv < 0) {
             AIM_LOG_ERROR("select() returned %d (%{errno})", rv, errno);
             /* Sleep 1 second, but continue to run */
@@ -233,6 +563,9 @@ onlp_sys_platform_manage_start(int block)
 {
     onlp_sys_platform_manage_init();
 
+    /* Reload overrides in the process which manages the platform. */
+    onlp_overrides_watch_start();
+
     if(control__.eventfd > 0) {
         /* Already running */
         return 0;
@@ -243,11 +576,20 @@ onlp_sys_platform_manage_start(int block)
         return -1;
     }
 
+    if( (control__.wakefd = eventfd(0, EFD_NONBLOCK)) < 0) {
+        AIM_LOG_ERROR("eventfd create failed: %{errno}", errno);
+        close(control__.eventfd);
+        control__.eventfd = -1;
+        return -1;
+    }
+
     if( (pthread_create(&control__.thread, NULL, onlp_sys_platform_manage_thread__,
                         &control__)) != 0) {
         AIM_LOG_ERROR("pthread create failed.");
         close(control__.eventfd);
+        close(control__.wakefd);
         control__.eventfd = -1;
+        control__.wakefd = -1;
         return -1;
     }
 
@@ -281,10 +623,79 @@ onlp_sys_platform_manage_join(void)
         pthread_join(control__.thread, NULL);
         close(control__.eventfd);
         control__.eventfd = -1;
+        close(control__.wakefd);
+        control__.wakefd = -1;
+    }
+    return 0;
+}
+
+/*
+ * The PSU and Fan notifiers keep a table of the OIDs they track.
+ * The table is refreshed whenever the OID tree generation changes,
+ * so hot-swapped FRUs are picked up. The saved info and initial
+ * report flag of OIDs which remain are preserved.
+ */
+typedef struct platform_oid_collect_s {
+    onlp_oid_t* oids;
+    int count;
+} platform_oid_collect_t;
+
+static int
+platform_oid_collect__(onlp_oid_t oid, void* cookie)
+{
+    int i;
+    platform_oid_collect_t* c = (platform_oid_collect_t*)cookie;
+
+    for(i = 0; i < c->count; i++) {
+        if(c->oids[i] == oid) {
+            return 0;
+        }
+    }
+    if(c->count < ONLP_OID_TABLE_SIZE) {
+        c->oids[c->count++] = oid;
     }
     return 0;
 }
 
+static int
+platform_oid_table_update__(onlp_oid_type_t type, uint32_t* generation,
+                            onlp_oid_t* oids, void* info, int size, int* flags)
+{
+    int i, j, rv;
+    uint8_t* new_info;
+    onlp_oid_t new_oids[ONLP_OID_TABLE_SIZE] = {0};
+    int new_flags[ONLP_OID_TABLE_SIZE] = {0};
+    platform_oid_collect_t c = { new_oids, 0 };
+    uint32_t g = onlp_oid_tree_generation();
+
+    if(g == *generation) {
+        return 0;
+    }
+
+    rv = onlp_oid_iterate(ONLP_OID_SYS, type, platform_oid_collect__, &c);
+    if(rv < 0) {
+        return rv;
+    }
+
+    new_info = aim_zmalloc(size * ONLP_OID_TABLE_SIZE);
+    for(i = 0; i < c.count; i++) {
+        for(j = 0; j < ONLP_OID_TABLE_SIZE && oids[j]; j++) {
+            if(oids[j] == new_oids[i]) {
+                memcpy(new_info + i*size, (uint8_t*)info + j*size, size);
+                new_flags[i] = flags[j];
+                break;
+            }
+        }
+    }
+
+    memcpy(oids, new_oids, sizeof(new_oids));
+    memcpy(info, new_info, size * ONLP_OID_TABLE_SIZE);
+    memcpy(flags, new_flags, sizeof(new_flags));
+    aim_free(new_info);
+
+    *generation = g;
+    return 0;
+}
 
 static int
 platform_psus_notify__(void)
@@ -293,21 +704,13 @@ platform_psus_notify__(void)
     static onlp_psu_info_t psu_info_table[ONLP_OID_TABLE_SIZE];
     int i = 0;
     static int flag[ONLP_OID_TABLE_SIZE] = {0};
+    static uint32_t generation = 0;
 
-    if(psu_oid_table[0] == 0) {
-        /* We haven't retreived the system PSU oids yet. */
-        onlp_sys_info_t si;
-        onlp_oid_t* oidp;
-
-        if(onlp_sys_info_get(&si) < 0) {
-            AIM_LOG_ERROR("onlp_sys_info_get() failed.");
-            return -1;
-        }
-        ONLP_OID_TABLE_ITER_TYPE(si.hdr.coids, oidp, PSU) {
-            psu_oid_table[i++] = *oidp;
-        }
-        /* free allocated memory */
-        onlp_sys_info_free(&si);
+    if(platform_oid_table_update__(ONLP_OID_TYPE_PSU, &generation,
+                                   psu_oid_table, psu_info_table,
+                                   sizeof(psu_info_table[0]), flag) < 0) {
+        AIM_LOG_ERROR("Failed to retreive the system PSU oids.");
+        return -1;
     }
 
     for(i = 0; i < AIM_ARRAYSIZE(psu_oid_table); i++) {
@@ -406,21 +809,13 @@ platform_fans_notify__(void)
     static onlp_fan_info_t fan_info_table[ONLP_OID_TABLE_SIZE];
     int i = 0;
     static int flag[ONLP_OID_TABLE_SIZE] = {0};
+    static uint32_t generation = 0;
 
-    if(fan_oid_table[0] == 0) {
-        /* We haven't retreived the system FAN oids yet. */
-        onlp_sys_info_t si;
-        onlp_oid_t* oidp;
-
-        if(onlp_sys_info_get(&si) < 0) {
-            AIM_LOG_ERROR("onlp_sys_info_get() failed.");
-            return -1;
-        }
-        ONLP_OID_TABLE_ITER_TYPE(si.hdr.coids, oidp, FAN) {
-            fan_oid_table[i++] = *oidp;
-        }
-        /* free allocated memory */
-        onlp_sys_info_free(&si);
+    if(platform_oid_table_update__(ONLP_OID_TYPE_FAN, &generation,
+                                   fan_oid_table, fan_info_table,
+                                   sizeof(fan_info_table[0]), flag) < 0) {
+        AIM_LOG_ERROR("Failed to retreive the system FAN oids.");
+        return -1;
     }
 
     for(i = 0; i < AIM_ARRAYSIZE(fan_oid_table); i++) {
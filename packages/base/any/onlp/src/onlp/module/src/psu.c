@@ -28,7 +28,9 @@
 #include <onlp/psu.h>
 #include <onlp/platformi/psui.h>
 #include "onlp_int.h"
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_PSU
 #include "onlp_locks.h"
+#include "onlp_cache.h"
 
 #define VALIDATE(_id)                           \
     do {                                        \
@@ -53,12 +55,41 @@ onlp_psu_init_locked__(void)
 ONLP_LOCKED_API0(onlp_psu_init);
 
 static int
-onlp_psu_info_get_locked__(onlp_oid_t id,  onlp_psu_info_t* info)
+onlp_psu_info_get_cached_locked__(onlp_oid_t id, onlp_psu_info_t* info,
+                                  uint32_t max_age)
 {
+    int rv;
     VALIDATE(id);
-    return onlp_psui_info_get(id, info);
+
+    if(onlp_cache_get(id, info, sizeof(*info), max_age)) {
+        rv = ONLP_STATUS_OK;
+    }
+    else if((rv = onlp_psui_info_get(id, info)) >= 0) {
+        onlp_cache_put(id, info, sizeof(*info));
+    }
+
+    if(rv >= 0) {
+        /* Cached data may have been read by another process. */
+        onlp_oid_tree_presence_observe__(id, info->status & ONLP_PSU_STATUS_PRESENT);
+    }
+    return rv;
+}
+ONLP_LOCKED_RAPI3(onlp_psu_info_get_cached, onlp_oid_t, id, onlp_psu_info_t*, info,
+                 uint32_t, max_age);
+
+static int
+onlp_psu_info_get_locked__(onlp_oid_t id,  onlp_psu_info_t* info)
+{
+    int rv = onlp_telemetry_info_get__(id, info, sizeof(*info));
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        if(rv >= 0) {
+            onlp_oid_tree_presence_observe__(id, info->status & ONLP_PSU_STATUS_PRESENT);
+        }
+        return rv;
+    }
+    return onlp_psu_info_get_cached_locked__(id, info, onlp_cache_ttl_get(id));
 }
-ONLP_LOCKED_API2(onlp_psu_info_get, onlp_oid_t, id, onlp_psu_info_t*, info);
+ONLP_LOCKED_RAPI2(onlp_psu_info_get, onlp_oid_t, id, onlp_psu_info_t*, info);
 
 static int
 onlp_psu_status_get_locked__(onlp_oid_t id, uint32_t* status)
@@ -74,7 +105,7 @@ onlp_psu_status_get_locked__(onlp_oid_t id, uint32_t* status)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_psu_status_get, onlp_oid_t, id, uint32_t*, status);
+ONLP_LOCKED_RAPI2(onlp_psu_status_get, onlp_oid_t, id, uint32_t*, status);
 
 static int
 onlp_psu_hdr_get_locked__(onlp_oid_t id, onlp_oid_hdr_t* hdr)
@@ -90,7 +121,7 @@ onlp_psu_hdr_get_locked__(onlp_oid_t id, onlp_oid_hdr_t* hdr)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_psu_hdr_get, onlp_oid_t, id, onlp_oid_hdr_t*, hdr);
+ONLP_LOCKED_RAPI2(onlp_psu_hdr_get, onlp_oid_t, id, onlp_oid_hdr_t*, hdr);
 int
 onlp_psu_vioctl_locked__(onlp_oid_t id, va_list vargs)
 {
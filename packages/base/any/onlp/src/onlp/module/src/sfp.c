@@ -25,13 +25,197 @@
 #include <onlp/sfp.h>
 #include <onlp/platformi/sfpi.h>
 #include "onlp_log.h"
+#include "onlp_int.h"
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_SFP
 #include "onlp_locks.h"
+#include <pthread.h>
+#include <AIM/aim_time.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <onlplib/shlocks.h>
 
 /**
  * All port numbers will be validated before calling the SFP driver.
  */
 static onlp_sfp_bitmap_t sfpi_bitmap__;
 
+/**
+ * EEPROM cache.
+ *
+ * Module identity data does not change while a module remains
+ * inserted. Each port carries a presence generation which is
+ * bumped whenever a presence transition is observed or the
+ * port is post-inserted. Cached EEPROM contents are valid only
+ * for the generation in which they were read.
+ *
+ * All state is indexed by the logical port number.
+ */
+typedef struct sfp_eeprom_cache_s {
+    /** The current presence generation. */
+    uint32_t generation;
+    /** Last observed presence (-1 if unknown) */
+    int present;
+    /** Monotonic time of the last presence observation. */
+    uint64_t observed;
+
+    /** Generation of the cached data. Zero if invalid. */
+    uint32_t cached;
+    uint8_t* data;
+
+    /** Memory model (SFP_MEM_MODEL_*) and the generation it belongs to. */
+    int model;
+    uint32_t model_generation;
+} sfp_eeprom_cache_t;
+
+static sfp_eeprom_cache_t sfp_eeprom_cache__[256];
+
+static void
+sfp_eeprom_cache_init__(void)
+{
+    int p;
+    for(p = 0; p < AIM_ARRAYSIZE(sfp_eeprom_cache__); p++) {
+        sfp_eeprom_cache__[p].generation = 1;
+        sfp_eeprom_cache__[p].present = -1;
+    }
+}
+
+static void
+sfp_eeprom_cache_denit__(void)
+{
+    int p;
+    for(p = 0; p < AIM_ARRAYSIZE(sfp_eeprom_cache__); p++) {
+        aim_free(sfp_eeprom_cache__[p].data);
+        sfp_eeprom_cache__[p].data = NULL;
+        sfp_eeprom_cache__[p].cached = 0;
+    }
+}
+
+static void
+sfp_eeprom_cache_bump__(int port)
+{
+    sfp_eeprom_cache_t* c = sfp_eeprom_cache__ + port;
+    if(++c->generation == 0) {
+        c->generation = 1;
+    }
+    c->cached = 0;
+}
+
+static void
+sfp_presence_observe__(int port, int present)
+{
+    sfp_eeprom_cache_t* c = sfp_eeprom_cache__ + port;
+    present = present ? 1 : 0;
+    if(c->present != present) {
+        sfp_eeprom_cache_bump__(port);
+        c->present = present;
+    }
+    c->observed = aim_time_monotonic();
+}
+
+/*
+ * Returns the offset of the vendor serial number (16 bytes) in the
+ * page 0 EEPROM, or -1 if the module type is not known.
+ */
+static int
+sfp_eeprom_serial_offset__(uint8_t* data)
+{
+    switch(data[0])
+        {
+        case 0x03: /* SFF-8472 */
+            return 68;
+        case 0x0C: /* SFF-8636 */
+        case 0x0D:
+        case 0x11:
+            return 196;
+        case 0x18: /* CMIS */
+        case 0x19:
+        case 0x1E:
+            return 166;
+        default:
+            return -1;
+        }
+}
+
+/*
+ * Returns 1 if the module still reports the cached serial number.
+ * A module swapped between two presence observations is not
+ * detected by presence alone.
+ */
+static int
+sfp_eeprom_cache_identity_check__(int port, int rport, sfp_eeprom_cache_t* c)
+{
+    uint8_t serial[16];
+    int offset = sfp_eeprom_serial_offset__(c->data);
+
+    if(offset < 0) {
+        return 0;
+    }
+    if(onlp_sfpi_dev_read(rport, 0x50, offset, serial, sizeof(serial)) < 0) {
+        return 0;
+    }
+    return memcmp(serial, c->data + offset, sizeof(serial)) == 0;
+}
+
+/*
+ * Returns 1 if cached data is available for the port.
+ * rport is the mapped port used for revalidation.
+ */
+static int
+sfp_eeprom_cache_get__(int port, int rport, uint8_t* data)
+{
+    sfp_eeprom_cache_t* c = sfp_eeprom_cache__ + port;
+
+    if(ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE == 0 ||
+       c->cached == 0 || c->cached != c->generation) {
+        return 0;
+    }
+
+    if(aim_time_monotonic() - c->observed >
+       ONLP_CONFIG_SFP_EEPROM_CACHE_PRESENCE_TTL * 1000ULL) {
+        /* The presence observation is stale. Revalidate. */
+        int rv = onlp_sfpi_is_present(rport);
+        if(rv < 0) {
+            return 0;
+        }
+        sfp_presence_observe__(port, rv);
+        if(c->cached != c->generation) {
+            return 0;
+        }
+        if(!sfp_eeprom_cache_identity_check__(port, rport, c)) {
+            sfp_eeprom_cache_bump__(port);
+            return 0;
+        }
+    }
+
+    memcpy(data, c->data, 256);
+    return 1;
+}
+
+static void
+sfp_eeprom_cache_put__(int port, uint32_t generation, uint8_t* data)
+{
+    sfp_eeprom_cache_t* c = sfp_eeprom_cache__ + port;
+
+    if(ONLP_CONFIG_INCLUDE_SFP_EEPROM_CACHE == 0 ||
+       generation != c->generation) {
+        /* Presence changed during the read. */
+        return;
+    }
+    if(c->data == NULL) {
+        c->data = aim_zmalloc(256);
+    }
+    memcpy(c->data, data, 256);
+    c->cached = generation;
+}
+
 void
 onlp_sfp_bitmap_t_init(onlp_sfp_bitmap_t* bmap)
 {
@@ -43,6 +227,7 @@ static int
 onlp_sfp_init_locked__(void)
 {
     onlp_sfp_bitmap_t_init(&sfpi_bitmap__);
+    sfp_eeprom_cache_init__();
 
     int rv = onlp_sfpi_init();
     if(rv < 0) {
@@ -77,12 +262,13 @@ onlp_sfp_bitmap_get_locked__(onlp_sfp_bitmap_t* bmap)
     AIM_BITMAP_ASSIGN(bmap, &sfpi_bitmap__);
     return ONLP_STATUS_OK;
 }
-ONLP_LOCKED_API1(onlp_sfp_bitmap_get, onlp_sfp_bitmap_t*, bmap);
+ONLP_LOCKED_RAPI1(onlp_sfp_bitmap_get, onlp_sfp_bitmap_t*, bmap);
 
 
 static int
 onlp_sfp_denit_locked__(void)
 {
+    sfp_eeprom_cache_denit__();
     return onlp_sfpi_denit();
 }
 ONLP_LOCKED_API0(onlp_sfp_denit);
@@ -99,11 +285,43 @@ ONLP_LOCKED_API0(onlp_sfp_denit);
         }                                                \
     } while(0)
 
+static int
+onlp_sfp_eeprom_cache_invalidate_locked__(int port)
+{
+    if(port < 0) {
+        AIM_BITMAP_ITER(&sfpi_bitmap__, port) {
+            sfp_eeprom_cache_bump__(port);
+        }
+        return ONLP_STATUS_OK;
+    }
+    if(AIM_BITMAP_GET(&sfpi_bitmap__, port) == 0) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    sfp_eeprom_cache_bump__(port);
+    return ONLP_STATUS_OK;
+}
+ONLP_LOCKED_API1(onlp_sfp_eeprom_cache_invalidate, int, port);
+
 static int
 onlp_sfp_is_present_locked__(int port)
 {
+    int lport = port;
+    int rv;
+    onlp_sfp_bitmap_t present;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
-    return onlp_sfpi_is_present(port);
+
+    onlp_sfp_bitmap_t_init(&present);
+    if(onlp_telemetry_sfp_bitmap_get__(ONLP_TELEMETRY_SFP_PRESENCE, &present) == 0) {
+        rv = AIM_BITMAP_GET(&present, lport);
+        sfp_presence_observe__(lport, rv);
+        return rv;
+    }
+
+    rv = onlp_sfpi_is_present(port);
+    if(rv >= 0) {
+        sfp_presence_observe__(lport, rv);
+    }
+    return rv;
 }
 ONLP_LOCKED_API1(onlp_sfp_is_present, int, port);
 
@@ -111,7 +329,10 @@ static int
 onlp_sfp_presence_bitmap_get_locked__(onlp_sfp_bitmap_t* dst)
 {
     onlp_sfp_bitmap_t_init(dst);
-    int rv = onlp_sfpi_presence_bitmap_get(dst);
+    int rv = onlp_telemetry_sfp_bitmap_get__(ONLP_TELEMETRY_SFP_PRESENCE, dst);
+    if(rv == ONLP_STATUS_E_UNSUPPORTED) {
+        rv = onlp_sfpi_presence_bitmap_get(dst);
+    }
 
     if(rv == ONLP_STATUS_E_UNSUPPORTED) {
         /* Generate from single-port API */
@@ -129,10 +350,475 @@ onlp_sfp_presence_bitmap_get_locked__(onlp_sfp_bitmap_t* dst)
         return 0;
     }
 
+    if(rv >= 0) {
+        int p;
+        AIM_BITMAP_ITER(&sfpi_bitmap__, p) {
+            sfp_presence_observe__(p, AIM_BITMAP_GET(dst, p));
+        }
+    }
+
     return rv;
 }
 ONLP_LOCKED_API1(onlp_sfp_presence_bitmap_get, onlp_sfp_bitmap_t*, dst);
 
+/**
+ * Presence monitor.
+ *
+ * One process on the system polls the presence hardware and
+ * publishes the bitmap in shared memory. Every process runs a
+ * monitor thread which follows the shared bitmap and wakes its
+ * onlp_sfp_presence_wait() callers and registered eventfds when it
+ * changes, so clients no longer poll the presence hardware themselves.
+ *
+ * The polling process uses the platform presence notification
+ * descriptor with poll(POLLPRI) if there is one. Otherwise it rereads
+ * the presence bitmap every ONLP_CONFIG_SFP_PRESENCE_POLL_MS. The other
+ * processes sleep on a futex in the shared segment and take over the
+ * polling if the polling process exits.
+ */
+#define SFP_PRESENCE_EVENTFDS_MAX 16
+
+/*
+ * The notification descriptor is still reread at this interval
+ * in case an event is ever lost.
+ */
+#define SFP_PRESENCE_NOTIFY_TIMEOUT_MS 30000
+
+#define SFP_PRESENCE_SHM_KEY 0xF00DF400
+#define SFP_PRESENCE_MAGIC   0x50524553
+
+typedef struct sfp_presence_shared_s {
+    uint32_t magic;
+    /** The polling process, 0 if none. */
+    int32_t poller;
+    /** Publication sequence. Odd while an update is in progress. */
+    uint32_t seq;
+    /** Status of the most recent presence read. */
+    int32_t status;
+    /** The most recent presence, one byte per port. */
+    uint8_t present[256];
+} sfp_presence_shared_t;
+
+typedef struct sfp_presence_monitor_s {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /** Status of the most recent presence read. */
+    int status;
+    /** The most recent presence bitmap. */
+    onlp_sfp_bitmap_t present;
+    /** Bumped on every change. */
+    uint32_t generation;
+
+    /** The shared presence state. */
+    sfp_presence_shared_t* shared;
+    /** Platform notification descriptor, or -1 */
+    int notify_fd;
+    /** Registered eventfds, -1 if unused. */
+    int eventfds[SFP_PRESENCE_EVENTFDS_MAX];
+} sfp_presence_monitor_t;
+
+static sfp_presence_monitor_t sfp_presence_monitor__;
+static pthread_once_t sfp_presence_monitor_once__ = PTHREAD_ONCE_INIT;
+
+static int
+sfp_presence_differs__(onlp_sfp_bitmap_t* a, onlp_sfp_bitmap_t* b)
+{
+    int p;
+    AIM_BITMAP_ITER(&sfpi_bitmap__, p) {
+        if(AIM_BITMAP_GET(a, p) != AIM_BITMAP_GET(b, p)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static sfp_presence_shared_t*
+sfp_presence_shared_init__(void)
+{
+    void* p = NULL;
+    int rv = onlp_shmem_create(SFP_PRESENCE_SHM_KEY,
+                               sizeof(sfp_presence_shared_t), &p);
+    sfp_presence_shared_t* s = p;
+
+    if(rv == 1) {
+        __sync_synchronize();
+        s->magic = SFP_PRESENCE_MAGIC;
+    }
+    else if(rv < 0 || s == NULL) {
+        /* Not shareable. This process polls for itself. */
+        AIM_LOG_VERBOSE("The shared presence state is not available.");
+        s = aim_zmalloc(sizeof(*s));
+        s->magic = SFP_PRESENCE_MAGIC;
+    }
+    return s;
+}
+
+/*
+ * Returns 1 if this process is (or has just become) the polling process.
+ */
+static int
+sfp_presence_poller_acquire__(sfp_presence_shared_t* s)
+{
+    int32_t me = getpid();
+    int32_t pid = s->poller;
+
+    if(pid == me) {
+        return 1;
+    }
+    if(pid == 0 || (kill(pid, 0) < 0 && errno == ESRCH)) {
+        return __sync_bool_compare_and_swap(&s->poller, pid, me);
+    }
+    return 0;
+}
+
+static void
+sfp_presence_shared_publish__(sfp_presence_shared_t* s, int status,
+                              onlp_sfp_bitmap_t* present)
+{
+    int p;
+    uint32_t seq = s->seq;
+
+    /* An update abandoned by a previous polling process leaves seq odd. */
+    seq += (seq & 1) ? 1 : 2;
+
+    s->seq = seq - 1;
+    __sync_synchronize();
+    s->status = status;
+    for(p = 0; p < AIM_ARRAYSIZE(s->present); p++) {
+        s->present[p] = (status >= 0) && AIM_BITMAP_GET(&sfpi_bitmap__, p) &&
+            AIM_BITMAP_GET(present, p);
+    }
+    __sync_synchronize();
+    s->seq = seq;
+    syscall(SYS_futex, &s->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/*
+ * Returns 1 if a consistent published state was copied.
+ */
+static int
+sfp_presence_shared_read__(sfp_presence_shared_t* s, int* status,
+                           onlp_sfp_bitmap_t* present)
+{
+    int i, p;
+
+    for(i = 0; i < 100; i++) {
+        uint32_t seq = s->seq;
+        if(seq == 0) {
+            /* Nothing has been published yet. */
+            return 0;
+        }
+        if(seq & 1) {
+            sched_yield();
+            continue;
+        }
+        __sync_synchronize();
+        *status = s->status;
+        onlp_sfp_bitmap_t_init(present);
+        AIM_BITMAP_ITER(&sfpi_bitmap__, p) {
+            if(s->present[p]) {
+                AIM_BITMAP_SET(present, p);
+            }
+        }
+        __sync_synchronize();
+        if(s->seq == seq) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Record a new presence state and wake this process's waiters.
+ */
+static void
+sfp_presence_monitor_set__(sfp_presence_monitor_t* m, int rv,
+                           onlp_sfp_bitmap_t* present, int invalidate)
+{
+    int i, p;
+    onlp_sfp_bitmap_t previous;
+    int changed = 0;
+
+    pthread_mutex_lock(&m->lock);
+    m->status = (rv < 0) ? rv : ONLP_STATUS_OK;
+    if(rv >= 0 && sfp_presence_differs__(&m->present, present)) {
+        changed = 1;
+        AIM_BITMAP_ASSIGN(&previous, &m->present);
+        AIM_BITMAP_ASSIGN(&m->present, present);
+        m->generation++;
+        pthread_cond_broadcast(&m->cond);
+        for(i = 0; i < SFP_PRESENCE_EVENTFDS_MAX; i++) {
+            if(m->eventfds[i] >= 0) {
+                uint64_t one = 1;
+                /* EAGAIN means an event is already pending. */
+                if(write(m->eventfds[i], &one, sizeof(one)) < 0 &&
+                   errno != EAGAIN) {
+                    AIM_LOG_ERROR("Presence eventfd write failed: %{errno}", errno);
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&m->lock);
+
+    if(changed && invalidate) {
+        /* The change was observed by another process. */
+        AIM_BITMAP_ITER(&sfpi_bitmap__, p) {
+            if(AIM_BITMAP_GET(&previous, p) != AIM_BITMAP_GET(present, p)) {
+                onlp_sfp_eeprom_cache_invalidate(p);
+            }
+        }
+    }
+}
+
+/*
+ * Read the presence hardware and publish the result.
+ */
+static void
+sfp_presence_monitor_poll__(sfp_presence_monitor_t* m)
+{
+    onlp_sfp_bitmap_t present;
+    int rv = onlp_sfp_presence_bitmap_get(&present);
+    sfp_presence_shared_publish__(m->shared, rv, &present);
+    sfp_presence_monitor_set__(m, rv, &present, 0);
+}
+
+/*
+ * Follow the state published by the polling process.
+ */
+static void
+sfp_presence_monitor_follow__(sfp_presence_monitor_t* m)
+{
+    int status;
+    onlp_sfp_bitmap_t present;
+
+    if(sfp_presence_shared_read__(m->shared, &status, &present)) {
+        sfp_presence_monitor_set__(m, status, &present, 1);
+    }
+}
+
+/*
+ * Rearm the sysfs notification.
+ * The attribute must be read before each poll().
+ */
+static void
+sfp_presence_notify_arm__(int fd)
+{
+    char buf[128];
+    if(lseek(fd, 0, SEEK_SET) < 0 || read(fd, buf, sizeof(buf)) < 0) {
+        AIM_LOG_ERROR("Failed to read the presence notification descriptor: %{errno}",
+                      errno);
+    }
+}
+
+static void
+sfp_presence_notify_open__(sfp_presence_monitor_t* m)
+{
+    if(onlp_sfpi_presence_notify_fd_get(&m->notify_fd) < 0) {
+        m->notify_fd = -1;
+    }
+    if(m->notify_fd >= 0) {
+        sfp_presence_notify_arm__(m->notify_fd);
+    }
+}
+
+static void*
+sfp_presence_monitor_thread__(void* arg)
+{
+    sfp_presence_monitor_t* m = (sfp_presence_monitor_t*)arg;
+    int notify_tried = 0;
+
+    for(;;) {
+        if(!sfp_presence_poller_acquire__(m->shared)) {
+            /* Sleep until the next publication or the liveness check. */
+            struct timespec ts;
+            uint32_t seq = m->shared->seq;
+            ts.tv_sec = ONLP_CONFIG_SFP_PRESENCE_POLL_MS / 1000;
+            ts.tv_nsec = (ONLP_CONFIG_SFP_PRESENCE_POLL_MS % 1000) * 1000000L;
+            syscall(SYS_futex, &m->shared->seq, FUTEX_WAIT, seq, &ts, NULL, 0);
+            sfp_presence_monitor_follow__(m);
+            continue;
+        }
+
+        if(!notify_tried) {
+            /* This process has just taken over the polling. */
+            sfp_presence_notify_open__(m);
+            notify_tried = 1;
+            sfp_presence_monitor_poll__(m);
+        }
+
+        if(m->notify_fd >= 0) {
+            struct pollfd pfd = { m->notify_fd, POLLPRI | POLLERR, 0 };
+            if(poll(&pfd, 1, SFP_PRESENCE_NOTIFY_TIMEOUT_MS) < 0 &&
+               errno != EINTR) {
+                AIM_LOG_ERROR("Presence notification poll failed: %{errno}",
+                              errno);
+                close(m->notify_fd);
+                m->notify_fd = -1;
+                continue;
+            }
+            /* Rearm before reading so no change can be missed. */
+            sfp_presence_notify_arm__(m->notify_fd);
+        }
+        else {
+            usleep(ONLP_CONFIG_SFP_PRESENCE_POLL_MS * 1000);
+        }
+        sfp_presence_monitor_poll__(m);
+    }
+    return NULL;
+}
+
+static void
+sfp_presence_monitor_init__(void)
+{
+    int i;
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_condattr_t cattr;
+    int status;
+    onlp_sfp_bitmap_t present;
+    sfp_presence_monitor_t* m = &sfp_presence_monitor__;
+
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m->cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    for(i = 0; i < SFP_PRESENCE_EVENTFDS_MAX; i++) {
+        m->eventfds[i] = -1;
+    }
+
+    onlp_sfp_bitmap_t_init(&m->present);
+    m->notify_fd = -1;
+    m->shared = sfp_presence_shared_init__();
+
+    /*
+     * The initial state is taken synchronously, from the shared
+     * state if the polling process has published one.
+     */
+    if(sfp_presence_shared_read__(m->shared, &status, &present)) {
+        sfp_presence_monitor_set__(m, status, &present, 0);
+    }
+    else {
+        status = onlp_sfp_presence_bitmap_get(&present);
+        sfp_presence_monitor_set__(m, status, &present, 0);
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if(pthread_create(&thread, &attr, sfp_presence_monitor_thread__, m) != 0) {
+        AIM_LOG_ERROR("Failed to start the SFP presence monitor.");
+        m->status = ONLP_STATUS_E_INTERNAL;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static sfp_presence_monitor_t*
+sfp_presence_monitor_get__(void)
+{
+    pthread_once(&sfp_presence_monitor_once__, sfp_presence_monitor_init__);
+    return &sfp_presence_monitor__;
+}
+
+int
+onlp_sfp_presence_wait(onlp_sfp_bitmap_t* prev, int timeout_ms,
+                       onlp_sfp_bitmap_t* dst)
+{
+    int rv = 0;
+    struct timespec deadline;
+    sfp_presence_monitor_t* m;
+
+    if(prev == NULL || dst == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    m = sfp_presence_monitor_get__();
+
+    if(timeout_ms > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if(deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&m->lock);
+    while(m->status >= 0 && !sfp_presence_differs__(prev, &m->present)) {
+        if(timeout_ms == 0) {
+            break;
+        }
+        if(timeout_ms < 0) {
+            pthread_cond_wait(&m->cond, &m->lock);
+        }
+        else if(pthread_cond_timedwait(&m->cond, &m->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    if(m->status < 0) {
+        rv = m->status;
+    }
+    else {
+        rv = sfp_presence_differs__(prev, &m->present);
+    }
+    AIM_BITMAP_ASSIGN(dst, &m->present);
+    pthread_mutex_unlock(&m->lock);
+    return rv;
+}
+
+int
+onlp_sfp_presence_eventfd_open(void)
+{
+    int i;
+    int fd;
+    sfp_presence_monitor_t* m = sfp_presence_monitor_get__();
+
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(fd < 0) {
+        AIM_LOG_ERROR("eventfd() failed: %{errno}", errno);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    pthread_mutex_lock(&m->lock);
+    for(i = 0; i < SFP_PRESENCE_EVENTFDS_MAX; i++) {
+        if(m->eventfds[i] < 0) {
+            m->eventfds[i] = fd;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&m->lock);
+
+    if(i == SFP_PRESENCE_EVENTFDS_MAX) {
+        AIM_LOG_ERROR("Too many presence event descriptors.");
+        close(fd);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    return fd;
+}
+
+int
+onlp_sfp_presence_eventfd_close(int fd)
+{
+    int i;
+    int rv = ONLP_STATUS_E_PARAM;
+    sfp_presence_monitor_t* m = sfp_presence_monitor_get__();
+
+    pthread_mutex_lock(&m->lock);
+    for(i = 0; i < SFP_PRESENCE_EVENTFDS_MAX; i++) {
+        if(fd >= 0 && m->eventfds[i] == fd) {
+            m->eventfds[i] = -1;
+            close(fd);
+            rv = ONLP_STATUS_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&m->lock);
+    return rv;
+}
+
 int
 onlp_sfp_port_valid(int port)
 {
@@ -144,13 +830,25 @@ onlp_sfp_eeprom_read_locked__(int port, uint8_t** datap)
 {
     int rv;
     uint8_t* data;
+    int lport = port;
+    uint32_t generation;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
 
     data = aim_zmalloc(256);
+    if(sfp_eeprom_cache_get__(lport, port, data) ||
+       onlp_telemetry_sfp_data_get__(lport, 0, data) == 0) {
+        *datap = data;
+        return ONLP_STATUS_OK;
+    }
+
+    generation = sfp_eeprom_cache__[lport].generation;
     if((rv = onlp_sfpi_eeprom_read(port, data)) < 0) {
         aim_free(data);
         data = NULL;
     }
+    else {
+        sfp_eeprom_cache_put__(lport, generation, data);
+    }
     *datap = data;
     return rv;
 }
@@ -161,9 +859,14 @@ onlp_sfp_dom_read_locked__(int port, uint8_t** datap)
 {
     int rv;
     uint8_t* data;
+    int lport = port;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
 
     data = aim_zmalloc(256);
+    if(onlp_telemetry_sfp_data_get__(lport, 1, data) == 0) {
+        *datap = data;
+        return ONLP_STATUS_OK;
+    }
     if((rv = onlp_sfpi_dom_read(port, data)) < 0) {
         aim_free(data);
         data = NULL;
@@ -173,6 +876,233 @@ onlp_sfp_dom_read_locked__(int port, uint8_t** datap)
 }
 ONLP_LOCKED_API2(onlp_sfp_dom_read, int, port, uint8_t**, rv);
 
+
+/**
+ * Bulk reads.
+ *
+ * Ports are grouped by access segment. Each group is read serially
+ * by a single worker and groups are read concurrently. If the
+ * platform does not report segments there is a single group, which
+ * the calling thread reads without starting any workers.
+ */
+typedef struct sfp_bulk_s {
+    /** Read DOM data rather than the EEPROM. */
+    int dom;
+
+    /** Ports ordered by segment */
+    int ports[256];
+    int rports[256];
+
+    /** Group boundaries in ports[] */
+    int groups[257];
+    int group_count;
+
+    /** The next group to be read */
+    int next;
+    pthread_mutex_t lock;
+
+    onlp_sfp_data_t* data;
+    int* status;
+} sfp_bulk_t;
+
+static void*
+sfp_bulk_worker__(void* arg)
+{
+    sfp_bulk_t* b = (sfp_bulk_t*)arg;
+
+    for(;;) {
+        int g, i, rv;
+
+        pthread_mutex_lock(&b->lock);
+        g = b->next++;
+        pthread_mutex_unlock(&b->lock);
+
+        if(g >= b->group_count) {
+            break;
+        }
+
+        for(i = b->groups[g]; i < b->groups[g+1]; i++) {
+            int port = b->ports[i];
+            if(b->dom) {
+                rv = onlp_sfpi_dom_read(b->rports[i], b->data[port]);
+            }
+            else {
+                rv = onlp_sfpi_eeprom_read(b->rports[i], b->data[port]);
+            }
+            b->status[port] = (rv < 0) ? rv : ONLP_STATUS_OK;
+        }
+    }
+    return NULL;
+}
+
+static int
+sfp_read_bulk__(onlp_sfp_bitmap_t* ports, onlp_sfp_data_t* data,
+                int* status, int dom)
+{
+    int p, i, g;
+    int count = 0;
+    int threads;
+    int segmented = 1;
+    int segments[256];
+    int assigned[256] = { 0 };
+    pthread_t tids[ONLP_CONFIG_SFP_BULK_THREADS_MAX];
+    sfp_bulk_t* b;
+
+    if(ports == NULL || data == NULL || status == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    b = aim_zmalloc(sizeof(*b));
+    b->dom = dom;
+    b->data = data;
+    b->status = status;
+    pthread_mutex_init(&b->lock, NULL);
+
+    /* Validate, map, and determine the segment for each port. */
+    AIM_BITMAP_ITER(ports, p) {
+        int rport = p;
+        if(AIM_BITMAP_GET(&sfpi_bitmap__, p) == 0) {
+            status[p] = ONLP_STATUS_E_PARAM;
+            continue;
+        }
+        if(onlp_sfpi_port_map(p, &rport) < 0) {
+            rport = p;
+        }
+        segments[count] = 0;
+        if(segmented && onlp_sfpi_port_segment_get(rport, segments + count) < 0) {
+            /* Unknown segments are serialized. */
+            segments[count] = 0;
+            segmented = 0;
+        }
+        b->ports[count] = p;
+        b->rports[count] = rport;
+        count++;
+    }
+    if(!segmented) {
+        /* A partial segment map is not trusted. */
+        for(i = 0; i < count; i++) {
+            segments[i] = 0;
+        }
+    }
+
+    /* Order the ports by segment. */
+    {
+        int ordered[256], rordered[256];
+        int n = 0;
+
+        for(i = 0; i < count; i++) {
+            int j;
+            if(assigned[i]) {
+                continue;
+            }
+            b->groups[b->group_count++] = n;
+            for(j = i; j < count; j++) {
+                if(!assigned[j] && segments[j] == segments[i]) {
+                    ordered[n] = b->ports[j];
+                    rordered[n] = b->rports[j];
+                    assigned[j] = 1;
+                    n++;
+                }
+            }
+        }
+        b->groups[b->group_count] = n;
+        memcpy(b->ports, ordered, sizeof(int) * n);
+        memcpy(b->rports, rordered, sizeof(int) * n);
+    }
+
+    threads = b->group_count;
+    if(threads > ONLP_CONFIG_SFP_BULK_THREADS_MAX) {
+        threads = ONLP_CONFIG_SFP_BULK_THREADS_MAX;
+    }
+
+    for(i = 0; i < threads - 1; i++) {
+        if(pthread_create(tids + i, NULL, sfp_bulk_worker__, b) != 0) {
+            AIM_LOG_ERROR("sfp bulk: pthread_create failed.");
+            break;
+        }
+    }
+
+    /* The calling thread is also a worker. */
+    sfp_bulk_worker__(b);
+
+    for(g = 0; g < i; g++) {
+        pthread_join(tids[g], NULL);
+    }
+
+    pthread_mutex_destroy(&b->lock);
+    aim_free(b);
+
+    AIM_BITMAP_ITER(ports, p) {
+        if(status[p] < 0) {
+            return status[p];
+        }
+    }
+    return ONLP_STATUS_OK;
+}
+
+static int
+onlp_sfp_eeprom_read_bulk_locked__(onlp_sfp_bitmap_t* ports,
+                                   onlp_sfp_data_t* data, int* status)
+{
+    int p, rv;
+    onlp_sfp_bitmap_t misses;
+    uint32_t generations[256];
+
+    if(ports == NULL || data == NULL || status == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    /* Satisfy what we can from the cache and bulk read the rest. */
+    onlp_sfp_bitmap_t_init(&misses);
+    AIM_BITMAP_ITER(ports, p) {
+        int rport = p;
+        if(AIM_BITMAP_GET(&sfpi_bitmap__, p) &&
+           onlp_sfpi_port_map(p, &rport) < 0) {
+            rport = p;
+        }
+        if(AIM_BITMAP_GET(&sfpi_bitmap__, p) &&
+           sfp_eeprom_cache_get__(p, rport, data[p])) {
+            status[p] = ONLP_STATUS_OK;
+        }
+        else {
+            generations[p] = sfp_eeprom_cache__[p].generation;
+            AIM_BITMAP_SET(&misses, p);
+        }
+    }
+
+    if(AIM_BITMAP_COUNT(&misses) == 0) {
+        return ONLP_STATUS_OK;
+    }
+
+    rv = sfp_read_bulk__(&misses, data, status, 0);
+
+    AIM_BITMAP_ITER(&misses, p) {
+        if(status[p] >= 0) {
+            sfp_eeprom_cache_put__(p, generations[p], data[p]);
+        }
+    }
+
+    if(rv >= 0) {
+        AIM_BITMAP_ITER(ports, p) {
+            if(status[p] < 0) {
+                return status[p];
+            }
+        }
+    }
+    return rv;
+}
+ONLP_LOCKED_API3(onlp_sfp_eeprom_read_bulk, onlp_sfp_bitmap_t*, ports,
+                 onlp_sfp_data_t*, data, int*, status);
+
+static int
+onlp_sfp_dom_read_bulk_locked__(onlp_sfp_bitmap_t* ports,
+                                onlp_sfp_data_t* data, int* status)
+{
+    return sfp_read_bulk__(ports, data, status, 1);
+}
+ONLP_LOCKED_API3(onlp_sfp_dom_read_bulk, onlp_sfp_bitmap_t*, ports,
+                 onlp_sfp_data_t*, data, int*, status);
+
 void
 onlp_sfp_dump(aim_pvs_t* pvs)
 {
@@ -245,7 +1175,9 @@ onlp_sfp_dump(aim_pvs_t* pvs)
 static int
 onlp_sfp_post_insert_locked__(int port, sff_info_t* info)
 {
+    int lport = port;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
+    sfp_eeprom_cache_bump__(lport);
     return onlp_sfpi_post_insert(port, info);
 }
 ONLP_LOCKED_API2(onlp_sfp_post_insert, int, port, sff_info_t*, info);
@@ -319,7 +1251,10 @@ ONLP_LOCKED_API3(onlp_sfp_control_get, int, port, onlp_sfp_control_t, control,
 static int
 onlp_sfp_rx_los_bitmap_get_locked__(onlp_sfp_bitmap_t* dst)
 {
-    int rv = onlp_sfpi_rx_los_bitmap_get(dst);
+    int rv = onlp_telemetry_sfp_bitmap_get__(ONLP_TELEMETRY_SFP_RX_LOS, dst);
+    if(rv == ONLP_STATUS_E_UNSUPPORTED) {
+        rv = onlp_sfpi_rx_los_bitmap_get(dst);
+    }
 
     if(rv == ONLP_STATUS_E_UNSUPPORTED) {
         /* Generate from control API */
@@ -411,7 +1346,11 @@ ONLP_LOCKED_API3(onlp_sfp_dev_readb, int, port, uint8_t, devaddr, uint8_t, addr)
 int
 onlp_sfp_dev_writeb_locked__(int port, uint8_t devaddr, uint8_t addr, uint8_t value)
 {
+    int lport = port;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
+    if(devaddr == 0x50) {
+        sfp_eeprom_cache_bump__(lport);
+    }
     return onlp_sfpi_dev_writeb(port, devaddr, addr, value);
 }
 ONLP_LOCKED_API4(onlp_sfp_dev_writeb, int, port, uint8_t, devaddr, uint8_t, addr, uint8_t, value);
@@ -427,7 +1366,11 @@ ONLP_LOCKED_API3(onlp_sfp_dev_readw, int, port, uint8_t, devaddr, uint8_t, addr)
 int
 onlp_sfp_dev_writew_locked__(int port, uint8_t devaddr, uint8_t addr, uint16_t value)
 {
+    int lport = port;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
+    if(devaddr == 0x50) {
+        sfp_eeprom_cache_bump__(lport);
+    }
     return onlp_sfpi_dev_writew(port, devaddr, addr, value);
 }
 ONLP_LOCKED_API4(onlp_sfp_dev_writew, int, port, uint8_t, devaddr, uint8_t, addr, uint16_t, value);
@@ -443,7 +1386,251 @@ ONLP_LOCKED_API5(onlp_sfp_dev_read, int, port, uint8_t, devaddr, uint8_t, addr,
 int
 onlp_sfp_dev_write_locked__(int port, uint8_t devaddr, uint8_t addr, uint8_t* data, int size)
 {
+    int lport = port;
     ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
+    if(devaddr == 0x50) {
+        sfp_eeprom_cache_bump__(lport);
+    }
     return onlp_sfpi_dev_write(port, devaddr, addr, data, size);
 }
 ONLP_LOCKED_API5(onlp_sfp_dev_write, int, port, uint8_t, devaddr, uint8_t, addr, uint8_t*, data, int, size);
+
+/*
+ * Upper page select register for paged transceiver memory
+ * (SFF-8472 A2h, SFF-8636 and CMIS).
+ */
+#define SFP_MEM_PAGE_SELECT__ 127
+
+/*
+ * Transceiver memory models.
+ *
+ * FLAT:       No page select register. Only page 0 exists.
+ * PAGED:      SFF-8636 or CMIS paged memory at 0x50.
+ * PAGED_A2:   SFF-8472 paged memory at 0x51. A0h is never paged.
+ */
+#define SFP_MEM_MODEL_FLAT__     1
+#define SFP_MEM_MODEL_PAGED__    2
+#define SFP_MEM_MODEL_PAGED_A2__ 3
+
+static int
+sfp_mem_validate__(uint8_t devaddr, int page, int offset, int len, uint8_t* buf)
+{
+    if(buf == NULL || len <= 0 || offset < 0 || offset + len > 256) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    if(page > 255) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    if(devaddr != 0x50 && devaddr != 0x51) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    return ONLP_STATUS_OK;
+}
+
+/*
+ * Determine the memory model from the module identifier (SFF-8024)
+ * and its flat memory or paging indicator. The result is kept until
+ * the next presence transition.
+ */
+static int
+sfp_mem_model__(int lport, int port)
+{
+    sfp_eeprom_cache_t* c = sfp_eeprom_cache__ + lport;
+    int id, v;
+    int model = SFP_MEM_MODEL_FLAT__;
+
+    if(c->model && c->model_generation == c->generation) {
+        return c->model;
+    }
+
+    if((id = onlp_sfpi_dev_readb(port, 0x50, 0)) < 0) {
+        return id;
+    }
+
+    switch(id)
+        {
+        case 0x0C: /* QSFP */
+        case 0x0D: /* QSFP+ */
+        case 0x11: /* QSFP28 */
+            /* SFF-8636 byte 2 bit 2: Flat_mem */
+            if((v = onlp_sfpi_dev_readb(port, 0x50, 2)) < 0) {
+                return v;
+            }
+            model = (v & 0x04) ? SFP_MEM_MODEL_FLAT__ : SFP_MEM_MODEL_PAGED__;
+            break;
+
+        case 0x18: /* QSFP-DD */
+        case 0x19: /* OSFP */
+        case 0x1E: /* QSFP+ or later with CMIS */
+            /* CMIS byte 2 bit 7: MemoryModel */
+            if((v = onlp_sfpi_dev_readb(port, 0x50, 2)) < 0) {
+                return v;
+            }
+            model = (v & 0x80) ? SFP_MEM_MODEL_FLAT__ : SFP_MEM_MODEL_PAGED__;
+            break;
+
+        case 0x03: /* SFP/SFP+/SFP28 */
+            /* SFF-8472 A0h byte 64 bit 4: Paging implemented */
+            if((v = onlp_sfpi_dev_readb(port, 0x50, 64)) < 0) {
+                return v;
+            }
+            model = (v & 0x10) ? SFP_MEM_MODEL_PAGED_A2__ : SFP_MEM_MODEL_FLAT__;
+            break;
+
+        default:
+            break;
+        }
+
+    c->model = model;
+    c->model_generation = c->generation;
+    return model;
+}
+
+/*
+ * Select page 0 again after an access which selected another page.
+ */
+static void
+sfp_mem_page_restore__(int lport, int port, uint8_t devaddr, int* restore)
+{
+    int rv;
+
+    if(*restore == 0) {
+        return;
+    }
+    *restore = 0;
+    rv = onlp_sfpi_dev_writeb(port, devaddr, SFP_MEM_PAGE_SELECT__, 0);
+    if(rv < 0) {
+        AIM_LOG_ERROR("port %d: failed to select page 0: %{onlp_status}",
+                      lport, rv);
+    }
+}
+
+/*
+ * Select the requested upper page if the access touches it.
+ *
+ * Pages are only selected on devices which implement a page select
+ * register. The register is read first and is only written if the
+ * page differs. '*restore' is set if a nonzero page is now selected;
+ * the caller must then call sfp_mem_page_restore__() once the access
+ * is complete, whatever its outcome, because other readers (other
+ * processes, optoe, the full EEPROM and DOM reads) expect page 0.
+ */
+static int
+sfp_mem_page_select__(int lport, int port, uint8_t devaddr, int page,
+                      int offset, int len, int* restore)
+{
+    int rv, model;
+
+    *restore = 0;
+    if(page < 0 || offset + len <= 128) {
+        return ONLP_STATUS_OK;
+    }
+
+    if((model = sfp_mem_model__(lport, port)) < 0) {
+        return model;
+    }
+
+    if(!((model == SFP_MEM_MODEL_PAGED__ && devaddr == 0x50) ||
+         (model == SFP_MEM_MODEL_PAGED_A2__ && devaddr == 0x51))) {
+        /* Unpaged. Only page 0 is available. */
+        return (page == 0) ? ONLP_STATUS_OK : ONLP_STATUS_E_UNSUPPORTED;
+    }
+
+    if((rv = onlp_sfpi_dev_readb(port, devaddr, SFP_MEM_PAGE_SELECT__)) < 0) {
+        return rv;
+    }
+    if(rv != page) {
+        /* A failed write may still have changed the page. */
+        *restore = 1;
+        rv = onlp_sfpi_dev_writeb(port, devaddr, SFP_MEM_PAGE_SELECT__, page);
+        if(rv < 0) {
+            sfp_mem_page_restore__(lport, port, devaddr, restore);
+            return rv;
+        }
+    }
+    *restore = (page != 0);
+    return ONLP_STATUS_OK;
+}
+
+static int
+onlp_sfp_mem_read_locked__(int port, uint8_t devaddr, int page, int offset,
+                           int len, uint8_t* buf)
+{
+    int rv;
+    int lport = port;
+    int restore;
+    uint8_t data[256];
+
+    ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
+
+    if((rv = sfp_mem_validate__(devaddr, page, offset, len, buf)) < 0) {
+        return rv;
+    }
+
+    rv = onlp_sfpi_mem_read(port, devaddr, page, offset, len, buf);
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        return rv;
+    }
+
+    /* Generic page select and partial read. */
+    if((rv = sfp_mem_page_select__(lport, port, devaddr, page, offset, len,
+                                   &restore)) < 0) {
+        return rv;
+    }
+    rv = onlp_sfpi_dev_read(port, devaddr, offset, buf, len);
+    sfp_mem_page_restore__(lport, port, devaddr, &restore);
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        return (rv < 0) ? rv : ONLP_STATUS_OK;
+    }
+
+    /*
+     * No partial read support. Only the unpaged view can be
+     * satisfied from the full EEPROM/DOM read.
+     */
+    if(page > 0 && offset + len > 128) {
+        return ONLP_STATUS_E_UNSUPPORTED;
+    }
+    rv = (devaddr == 0x50) ?
+        onlp_sfpi_eeprom_read(port, data) : onlp_sfpi_dom_read(port, data);
+    if(rv < 0) {
+        return rv;
+    }
+    ONLP_MEMCPY(buf, data + offset, len);
+    return ONLP_STATUS_OK;
+}
+ONLP_LOCKED_API6(onlp_sfp_mem_read, int, port, uint8_t, devaddr, int, page,
+                 int, offset, int, len, uint8_t*, buf);
+
+static int
+onlp_sfp_mem_write_locked__(int port, uint8_t devaddr, int page, int offset,
+                            int len, uint8_t* buf)
+{
+    int rv;
+    int lport = port;
+    int restore;
+
+    ONLP_SFP_PORT_VALIDATE_AND_MAP(port);
+
+    if((rv = sfp_mem_validate__(devaddr, page, offset, len, buf)) < 0) {
+        return rv;
+    }
+
+    if(devaddr == 0x50) {
+        sfp_eeprom_cache_bump__(lport);
+    }
+
+    rv = onlp_sfpi_mem_write(port, devaddr, page, offset, len, buf);
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        return rv;
+    }
+
+    if((rv = sfp_mem_page_select__(lport, port, devaddr, page, offset, len,
+                                   &restore)) < 0) {
+        return rv;
+    }
+    rv = onlp_sfpi_dev_write(port, devaddr, offset, buf, len);
+    sfp_mem_page_restore__(lport, port, devaddr, &restore);
+    return (rv < 0) ? rv : ONLP_STATUS_OK;
+}
+ONLP_LOCKED_API6(onlp_sfp_mem_write, int, port, uint8_t, devaddr, int, page,
+                 int, offset, int, len, uint8_t*, buf);
@@ -0,0 +1,154 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ *
+ * Platform Snapshot
+ *
+ ***********************************************************/
+#include <onlp/snapshot.h>
+#include <AIM/aim_time.h>
+#include <stddef.h>
+#include "onlp_log.h"
+
+#define SNAPSHOT_ADD(_table, _oid, _get)                                \
+    do {                                                                \
+        uint32_t _i;                                                    \
+        for(_i = 0; _i < (_table)->count; _i++) {                       \
+            if((_table)->info[_i].hdr.id == (_oid)) {                   \
+                return ONLP_STATUS_OK;                                  \
+            }                                                           \
+        }                                                               \
+        if((_table)->count >= ONLP_SNAPSHOT_OID_MAX) {                  \
+            AIM_LOG_ERROR("Snapshot table is full (0x%x)", (_oid));     \
+            return ONLP_STATUS_OK;                                      \
+        }                                                               \
+        _i = (_table)->count++;                                         \
+        (_table)->status[_i] = _get((_oid), &(_table)->info[_i]);       \
+        (_table)->info[_i].hdr.id = (_oid);                             \
+    } while(0)
+
+static int
+snapshot_oid__(onlp_oid_t oid, void* cookie)
+{
+    onlp_snapshot_t* s = (onlp_snapshot_t*)cookie;
+
+    switch(ONLP_OID_TYPE_GET(oid))
+        {
+        case ONLP_OID_TYPE_THERMAL:
+            SNAPSHOT_ADD(&s->thermals, oid, onlp_thermal_info_get);
+            break;
+        case ONLP_OID_TYPE_FAN:
+            SNAPSHOT_ADD(&s->fans, oid, onlp_fan_info_get);
+            break;
+        case ONLP_OID_TYPE_PSU:
+            SNAPSHOT_ADD(&s->psus, oid, onlp_psu_info_get);
+            break;
+        case ONLP_OID_TYPE_LED:
+            SNAPSHOT_ADD(&s->leds, oid, onlp_led_info_get);
+            break;
+        default:
+            break;
+        }
+    return ONLP_STATUS_OK;
+}
+
+static void
+snapshot_bitmap_export__(onlp_sfp_bitmap_t* bmap, uint32_t* words)
+{
+    int p;
+    AIM_BITMAP_ITER(bmap, p) {
+        if(p < ONLP_SNAPSHOT_SFP_PORTS) {
+            words[p / 32] |= (1U << (p % 32));
+        }
+    }
+}
+
+int
+onlp_snapshot_get(onlp_snapshot_t* s, uint32_t flags)
+{
+    int p, rv;
+    onlp_sfp_bitmap_t ports;
+    onlp_sfp_bitmap_t present;
+    onlp_sfp_bitmap_t rx_los;
+
+    if(s == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    /* Don't touch the (large) EEPROM and DOM areas unless they are requested. */
+    ONLP_MEMSET(s, 0, offsetof(onlp_snapshot_t, eeprom));
+    if(flags & ONLP_SNAPSHOT_F_EEPROM) {
+        ONLP_MEMSET(s->eeprom, 0, sizeof(s->eeprom));
+    }
+    if(flags & ONLP_SNAPSHOT_F_DOM) {
+        ONLP_MEMSET(s->dom, 0, sizeof(s->dom));
+    }
+
+    s->version = ONLP_SNAPSHOT_VERSION;
+    s->size = sizeof(*s);
+    s->flags = flags;
+    s->timestamp = aim_time_monotonic();
+
+    for(p = 0; p < ONLP_SNAPSHOT_SFP_PORTS; p++) {
+        s->eeprom_status[p] = ONLP_STATUS_E_MISSING;
+        s->dom_status[p] = ONLP_STATUS_E_MISSING;
+    }
+
+    rv = onlp_oid_hdr_get(ONLP_OID_SYS, &s->sys);
+    if(rv < 0) {
+        return rv;
+    }
+
+    rv = onlp_oid_iterate(ONLP_OID_SYS, 0, snapshot_oid__, s);
+    if(rv < 0) {
+        return rv;
+    }
+
+    onlp_sfp_bitmap_t_init(&ports);
+    onlp_sfp_bitmap_t_init(&present);
+    if(onlp_sfp_bitmap_get(&ports) < 0) {
+        /* No SFP ports */
+        return ONLP_STATUS_OK;
+    }
+    snapshot_bitmap_export__(&ports, s->ports);
+
+    s->presence_status = onlp_sfp_presence_bitmap_get(&present);
+    if(s->presence_status < 0) {
+        return ONLP_STATUS_OK;
+    }
+    snapshot_bitmap_export__(&present, s->presence);
+
+    onlp_sfp_bitmap_t_init(&rx_los);
+    s->rx_los_status = onlp_sfp_rx_los_bitmap_get(&rx_los);
+    if(s->rx_los_status >= 0) {
+        snapshot_bitmap_export__(&rx_los, s->rx_los);
+    }
+
+    /* Per-port results are reported in eeprom_status and dom_status. */
+    if(flags & ONLP_SNAPSHOT_F_EEPROM) {
+        onlp_sfp_eeprom_read_bulk(&present, s->eeprom, s->eeprom_status);
+    }
+    if(flags & ONLP_SNAPSHOT_F_DOM) {
+        onlp_sfp_dom_read_bulk(&present, s->dom, s->dom_status);
+    }
+
+    return ONLP_STATUS_OK;
+}
@@ -25,9 +25,15 @@
 #include <onlp/sys.h>
 #include <onlp/platformi/sysi.h>
 #include <onlplib/mmap.h>
+#include <onlplib/crc32.h>
 #include <AIM/aim.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
 #include "onlp_log.h"
 #include "onlp_int.h"
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_SYS
 #include "onlp_locks.h"
 
 static char*
@@ -96,9 +102,19 @@ onlp_sys_init_locked__(void)
     /* If we get here, its all good */
     aim_free((char*)current_platform);
     rv = onlp_sysi_init();
+
+#if ONLP_CONFIG_INCLUDE_API_LOCK == 1
+    {
+        uint32_t flags = 0;
+        if(onlp_sysi_api_lock_flags_get(&flags) < 0) {
+            flags = 0;
+        }
+        onlp_api_lock_flags_set__(flags);
+    }
+#endif
     return rv;
 }
-ONLP_LOCKED_API0(onlp_sys_init);
+ONLP_LOCKED_DAPI0(ONLP_API_LOCK_DOMAIN_GLOBAL, 0, onlp_sys_init);
 
 static uint8_t*
 onie_data_get__(int* free)
@@ -120,43 +136,366 @@ onie_data_get__(int* free)
     return ma;
 }
 
+/**
+ * Read and decode the system ONIE information and the platform
+ * information from the platform.
+ *
+ * If 'tlv' is specified it receives a copy of the raw TlvInfo
+ * data and its length is returned. Returns 0 if the ONIE information
+ * was decoded by the platform and < 0 if it is not available or the
+ * platform information could not be read. Neither is cached then.
+ * A platform which does not support the platform information has
+ * none, which is cached like any other result.
+ */
 static int
-onlp_sys_info_get_locked__(onlp_sys_info_t* rv)
+sys_info_read__(onlp_onie_info_t* onie_info, onlp_platform_info_t* pi,
+                uint8_t** tlv)
 {
-    if(rv == NULL) {
-        return -1;
-    }
-
-    memset(rv, 0, sizeof(*rv));
-
-    /**
-     * Get the system ONIE information.
-     */
-    int free;
+    int free, rv;
+    int len = -1;
     uint8_t* onie_data = onie_data_get__(&free);
 
     if(onie_data) {
-        onlp_onie_decode(&rv->onie_info, onie_data, -1);
+        if(onlp_onie_decode(onie_info, onie_data, -1) == 0 && tlv) {
+            len = onlp_onie_data_validate(onie_data, 64*1024, NULL);
+            if(len > 0) {
+                *tlv = aim_malloc(len);
+                memcpy(*tlv, onie_data, len);
+            }
+        }
         if(free) {
             onlp_sysi_onie_data_free(onie_data);
         }
     }
     else {
-        if(onlp_sysi_onie_info_get(&rv->onie_info) != 0) {
-            memset(&rv->onie_info, 0, sizeof(rv->onie_info));
-            list_init(&rv->onie_info.vx_list);
+        if(onlp_sysi_onie_info_get(onie_info) != 0) {
+            memset(onie_info, 0, sizeof(*onie_info));
+            list_init(&onie_info->vx_list);
+        }
+        else {
+            len = 0;
         }
     }
 
-    /*
-     * Query the sys oids
+    rv = onlp_sysi_platform_info_get(pi);
+    if(rv == ONLP_STATUS_E_UNSUPPORTED) {
+        /* The platform has no version strings. That is a valid answer. */
+        memset(pi, 0, sizeof(*pi));
+        rv = 0;
+    }
+    if(rv < 0) {
+        AIM_LOG_ERROR("Platform information not available: %{onlp_status}", rv);
+        if(tlv) {
+            aim_free(*tlv);
+            *tlv = NULL;
+        }
+        return rv;
+    }
+    return len;
+}
+
+#if ONLP_CONFIG_INCLUDE_ONIE_CACHE == 1
+
+/**
+ * System Information Cache
+ *
+ * The ONIE and platform information are read from the platform once
+ * per process. The raw TlvInfo data and the platform information are
+ * also persisted to ONLP_CONFIG_ONIE_CACHE_FILENAME so later processes
+ * do not need to access the EEPROM or /dev/mem at all.
+ *
+ * The file is keyed by the TlvInfo CRC. It is only used if the
+ * TlvInfo data passes its checksum, its CRC matches the key and the
+ * platform information matches its own CRC.
+ */
+
+#define SYS_CACHE_MAGIC   0x4F4E4945
+#define SYS_CACHE_VERSION 1
+
+typedef struct sys_cache_hdr_s {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t crc;       /* TlvInfo CRC */
+    uint32_t tlv_size;
+    uint32_t pi_size;
+    uint32_t pi_crc;    /* Platform information CRC */
+} sys_cache_hdr_t;
+
+static struct {
+    int valid;
+    onlp_onie_info_t onie_info;
+    onlp_platform_info_t platform_info;
+} sys_cache__;
+
+/*
+ * The platform information strings are stored as a presence
+ * byte followed by the nul-terminated string.
+ */
+static int
+pi_string_pack__(uint8_t* buf, const char* s)
+{
+    int len = s ? ONLP_STRLEN(s) + 1 : 0;
+    if(buf) {
+        buf[0] = s ? 1 : 0;
+        if(s) {
+            memcpy(buf + 1, s, len);
+        }
+    }
+    return 1 + len;
+}
+
+static int
+pi_string_unpack__(const uint8_t* buf, int size, char** s)
+{
+    int len;
+    if(size < 1) {
+        return -1;
+    }
+    if(buf[0] == 0) {
+        *s = NULL;
+        return 1;
+    }
+    len = strnlen((const char*)buf + 1, size - 1);
+    if(len == size - 1) {
+        return -1;
+    }
+    *s = aim_strdup((const char*)buf + 1);
+    return len + 2;
+}
+
+static void
+pi_free__(onlp_platform_info_t* pi)
+{
+    aim_free(pi->cpld_versions);
+    aim_free(pi->other_versions);
+    memset(pi, 0, sizeof(*pi));
+}
+
+static void
+pi_copy__(onlp_platform_info_t* dst, const onlp_platform_info_t* src)
+{
+    dst->cpld_versions = src->cpld_versions ? aim_strdup(src->cpld_versions) : NULL;
+    dst->other_versions = src->other_versions ? aim_strdup(src->other_versions) : NULL;
+}
+
+static int
+sys_cache_load__(void)
+{
+    FILE* fp;
+    long size;
+    uint8_t* data = NULL;
+    sys_cache_hdr_t* hdr;
+    uint8_t* pi;
+    uint32_t crc;
+    int rv = -1;
+    int len;
+
+    if((fp = fopen(ONLP_CONFIG_ONIE_CACHE_FILENAME, "rb")) == NULL) {
+        return -1;
+    }
+
+    if(fseek(fp, 0L, SEEK_END) < 0 || (size = ftell(fp)) < (long)sizeof(*hdr)) {
+        goto done;
+    }
+    rewind(fp);
+    data = aim_malloc(size);
+    if(fread(data, 1, size, fp) != size) {
+        goto done;
+    }
+
+    hdr = (sys_cache_hdr_t*)data;
+    if(hdr->magic != SYS_CACHE_MAGIC || hdr->version != SYS_CACHE_VERSION ||
+       size != sizeof(*hdr) + hdr->tlv_size + hdr->pi_size) {
+        goto done;
+    }
+
+    if(onlp_onie_data_validate(data + sizeof(*hdr), hdr->tlv_size, &crc) != (int)hdr->tlv_size ||
+       crc != hdr->crc) {
+        AIM_LOG_WARN("Ignoring invalid system information cache %s.",
+                     ONLP_CONFIG_ONIE_CACHE_FILENAME);
+        goto done;
+    }
+
+    pi = data + sizeof(*hdr) + hdr->tlv_size;
+    if(onlp_crc32(0, pi, hdr->pi_size) != hdr->pi_crc) {
+        AIM_LOG_WARN("Ignoring invalid system information cache %s.",
+                     ONLP_CONFIG_ONIE_CACHE_FILENAME);
+        goto done;
+    }
+
+    if(onlp_onie_decode(&sys_cache__.onie_info, data + sizeof(*hdr), hdr->tlv_size) < 0) {
+        onlp_onie_info_free(&sys_cache__.onie_info);
+        goto done;
+    }
+
+    if((len = pi_string_unpack__(pi, hdr->pi_size,
+                                 &sys_cache__.platform_info.cpld_versions)) < 0 ||
+       pi_string_unpack__(pi + len, hdr->pi_size - len,
+                          &sys_cache__.platform_info.other_versions) < 0) {
+        onlp_onie_info_free(&sys_cache__.onie_info);
+        pi_free__(&sys_cache__.platform_info);
+        goto done;
+    }
+
+    rv = 0;
+
+ done:
+    if(rv < 0) {
+        memset(&sys_cache__, 0, sizeof(sys_cache__));
+    }
+    aim_free(data);
+    fclose(fp);
+    return rv;
+}
+
+static void
+sys_cache_store__(const uint8_t* tlv, int tlv_size)
+{
+    FILE* fp;
+    char* tmp;
+    char* dir;
+    uint8_t* pi;
+    sys_cache_hdr_t hdr;
+    onlp_platform_info_t* spi = &sys_cache__.platform_info;
+    int rv;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SYS_CACHE_MAGIC;
+    hdr.version = SYS_CACHE_VERSION;
+    hdr.tlv_size = tlv_size;
+    onlp_onie_data_validate(tlv, tlv_size, &hdr.crc);
+
+    hdr.pi_size = pi_string_pack__(NULL, spi->cpld_versions) +
+        pi_string_pack__(NULL, spi->other_versions);
+    pi = aim_zmalloc(hdr.pi_size);
+    pi_string_pack__(pi + pi_string_pack__(pi, spi->cpld_versions),
+                     spi->other_versions);
+    hdr.pi_crc = onlp_crc32(0, pi, hdr.pi_size);
+
+    dir = aim_strdup(ONLP_CONFIG_ONIE_CACHE_FILENAME);
+    mkdir(dirname(dir), 0755);
+    aim_free(dir);
+
+    /* Written to a temporary file and renamed so readers never see a partial file. */
+    tmp = aim_fstrdup("%s.%d", ONLP_CONFIG_ONIE_CACHE_FILENAME, getpid());
+    if((fp = fopen(tmp, "wb")) == NULL) {
+        AIM_LOG_VERBOSE("Could not create %s: %{errno}", tmp, errno);
+    }
+    else {
+        rv = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+              fwrite(tlv, tlv_size, 1, fp) == 1 &&
+              fwrite(pi, hdr.pi_size, 1, fp) == 1);
+        if(fclose(fp) == 0 && rv && rename(tmp, ONLP_CONFIG_ONIE_CACHE_FILENAME) == 0) {
+            AIM_LOG_VERBOSE("System information cached in %s (crc 0x%.8x)",
+                            ONLP_CONFIG_ONIE_CACHE_FILENAME, hdr.crc);
+        }
+        else {
+            AIM_LOG_VERBOSE("Could not write %s: %{errno}", tmp, errno);
+            unlink(tmp);
+        }
+    }
+    aim_free(tmp);
+    aim_free(pi);
+}
+
+/**
+ * Get the ONIE and platform information, from the cache if possible.
+ * The results are always copies which must be released with
+ * onlp_onie_info_free() and pi_free__().
+ */
+static void
+sys_info_get__(onlp_onie_info_t* onie_info, onlp_platform_info_t* pi)
+{
+    if(!sys_cache__.valid) {
+        if(sys_cache_load__() == 0) {
+            sys_cache__.valid = 1;
+        }
+        else {
+            uint8_t* tlv = NULL;
+            onlp_platform_info_t ppi;
+            int len;
+
+            memset(&ppi, 0, sizeof(ppi));
+            len = sys_info_read__(&sys_cache__.onie_info, &ppi, &tlv);
+
+            /* The platform strings are not necessarily allocated with aim_malloc(). */
+            pi_copy__(&sys_cache__.platform_info, &ppi);
+            onlp_sysi_platform_info_free(&ppi);
+
+            if(len > 0) {
+                sys_cache_store__(tlv, len);
+                aim_free(tlv);
+                sys_cache__.valid = 1;
+            }
+            else if(len == 0) {
+                /* Decoded by the platform. Cached for this process only. */
+                sys_cache__.valid = 1;
+            }
+        }
+    }
+
+    onlp_onie_info_copy(onie_info, &sys_cache__.onie_info);
+    pi_copy__(pi, &sys_cache__.platform_info);
+
+    if(!sys_cache__.valid) {
+        /* No valid ONIE data. Do not cache the failure. */
+        onlp_onie_info_free(&sys_cache__.onie_info);
+        pi_free__(&sys_cache__.platform_info);
+        memset(&sys_cache__, 0, sizeof(sys_cache__));
+    }
+}
+
+static int
+onlp_sys_info_cache_clear_locked__(void)
+{
+    if(sys_cache__.valid) {
+        onlp_onie_info_free(&sys_cache__.onie_info);
+        pi_free__(&sys_cache__.platform_info);
+        memset(&sys_cache__, 0, sizeof(sys_cache__));
+    }
+    if(unlink(ONLP_CONFIG_ONIE_CACHE_FILENAME) < 0 && errno != ENOENT) {
+        AIM_LOG_ERROR("Could not remove %s: %{errno}",
+                      ONLP_CONFIG_ONIE_CACHE_FILENAME, errno);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    return ONLP_STATUS_OK;
+}
+ONLP_LOCKED_API0(onlp_sys_info_cache_clear);
+
+#else
+
+static void
+sys_info_get__(onlp_onie_info_t* onie_info, onlp_platform_info_t* pi)
+{
+    sys_info_read__(onie_info, pi, NULL);
+}
+
+int
+onlp_sys_info_cache_clear(void)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+#endif /* ONLP_CONFIG_INCLUDE_ONIE_CACHE */
+
+static int
+onlp_sys_info_get_locked__(onlp_sys_info_t* rv)
+{
+    if(rv == NULL) {
+        return -1;
+    }
+
+    memset(rv, 0, sizeof(*rv));
+
+    /**
+     * Get the system ONIE and platform information.
      */
-    onlp_sysi_oids_get(rv->hdr.coids, AIM_ARRAYSIZE(rv->hdr.coids));
+    sys_info_get__(&rv->onie_info, &rv->platform_info);
 
     /*
-     * Platform Information
+     * Query the sys oids
      */
-    onlp_sysi_platform_info_get(&rv->platform_info);
+    onlp_sysi_oids_get(rv->hdr.coids, AIM_ARRAYSIZE(rv->hdr.coids));
 
     return 0;
 }
@@ -166,7 +505,11 @@ void
 onlp_sys_info_free(onlp_sys_info_t* info)
 {
     onlp_onie_info_free(&info->onie_info);
+#if ONLP_CONFIG_INCLUDE_ONIE_CACHE == 1
+    pi_free__(&info->platform_info);
+#else
     onlp_sysi_platform_info_free(&info->platform_info);
+#endif
 }
 
 static int
@@ -175,7 +518,7 @@ onlp_sys_hdr_get_locked__(onlp_oid_hdr_t* hdr)
     memset(hdr, 0, sizeof(*hdr));
     return onlp_sysi_oids_get(hdr->coids, AIM_ARRAYSIZE(hdr->coids));
 }
-ONLP_LOCKED_API1(onlp_sys_hdr_get, onlp_oid_hdr_t*, hdr);
+ONLP_LOCKED_RAPI1(onlp_sys_hdr_get, onlp_oid_hdr_t*, hdr);
 
 
 void
@@ -295,11 +638,11 @@ onlp_sys_vioctl_locked__(int code, va_list vargs)
 {
     return onlp_sysi_ioctl(code, vargs);
 }
-ONLP_LOCKED_API2(onlp_sys_vioctl, int, code, va_list, vargs);
+ONLP_LOCKED_DAPI2(ONLP_API_LOCK_DOMAIN_GLOBAL, 0, onlp_sys_vioctl, int, code, va_list, vargs);
 
 static int
 onlp_sys_debug_locked__(aim_pvs_t* pvs, int argc, char* argv[])
 {
     return onlp_sysi_debug(pvs, argc, argv);
 }
-ONLP_LOCKED_API3(onlp_sys_debug, aim_pvs_t*, pvs, int, argc, char**, argv);
+ONLP_LOCKED_DAPI3(ONLP_API_LOCK_DOMAIN_GLOBAL, 0, onlp_sys_debug, aim_pvs_t*, pvs, int, argc, char**, argv);
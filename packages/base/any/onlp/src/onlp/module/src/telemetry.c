@@ -0,0 +1,1034 @@
+/************************************************************
+ * <bsn.cl fy=2014 v=onl>
+ *
+ *        Copyright 2014, 2015 Big Switch Networks, Inc.
+ *
+ * Licensed under the Eclipse Public License, Version 1.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *        http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the
+ * License.
+ *
+ * </bsn.cl>
+ ************************************************************
+ *
+ *
+ * Platform Telemetry Service
+ *
+ ***********************************************************/
+#include <onlp/telemetry.h>
+#include <onlp/sfp.h>
+#include <onlplib/file_uds.h>
+#include <AIM/aim_time.h>
+#include <cjson_util/cjson_util.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#include "onlp_int.h"
+#include "onlp_log.h"
+
+#if ONLP_CONFIG_INCLUDE_TELEMETRY == 1
+
+/** The maximum number of subscriptions. */
+#define TELEMETRY_SUBSCRIBERS_MAX 32
+
+/** Socket timeout (us). */
+#define TELEMETRY_TIMEOUT_US 1000000
+
+/** The snapshot content which determines the generation. */
+#define TELEMETRY_CONTENT_OFFSET offsetof(onlp_snapshot_t, sys)
+#define TELEMETRY_CONTENT_SIZE (sizeof(onlp_snapshot_t) - TELEMETRY_CONTENT_OFFSET)
+
+static int
+telemetry_interval__(void)
+{
+    int v = ONLP_CONFIG_TELEMETRY_INTERVAL_MS;
+    cjson_util_lookup_int(onlp_json_get(0), &v, "telemetry.interval");
+    return (v > 0) ? v : ONLP_CONFIG_TELEMETRY_INTERVAL_MS;
+}
+
+static void
+telemetry_timeouts__(int fd)
+{
+    struct timeval tv;
+    tv.tv_sec = TELEMETRY_TIMEOUT_US / 1000000;
+    tv.tv_usec = TELEMETRY_TIMEOUT_US % 1000000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static int
+telemetry_send__(int fd, const void* data, int size, int flags)
+{
+    const uint8_t* p = data;
+    while(size > 0) {
+        ssize_t rv = send(fd, p, size, flags | MSG_NOSIGNAL);
+        if(rv < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return ONLP_STATUS_E_INTERNAL;
+        }
+        p += rv;
+        size -= rv;
+    }
+    return ONLP_STATUS_OK;
+}
+
+static int
+telemetry_recv__(int fd, void* data, int size)
+{
+    uint8_t* p = data;
+    while(size > 0) {
+        ssize_t rv = recv(fd, p, size, 0);
+        if(rv < 0 && errno == EINTR) {
+            continue;
+        }
+        if(rv <= 0) {
+            return ONLP_STATUS_E_INTERNAL;
+        }
+        p += rv;
+        size -= rv;
+    }
+    return ONLP_STATUS_OK;
+}
+
+static int
+telemetry_reply_check__(onlp_telemetry_reply_t* reply, uint32_t op)
+{
+    if(reply->magic != ONLP_TELEMETRY_MAGIC ||
+       reply->version != ONLP_TELEMETRY_VERSION ||
+       reply->op != op) {
+        AIM_LOG_ERROR("Invalid telemetry reply (magic 0x%x version %d op %d)",
+                      reply->magic, reply->version, reply->op);
+        return ONLP_STATUS_E_INVALID;
+    }
+    return reply->status;
+}
+
+
+/**
+ * The telemetry service.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_t thread;
+    int running;
+    int stopfd;
+    int collectfd;
+    onlp_file_uds_t* uds;
+
+    uint32_t flags;
+    int interval;
+
+    /** The published snapshot and the collection buffer. */
+    onlp_snapshot_t* snapshot;
+    onlp_snapshot_t* scratch;
+    uint32_t generation;
+
+    int subscribers[TELEMETRY_SUBSCRIBERS_MAX];
+} server__ = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void
+server_reply_init__(onlp_telemetry_reply_t* reply, uint32_t op, int status)
+{
+    ONLP_MEMSET(reply, 0, sizeof(*reply));
+    reply->magic = ONLP_TELEMETRY_MAGIC;
+    reply->version = ONLP_TELEMETRY_VERSION;
+    reply->op = op;
+    reply->status = status;
+    reply->generation = server__.generation;
+    reply->timestamp = server__.snapshot->timestamp;
+}
+
+static void
+server_notify_locked__(void)
+{
+    int i;
+    onlp_telemetry_reply_t reply;
+
+    server_reply_init__(&reply, ONLP_TELEMETRY_OP_NOTIFY, ONLP_STATUS_OK);
+    for(i = 0; i < TELEMETRY_SUBSCRIBERS_MAX; i++) {
+        int fd = server__.subscribers[i];
+        if(fd < 0) {
+            continue;
+        }
+        /* Never block the collector on a subscriber. */
+        if(telemetry_send__(fd, &reply, sizeof(reply), MSG_DONTWAIT) < 0) {
+            AIM_LOG_VERBOSE("Dropping telemetry subscriber %d: %{errno}", fd, errno);
+            close(fd);
+            server__.subscribers[i] = -1;
+        }
+    }
+}
+
+static void
+server_collect__(void)
+{
+    int rv;
+    uint32_t flags;
+    onlp_snapshot_t* s = server__.scratch;
+
+    pthread_mutex_lock(&server__.lock);
+    flags = server__.flags;
+    pthread_mutex_unlock(&server__.lock);
+
+    if((rv = onlp_snapshot_get(s, flags)) < 0) {
+        AIM_LOG_ERROR("Telemetry snapshot failed: %{onlp_status}", rv);
+        return;
+    }
+
+    pthread_mutex_lock(&server__.lock);
+    /* The flags say which data the snapshot carries. */
+    if(s->flags != server__.snapshot->flags ||
+       memcmp((uint8_t*)s + TELEMETRY_CONTENT_OFFSET,
+                   (uint8_t*)server__.snapshot + TELEMETRY_CONTENT_OFFSET,
+                   TELEMETRY_CONTENT_SIZE)) {
+        server__.scratch = server__.snapshot;
+        server__.snapshot = s;
+        if(++server__.generation == 0) {
+            /* 0 is reserved for clients without a snapshot. */
+            server__.generation = 1;
+        }
+        server_notify_locked__();
+    }
+    else {
+        server__.snapshot->timestamp = s->timestamp;
+    }
+    pthread_mutex_unlock(&server__.lock);
+}
+
+static void*
+server_thread__(void* arg)
+{
+    struct pollfd fds[3];
+
+    fds[0].fd = server__.stopfd;
+    fds[0].events = POLLIN;
+    /* Collect immediately when a transceiver is inserted or removed. */
+    fds[1].fd = onlp_sfp_presence_eventfd_open();
+    fds[1].events = POLLIN;
+    /* Collect immediately when the flags change. */
+    fds[2].fd = server__.collectfd;
+    fds[2].events = POLLIN;
+
+    for(;;) {
+        int rv = poll(fds, AIM_ARRAYSIZE(fds), server__.interval);
+        if(rv < 0 && errno != EINTR) {
+            AIM_LOG_ERROR("telemetry poll: %{errno}", errno);
+            break;
+        }
+        if(fds[0].revents & POLLIN) {
+            break;
+        }
+        if(fds[1].revents & POLLIN) {
+            uint64_t v;
+            if(read(fds[1].fd, &v, sizeof(v)) < 0) {
+                AIM_LOG_VERBOSE("presence eventfd read: %{errno}", errno);
+            }
+        }
+        if(fds[2].revents & POLLIN) {
+            uint64_t v;
+            if(read(fds[2].fd, &v, sizeof(v)) < 0) {
+                AIM_LOG_VERBOSE("collect eventfd read: %{errno}", errno);
+            }
+        }
+        server_collect__();
+    }
+
+    if(fds[1].fd >= 0) {
+        onlp_sfp_presence_eventfd_close(fds[1].fd);
+    }
+    return NULL;
+}
+
+static int
+server_subscribe_locked__(int fd)
+{
+    int i;
+    for(i = 0; i < TELEMETRY_SUBSCRIBERS_MAX; i++) {
+        if(server__.subscribers[i] < 0) {
+            server__.subscribers[i] = fd;
+            return i;
+        }
+    }
+    AIM_LOG_ERROR("Too many telemetry subscribers.");
+    return ONLP_STATUS_E_INTERNAL;
+}
+
+/**
+ * A snapshot reply being sent to a client.
+ *
+ * The handlers run on the shared file_uds thread, so a snapshot is
+ * sent by its own thread rather than stalling every other socket on
+ * a slow reader for up to the send timeout.
+ */
+typedef struct server_transfer_s {
+    int fd;
+    onlp_telemetry_reply_t reply;
+    onlp_snapshot_t snapshot;
+} server_transfer_t;
+
+static void*
+server_transfer_thread__(void* arg)
+{
+    server_transfer_t* t = arg;
+
+    if(telemetry_send__(t->fd, &t->reply, sizeof(t->reply), 0) == 0) {
+        telemetry_send__(t->fd, &t->snapshot, t->reply.size, 0);
+    }
+    close(t->fd);
+    aim_free(t);
+    return NULL;
+}
+
+/* Takes ownership of the descriptor if it succeeds. */
+static int
+server_transfer_start__(server_transfer_t* t)
+{
+    int rv;
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    rv = pthread_create(&thread, &attr, server_transfer_thread__, t);
+    pthread_attr_destroy(&attr);
+    if(rv != 0) {
+        AIM_LOG_ERROR("telemetry transfer pthread_create: %{errno}", rv);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    return ONLP_STATUS_OK;
+}
+
+static int
+server_handler__(int fd, void* cookie)
+{
+    int rv, slot;
+    onlp_telemetry_request_t request;
+    onlp_telemetry_reply_t reply;
+    server_transfer_t* transfer = NULL;
+
+    telemetry_timeouts__(fd);
+
+    if(telemetry_recv__(fd, &request, sizeof(request)) < 0) {
+        return 0;
+    }
+    if(request.magic != ONLP_TELEMETRY_MAGIC ||
+       request.version != ONLP_TELEMETRY_VERSION) {
+        AIM_LOG_ERROR("Invalid telemetry request (magic 0x%x version %d)",
+                      request.magic, request.version);
+        return 0;
+    }
+
+    pthread_mutex_lock(&server__.lock);
+    switch(request.op)
+        {
+        case ONLP_TELEMETRY_OP_GET:
+            server_reply_init__(&reply, request.op, ONLP_STATUS_OK);
+            if(request.generation != server__.generation) {
+                /* Sent below without holding the lock. */
+                reply.size = sizeof(onlp_snapshot_t);
+                transfer = aim_zmalloc(sizeof(*transfer));
+                transfer->fd = fd;
+                transfer->reply = reply;
+                ONLP_MEMCPY(&transfer->snapshot, server__.snapshot,
+                            sizeof(onlp_snapshot_t));
+            }
+            rv = 0;
+            break;
+
+        case ONLP_TELEMETRY_OP_SUBSCRIBE:
+            slot = server_subscribe_locked__(fd);
+            server_reply_init__(&reply, ONLP_TELEMETRY_OP_NOTIFY,
+                                (slot < 0) ? slot : ONLP_STATUS_OK);
+            rv = telemetry_send__(fd, &reply, sizeof(reply), MSG_DONTWAIT);
+            if(slot >= 0 && rv == 0) {
+                /* The subscription owns the descriptor now. */
+                rv = ONLP_FILE_UDS_HANDLER_KEEP;
+            }
+            else {
+                if(slot >= 0) {
+                    server__.subscribers[slot] = -1;
+                }
+                rv = 0;
+            }
+            break;
+
+        default:
+            server_reply_init__(&reply, request.op, ONLP_STATUS_E_PARAM);
+            rv = 0;
+            break;
+        }
+    pthread_mutex_unlock(&server__.lock);
+
+    if(transfer) {
+        if(server_transfer_start__(transfer) == 0) {
+            /* The transfer thread owns the descriptor now. */
+            return ONLP_FILE_UDS_HANDLER_KEEP;
+        }
+        aim_free(transfer);
+    }
+    else if(request.op != ONLP_TELEMETRY_OP_SUBSCRIBE) {
+        /* A bare reply fits in the socket buffer. Never block on it. */
+        telemetry_send__(fd, &reply, sizeof(reply), MSG_DONTWAIT);
+    }
+    return rv;
+}
+
+static int
+telemetry_config_bool__(const char* key, int dflt)
+{
+    cJSON* item = NULL;
+    cjson_util_lookup(onlp_json_get(0), &item, "telemetry.%s", key);
+    if(item == NULL) {
+        return dflt;
+    }
+    switch(item->type & 0xFF)
+        {
+        case cJSON_True: return 1;
+        case cJSON_False: return 0;
+        default:
+            AIM_LOG_ERROR("telemetry.%s must be a boolean.", key);
+            return dflt;
+        }
+}
+
+static void client_server_mode__(void);
+
+int
+onlp_telemetry_server_start(void)
+{
+    int i;
+
+    if(server__.running) {
+        return ONLP_STATUS_OK;
+    }
+
+    /* This process is the source of the telemetry. */
+    client_server_mode__();
+
+    server__.interval = telemetry_interval__();
+    server__.flags = 0;
+    if(telemetry_config_bool__("eeprom", 1)) {
+        server__.flags |= ONLP_SNAPSHOT_F_EEPROM;
+    }
+    if(telemetry_config_bool__("dom", 1)) {
+        server__.flags |= ONLP_SNAPSHOT_F_DOM;
+    }
+    for(i = 0; i < TELEMETRY_SUBSCRIBERS_MAX; i++) {
+        server__.subscribers[i] = -1;
+    }
+
+    server__.snapshot = aim_zmalloc(sizeof(onlp_snapshot_t));
+    server__.scratch = aim_zmalloc(sizeof(onlp_snapshot_t));
+    if(onlp_snapshot_get(server__.snapshot, server__.flags) < 0) {
+        AIM_LOG_ERROR("Initial telemetry snapshot failed.");
+    }
+    server__.generation = 1;
+
+    server__.collectfd = -1;
+    if((server__.stopfd = eventfd(0, EFD_CLOEXEC)) < 0 ||
+       (server__.collectfd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        AIM_LOG_ERROR("eventfd: %{errno}", errno);
+        goto failed;
+    }
+    if(pthread_create(&server__.thread, NULL, server_thread__, NULL) != 0) {
+        AIM_LOG_ERROR("pthread_create: %{errno}", errno);
+        goto failed;
+    }
+    server__.running = 1;
+
+    if(onlp_file_uds_create(&server__.uds) < 0 ||
+       onlp_file_uds_add(server__.uds, ONLP_CONFIG_TELEMETRY_SOCKET,
+                         server_handler__, NULL) < 0) {
+        AIM_LOG_ERROR("Failed to create the telemetry socket %s",
+                      ONLP_CONFIG_TELEMETRY_SOCKET);
+        onlp_telemetry_server_stop();
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    AIM_LOG_INFO("Telemetry service started on %s (interval %dms, flags 0x%x)",
+                 ONLP_CONFIG_TELEMETRY_SOCKET, server__.interval, server__.flags);
+    return ONLP_STATUS_OK;
+
+ failed:
+    if(server__.stopfd >= 0) {
+        close(server__.stopfd);
+    }
+    if(server__.collectfd >= 0) {
+        close(server__.collectfd);
+    }
+    aim_free(server__.snapshot);
+    aim_free(server__.scratch);
+    server__.snapshot = server__.scratch = NULL;
+    return ONLP_STATUS_E_INTERNAL;
+}
+
+int
+onlp_telemetry_server_stop(void)
+{
+    int i;
+    uint64_t v = 1;
+
+    if(!server__.running) {
+        return ONLP_STATUS_OK;
+    }
+
+    if(server__.uds) {
+        onlp_file_uds_destroy(server__.uds);
+        server__.uds = NULL;
+        unlink(ONLP_CONFIG_TELEMETRY_SOCKET);
+    }
+
+    if(write(server__.stopfd, &v, sizeof(v)) < 0) {
+        AIM_LOG_ERROR("eventfd write: %{errno}", errno);
+    }
+    pthread_join(server__.thread, NULL);
+    close(server__.stopfd);
+    close(server__.collectfd);
+    server__.running = 0;
+
+    for(i = 0; i < TELEMETRY_SUBSCRIBERS_MAX; i++) {
+        if(server__.subscribers[i] >= 0) {
+            close(server__.subscribers[i]);
+            server__.subscribers[i] = -1;
+        }
+    }
+    aim_free(server__.snapshot);
+    aim_free(server__.scratch);
+    server__.snapshot = server__.scratch = NULL;
+    return ONLP_STATUS_OK;
+}
+
+int
+onlp_telemetry_server_flags_set(uint32_t flags)
+{
+    uint64_t v = 1;
+
+    if(!server__.running) {
+        return ONLP_STATUS_E_INVALID;
+    }
+
+    pthread_mutex_lock(&server__.lock);
+    server__.flags = flags & (ONLP_SNAPSHOT_F_EEPROM | ONLP_SNAPSHOT_F_DOM);
+    pthread_mutex_unlock(&server__.lock);
+
+    /* Publish the new content without waiting for the interval. */
+    if(write(server__.collectfd, &v, sizeof(v)) < 0) {
+        AIM_LOG_ERROR("eventfd write: %{errno}", errno);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    return ONLP_STATUS_OK;
+}
+
+
+/**
+ * Client side.
+ */
+static int
+telemetry_connect__(uint32_t op, uint32_t generation)
+{
+    int fd;
+    struct sockaddr_un addr;
+    onlp_telemetry_request_t request;
+
+    if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+        AIM_LOG_ERROR("socket: %{errno}", errno);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    ONLP_MEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    aim_strlcpy(addr.sun_path, ONLP_CONFIG_TELEMETRY_SOCKET, sizeof(addr.sun_path));
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        /* The service is not running. */
+        close(fd);
+        return ONLP_STATUS_E_MISSING;
+    }
+    telemetry_timeouts__(fd);
+
+    ONLP_MEMSET(&request, 0, sizeof(request));
+    request.magic = ONLP_TELEMETRY_MAGIC;
+    request.version = ONLP_TELEMETRY_VERSION;
+    request.op = op;
+    request.generation = generation;
+    if(telemetry_send__(fd, &request, sizeof(request), 0) < 0) {
+        close(fd);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    return fd;
+}
+
+/** Like onlp_telemetry_get() but also returns the collection time. */
+static int
+telemetry_get__(onlp_snapshot_t* snapshot, uint32_t* generation,
+                uint64_t* timestamp)
+{
+    int fd, rv;
+    onlp_telemetry_reply_t reply;
+
+    if((fd = telemetry_connect__(ONLP_TELEMETRY_OP_GET, *generation)) < 0) {
+        return fd;
+    }
+
+    if((rv = telemetry_recv__(fd, &reply, sizeof(reply))) < 0 ||
+       (rv = telemetry_reply_check__(&reply, ONLP_TELEMETRY_OP_GET)) < 0) {
+        goto done;
+    }
+
+    if(reply.size == 0) {
+        rv = 0;
+    }
+    else if(reply.size != sizeof(*snapshot)) {
+        AIM_LOG_ERROR("Telemetry snapshot size mismatch (%d != %d)",
+                      reply.size, (int)sizeof(*snapshot));
+        rv = ONLP_STATUS_E_INVALID;
+        goto done;
+    }
+    else if((rv = telemetry_recv__(fd, snapshot, reply.size)) < 0) {
+        /* The caller's snapshot is incomplete. */
+        reply.generation = 0;
+    }
+    else {
+        rv = 1;
+    }
+    *generation = reply.generation;
+    if(timestamp) {
+        *timestamp = reply.timestamp;
+    }
+
+ done:
+    close(fd);
+    return rv;
+}
+
+int
+onlp_telemetry_get(onlp_snapshot_t* snapshot, uint32_t* generation)
+{
+    if(snapshot == NULL || generation == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    return telemetry_get__(snapshot, generation, NULL);
+}
+
+int
+onlp_telemetry_subscribe(void)
+{
+    int fd, rv;
+    onlp_telemetry_reply_t reply;
+
+    if((fd = telemetry_connect__(ONLP_TELEMETRY_OP_SUBSCRIBE, 0)) < 0) {
+        return fd;
+    }
+    if((rv = telemetry_recv__(fd, &reply, sizeof(reply))) < 0 ||
+       (rv = telemetry_reply_check__(&reply, ONLP_TELEMETRY_OP_NOTIFY)) < 0) {
+        close(fd);
+        return rv;
+    }
+    /* Notifications arrive on their own schedule. */
+    struct timeval tv = { 0, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+int
+onlp_telemetry_notify_read(int fd, uint32_t* generation)
+{
+    int rv;
+    onlp_telemetry_reply_t reply;
+
+    if(generation == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    if((rv = telemetry_recv__(fd, &reply, sizeof(reply))) < 0 ||
+       (rv = telemetry_reply_check__(&reply, ONLP_TELEMETRY_OP_NOTIFY)) < 0) {
+        return rv;
+    }
+    *generation = reply.generation;
+    return ONLP_STATUS_OK;
+}
+
+
+/**
+ * Client mode.
+ *
+ * The snapshot is refreshed from the service at most once per
+ * interval and used while it is no older than two intervals.
+ *
+ * The refresh is done by onlp_telemetry_refresh__() before the
+ * outermost API call takes its lock. It fetches into a spare buffer
+ * without holding client__.lock, so lookups never wait on the service.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_mutex_t refresh;    /* Held by the refreshing thread. */
+    int enabled;
+    int server;
+
+    uint64_t interval;          /* us */
+    uint64_t checked;           /* Last exchange with the service. */
+
+    onlp_snapshot_t* snapshot;
+    onlp_snapshot_t* spare;     /* Owned by the refreshing thread. */
+    uint32_t generation;
+    uint64_t timestamp;         /* Collection time of the snapshot. */
+    uint64_t hits;
+    uint64_t misses;
+} client__ = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .refresh = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void
+client_server_mode__(void)
+{
+    pthread_mutex_lock(&client__.lock);
+    client__.server = 1;
+    client__.enabled = 0;
+    pthread_mutex_unlock(&client__.lock);
+}
+
+void
+onlp_telemetry_client_enable(int enable)
+{
+    pthread_mutex_lock(&client__.lock);
+    client__.enabled = enable && !client__.server;
+    client__.interval = telemetry_interval__() * 1000ULL;
+    client__.checked = 0;
+    client__.generation = 0;
+    pthread_mutex_unlock(&client__.lock);
+}
+
+void
+onlp_telemetry_init__(void)
+{
+    onlp_telemetry_client_enable(telemetry_config_bool__("client", 1));
+}
+
+void
+onlp_telemetry_refresh__(void)
+{
+    int rv;
+    uint64_t now, timestamp = 0;
+    uint32_t generation;
+    onlp_snapshot_t* s;
+
+    /* Unlocked tests; client mode is normally fixed at init. */
+    if(!client__.enabled) {
+        return;
+    }
+    now = aim_time_monotonic();
+    if(now - client__.checked < client__.interval) {
+        return;
+    }
+    if(pthread_mutex_trylock(&client__.refresh) != 0) {
+        /* Another thread is refreshing. */
+        return;
+    }
+
+    pthread_mutex_lock(&client__.lock);
+    if(!client__.enabled || now - client__.checked < client__.interval) {
+        pthread_mutex_unlock(&client__.lock);
+        pthread_mutex_unlock(&client__.refresh);
+        return;
+    }
+    client__.checked = now;
+    generation = client__.generation;
+    pthread_mutex_unlock(&client__.lock);
+
+    if(client__.spare == NULL) {
+        client__.spare = aim_zmalloc(sizeof(onlp_snapshot_t));
+    }
+    rv = telemetry_get__(client__.spare, &generation, &timestamp);
+
+    pthread_mutex_lock(&client__.lock);
+    if(rv < 0) {
+        client__.generation = 0;
+    }
+    else {
+        if(rv == 1) {
+            s = client__.snapshot;
+            client__.snapshot = client__.spare;
+            client__.spare = s;
+        }
+        client__.generation = generation;
+        client__.timestamp = timestamp;
+    }
+    pthread_mutex_unlock(&client__.lock);
+    pthread_mutex_unlock(&client__.refresh);
+}
+
+/**
+ * Returns the current snapshot with client__.lock held, or NULL.
+ */
+static onlp_snapshot_t*
+client_snapshot_lock__(void)
+{
+    if(!client__.enabled) {
+        /* Unlocked test; client mode is normally fixed at init. */
+        return NULL;
+    }
+
+    pthread_mutex_lock(&client__.lock);
+    if(client__.enabled && client__.generation && client__.snapshot &&
+       aim_time_monotonic() - client__.timestamp <= 2*client__.interval) {
+        return client__.snapshot;
+    }
+
+    client__.misses++;
+    pthread_mutex_unlock(&client__.lock);
+    return NULL;
+}
+
+static void
+client_snapshot_unlock__(int served)
+{
+    if(served) {
+        client__.hits++;
+    }
+    else {
+        client__.misses++;
+    }
+    pthread_mutex_unlock(&client__.lock);
+}
+
+#define TELEMETRY_INFO_FIND(_table, _oid, _info, _size, _rv)            \
+    do {                                                                \
+        uint32_t _i;                                                    \
+        for(_i = 0; _i < (_table).count; _i++) {                        \
+            if((_table).info[_i].hdr.id == (_oid) &&                    \
+               (_size) == sizeof((_table).info[_i])) {                  \
+                (_rv) = (_table).status[_i];                            \
+                ONLP_MEMCPY((_info), &(_table).info[_i], (_size));      \
+                break;                                                  \
+            }                                                           \
+        }                                                               \
+    } while(0)
+
+int
+onlp_telemetry_info_get__(onlp_oid_t oid, void* info, int size)
+{
+    int rv = ONLP_STATUS_E_UNSUPPORTED;
+    onlp_snapshot_t* s = client_snapshot_lock__();
+
+    if(s == NULL) {
+        return rv;
+    }
+
+    switch(ONLP_OID_TYPE_GET(oid))
+        {
+        case ONLP_OID_TYPE_THERMAL:
+            TELEMETRY_INFO_FIND(s->thermals, oid, info, size, rv);
+            break;
+        case ONLP_OID_TYPE_FAN:
+            TELEMETRY_INFO_FIND(s->fans, oid, info, size, rv);
+            break;
+        case ONLP_OID_TYPE_PSU:
+            TELEMETRY_INFO_FIND(s->psus, oid, info, size, rv);
+            break;
+        case ONLP_OID_TYPE_LED:
+            TELEMETRY_INFO_FIND(s->leds, oid, info, size, rv);
+            break;
+        default:
+            break;
+        }
+
+    client_snapshot_unlock__(rv != ONLP_STATUS_E_UNSUPPORTED);
+    return rv;
+}
+
+static void
+telemetry_bitmap_import__(const uint32_t* words, onlp_sfp_bitmap_t* bmap)
+{
+    int p;
+    AIM_BITMAP_CLR_ALL(bmap);
+    for(p = 0; p < ONLP_SNAPSHOT_SFP_PORTS && p <= bmap->hdr.maxbit; p++) {
+        if(words[p / 32] & (1U << (p % 32))) {
+            AIM_BITMAP_SET(bmap, p);
+        }
+    }
+}
+
+int
+onlp_telemetry_sfp_bitmap_get__(int which, onlp_sfp_bitmap_t* dst)
+{
+    int rv = ONLP_STATUS_E_UNSUPPORTED;
+    onlp_snapshot_t* s = client_snapshot_lock__();
+
+    if(s == NULL) {
+        return rv;
+    }
+
+    switch(which)
+        {
+        case ONLP_TELEMETRY_SFP_PRESENCE:
+            if(s->presence_status >= 0) {
+                telemetry_bitmap_import__(s->presence, dst);
+                rv = ONLP_STATUS_OK;
+            }
+            break;
+        case ONLP_TELEMETRY_SFP_RX_LOS:
+            if(s->rx_los_status >= 0) {
+                telemetry_bitmap_import__(s->rx_los, dst);
+                rv = ONLP_STATUS_OK;
+            }
+            break;
+        default:
+            break;
+        }
+
+    client_snapshot_unlock__(rv == ONLP_STATUS_OK);
+    return rv;
+}
+
+int
+onlp_telemetry_sfp_data_get__(int port, int dom, uint8_t* data)
+{
+    int rv = ONLP_STATUS_E_UNSUPPORTED;
+    onlp_snapshot_t* s = client_snapshot_lock__();
+
+    if(s == NULL) {
+        return rv;
+    }
+
+    if(port >= 0 && port < ONLP_SNAPSHOT_SFP_PORTS) {
+        if(dom && (s->flags & ONLP_SNAPSHOT_F_DOM) && s->dom_status[port] >= 0) {
+            ONLP_MEMCPY(data, s->dom[port], sizeof(s->dom[port]));
+            rv = ONLP_STATUS_OK;
+        }
+        if(!dom && (s->flags & ONLP_SNAPSHOT_F_EEPROM) && s->eeprom_status[port] >= 0) {
+            ONLP_MEMCPY(data, s->eeprom[port], sizeof(s->eeprom[port]));
+            rv = ONLP_STATUS_OK;
+        }
+    }
+
+    client_snapshot_unlock__(rv == ONLP_STATUS_OK);
+    return rv;
+}
+
+void
+onlp_telemetry_show(aim_pvs_t* pvs)
+{
+    onlp_snapshot_t* s;
+    uint32_t generation = 0;
+    uint64_t timestamp = 0;
+    int rv;
+
+    s = aim_zmalloc(sizeof(*s));
+    rv = telemetry_get__(s, &generation, &timestamp);
+    if(rv < 0) {
+        aim_printf(pvs, "Telemetry service %s: %{onlp_status}\n",
+                   ONLP_CONFIG_TELEMETRY_SOCKET, rv);
+    }
+    else {
+        aim_printf(pvs, "Telemetry service %s:\n", ONLP_CONFIG_TELEMETRY_SOCKET);
+        aim_printf(pvs, "  generation: %u\n", generation);
+        aim_printf(pvs, "  age: %llu ms\n",
+                   (unsigned long long)(aim_time_monotonic() - timestamp) / 1000);
+        aim_printf(pvs, "  flags: 0x%x\n", s->flags);
+        aim_printf(pvs, "  thermals: %u fans: %u psus: %u leds: %u\n",
+                   s->thermals.count, s->fans.count, s->psus.count, s->leds.count);
+    }
+    aim_free(s);
+
+    pthread_mutex_lock(&client__.lock);
+    aim_printf(pvs, "Client mode: %s\n",
+               client__.server ? "server" : client__.enabled ? "enabled" : "disabled");
+    aim_printf(pvs, "  generation: %u hits: %llu misses: %llu\n",
+               client__.generation, (unsigned long long)client__.hits,
+               (unsigned long long)client__.misses);
+    pthread_mutex_unlock(&client__.lock);
+}
+
+#else
+
+int
+onlp_telemetry_server_start(void)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_telemetry_server_stop(void)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_telemetry_server_flags_set(uint32_t flags)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_telemetry_get(onlp_snapshot_t* snapshot, uint32_t* generation)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_telemetry_subscribe(void)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_telemetry_notify_read(int fd, uint32_t* generation)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+void
+onlp_telemetry_client_enable(int enable)
+{
+}
+
+void
+onlp_telemetry_init__(void)
+{
+}
+
+int
+onlp_telemetry_info_get__(onlp_oid_t oid, void* info, int size)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+void
+onlp_telemetry_refresh__(void)
+{
+}
+
+int
+onlp_telemetry_sfp_bitmap_get__(int which, onlp_sfp_bitmap_t* dst)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+int
+onlp_telemetry_sfp_data_get__(int port, int dom, uint8_t* data)
+{
+    return ONLP_STATUS_E_UNSUPPORTED;
+}
+
+void
+onlp_telemetry_show(aim_pvs_t* pvs)
+{
+    aim_printf(pvs, "Telemetry is not available in this build.\n");
+}
+
+#endif /* ONLP_CONFIG_INCLUDE_TELEMETRY */
@@ -26,7 +26,10 @@
 #include <onlp/platformi/thermali.h>
 #include <onlp/oids.h>
 #include "onlp_int.h"
+#define ONLP_API_LOCK_DOMAIN ONLP_API_LOCK_DOMAIN_THERMAL
 #include "onlp_locks.h"
+#include "onlp_cache.h"
+#include "onlp_overrides.h"
 
 #define VALIDATE(_id)                           \
     do {                                        \
@@ -50,51 +53,48 @@ onlp_thermal_init_locked__(void)
 }
 ONLP_LOCKED_API0(onlp_thermal_init);
 
-#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES == 1
-
 static int
-onlp_thermali_info_from_json__(cJSON* data, onlp_thermal_info_t* info, int errorcheck)
+onlp_thermal_info_get__(onlp_oid_t oid, onlp_thermal_info_t* info)
 {
     int rv;
-    int t;
 
-    if(data == NULL) {
-        return (errorcheck) ? ONLP_STATUS_E_PARAM : 0;
+    rv = onlp_thermali_info_get(oid, info);
+    if(rv >= 0) {
+        ONLP_OVERRIDES_APPLY(oid, info);
     }
-
-    rv = cjson_util_lookup_int(data, (int*) &info->status, "status");
-    if(rv < 0 && errorcheck) return rv;
-
-    rv = cjson_util_lookup_int(data, &t, "mcelsius");
-    if(rv < 0 && errorcheck) return rv;
-    info->mcelsius = t;
-
-    return 0;
+    return rv;
 }
 
-#endif
-
 static int
-onlp_thermal_info_get_locked__(onlp_oid_t oid, onlp_thermal_info_t* info)
+onlp_thermal_info_get_cached_locked__(onlp_oid_t oid, onlp_thermal_info_t* info,
+                                      uint32_t max_age)
 {
     int rv;
     VALIDATE(oid);
 
-    rv = onlp_thermali_info_get(oid, info);
-    if(rv >= 0) {
-
-#if ONLP_CONFIG_INCLUDE_PLATFORM_OVERRIDES == 1
-        int id = ONLP_OID_ID_GET(oid);
-        cJSON* entry = NULL;
-
-        cjson_util_lookup(onlp_json_get(0), &entry, "overrides.thermal.%d", id);
-        onlp_thermali_info_from_json__(entry, info, 0);
-#endif
+    if(onlp_cache_get(oid, info, sizeof(*info), max_age)) {
+        return ONLP_STATUS_OK;
+    }
 
+    rv = onlp_thermal_info_get__(oid, info);
+    if(rv >= 0) {
+        onlp_cache_put(oid, info, sizeof(*info));
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_thermal_info_get, onlp_oid_t, oid, onlp_thermal_info_t*, info);
+ONLP_LOCKED_RAPI3(onlp_thermal_info_get_cached, onlp_oid_t, oid,
+                 onlp_thermal_info_t*, info, uint32_t, max_age);
+
+static int
+onlp_thermal_info_get_locked__(onlp_oid_t oid, onlp_thermal_info_t* info)
+{
+    int rv = onlp_telemetry_info_get__(oid, info, sizeof(*info));
+    if(rv != ONLP_STATUS_E_UNSUPPORTED) {
+        return rv;
+    }
+    return onlp_thermal_info_get_cached_locked__(oid, info, onlp_cache_ttl_get(oid));
+}
+ONLP_LOCKED_RAPI2(onlp_thermal_info_get, onlp_oid_t, oid, onlp_thermal_info_t*, info);
 
 static int
 onlp_thermal_status_get_locked__(onlp_oid_t id, uint32_t* status)
@@ -110,7 +110,7 @@ onlp_thermal_status_get_locked__(onlp_oid_t id, uint32_t* status)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_thermal_status_get, onlp_oid_t, id, uint32_t*, status);
+ONLP_LOCKED_RAPI2(onlp_thermal_status_get, onlp_oid_t, id, uint32_t*, status);
 
 static int
 onlp_thermal_hdr_get_locked__(onlp_oid_t id, onlp_oid_hdr_t* hdr)
@@ -126,7 +126,7 @@ onlp_thermal_hdr_get_locked__(onlp_oid_t id, onlp_oid_hdr_t* hdr)
     }
     return rv;
 }
-ONLP_LOCKED_API2(onlp_thermal_hdr_get, onlp_oid_t, id, onlp_oid_hdr_t*, hdr);
+ONLP_LOCKED_RAPI2(onlp_thermal_hdr_get, onlp_oid_t, id, onlp_oid_hdr_t*, hdr);
 int
 onlp_thermal_ioctl(int code, ...)
 {
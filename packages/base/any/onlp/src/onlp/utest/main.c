@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
 
 #include <AIM/aim.h>
 #include <onlp/onlp.h>
@@ -107,6 +108,59 @@ iter__(onlp_oid_t oid, void* cookie)
 #include <onlp/thermal.h>
 #include <onlp/oids.h>
 #include <onlp/sys.h>
+#include <onlp/telemetry.h>
+
+/**
+ * Test the telemetry service protocol.
+ */
+void
+telemetry_test(void)
+{
+    int fd, rv;
+    uint32_t generation = 0;
+    uint32_t current;
+    struct pollfd pfd;
+    onlp_snapshot_t* s = aim_zmalloc(sizeof(*s));
+
+    TRY(onlp_telemetry_server_start());
+
+    /* A client without a snapshot receives one. */
+    TRY(rv = onlp_telemetry_get(s, &generation));
+    if(rv != 1 || generation == 0) {
+        AIM_DIE("initial get: rv=%d generation=%u", rv, generation);
+    }
+    current = generation;
+
+    /* A current client does not. */
+    TRY(rv = onlp_telemetry_get(s, &generation));
+    if(rv != 0 || generation != current) {
+        AIM_DIE("current get: rv=%d generation=%u/%u", rv, generation, current);
+    }
+
+    /* A stale client does. */
+    generation = current + 1;
+    TRY(rv = onlp_telemetry_get(s, &generation));
+    if(rv != 1 || generation != current) {
+        AIM_DIE("stale get: rv=%d generation=%u/%u", rv, generation, current);
+    }
+
+    /* Changing what is collected changes the content and notifies. */
+    TRY(fd = onlp_telemetry_subscribe());
+    TRY(onlp_telemetry_server_flags_set(s->flags ^ ONLP_SNAPSHOT_F_DOM));
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if(poll(&pfd, 1, 5000) != 1) {
+        AIM_DIE("no notification");
+    }
+    TRY(onlp_telemetry_notify_read(fd, &generation));
+    if(generation == current) {
+        AIM_DIE("notification without a new generation");
+    }
+    close(fd);
+
+    TRY(onlp_telemetry_server_stop());
+    aim_free(s);
+}
 
 int
 aim_main(int argc, char* argv[])
@@ -119,6 +173,8 @@ aim_main(int argc, char* argv[])
     onlp_oid_iterate(0, 0, iter__, NULL);
     onlp_platform_show(&aim_pvs_stdout, ONLP_OID_SHOW_RECURSE|ONLP_OID_SHOW_EXTENDED);
 
+    TEST(telemetry_test());
+
     if(argv[1] && !strcmp("manage", argv[1])) {
         onlp_sys_platform_manage_start();
         printf("Sleeping...\n");
@@ -37,4 +37,50 @@
 
 uint32_t onlp_crc32(uint32_t crc, const void *buf, int size);
 
+/**
+ * CRC32 implementations.
+ *
+ * onlp_crc32() uses the fastest implementation supported by
+ * the CPU. The others are available for testing and benchmarks.
+ */
+typedef enum onlp_crc32_impl_e {
+    /** Byte at a time (reference) */
+    ONLP_CRC32_IMPL_TABLE,
+    /** Slice-by-8 */
+    ONLP_CRC32_IMPL_SLICE8,
+    /** x86-64 PCLMULQDQ folding */
+    ONLP_CRC32_IMPL_PCLMUL,
+    /** ARMv8 CRC32 instructions */
+    ONLP_CRC32_IMPL_ARMV8,
+    ONLP_CRC32_IMPL_COUNT,
+} onlp_crc32_impl_t;
+
+/**
+ * @brief Determine whether a CRC32 implementation is supported.
+ * @param impl The implementation.
+ * @returns 1 if it is available in this build and supported by the CPU.
+ */
+int onlp_crc32_impl_supported(onlp_crc32_impl_t impl);
+
+/**
+ * @brief Get the implementation used by onlp_crc32().
+ */
+onlp_crc32_impl_t onlp_crc32_impl_get(void);
+
+/**
+ * @brief Get the name of a CRC32 implementation.
+ */
+const char* onlp_crc32_impl_name(onlp_crc32_impl_t impl);
+
+/**
+ * @brief Calculate CRC32 using the given implementation.
+ * @param impl The implementation.
+ * @param crc CRC start
+ * @param buf The data buffer
+ * @param size The size of the data buffer.
+ * @note The table implementation is used if 'impl' is not supported.
+ */
+uint32_t onlp_crc32_impl(onlp_crc32_impl_t impl,
+                         uint32_t crc, const void *buf, int size);
+
 #endif /* __ONLP_CRC32_H__ */
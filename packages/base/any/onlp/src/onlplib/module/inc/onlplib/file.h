@@ -197,4 +197,93 @@ int onlp_file_vopen(int flags, int log, const char* fmt, va_list vargs);
  */
 int onlp_file_find(char* root, char* fname, char** rpath);
 
+/**
+ * @brief Flush the resolved wildcard path cache.
+ */
+void onlp_file_find_cache_flush(void);
+
+/**
+ * @brief Close all cached sysfs read descriptors.
+ * @note onlp_file_read() and the functions based on it keep sysfs
+ * descriptors open and re-read them in place
+ * (see ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE).
+ */
+void onlp_file_handle_cache_flush(void);
+
+
+/**
+ * A file handle.
+ *
+ * The filename is resolved and opened once and the file
+ * is re-read or re-written in place on each access. This is
+ * suitable for sysfs attributes which are polled repeatedly.
+ */
+typedef struct onlp_file_handle_s {
+    /** The open descriptor, or -1 */
+    int fd;
+    /** The open flags */
+    int flags;
+    /** The resolved filename */
+    char* path;
+} onlp_file_handle_t;
+
+#define ONLP_FILE_HANDLE_INIT { -1, 0, NULL }
+
+/**
+ * @brief Open a file handle.
+ * @param handle The handle.
+ * @param flags The open flags.
+ * @param fmt The filename format string.
+ * @param vargs The filename format string arguments.
+ */
+int onlp_file_handle_vopen(onlp_file_handle_t* handle, int flags,
+                           const char* fmt, va_list vargs);
+
+/**
+ * @brief Open a file handle.
+ * @param handle The handle.
+ * @param flags The open flags.
+ * @param fmt The filename format string.
+ * @param ... The filename format string arguments.
+ */
+int onlp_file_handle_open(onlp_file_handle_t* handle, int flags,
+                          const char* fmt, ...);
+
+/**
+ * @brief Read the contents of a file handle from offset 0.
+ * @param handle The handle.
+ * @param data Receives the data.
+ * @param max Maximum read size.
+ * @param len Receives the actual read length.
+ */
+int onlp_file_handle_read(onlp_file_handle_t* handle, uint8_t* data, int max, int* len);
+
+/**
+ * @brief Read the integer contents of a file handle.
+ * @param handle The handle.
+ * @param value Receives the integer value.
+ */
+int onlp_file_handle_read_int(onlp_file_handle_t* handle, int* value);
+
+/**
+ * @brief Write data to a file handle at offset 0.
+ * @param handle The handle.
+ * @param data The data to write.
+ * @param len The length of the data.
+ */
+int onlp_file_handle_write(onlp_file_handle_t* handle, uint8_t* data, int len);
+
+/**
+ * @brief Write an integer as a string to a file handle.
+ * @param handle The handle.
+ * @param value The integer.
+ */
+int onlp_file_handle_write_int(onlp_file_handle_t* handle, int value);
+
+/**
+ * @brief Close a file handle.
+ * @param handle The handle.
+ */
+void onlp_file_handle_close(onlp_file_handle_t* handle);
+
 #endif /* __ONLPLIB_FILE_H__ */
@@ -81,6 +81,13 @@ int onlp_file_uds_create(onlp_file_uds_t** fuds);
  */
 typedef int (*onlp_file_uds_handler_t)(int fd, void* cookie);
 
+/**
+ * Return this from your handler to keep the client descriptor open.
+ * The handler then owns the descriptor and must close it.
+ * The descriptor is closed after any other return value.
+ */
+#define ONLP_FILE_UDS_HANDLER_KEEP 1
+
 /**
  * @brief Add a domain socket service path to an existing service manager.
  * @param fuds The service manager
@@ -77,6 +77,12 @@
  */
 #define ONLP_I2C_F_DISABLE_READ_RETRIES 0x80
 
+/**
+ * Use a single I2C_RDWR transaction for multi-byte reads if possible.
+ * The default is to read a byte at a time.
+ */
+#define ONLP_I2C_F_USE_RDWR 0x100
+
 /**
  * @brief Open and prepare for reading or writing.
  * @param bus The i2c bus number.
@@ -86,6 +92,13 @@
  */
 int onlp_i2c_open(int bus, uint8_t addr, uint32_t flags);
 
+/**
+ * @brief Close all idle pooled i2c descriptors.
+ * @note Descriptors currently in use are closed when released.
+ * This should be called if i2c adapters are removed or renumbered.
+ */
+void onlp_i2c_pool_flush(void);
+
 
 /**
  * @brief Read i2c data.
@@ -95,7 +108,8 @@ int onlp_i2c_open(int bus, uint8_t addr, uint32_t flags);
  * @param size The byte count.
  * @param rdata [out] Receives the data.
  * @param flags See ONLP_I2C_F_*
- * @note This function reads a byte at a time.
+ * @note This function reads a byte at a time unless
+ * ONLP_I2C_F_USE_RDWR is specified.
  * See onlp_i2c_read_block() for block reads.
  */
 
@@ -181,6 +195,50 @@ int onlp_i2c_readw(int bus, uint8_t addr, uint8_t offset, uint32_t flags);
 int onlp_i2c_writew(int bus, uint8_t addr, uint8_t offset, uint16_t word,
                     uint32_t flags);
 
+/**
+ * A single register-addressed i2c transfer.
+ */
+typedef struct onlp_i2c_xfer_s {
+    /** The slave address. */
+    uint8_t addr;
+
+    /** The register offset. */
+    uint8_t offset;
+
+    /** Nonzero to write, zero to read. */
+    int write;
+
+    /** The byte count. */
+    int size;
+
+    /** The data to write, or receives the data read. */
+    uint8_t* data;
+
+    /** [out] The status of this transfer. */
+    int status;
+
+} onlp_i2c_xfer_t;
+
+/**
+ * @brief Perform a set of i2c transfers on a single bus.
+ * @param bus The i2c bus number.
+ * @param xfers The transfers.
+ * @param count The number of transfers.
+ * @param flags See ONLP_I2C_F_*
+ * @returns 0 if all transfers succeeded, otherwise the first error.
+ * @note Transfers are packed into as few I2C_RDWR transactions as possible
+ * and are performed in order. If the adapter does not support plain i2c
+ * transactions (or PEC is requested) each transfer is performed using
+ * SMBus block reads and byte writes instead. The status of each transfer
+ * is reported individually.
+ * @note Failed transactions containing only reads are retried. A failed
+ * transaction containing a write is never repeated: its transfers and all
+ * following transfers are reported as failed.
+ * @note As with the other functions, addresses in use by a kernel driver
+ * are refused unless ONLP_I2C_F_FORCE is specified.
+ */
+int onlp_i2c_xfer(int bus, onlp_i2c_xfer_t* xfers, int count, uint32_t flags);
+
 
 
 /****************************************************************************
@@ -85,6 +85,21 @@ typedef struct onlp_onie_vx_s {
 int onlp_onie_decode(onlp_onie_info_t* rv, const uint8_t* data, int size);
 int onlp_onie_decode_file(onlp_onie_info_t* rv, const char* file);
 
+/**
+ * Validate raw TlvInfo data.
+ *
+ * Unlike onlp_onie_decode() the data must end with a CRC-32 TLV.
+ * Returns the length of the TlvInfo data (header and TLVs) and
+ * the stored CRC in 'crc' if it is valid, -1 otherwise.
+ */
+int onlp_onie_data_validate(const uint8_t* data, int size, uint32_t* crc);
+
+/**
+ * Copy an ONIE info structure.
+ * The copy must be released with onlp_onie_info_free().
+ */
+int onlp_onie_info_copy(onlp_onie_info_t* dst, const onlp_onie_info_t* src);
+
 /**
  * Free an ONIE info structure.
  */
@@ -145,6 +145,46 @@
 #define ONLPLIB_CONFIG_I2C_READ_RETRY_COUNT 16
 #endif
 
+/**
+ * ONLPLIB_CONFIG_I2C_FD_POOL_SIZE
+ *
+ * The number of I2C device descriptors kept open for reuse. Zero disables descriptor pooling. */
+
+
+#ifndef ONLPLIB_CONFIG_I2C_FD_POOL_SIZE
+#define ONLPLIB_CONFIG_I2C_FD_POOL_SIZE 16
+#endif
+
+/**
+ * ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE
+ *
+ * The number of resolved wildcard file paths cached by the file functions. Zero disables the cache. */
+
+
+#ifndef ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE
+#define ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE 32
+#endif
+
+/**
+ * ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE
+ *
+ * The number of sysfs descriptors kept open for reuse by onlp_file_read() and the functions based on it. Zero disables descriptor caching. */
+
+
+#ifndef ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE
+#define ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE 64
+#endif
+
+/**
+ * ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL
+ *
+ * Include the slice-by-8 and hardware (PCLMULQDQ, ARMv8 CRC32) CRC32 implementations. The fastest one supported by the CPU is selected at runtime. */
+
+
+#ifndef ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL
+#define ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL 1
+#endif
+
 /**
  * ONLPLIB_CONFIG_I2C_USE_CUSTOM_HEADER
  *
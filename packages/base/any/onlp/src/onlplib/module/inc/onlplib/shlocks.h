@@ -76,6 +76,60 @@ int onlp_shlock_give(onlp_shlock_t* shlock);
 const char* onlp_shlock_name(onlp_shlock_t* lock);
 
 
+
+/**
+ * Shared memory IPC reader/writer locks.
+ *
+ * Unlike the shared mutexes these are not robust - a process which
+ * dies while holding one leaves it held. All take operations are
+ * therefore bounded by a timeout.
+ */
+typedef struct onlp_shrwlock_s onlp_shrwlock_t;
+
+/**
+ * @brief Create a shared memory IPC reader/writer lock with the given id.
+ * @param id The shared memory id.
+ * @param rv Receives the shared lock.
+ */
+int onlp_shrwlock_create(key_t id, onlp_shrwlock_t** rv,
+                         const char* name, ...);
+
+/**
+ * @brief Take a shared lock for reading.
+ * @param lock The shared lock.
+ * @param timeout The maximum time to wait (in usecs). Zero waits forever.
+ * @returns 0 on success, -1 if the timeout expired.
+ */
+int onlp_shrwlock_rdlock(onlp_shrwlock_t* lock, uint32_t timeout);
+
+/**
+ * @brief Take a shared lock for writing.
+ * @param lock The shared lock.
+ * @param timeout The maximum time to wait (in usecs). Zero waits forever.
+ * @param owner Recorded as the lock owner (optional).
+ * @returns 0 on success, -1 if the timeout expired.
+ */
+int onlp_shrwlock_wrlock(onlp_shrwlock_t* lock, uint32_t timeout,
+                         const char* owner);
+
+/**
+ * @brief Release a shared reader/writer lock.
+ * @param lock The shared lock.
+ */
+int onlp_shrwlock_unlock(onlp_shrwlock_t* lock);
+
+/**
+ * @brief Get a shared reader/writer lock's name.
+ * @param lock The lock.
+ */
+const char* onlp_shrwlock_name(onlp_shrwlock_t* lock);
+
+/**
+ * @brief Get the last writer of a shared reader/writer lock.
+ * @param lock The lock.
+ */
+const char* onlp_shrwlock_owner(onlp_shrwlock_t* lock);
+
 /**
  * A single global lock is always initialized
  * and ready at startup.
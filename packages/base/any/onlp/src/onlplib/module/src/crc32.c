@@ -40,7 +40,12 @@
  * CRC32 code derived from work by Gary S. Brown.
  */
 
+#include <onlplib/onlplib_config.h>
+#include <onlplib/crc32.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
 
 static uint32_t crc32_tab[] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
@@ -88,17 +93,305 @@ static uint32_t crc32_tab[] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-uint32_t
-onlp_crc32(uint32_t crc, const void *buf, int size)
-{
-    const uint8_t *p;
-
-    p = buf;
-    crc = crc ^ ~0U;
+/*
+ * All implementations operate on the inverted CRC register.
+ */
+typedef uint32_t (*crc32_f)(uint32_t crc, const uint8_t* p, size_t size);
 
+static uint32_t
+crc32_table__(uint32_t crc, const uint8_t* p, size_t size)
+{
     while (size--)
         crc = crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
 
-    return crc ^ ~0U;
+    return crc;
+}
+
+#if ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL == 1
+
+/**
+ * Slice-by-8
+ *
+ * crc32_slice_tab[k][n] is the CRC of byte 'n' followed by 'k'
+ * zero bytes, so eight bytes are folded with eight lookups.
+ */
+static uint32_t crc32_slice_tab[8][256];
+
+static void
+crc32_slice_init__(void)
+{
+    int k, n;
+
+    for(n = 0; n < 256; n++) {
+        crc32_slice_tab[0][n] = crc32_tab[n];
+    }
+    for(k = 1; k < 8; k++) {
+        for(n = 0; n < 256; n++) {
+            uint32_t c = crc32_slice_tab[k-1][n];
+            crc32_slice_tab[k][n] = (c >> 8) ^ crc32_tab[c & 0xFF];
+        }
+    }
+}
+
+#define CRC32_LE32(_p)                                                  \
+    ((uint32_t)(_p)[0] | (uint32_t)(_p)[1] << 8 |                       \
+     (uint32_t)(_p)[2] << 16 | (uint32_t)(_p)[3] << 24)
+
+static uint32_t
+crc32_slice8__(uint32_t crc, const uint8_t* p, size_t size)
+{
+    while(size >= 8) {
+        uint32_t one = crc ^ CRC32_LE32(p);
+        uint32_t two = CRC32_LE32(p + 4);
+        crc =
+            crc32_slice_tab[7][one & 0xFF] ^
+            crc32_slice_tab[6][(one >> 8) & 0xFF] ^
+            crc32_slice_tab[5][(one >> 16) & 0xFF] ^
+            crc32_slice_tab[4][one >> 24] ^
+            crc32_slice_tab[3][two & 0xFF] ^
+            crc32_slice_tab[2][(two >> 8) & 0xFF] ^
+            crc32_slice_tab[1][(two >> 16) & 0xFF] ^
+            crc32_slice_tab[0][two >> 24];
+        p += 8;
+        size -= 8;
+    }
+    return crc32_table__(crc, p, size);
+}
+
+#if defined(__x86_64__)
+#define CRC32_PCLMUL 1
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+/**
+ * PCLMULQDQ folding.
+ *
+ * From "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction" (Intel, 2009), using the bit-reflected constants for
+ * the CRC32 polynomial. Four 128 bit lanes are folded 64 bytes at a
+ * time, then reduced to 32 bits with a Barrett reduction. Lengths which
+ * are not a multiple of 16 are finished with slice-by-8.
+ */
+__attribute__((target("sse2,pclmul")))
+static uint32_t
+crc32_pclmul__(uint32_t crc, const uint8_t* p, size_t size)
+{
+    static const uint64_t __attribute__((aligned(16))) k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    static const uint64_t __attribute__((aligned(16))) k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    static const uint64_t __attribute__((aligned(16))) k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    static const uint64_t __attribute__((aligned(16))) poly[] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    if(size < 64) {
+        return crc32_slice8__(crc, p, size);
+    }
+
+    x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    x0 = _mm_load_si128((const __m128i*)k1k2);
+    p += 64;
+    size -= 64;
+
+    /* Fold 64 bytes at a time. */
+    while(size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+        p += 64;
+        size -= 64;
+    }
+
+    /* Fold the four lanes into one. */
+    x0 = _mm_load_si128((const __m128i*)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* Fold 16 bytes at a time. */
+    while(size >= 16) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)p)), x5);
+        p += 16;
+        size -= 16;
+    }
+
+    /* 128 bits to 64 bits. */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits. */
+    x0 = _mm_load_si128((const __m128i*)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    crc = _mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+
+    return crc32_slice8__(crc, p, size);
+}
+
+static int
+crc32_pclmul_supported__(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL);
+}
+#endif /* __x86_64__ */
+
+#if defined(__aarch64__)
+#define CRC32_ARMV8 1
+#include <arm_acle.h>
+#include <sys/auxv.h>
+
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+
+#if defined(__clang__)
+#define CRC32_TARGET_ARMV8 __attribute__((target("crc")))
+#else
+#define CRC32_TARGET_ARMV8 __attribute__((target("+crc")))
+#endif
+
+/**
+ * ARMv8 CRC32 instructions.
+ * These implement the CRC32 polynomial directly (not CRC32C).
+ */
+CRC32_TARGET_ARMV8
+static uint32_t
+crc32_armv8__(uint32_t crc, const uint8_t* p, size_t size)
+{
+    uint64_t v;
+
+    while(size && ((uintptr_t)p & 7)) {
+        crc = __crc32b(crc, *p++);
+        size--;
+    }
+    while(size >= 8) {
+        memcpy(&v, p, sizeof(v));
+        crc = __crc32d(crc, v);
+        p += 8;
+        size -= 8;
+    }
+    while(size--) {
+        crc = __crc32b(crc, *p++);
+    }
+    return crc;
+}
+
+static int
+crc32_armv8_supported__(void)
+{
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+#endif /* __aarch64__ */
+
+#endif /* ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL */
+
+static struct {
+    int supported;
+    crc32_f f;
+    const char* name;
+} crc32_impls__[ONLP_CRC32_IMPL_COUNT] = {
+    [ONLP_CRC32_IMPL_TABLE]  = { 1, crc32_table__, "table" },
+    [ONLP_CRC32_IMPL_SLICE8] = { 0, NULL, "slice8" },
+    [ONLP_CRC32_IMPL_PCLMUL] = { 0, NULL, "pclmul" },
+    [ONLP_CRC32_IMPL_ARMV8]  = { 0, NULL, "armv8" },
+};
+
+static onlp_crc32_impl_t crc32_impl__ = ONLP_CRC32_IMPL_TABLE;
+static pthread_once_t crc32_once__ = PTHREAD_ONCE_INIT;
+
+static void
+crc32_init__(void)
+{
+#if ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL == 1
+    crc32_slice_init__();
+    crc32_impls__[ONLP_CRC32_IMPL_SLICE8].f = crc32_slice8__;
+    crc32_impls__[ONLP_CRC32_IMPL_SLICE8].supported = 1;
+    crc32_impl__ = ONLP_CRC32_IMPL_SLICE8;
+#ifdef CRC32_PCLMUL
+    crc32_impls__[ONLP_CRC32_IMPL_PCLMUL].f = crc32_pclmul__;
+    if(crc32_pclmul_supported__()) {
+        crc32_impls__[ONLP_CRC32_IMPL_PCLMUL].supported = 1;
+        crc32_impl__ = ONLP_CRC32_IMPL_PCLMUL;
+    }
+#endif
+#ifdef CRC32_ARMV8
+    crc32_impls__[ONLP_CRC32_IMPL_ARMV8].f = crc32_armv8__;
+    if(crc32_armv8_supported__()) {
+        crc32_impls__[ONLP_CRC32_IMPL_ARMV8].supported = 1;
+        crc32_impl__ = ONLP_CRC32_IMPL_ARMV8;
+    }
+#endif
+#endif
+}
+
+int
+onlp_crc32_impl_supported(onlp_crc32_impl_t impl)
+{
+    pthread_once(&crc32_once__, crc32_init__);
+    return (impl >= 0 && impl < ONLP_CRC32_IMPL_COUNT) ?
+        crc32_impls__[impl].supported : 0;
+}
+
+onlp_crc32_impl_t
+onlp_crc32_impl_get(void)
+{
+    pthread_once(&crc32_once__, crc32_init__);
+    return crc32_impl__;
+}
+
+const char*
+onlp_crc32_impl_name(onlp_crc32_impl_t impl)
+{
+    return (impl >= 0 && impl < ONLP_CRC32_IMPL_COUNT) ?
+        crc32_impls__[impl].name : "unknown";
+}
+
+uint32_t
+onlp_crc32_impl(onlp_crc32_impl_t impl, uint32_t crc, const void *buf, int size)
+{
+    if(!onlp_crc32_impl_supported(impl)) {
+        impl = ONLP_CRC32_IMPL_TABLE;
+    }
+    if(size <= 0) {
+        return crc;
+    }
+    return crc32_impls__[impl].f(crc ^ ~0U, buf, size) ^ ~0U;
 }
 
+uint32_t
+onlp_crc32(uint32_t crc, const void *buf, int size)
+{
+    return onlp_crc32_impl(onlp_crc32_impl_get(), crc, buf, size);
+}
@@ -34,6 +34,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/stat.h>
+#include <pthread.h>
 
 /**
  * @brief Connects to a unix domain socket.
@@ -77,43 +78,192 @@ ds_connect__(const char* path)
     }
 }
 
+#if ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE > 0
+
+/**
+ * Resolved wildcard path cache.
+ *
+ * Wildcard lookups walk the search root on every access.
+ * The resolved paths are cached by their unexpanded filename
+ * and dropped when the resolved path no longer exists.
+ */
+typedef struct find_cache_entry_s {
+    char* pattern;
+    char* rpath;
+    uint32_t used;
+} find_cache_entry_t;
+
+static find_cache_entry_t find_cache__[ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE];
+static uint32_t find_cache_clock__;
+static pthread_mutex_t find_cache_lock__ = PTHREAD_MUTEX_INITIALIZER;
+
+static int
+find_cache_get__(const char* pattern, char* dst, int size)
+{
+    int i;
+    int rv = 0;
+    pthread_mutex_lock(&find_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE; i++) {
+        find_cache_entry_t* e = find_cache__ + i;
+        if(e->pattern && !strcmp(e->pattern, pattern)) {
+            aim_strlcpy(dst, e->rpath, size);
+            e->used = ++find_cache_clock__;
+            rv = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&find_cache_lock__);
+    return rv;
+}
+
+static void
+find_cache_entry_clear__(find_cache_entry_t* e)
+{
+    aim_free(e->pattern);
+    aim_free(e->rpath);
+    memset(e, 0, sizeof(*e));
+}
+
+static void
+find_cache_put__(const char* pattern, const char* rpath)
+{
+    int i;
+    find_cache_entry_t* victim = find_cache__;
+
+    pthread_mutex_lock(&find_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE; i++) {
+        find_cache_entry_t* e = find_cache__ + i;
+        if(e->pattern == NULL) {
+            victim = e;
+            break;
+        }
+        if(e->used < victim->used) {
+            victim = e;
+        }
+    }
+    find_cache_entry_clear__(victim);
+    victim->pattern = aim_strdup(pattern);
+    victim->rpath = aim_strdup(rpath);
+    victim->used = ++find_cache_clock__;
+    pthread_mutex_unlock(&find_cache_lock__);
+}
+
+static void
+find_cache_remove__(const char* pattern)
+{
+    int i;
+    pthread_mutex_lock(&find_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE; i++) {
+        find_cache_entry_t* e = find_cache__ + i;
+        if(e->pattern && !strcmp(e->pattern, pattern)) {
+            find_cache_entry_clear__(e);
+        }
+    }
+    pthread_mutex_unlock(&find_cache_lock__);
+}
+
+void
+onlp_file_find_cache_flush(void)
+{
+    int i;
+    pthread_mutex_lock(&find_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE; i++) {
+        find_cache_entry_clear__(find_cache__ + i);
+    }
+    pthread_mutex_unlock(&find_cache_lock__);
+}
+
+#else
+
+#define find_cache_get__(_pattern, _dst, _size) 0
+#define find_cache_put__(_pattern, _rpath)
+#define find_cache_remove__(_pattern)
+
+void
+onlp_file_find_cache_flush(void)
+{
+}
+
+#endif /* ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE */
+
+/**
+ * @brief Resolve a wildcard filename.
+ * @param fname The filename. Replaced with the resolved path.
+ * @param size The size of the filename buffer.
+ * @param cached Set if the path was resolved from the cache.
+ */
+static int
+resolve__(char* fname, int size, int* cached)
+{
+    char* asterisk;
+    char pattern[PATH_MAX];
+    char* rpath = NULL;
+
+    *cached = 0;
+
+    /**
+     * An asterisk in the filename separates a search root
+     * directory from a filename.
+     */
+    if( (asterisk = strchr(fname, '*')) == NULL) {
+        return ONLP_STATUS_OK;
+    }
+
+    aim_strlcpy(pattern, fname, sizeof(pattern));
+    if(find_cache_get__(pattern, fname, size)) {
+        *cached = 1;
+        return ONLP_STATUS_OK;
+    }
+
+    *asterisk = 0;
+    if(onlp_file_find(fname, asterisk+1, &rpath) < 0) {
+        return ONLP_STATUS_E_MISSING;
+    }
+    aim_strlcpy(fname, rpath, size);
+    aim_free(rpath);
+    find_cache_put__(pattern, fname);
+    return ONLP_STATUS_OK;
+}
+
 /**
  * @brief Open a file or domain socket.
  * @param dst Receives the full filename (for logging purposes).
  * @param flags The open flags.
- * @param fmt Format specifier.
- * @param vargs Format specifier arguments.
+ * @param name The unresolved filename.
  */
 static int
-vopen__(char** dst, int flags, const char* fmt, va_list vargs)
+open__(char** dst, int flags, const char* name)
 {
     int fd;
+    int rv;
     struct stat sb;
     char fname[PATH_MAX];
-    char* asterisk;
+    char pattern[PATH_MAX];
+    int cached;
 
-    ONLPLIB_VSNPRINTF(fname, sizeof(fname)-1, fmt, vargs);
+    aim_strlcpy(fname, name, sizeof(fname));
+    aim_strlcpy(pattern, fname, sizeof(pattern));
 
-    /**
-     * An asterisk in the filename separates a search root
-     * directory from a filename.
-     */
-    if( (asterisk = strchr(fname, '*')) ) {
-        char* root = fname;
-        char* rpath = NULL;
-        *asterisk = 0;
-        if(onlp_file_find(root, asterisk+1, &rpath) < 0) {
+    if(resolve__(fname, sizeof(fname), &cached) < 0) {
+        return ONLP_STATUS_E_MISSING;
+    }
+
+    rv = stat(fname, &sb);
+    if(rv == -1 && cached) {
+        /* The cached path is stale. Search again. */
+        find_cache_remove__(pattern);
+        aim_strlcpy(fname, pattern, sizeof(fname));
+        if(resolve__(fname, sizeof(fname), &cached) < 0) {
             return ONLP_STATUS_E_MISSING;
         }
-        strcpy(fname, rpath);
-        aim_free(rpath);
+        rv = stat(fname, &sb);
     }
 
     if(dst) {
         *dst = aim_strdup(fname);
     }
 
-    if(stat(fname, &sb) == -1) {
+    if(rv == -1) {
         return ONLP_STATUS_E_MISSING;
     }
 
@@ -127,6 +277,168 @@ vopen__(char** dst, int flags, const char* fmt, va_list vargs)
     return (fd > 0) ? fd : ONLP_STATUS_E_MISSING;
 }
 
+/**
+ * @brief Open a file or domain socket.
+ * @param dst Receives the full filename (for logging purposes).
+ * @param flags The open flags.
+ * @param fmt Format specifier.
+ * @param vargs Format specifier arguments.
+ */
+static int
+vopen__(char** dst, int flags, const char* fmt, va_list vargs)
+{
+    char fname[PATH_MAX];
+    ONLPLIB_VSNPRINTF(fname, sizeof(fname)-1, fmt, vargs);
+    return open__(dst, flags, fname);
+}
+
+#if ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE > 0
+
+/**
+ * Cached read descriptors.
+ *
+ * Sysfs attributes are polled repeatedly. Descriptors opened by
+ * onlp_file_read() for sysfs attributes are kept open, keyed by the
+ * unresolved filename, and re-read in place at offset 0. An entry is
+ * dropped on any read error and the read falls back to a fresh open,
+ * so removed or recreated attributes behave as before.
+ *
+ * The cache lock only covers the table. Readers take a reference on
+ * the entry and pread() outside the lock; an entry that is evicted or
+ * flushed while referenced is marked stale and closed by the last
+ * reader.
+ */
+typedef struct handle_cache_entry_s {
+    char* name;
+    int fd;
+    uint32_t used;
+    int refs;
+    int stale;
+} handle_cache_entry_t;
+
+static handle_cache_entry_t handle_cache__[ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE];
+static uint32_t handle_cache_clock__;
+static pthread_mutex_t handle_cache_lock__ = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+handle_cache_entry_clear__(handle_cache_entry_t* e)
+{
+    if(e->refs) {
+        e->stale = 1;
+        return;
+    }
+    if(e->name) {
+        close(e->fd);
+    }
+    aim_free(e->name);
+    memset(e, 0, sizeof(*e));
+}
+
+/*
+ * Returns 1 if the read was satisfied from a cached descriptor.
+ */
+static int
+handle_cache_read__(const char* name, uint8_t* data, int max, int* len)
+{
+    int i;
+    int n;
+    handle_cache_entry_t* e = NULL;
+
+    pthread_mutex_lock(&handle_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE; i++) {
+        if(handle_cache__[i].name && !handle_cache__[i].stale &&
+           !strcmp(handle_cache__[i].name, name)) {
+            e = handle_cache__ + i;
+            e->refs++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&handle_cache_lock__);
+
+    if(e == NULL) {
+        return 0;
+    }
+
+    memset(data, 0, max);
+    n = pread(e->fd, data, max, 0);
+
+    pthread_mutex_lock(&handle_cache_lock__);
+    e->refs--;
+    if(n > 0) {
+        *len = n;
+        e->used = ++handle_cache_clock__;
+    }
+    if(n <= 0 || e->stale) {
+        handle_cache_entry_clear__(e);
+    }
+    pthread_mutex_unlock(&handle_cache_lock__);
+    return n > 0;
+}
+
+/*
+ * Returns 1 if the cache took ownership of the descriptor.
+ */
+static int
+handle_cache_put__(const char* name, const char* path, int fd)
+{
+    int i;
+    handle_cache_entry_t* victim = NULL;
+
+    if(strncmp(path, "/sys/", 5)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&handle_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE; i++) {
+        handle_cache_entry_t* e = handle_cache__ + i;
+        if(e->name && !e->stale && !strcmp(e->name, name)) {
+            /* Added by another thread. */
+            pthread_mutex_unlock(&handle_cache_lock__);
+            return 0;
+        }
+        if(e->refs) {
+            /* In use; cannot be evicted. */
+            continue;
+        }
+        if(victim == NULL || (victim->name && (e->name == NULL || e->used < victim->used))) {
+            victim = e;
+        }
+    }
+    if(victim == NULL) {
+        pthread_mutex_unlock(&handle_cache_lock__);
+        return 0;
+    }
+    handle_cache_entry_clear__(victim);
+    victim->name = aim_strdup(name);
+    victim->fd = fd;
+    victim->used = ++handle_cache_clock__;
+    pthread_mutex_unlock(&handle_cache_lock__);
+    return 1;
+}
+
+void
+onlp_file_handle_cache_flush(void)
+{
+    int i;
+    pthread_mutex_lock(&handle_cache_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE; i++) {
+        handle_cache_entry_clear__(handle_cache__ + i);
+    }
+    pthread_mutex_unlock(&handle_cache_lock__);
+}
+
+#else
+
+#define handle_cache_read__(_name, _data, _max, _len) 0
+#define handle_cache_put__(_name, _path, _fd) 0
+
+void
+onlp_file_handle_cache_flush(void)
+{
+}
+
+#endif /* ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE */
+
 int
 onlp_file_vsize(const char* fmt, va_list vargs)
 {
@@ -161,9 +473,17 @@ onlp_file_vread(uint8_t* data, int max, int* len, const char* fmt, va_list vargs
 {
     int fd;
     char* fname = NULL;
+    char name[PATH_MAX];
     int rv;
 
-    if ((fd = vopen__(&fname, O_RDONLY, fmt, vargs)) < 0) {
+    ONLPLIB_VSNPRINTF(name, sizeof(name)-1, fmt, vargs);
+
+    if(handle_cache_read__(name, data, max, len)) {
+        return ONLP_STATUS_OK;
+    }
+
+    /* Descriptors may be cached; keep them out of child processes. */
+    if ((fd = open__(&fname, O_RDONLY | O_CLOEXEC, name)) < 0) {
         rv = fd;
     }
     else {
@@ -171,11 +491,14 @@ onlp_file_vread(uint8_t* data, int max, int* len, const char* fmt, va_list vargs
         if ((*len = read(fd, data, max)) <= 0) {
             AIM_LOG_ERROR("Failed to read input file '%s'", fname);
             rv = ONLP_STATUS_E_INTERNAL;
+            close(fd);
         }
         else {
             rv = ONLP_STATUS_OK;
+            if(!handle_cache_put__(name, fname, fd)) {
+                close(fd);
+            }
         }
-        close(fd);
     }
     aim_free(fname);
     return rv;
@@ -411,6 +734,160 @@ onlp_file_vopen(int flags, int log, const char* fmt, va_list vargs)
     return rv;
 }
 
+int
+onlp_file_handle_vopen(onlp_file_handle_t* handle, int flags,
+                       const char* fmt, va_list vargs)
+{
+    int fd;
+    char* fname = NULL;
+    struct stat sb;
+
+    if(handle == NULL || fmt == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    handle->fd = -1;
+    handle->flags = flags;
+    handle->path = NULL;
+
+    fd = vopen__(&fname, flags, fmt, vargs);
+    if(fd < 0) {
+        aim_free(fname);
+        return fd;
+    }
+
+    if(fstat(fd, &sb) == 0 && S_ISSOCK(sb.st_mode)) {
+        /*
+         * Domain sockets cannot be re-read in place.
+         * Accesses reconnect through the resolved path.
+         */
+        close(fd);
+        fd = -1;
+    }
+
+    handle->fd = fd;
+    handle->path = fname;
+    return ONLP_STATUS_OK;
+}
+
+int
+onlp_file_handle_open(onlp_file_handle_t* handle, int flags,
+                      const char* fmt, ...)
+{
+    int rv;
+    va_list vargs;
+    va_start(vargs, fmt);
+    rv = onlp_file_handle_vopen(handle, flags, fmt, vargs);
+    va_end(vargs);
+    return rv;
+}
+
+/**
+ * @brief Reopen a handle after an access error.
+ */
+static int
+handle_reopen__(onlp_file_handle_t* handle)
+{
+    if(handle->fd >= 0) {
+        close(handle->fd);
+    }
+    handle->fd = open(handle->path, handle->flags);
+    return (handle->fd >= 0) ? ONLP_STATUS_OK : ONLP_STATUS_E_MISSING;
+}
+
+int
+onlp_file_handle_read(onlp_file_handle_t* handle, uint8_t* data, int max, int* len)
+{
+    int rv;
+
+    if(handle == NULL || handle->path == NULL || data == NULL || len == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    if(handle->fd < 0) {
+        return onlp_file_read(data, max, len, "%s", handle->path);
+    }
+
+    memset(data, 0, max);
+    rv = pread(handle->fd, data, max, 0);
+    if(rv < 0 && handle_reopen__(handle) == 0) {
+        /* The attribute may have been recreated. Try once more. */
+        rv = pread(handle->fd, data, max, 0);
+    }
+
+    if(rv <= 0) {
+        AIM_LOG_ERROR("Failed to read input file '%s'", handle->path);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    *len = rv;
+    return ONLP_STATUS_OK;
+}
+
+int
+onlp_file_handle_read_int(onlp_file_handle_t* handle, int* value)
+{
+    int rv;
+    uint8_t data[32];
+    int len;
+
+    rv = onlp_file_handle_read(handle, data, sizeof(data)-1, &len);
+    if(rv < 0) {
+        return rv;
+    }
+    data[len] = 0;
+    *value = ONLPLIB_ATOI((char*)data);
+    return 0;
+}
+
+int
+onlp_file_handle_write(onlp_file_handle_t* handle, uint8_t* data, int len)
+{
+    int rv;
+
+    if(handle == NULL || handle->path == NULL || data == NULL) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    if(handle->fd < 0) {
+        return onlp_file_write(data, len, "%s", handle->path);
+    }
+
+    rv = pwrite(handle->fd, data, len, 0);
+    if(rv < 0 && handle_reopen__(handle) == 0) {
+        rv = pwrite(handle->fd, data, len, 0);
+    }
+
+    if(rv != len) {
+        AIM_LOG_ERROR("Failed to write output file '%s'", handle->path);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    return ONLP_STATUS_OK;
+}
+
+int
+onlp_file_handle_write_int(onlp_file_handle_t* handle, int value)
+{
+    int rv;
+    char* s = aim_fstrdup("%d", value);
+    rv = onlp_file_handle_write(handle, (uint8_t*)s, strlen(s)+1);
+    aim_free(s);
+    return rv;
+}
+
+void
+onlp_file_handle_close(onlp_file_handle_t* handle)
+{
+    if(handle) {
+        if(handle->fd >= 0) {
+            close(handle->fd);
+        }
+        aim_free(handle->path);
+        handle->fd = -1;
+        handle->path = NULL;
+    }
+}
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <err.h>
@@ -210,10 +210,12 @@ accept__(onlp_file_uds_service_t* ufp)
 {
     int fd;
 
-    if((fd = accept(ufp->lfd, NULL, 0)) > 0) {
-        ufp->handler(fd, ufp->cookie);
+    if((fd = accept(ufp->lfd, NULL, 0)) < 0) {
+        return;
+    }
+    if(ufp->handler(fd, ufp->cookie) != ONLP_FILE_UDS_HANDLER_KEEP) {
+        close(fd);
     }
-    close(fd);
 }
 
 /**
@@ -226,8 +228,9 @@ accept__(onlp_file_uds_service_t* ufp)
  * All registered services are polled for incoming connections
  * and handled in series.
  *
- * These are designed for simple transactions and not
- * long-lived connections.
+ * These are designed for simple transactions. Handlers which
+ * need a long-lived connection keep the descriptor and serve
+ * it from their own thread.
  */
 static void*
 uds_thread_worker__(void* p)
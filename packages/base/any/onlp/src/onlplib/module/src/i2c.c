@@ -29,6 +29,8 @@
 #include <onlplib/file.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <pthread.h>
 
 #include <sys/types.h>
 #include <sys/ioctl.h>
@@ -36,13 +38,31 @@
 #include <onlp/onlp.h>
 #include "onlplib_log.h"
 
-int
-onlp_i2c_open(int bus, uint8_t addr, uint32_t flags)
+#if ONLPLIB_CONFIG_I2C_USE_CUSTOM_HEADER == 0
+#include <linux/i2c.h>
+#endif
+
+#ifndef I2C_RDWR_IOCTL_MAX_MSGS
+#define I2C_RDWR_IOCTL_MAX_MSGS 42
+#endif
+
+/**
+ * Flags which affect the state of an open descriptor.
+ */
+#define I2C_FD_FLAGS (ONLP_I2C_F_TENBIT | ONLP_I2C_F_FORCE | ONLP_I2C_F_PEC)
+
+/**
+ * Descriptor address for bus-only access (I2C_RDWR).
+ */
+#define I2C_FD_NO_ADDR -1
+
+static int
+i2c_open__(int bus, int addr, uint32_t flags, int oflags)
 {
     int fd;
     int rv;
 
-    fd = onlp_file_open(O_RDWR, 1, "/dev/i2c-%d", bus);
+    fd = onlp_file_open(O_RDWR | oflags, 1, "/dev/i2c-%d", bus);
     if(fd < 0) {
         return fd;
     }
@@ -55,6 +75,11 @@ onlp_i2c_open(int bus, uint8_t addr, uint32_t flags)
         goto error;
     }
 
+    if(addr == I2C_FD_NO_ADDR) {
+        /* Slave addressing is specified per message. */
+        return fd;
+    }
+
     /* Enable/Disable PEC */
     rv = ioctl(fd, I2C_PEC, (flags & ONLP_I2C_F_PEC) ? 1 : 0);
     if(rv == -1) {
@@ -84,13 +109,201 @@ onlp_i2c_open(int bus, uint8_t addr, uint32_t flags)
     return ONLP_STATUS_E_I2C;
 }
 
+int
+onlp_i2c_open(int bus, uint8_t addr, uint32_t flags)
+{
+    return i2c_open__(bus, addr, flags, 0);
+}
+
+
+/**
+ * Descriptor Pool
+ *
+ * Opening a device requires an open() and up to three ioctls.
+ * Descriptors are kept open per (bus, addr, flags) and reused
+ * until they are evicted (least recently used first), flushed,
+ * or released after an error.
+ */
+#if ONLPLIB_CONFIG_I2C_FD_POOL_SIZE > 0
+
+typedef struct i2c_fd_s {
+    int valid;
+    int fd;
+    int bus;
+    int addr;
+    uint32_t flags;
+    unsigned long funcs;
+
+    /** Number of active users. */
+    int refs;
+
+    /** Close when the last user releases it. */
+    int stale;
+
+    /** Last use (for eviction). */
+    uint64_t used;
+} i2c_fd_t;
+
+static i2c_fd_t pool__[ONLPLIB_CONFIG_I2C_FD_POOL_SIZE];
+static uint64_t pool_clock__;
+static pthread_mutex_t pool_lock__ = PTHREAD_MUTEX_INITIALIZER;
+
+#endif
+
+static unsigned long
+i2c_funcs__(int fd)
+{
+    unsigned long funcs = 0;
+    if(ioctl(fd, I2C_FUNCS, &funcs) < 0) {
+        funcs = 0;
+    }
+    return funcs;
+}
+
+/**
+ * Get a descriptor for the given device.
+ * Must be released with i2c_fd_put__().
+ */
+static int
+i2c_fd_get__(int bus, int addr, uint32_t flags, unsigned long* funcs)
+{
+    int fd;
+    flags &= I2C_FD_FLAGS;
+
+#if ONLPLIB_CONFIG_I2C_FD_POOL_SIZE > 0
+    int i;
+    i2c_fd_t* e = NULL;
+
+    pthread_mutex_lock(&pool_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_I2C_FD_POOL_SIZE; i++) {
+        i2c_fd_t* p = pool__ + i;
+        if(p->valid && !p->stale && p->bus == bus &&
+           p->addr == addr && p->flags == flags) {
+            p->refs++;
+            p->used = ++pool_clock__;
+            fd = p->fd;
+            if(funcs) {
+                *funcs = p->funcs;
+            }
+            pthread_mutex_unlock(&pool_lock__);
+            return fd;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock__);
+
+    fd = i2c_open__(bus, addr, flags, O_CLOEXEC);
+    if(fd < 0) {
+        return fd;
+    }
+
+    pthread_mutex_lock(&pool_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_I2C_FD_POOL_SIZE; i++) {
+        i2c_fd_t* p = pool__ + i;
+        if(!p->valid) {
+            e = p;
+            break;
+        }
+        if(p->refs == 0 && (e == NULL || p->used < e->used)) {
+            e = p;
+        }
+    }
+    if(e) {
+        if(e->valid) {
+            close(e->fd);
+        }
+        e->valid = 1;
+        e->fd = fd;
+        e->bus = bus;
+        e->addr = addr;
+        e->flags = flags;
+        e->funcs = i2c_funcs__(fd);
+        e->refs = 1;
+        e->stale = 0;
+        e->used = ++pool_clock__;
+        if(funcs) {
+            *funcs = e->funcs;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock__);
+
+    if(e) {
+        return fd;
+    }
+    /* Pool is fully in use. This descriptor is closed on release. */
+#else
+    fd = i2c_open__(bus, addr, flags, O_CLOEXEC);
+    if(fd < 0) {
+        return fd;
+    }
+#endif
+
+    if(funcs) {
+        *funcs = i2c_funcs__(fd);
+    }
+    return fd;
+}
+
+/**
+ * Release a descriptor returned by i2c_fd_get__().
+ * Descriptors released after an error are not reused.
+ */
+static void
+i2c_fd_put__(int fd, int error)
+{
+#if ONLPLIB_CONFIG_I2C_FD_POOL_SIZE > 0
+    int i;
+
+    pthread_mutex_lock(&pool_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_I2C_FD_POOL_SIZE; i++) {
+        i2c_fd_t* p = pool__ + i;
+        if(p->valid && p->fd == fd) {
+            p->refs--;
+            if(error) {
+                p->stale = 1;
+            }
+            if(p->stale && p->refs == 0) {
+                close(p->fd);
+                p->valid = 0;
+            }
+            pthread_mutex_unlock(&pool_lock__);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock__);
+#endif
+    close(fd);
+}
+
+void
+onlp_i2c_pool_flush(void)
+{
+#if ONLPLIB_CONFIG_I2C_FD_POOL_SIZE > 0
+    int i;
+
+    pthread_mutex_lock(&pool_lock__);
+    for(i = 0; i < ONLPLIB_CONFIG_I2C_FD_POOL_SIZE; i++) {
+        i2c_fd_t* p = pool__ + i;
+        if(p->valid) {
+            if(p->refs == 0) {
+                close(p->fd);
+                p->valid = 0;
+            }
+            else {
+                p->stale = 1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&pool_lock__);
+#endif
+}
+
 int
 onlp_i2c_block_read(int bus, uint8_t addr, uint8_t offset, int size,
                     uint8_t* rdata, uint32_t flags)
 {
     int fd;
 
-    fd = onlp_i2c_open(bus, addr, flags);
+    fd = i2c_fd_get__(bus, addr, flags, NULL);
 
     if(fd < 0) {
         return fd;
@@ -127,11 +340,11 @@ onlp_i2c_block_read(int bus, uint8_t addr, uint8_t offset, int size,
         count -= rsize;
     }
 
-    close(fd);
+    i2c_fd_put__(fd, 0);
     return 0;
 
  error:
-    close(fd);
+    i2c_fd_put__(fd, 1);
     return ONLP_STATUS_E_I2C;
 }
 
@@ -142,7 +355,18 @@ onlp_i2c_read(int bus, uint8_t addr, uint8_t offset, int size,
     int i;
     int fd;
 
-    fd = onlp_i2c_open(bus, addr, flags);
+    if((flags & ONLP_I2C_F_USE_RDWR) && size > 1) {
+        onlp_i2c_xfer_t xfer = {
+            .addr = addr,
+            .offset = offset,
+            .write = 0,
+            .size = size,
+            .data = rdata,
+        };
+        return onlp_i2c_xfer(bus, &xfer, 1, flags);
+    }
+
+    fd = i2c_fd_get__(bus, addr, flags, NULL);
 
     if(fd < 0) {
         return fd;
@@ -165,11 +389,11 @@ onlp_i2c_read(int bus, uint8_t addr, uint8_t offset, int size,
             rdata[i] = rv;
         }
     }
-    close(fd);
+    i2c_fd_put__(fd, 0);
     return 0;
 
  error:
-    close(fd);
+    i2c_fd_put__(fd, 1);
     return ONLP_STATUS_E_I2C;
 }
 
@@ -181,7 +405,7 @@ onlp_i2c_write(int bus, uint8_t addr, uint8_t offset, int size,
     int i;
     int fd;
 
-    fd = onlp_i2c_open(bus, addr, flags);
+    fd = i2c_fd_get__(bus, addr, flags, NULL);
 
     if(fd < 0) {
         return fd;
@@ -195,11 +419,11 @@ onlp_i2c_write(int bus, uint8_t addr, uint8_t offset, int size,
             goto error;
         }
     }
-    close(fd);
+    i2c_fd_put__(fd, 0);
     return 0;
 
  error:
-    close(fd);
+    i2c_fd_put__(fd, 1);
     return ONLP_STATUS_E_I2C;
 }
 
@@ -236,7 +460,7 @@ onlp_i2c_readw(int bus, uint8_t addr, uint8_t offset, uint32_t flags)
     int fd;
     int rv;
 
-    fd = onlp_i2c_open(bus, addr, flags);
+    fd = i2c_fd_get__(bus, addr, flags, NULL);
 
     if(fd < 0) {
         return fd;
@@ -244,7 +468,7 @@ onlp_i2c_readw(int bus, uint8_t addr, uint8_t offset, uint32_t flags)
 
     rv = i2c_smbus_read_word_data(fd, offset);
 
-    close(fd);
+    i2c_fd_put__(fd, rv < 0);
     return rv;
 }
 
@@ -255,7 +479,7 @@ onlp_i2c_writew(int bus, uint8_t addr, uint8_t offset, uint16_t word,
     int fd;
     int rv;
 
-    fd = onlp_i2c_open(bus, addr, flags);
+    fd = i2c_fd_get__(bus, addr, flags, NULL);
 
     if(fd < 0) {
         return fd;
@@ -263,9 +487,242 @@ onlp_i2c_writew(int bus, uint8_t addr, uint8_t offset, uint16_t word,
 
     rv = i2c_smbus_write_word_data(fd, offset, word);
 
-    close(fd);
+    i2c_fd_put__(fd, rv < 0);
+    return rv;
+
+}
+
+
+/**
+ * Batched Transfers
+ */
+
+static int
+i2c_rdwr__(int fd, struct i2c_msg* msgs, int nmsgs, int retries)
+{
+    int rv = -1;
+    struct i2c_rdwr_ioctl_data data;
+
+    data.msgs = msgs;
+    data.nmsgs = nmsgs;
+
+    while(retries-- && rv < 0) {
+        rv = ioctl(fd, I2C_RDWR, &data);
+    }
     return rv;
+}
+
+static int
+i2c_xfer_rdwr__(int fd, int bus, onlp_i2c_xfer_t* xfers, int count,
+                uint32_t flags)
+{
+    int i, m;
+    int rv = 0;
+    int wsize = 0;
+    uint8_t* wbuf;
+    uint8_t* wp;
+    struct i2c_msg* msgs;
+    int* first;
+    uint16_t mflags = (flags & ONLP_I2C_F_TENBIT) ? I2C_M_TEN : 0;
+    int retries = (flags & ONLP_I2C_F_DISABLE_READ_RETRIES) ? 1 : ONLPLIB_CONFIG_I2C_READ_RETRY_COUNT;
+
+    /*
+     * Writes carry the offset and the data in a single message.
+     * Reads write the offset and then read with a repeated start.
+     */
+    for(i = 0; i < count; i++) {
+        wsize += 1 + (xfers[i].write ? xfers[i].size : 0);
+    }
 
+    wp = wbuf = aim_zmalloc(wsize);
+    msgs = aim_zmalloc(sizeof(*msgs) * 2 * count);
+    first = aim_zmalloc(sizeof(*first) * (count + 1));
+
+    for(i = 0, m = 0; i < count; i++) {
+        onlp_i2c_xfer_t* x = xfers + i;
+        first[i] = m;
+        wp[0] = x->offset;
+        msgs[m].addr = x->addr;
+        msgs[m].flags = mflags;
+        msgs[m].buf = wp;
+        if(x->write) {
+            memcpy(wp + 1, x->data, x->size);
+            msgs[m].len = 1 + x->size;
+            wp += 1 + x->size;
+            m++;
+        }
+        else {
+            msgs[m].len = 1;
+            wp += 1;
+            m++;
+            msgs[m].addr = x->addr;
+            msgs[m].flags = mflags | I2C_M_RD;
+            msgs[m].len = x->size;
+            msgs[m].buf = x->data;
+            m++;
+        }
+    }
+    first[count] = m;
+
+    i = 0;
+    while(i < count) {
+        int start = i;
+        int writes = 0;
+
+        while(i < count &&
+              first[i+1] - first[start] <= I2C_RDWR_IOCTL_MAX_MSGS) {
+            writes |= xfers[i].write;
+            i++;
+        }
+
+        /* Writes are not retried. */
+        if(i2c_rdwr__(fd, msgs + first[start], first[i] - first[start],
+                      writes ? 1 : retries) >= 0) {
+            for(m = start; m < i; m++) {
+                xfers[m].status = ONLP_STATUS_OK;
+            }
+            continue;
+        }
+
+        if(writes) {
+            /*
+             * The failed message is not known, so some of the writes may
+             * have completed. They are not repeated and the remaining
+             * transfers are not attempted.
+             */
+            AIM_LOG_ERROR("i2c-%d: transfers %d-%d failed: %{errno}",
+                          bus, start, i - 1, errno);
+            for(m = start; m < count; m++) {
+                xfers[m].status = ONLP_STATUS_E_I2C;
+            }
+            rv = ONLP_STATUS_E_I2C;
+            break;
+        }
+
+        /*
+         * The reads failed as a whole.
+         * Repeat each transfer individually to localize the failure.
+         */
+        for(m = start; m < i; m++) {
+            onlp_i2c_xfer_t* x = xfers + m;
+            if(i - start > 1 &&
+               i2c_rdwr__(fd, msgs + first[m], first[m+1] - first[m],
+                          retries) >= 0) {
+                x->status = ONLP_STATUS_OK;
+            }
+            else {
+                AIM_LOG_ERROR("i2c-%d: reading address 0x%x, offset %d, size=%d failed: %{errno}",
+                              bus, x->addr, x->offset, x->size, errno);
+                x->status = ONLP_STATUS_E_I2C;
+                if(rv == 0) {
+                    rv = ONLP_STATUS_E_I2C;
+                }
+            }
+        }
+    }
+
+    aim_free(first);
+    aim_free(msgs);
+    aim_free(wbuf);
+    return rv;
+}
+
+/**
+ * I2C_RDWR does not check whether a kernel driver owns an address.
+ * Apply the same check as I2C_SLAVE to every address unless forced.
+ */
+static int
+i2c_xfer_addr_check__(int fd, int bus, onlp_i2c_xfer_t* xfers, int count)
+{
+    int i, j;
+
+    for(i = 0; i < count; i++) {
+        for(j = 0; j < i && xfers[j].addr != xfers[i].addr; j++);
+        if(j < i) {
+            continue;
+        }
+        if(ioctl(fd, I2C_SLAVE, xfers[i].addr) < 0) {
+            AIM_LOG_ERROR("i2c-%d: setting slave address 0x%x failed: %{errno}",
+                          bus, xfers[i].addr, errno);
+            for(j = 0; j < count; j++) {
+                xfers[j].status = ONLP_STATUS_E_I2C;
+            }
+            return ONLP_STATUS_E_I2C;
+        }
+    }
+    return 0;
+}
+
+static int
+i2c_xfer_smbus__(int bus, onlp_i2c_xfer_t* xfers, int count,
+                 uint32_t flags, unsigned long funcs)
+{
+    int i;
+    int rv = 0;
+
+    flags &= ~ONLP_I2C_F_USE_RDWR;
+
+    for(i = 0; i < count; i++) {
+        onlp_i2c_xfer_t* x = xfers + i;
+        if(x->write) {
+            x->status = onlp_i2c_write(bus, x->addr, x->offset, x->size,
+                                       x->data, flags);
+        }
+        else if(funcs & I2C_FUNC_SMBUS_READ_I2C_BLOCK) {
+            x->status = onlp_i2c_block_read(bus, x->addr, x->offset, x->size,
+                                            x->data, flags);
+        }
+        else {
+            x->status = onlp_i2c_read(bus, x->addr, x->offset, x->size,
+                                      x->data, flags);
+        }
+        if(x->status < 0 && rv == 0) {
+            rv = x->status;
+        }
+    }
+    return rv;
+}
+
+int
+onlp_i2c_xfer(int bus, onlp_i2c_xfer_t* xfers, int count, uint32_t flags)
+{
+    int i;
+    int fd;
+    int rv;
+    unsigned long funcs;
+
+    if(xfers == NULL || count <= 0) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    for(i = 0; i < count; i++) {
+        if(xfers[i].size < 0 || xfers[i].size > 8192 ||
+           (xfers[i].size && xfers[i].data == NULL) ||
+           (!xfers[i].write && xfers[i].size == 0)) {
+            return ONLP_STATUS_E_PARAM;
+        }
+    }
+
+    fd = i2c_fd_get__(bus, I2C_FD_NO_ADDR, flags & ONLP_I2C_F_TENBIT, &funcs);
+    if(fd < 0) {
+        return fd;
+    }
+
+    if(!(funcs & I2C_FUNC_I2C) || (flags & ONLP_I2C_F_PEC)) {
+        /* I2C_RDWR is not available. */
+        i2c_fd_put__(fd, 0);
+        return i2c_xfer_smbus__(bus, xfers, count, flags, funcs);
+    }
+
+    if(!(flags & ONLP_I2C_F_FORCE) &&
+       (rv = i2c_xfer_addr_check__(fd, bus, xfers, count)) < 0) {
+        i2c_fd_put__(fd, 0);
+        return rv;
+    }
+
+    rv = i2c_xfer_rdwr__(fd, bus, xfers, count, flags);
+    i2c_fd_put__(fd, rv < 0);
+    return rv;
 }
 
 int
@@ -317,6 +317,80 @@ checksum_validate__(const uint8_t *data)
     return 0;
 }
 
+int
+onlp_onie_data_validate(const uint8_t* data, int size, uint32_t* crc)
+{
+    tlvinfo_header_t* data_hdr = (tlvinfo_header_t *) data;
+    tlvinfo_tlv_t* data_crc;
+    int len;
+
+    if(data == NULL || size < sizeof(*data_hdr) ||
+       !is_valid_tlvinfo_header__(data_hdr)) {
+        return -1;
+    }
+
+    len = sizeof(tlvinfo_header_t) + ntohs(data_hdr->totallen);
+    if(len > size || len < sizeof(tlvinfo_header_t) + sizeof(tlvinfo_tlv_t) + 4) {
+        return -1;
+    }
+
+    data_crc = (tlvinfo_tlv_t *) &data[len - (sizeof(tlvinfo_tlv_t) + 4)];
+    if((data_crc->type != TLV_CODE_CRC_32) || (data_crc->length != 4)) {
+        return -1;
+    }
+
+    if(checksum_validate__(data) != 0) {
+        return -1;
+    }
+
+    if(crc) {
+        *crc = (data_crc->value[0] << 24) |
+            (data_crc->value[1] << 16) |
+            (data_crc->value[2] <<  8) |
+            data_crc->value[3];
+    }
+    return len;
+}
+
+int
+onlp_onie_info_copy(onlp_onie_info_t* dst, const onlp_onie_info_t* src)
+{
+    list_links_t *cur;
+
+    if(dst == NULL || src == NULL) {
+        return -1;
+    }
+
+    memcpy(dst, src, sizeof(*dst));
+    list_init(&dst->vx_list);
+
+#define COPY_STRING(_member)                                    \
+    dst -> _member = src -> _member ? aim_strdup(src -> _member) : NULL
+
+    COPY_STRING(product_name);
+    COPY_STRING(part_number);
+    COPY_STRING(serial_number);
+    COPY_STRING(manufacture_date);
+    COPY_STRING(label_revision);
+    COPY_STRING(platform_name);
+    COPY_STRING(onie_version);
+    COPY_STRING(manufacturer);
+    COPY_STRING(country_code);
+    COPY_STRING(vendor);
+    COPY_STRING(diag_version);
+    COPY_STRING(service_tag);
+    COPY_STRING(_hdr_id_string);
+
+    LIST_FOREACH((list_head_t*)&src->vx_list, cur) {
+        onlp_onie_vx_t* vx = container_of(cur, links, onlp_onie_vx_t);
+        onlp_onie_vx_t* copy = aim_zmalloc(sizeof(*copy));
+        memcpy(copy->data, vx->data, sizeof(copy->data));
+        copy->size = vx->size;
+        list_push(&dst->vx_list, &copy->links);
+    }
+    return 0;
+}
+
 void
 onlp_onie_info_free(onlp_onie_info_t* info)
 {
@@ -80,6 +80,26 @@ onlplib_config_settings_t onlplib_config_settings[] =
 #else
 { ONLPLIB_CONFIG_I2C_READ_RETRY_COUNT(__onlplib_config_STRINGIFY_NAME), "__undefined__" },
 #endif
+#ifdef ONLPLIB_CONFIG_I2C_FD_POOL_SIZE
+    { __onlplib_config_STRINGIFY_NAME(ONLPLIB_CONFIG_I2C_FD_POOL_SIZE), __onlplib_config_STRINGIFY_VALUE(ONLPLIB_CONFIG_I2C_FD_POOL_SIZE) },
+#else
+{ ONLPLIB_CONFIG_I2C_FD_POOL_SIZE(__onlplib_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE
+    { __onlplib_config_STRINGIFY_NAME(ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE), __onlplib_config_STRINGIFY_VALUE(ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE) },
+#else
+{ ONLPLIB_CONFIG_FILE_FIND_CACHE_SIZE(__onlplib_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE
+    { __onlplib_config_STRINGIFY_NAME(ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE), __onlplib_config_STRINGIFY_VALUE(ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE) },
+#else
+{ ONLPLIB_CONFIG_FILE_HANDLE_CACHE_SIZE(__onlplib_config_STRINGIFY_NAME), "__undefined__" },
+#endif
+#ifdef ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL
+    { __onlplib_config_STRINGIFY_NAME(ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL), __onlplib_config_STRINGIFY_VALUE(ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL) },
+#else
+{ ONLPLIB_CONFIG_INCLUDE_CRC32_ACCEL(__onlplib_config_STRINGIFY_NAME), "__undefined__" },
+#endif
 #ifdef ONLPLIB_CONFIG_I2C_USE_CUSTOM_HEADER
     { __onlplib_config_STRINGIFY_NAME(ONLPLIB_CONFIG_I2C_USE_CUSTOM_HEADER), __onlplib_config_STRINGIFY_VALUE(ONLPLIB_CONFIG_I2C_USE_CUSTOM_HEADER) },
 #else
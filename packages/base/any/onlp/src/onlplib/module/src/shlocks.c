@@ -26,6 +26,7 @@
 #include "onlplib_log.h"
 #include <sys/ipc.h>
 #include <errno.h>
+#include <time.h>
 
 static int
 shared_pthread_mutex_init__(pthread_mutex_t* mutex)
@@ -211,6 +212,179 @@ onlp_shlock_name(onlp_shlock_t* lock)
 }
 
 
+struct onlp_shrwlock_s {
+    uint32_t magic;
+    char name[64];
+    char owner[64];
+
+    pthread_rwlock_t rwlock;
+};
+
+#define SHRWLOCK_MAGIC 0xFEEDBEEF
+
+static int
+shared_pthread_rwlock_init__(pthread_rwlock_t* rwlock)
+{
+    int rv;
+    pthread_rwlockattr_t ra;
+
+    pthread_rwlockattr_init(&ra);
+
+    /* default to failed */
+    rv = -1;
+    if(pthread_rwlockattr_setpshared(&ra, PTHREAD_PROCESS_SHARED) != 0) {
+        AIM_LOG_ERROR("rwlock setpshared() failed: %{errno}", errno);
+    }
+#ifdef __GLIBC__
+    /*
+     * The default glibc policy prefers readers, which can starve
+     * writers indefinitely when readers overlap.
+     */
+    else if(pthread_rwlockattr_setkind_np(&ra,
+                                          PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP) != 0) {
+        AIM_LOG_ERROR("rwlock setkind() failed: %{errno}", errno);
+    }
+#endif
+    else if(pthread_rwlock_init(rwlock, &ra) != 0) {
+        AIM_LOG_ERROR("rwlock_init() failed: %{errno}", errno);
+    }
+    else {
+        /* Success */
+        rv = 0;
+    }
+    pthread_rwlockattr_destroy(&ra);
+    return rv;
+}
+
+int
+onlp_shrwlock_create(key_t id, onlp_shrwlock_t** rvl, const char* fmt, ...)
+{
+    onlp_shrwlock_t* l = NULL;
+    int rv = onlp_shmem_create(id, sizeof(onlp_shrwlock_t), (void**)&l);
+
+    if(rv >= 0) {
+        if(l->magic != SHRWLOCK_MAGIC) {
+            va_list vargs;
+            char* s;
+
+            if(shared_pthread_rwlock_init__(&l->rwlock) != 0) {
+                /* There is no useful recovery from this */
+                AIM_DIE("shrwlock_create(): rwlock_init failed\n");
+            }
+            va_start(vargs, fmt);
+            s = aim_vfstrdup(fmt, vargs);
+            va_end(vargs);
+            aim_strlcpy(l->name, s, sizeof(l->name));
+            aim_free(s);
+            l->owner[0] = 0;
+            l->magic = SHRWLOCK_MAGIC;
+        }
+        *rvl = l;
+    }
+    else {
+        AIM_DIE("shrwlock_create(): shmem_create failed\n");
+        rv = -1;
+    }
+    return rv;
+}
+
+static void
+abstime__(struct timespec* ts, uint32_t timeout)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += timeout / 1000000;
+    ts->tv_nsec += (timeout % 1000000) * 1000;
+    if(ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+int
+onlp_shrwlock_rdlock(onlp_shrwlock_t* lock, uint32_t timeout)
+{
+    int rv;
+
+    if(lock == NULL) {
+        AIM_DIE("shrwlock_rdlock(): lock is NULL");
+    }
+
+    if(timeout) {
+        struct timespec ts;
+        abstime__(&ts, timeout);
+        rv = pthread_rwlock_timedrdlock(&lock->rwlock, &ts);
+    }
+    else {
+        rv = pthread_rwlock_rdlock(&lock->rwlock);
+    }
+
+    if(rv == 0) {
+        return 0;
+    }
+    if(rv == ETIMEDOUT) {
+        return -1;
+    }
+    AIM_DIE("rwlock_rdlock failed: %{errno}", rv);
+    return -1;
+}
+
+int
+onlp_shrwlock_wrlock(onlp_shrwlock_t* lock, uint32_t timeout,
+                     const char* owner)
+{
+    int rv;
+
+    if(lock == NULL) {
+        AIM_DIE("shrwlock_wrlock(): lock is NULL");
+    }
+
+    if(timeout) {
+        struct timespec ts;
+        abstime__(&ts, timeout);
+        rv = pthread_rwlock_timedwrlock(&lock->rwlock, &ts);
+    }
+    else {
+        rv = pthread_rwlock_wrlock(&lock->rwlock);
+    }
+
+    if(rv == 0) {
+        aim_strlcpy(lock->owner, owner ? owner : "", sizeof(lock->owner));
+        return 0;
+    }
+    if(rv == ETIMEDOUT) {
+        return -1;
+    }
+    AIM_DIE("rwlock_wrlock failed: %{errno}", rv);
+    return -1;
+}
+
+int
+onlp_shrwlock_unlock(onlp_shrwlock_t* lock)
+{
+    if(lock == NULL) {
+        AIM_DIE("shrwlock_unlock(): lock is NULL");
+    }
+
+    if(pthread_rwlock_unlock(&lock->rwlock) != 0) {
+        AIM_DIE("rwlock_unlock() failed: %{errno}", errno);
+        return -1;
+    }
+    return 0;
+}
+
+const char*
+onlp_shrwlock_name(onlp_shrwlock_t* lock)
+{
+    return lock->name;
+}
+
+const char*
+onlp_shrwlock_owner(onlp_shrwlock_t* lock)
+{
+    return lock->owner;
+}
+
+
 static onlp_shlock_t* global_lock__ = NULL;
 
 
@@ -24,16 +24,130 @@
  ***********************************************************/
 
 #include <onlplib/onlplib_config.h>
+#include <onlplib/crc32.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <AIM/aim.h>
+#include <AIM/aim_time.h>
+
+/**
+ * CRC32 test vectors.
+ */
+static struct {
+    const char* data;
+    uint32_t crc;
+} crc32_vectors__[] = {
+    { "", 0x00000000 },
+    { "a", 0xe8b7be43 },
+    { "abc", 0x352441c2 },
+    { "123456789", 0xcbf43926 },
+    { "message digest", 0x20159d7f },
+    { "abcdefghijklmnopqrstuvwxyz", 0x4c2750bd },
+    { "The quick brown fox jumps over the lazy dog", 0x414fa339 },
+    { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 0x1fc2e6d2 },
+};
+
+#define CRC32_BUFFER_SIZE (64*1024)
+
+static int
+crc32_test__(const uint8_t* buf)
+{
+    int impl, i, len, offset;
+    int errors = 0;
+
+    for(impl = 0; impl < ONLP_CRC32_IMPL_COUNT; impl++) {
+        if(!onlp_crc32_impl_supported(impl)) {
+            continue;
+        }
+
+        for(i = 0; i < AIM_ARRAYSIZE(crc32_vectors__); i++) {
+            uint32_t crc = onlp_crc32_impl(impl, 0, crc32_vectors__[i].data,
+                                           strlen(crc32_vectors__[i].data));
+            if(crc != crc32_vectors__[i].crc) {
+                printf("crc32 %s: \"%s\" 0x%.8x != 0x%.8x\n",
+                       onlp_crc32_impl_name(impl), crc32_vectors__[i].data,
+                       crc, crc32_vectors__[i].crc);
+                errors++;
+            }
+        }
+
+        /* Every length and alignment against the reference. */
+        for(len = 0; len <= 1024; len++) {
+            for(offset = 0; offset < 16; offset++) {
+                uint32_t ref = onlp_crc32_impl(ONLP_CRC32_IMPL_TABLE, len, buf + offset, len);
+                uint32_t crc = onlp_crc32_impl(impl, len, buf + offset, len);
+                if(crc != ref) {
+                    printf("crc32 %s: len %d offset %d 0x%.8x != 0x%.8x\n",
+                           onlp_crc32_impl_name(impl), len, offset, crc, ref);
+                    errors++;
+                }
+            }
+        }
+
+        /* Incremental calculation. */
+        for(len = 0; len < CRC32_BUFFER_SIZE; len += 4099) {
+            uint32_t ref = onlp_crc32_impl(ONLP_CRC32_IMPL_TABLE, 0, buf, CRC32_BUFFER_SIZE);
+            uint32_t crc = onlp_crc32_impl(impl, 0, buf, len);
+            crc = onlp_crc32_impl(impl, crc, buf + len, CRC32_BUFFER_SIZE - len);
+            if(crc != ref) {
+                printf("crc32 %s: split %d 0x%.8x != 0x%.8x\n",
+                       onlp_crc32_impl_name(impl), len, crc, ref);
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+static void
+crc32_benchmark__(const uint8_t* buf)
+{
+    static const int sizes[] = { 256, 2048, CRC32_BUFFER_SIZE };
+    int impl, s, i, iterations;
+
+    printf("crc32: using %s\n", onlp_crc32_impl_name(onlp_crc32_impl_get()));
+
+    for(impl = 0; impl < ONLP_CRC32_IMPL_COUNT; impl++) {
+        if(!onlp_crc32_impl_supported(impl)) {
+            continue;
+        }
+        printf("crc32 %-8s", onlp_crc32_impl_name(impl));
+        for(s = 0; s < AIM_ARRAYSIZE(sizes); s++) {
+            volatile uint32_t crc = 0;
+            uint64_t start, elapsed;
+
+            iterations = (16*1024*1024) / sizes[s];
+            start = aim_time_monotonic();
+            for(i = 0; i < iterations; i++) {
+                crc = onlp_crc32_impl(impl, crc, buf, sizes[s]);
+            }
+            elapsed = aim_time_monotonic() - start;
+            printf(" %6d bytes: %6.0f MB/s", sizes[s],
+                   elapsed ? (16.0*1024*1024) / elapsed : 0.0);
+        }
+        printf("\n");
+    }
+}
 
 int aim_main(int argc, char* argv[])
 {
-    printf("onlplib Utest Is Empty\n");
+    int i;
+    int errors;
+    uint8_t* buf = aim_zmalloc(CRC32_BUFFER_SIZE + 16);
+
     onlplib_config_show(&aim_pvs_stdout);
-    return 0;
+
+    srand(0);
+    for(i = 0; i < CRC32_BUFFER_SIZE + 16; i++) {
+        buf[i] = rand();
+    }
+
+    errors = crc32_test__(buf);
+    crc32_benchmark__(buf);
+
+    aim_free(buf);
+    return errors ? 1 : 0;
 }
 
@@ -87,7 +87,6 @@ int oom_get_portlist(oom_port_t portlist[], int listsize){
 int oom_get_memory_sff(oom_port_t* port, int address, int page, int offset, int len, uint8_t* data){
     int rv;
     unsigned int port_num; 
-    uint8_t* idprom = NULL;
 
     port_num = (unsigned int)(uintptr_t)port->handle;
     port_num -= 1;
@@ -95,27 +94,17 @@ int oom_get_memory_sff(oom_port_t* port, int address, int page, int offset, int
     if (offset >= 256)
         return -1;  /* out of range */
 
-    /** 
-     * place holder implementation until onlp_sfp_eeprom_read() 
-     * can be improved to handle partial page gets
-     **/
-
-    if (address == 0xa0) {
-        rv = onlp_sfp_eeprom_read(port_num, &idprom);
-    } else if (address == 0xa2) {
-        rv = onlp_sfp_dom_read(port_num, &idprom);
-    } else {
+    if (address != 0xa0 && address != 0xa2) {
         aim_printf(&aim_pvs_stdout, "Error invalid address: 0x%02x\n", address);
         return -EINVAL;
     }
 
+    rv = onlp_sfp_mem_read(port_num, address >> 1, page, offset, len, data);
     if(rv < 0) {
-        aim_printf(&aim_pvs_stdout, "Error reading eeprom: %{onlp_status}\n");
+        aim_printf(&aim_pvs_stdout, "Error reading eeprom: %{onlp_status}\n", rv);
         return -1;
     }
-    memcpy(data, &idprom[offset], len); 
-    aim_free(idprom);
-    
+
     return 0;
 }
 
@@ -130,8 +119,27 @@ int oom_get_memory_cfp(oom_port_t* port, int address, int len, uint16_t* data){
 }
 
 int oom_set_memory_sff(oom_port_t* port, int address, int page, int offset, int len, uint8_t* data){
-    //not implemented
-    return -1;
+    int rv;
+    unsigned int port_num;
+
+    port_num = (unsigned int)(uintptr_t)port->handle;
+    port_num -= 1;
+
+    if (offset >= 256)
+        return -1;  /* out of range */
+
+    if (address != 0xa0 && address != 0xa2) {
+        aim_printf(&aim_pvs_stdout, "Error invalid address: 0x%02x\n", address);
+        return -EINVAL;
+    }
+
+    rv = onlp_sfp_mem_write(port_num, address >> 1, page, offset, len, data);
+    if(rv < 0) {
+        aim_printf(&aim_pvs_stdout, "Error writing eeprom: %{onlp_status}\n", rv);
+        return -1;
+    }
+
+    return 0;
 }
 
 int oom_set_function(oom_port_t* port, oom_functions_t function, int value){
@@ -33,6 +33,7 @@
 #include <linux/slab.h>
 #include <linux/delay.h>
 #include <linux/list.h>
+#include "accton_hwmon_cache.h"
 
 static LIST_HEAD(cpld_client_list);
 static struct mutex	 list_lock;
@@ -44,6 +45,7 @@ struct cpld_client_node {
 
 #define I2C_RW_RETRY_COUNT				10
 #define I2C_RW_RETRY_INTERVAL			60 /* ms */
+#define CPLD_UPDATE_INTERVAL			500 /* ms */
 
 static ssize_t show_present(struct device *dev, struct device_attribute *da,
              char *buf);
@@ -53,12 +55,37 @@ static ssize_t access(struct device *dev, struct device_attribute *da,
 			const char *buf, size_t count);
 static ssize_t show_version(struct device *dev, struct device_attribute *da,
              char *buf);
+static ssize_t show_update_interval(struct device *dev, struct device_attribute *da,
+             char *buf);
+static ssize_t set_update_interval(struct device *dev, struct device_attribute *da,
+			const char *buf, size_t count);
+static ssize_t show_update_age(struct device *dev, struct device_attribute *da,
+             char *buf);
 static int as7712_32x_cpld_read_internal(struct i2c_client *client, u8 reg);
 static int as7712_32x_cpld_write_internal(struct i2c_client *client, u8 reg, u8 value);
 
+/* Registers refreshed by the register cache, the index should match cpld_reg_index
+ */
+static const u8 cpld_reg[] = {
+	0x01,	/* CPLD version */
+	0x30,	/* module 1-8 present */
+	0x31,	/* module 9-16 present */
+	0x32,	/* module 17-24 present */
+	0x33,	/* module 25-32 present */
+};
+
+enum cpld_reg_index {
+	CPLD_VERSION_REG,
+	MODULE_PRESENT_REG_1,
+	MODULE_PRESENT_REG_2,
+	MODULE_PRESENT_REG_3,
+	MODULE_PRESENT_REG_4,
+};
+
 struct as7712_32x_cpld_data {
     struct device      *hwmon_dev;
-    struct mutex        update_lock;
+    struct accton_hwmon_cache cache; /* Register values, see cpld_reg */
+    u8                  present[4];  /* Last notified module present registers */
 };
 
 /* Addresses scanned for as7712_32x_cpld
@@ -116,6 +143,8 @@ enum as7712_32x_cpld_sysfs_attributes {
 
 static SENSOR_DEVICE_ATTR(version, S_IRUGO, show_version, NULL, CPLD_VERSION);
 static SENSOR_DEVICE_ATTR(access, S_IWUSR, NULL, access, ACCESS);
+static DEVICE_ATTR(update_interval, S_IWUSR | S_IRUGO, show_update_interval, set_update_interval);
+static DEVICE_ATTR(update_age, S_IRUGO, show_update_age, NULL);
 /* transceiver attributes */
 static SENSOR_DEVICE_ATTR(module_present_all, S_IRUGO, show_present_all, NULL, MODULE_PRESENT_ALL);
 DECLARE_TRANSCEIVER_SENSOR_DEVICE_ATTR(1);
@@ -154,6 +183,8 @@ DECLARE_TRANSCEIVER_SENSOR_DEVICE_ATTR(32);
 static struct attribute *as7712_32x_cpld_attributes[] = {
     &sensor_dev_attr_version.dev_attr.attr,
     &sensor_dev_attr_access.dev_attr.attr,
+    &dev_attr_update_interval.attr,
+    &dev_attr_update_age.attr,
 	/* transceiver attributes */
 	&sensor_dev_attr_module_present_all.dev_attr.attr,
 	DECLARE_TRANSCEIVER_ATTR(1),
@@ -198,34 +229,20 @@ static const struct attribute_group as7712_32x_cpld_group = {
 static ssize_t show_present_all(struct device *dev, struct device_attribute *da,
              char *buf)
 {
-	int i, status;
-	u8 values[4]  = {0};
-	u8 regs[] = {0x30, 0x31, 0x32, 0x33};
+	int status;
+	u8 values[ARRAY_SIZE(cpld_reg)];
 	struct i2c_client *client = to_i2c_client(dev);
 	struct as7712_32x_cpld_data *data = i2c_get_clientdata(client);
 
-	mutex_lock(&data->update_lock);
-
-    for (i = 0; i < ARRAY_SIZE(regs); i++) {
-        status = as7712_32x_cpld_read_internal(client, regs[i]);
-        
-        if (status < 0) {
-            goto exit;
-        }
-
-        values[i] = ~(u8)status;
-    }
-
-	mutex_unlock(&data->update_lock);
+	status = accton_hwmon_cache_read(&data->cache, values);
+	if (unlikely(status < 0)) {
+		return status;
+	}
 
     /* Return values 1 -> 32 in order */
     return sprintf(buf, "%.2x %.2x %.2x %.2x\n",
-                   values[0], values[1], values[2],
-                   values[3]);
-
-exit:
-	mutex_unlock(&data->update_lock);
-	return status;
+                   (u8)~values[MODULE_PRESENT_REG_1], (u8)~values[MODULE_PRESENT_REG_2],
+                   (u8)~values[MODULE_PRESENT_REG_3], (u8)~values[MODULE_PRESENT_REG_4]);
 }
 
 static ssize_t show_present(struct device *dev, struct device_attribute *da,
@@ -235,73 +252,52 @@ static ssize_t show_present(struct device *dev, struct device_attribute *da,
     struct i2c_client *client = to_i2c_client(dev);
     struct as7712_32x_cpld_data *data = i2c_get_clientdata(client);
 	int status = 0;
+	u8 values[ARRAY_SIZE(cpld_reg)];
 	u8 reg = 0, mask = 0;
 
 	switch (attr->index) {
 	case MODULE_PRESENT_1 ... MODULE_PRESENT_8:
-		reg  = 0x30;
+		reg  = MODULE_PRESENT_REG_1;
 		mask = 0x1 << (attr->index - MODULE_PRESENT_1);
 		break;
 	case MODULE_PRESENT_9 ... MODULE_PRESENT_16:
-		reg  = 0x31;
+		reg  = MODULE_PRESENT_REG_2;
 		mask = 0x1 << (attr->index - MODULE_PRESENT_9);
 		break;
 	case MODULE_PRESENT_17 ... MODULE_PRESENT_24:
-		reg  = 0x32;
+		reg  = MODULE_PRESENT_REG_3;
 		mask = 0x1 << (attr->index - MODULE_PRESENT_17);
 		break;
 	case MODULE_PRESENT_25 ... MODULE_PRESENT_32:
-		reg  = 0x33;
+		reg  = MODULE_PRESENT_REG_4;
 		mask = 0x1 << (attr->index - MODULE_PRESENT_25);
 		break;
 	default:
 		return 0;
 	}
 
-
-    mutex_lock(&data->update_lock);
-	status = as7712_32x_cpld_read_internal(client, reg);
+	status = accton_hwmon_cache_read(&data->cache, values);
 	if (unlikely(status < 0)) {
-		goto exit;
+		return status;
 	}
-	mutex_unlock(&data->update_lock);
-
-	return sprintf(buf, "%d\n", !(status & mask));
 
-exit:
-	mutex_unlock(&data->update_lock);
-	return status;
+	return sprintf(buf, "%d\n", !(values[reg] & mask));
 }
 
 static ssize_t show_version(struct device *dev, struct device_attribute *da,
              char *buf)
 {
-	u8 reg = 0, mask = 0;
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
     struct i2c_client *client = to_i2c_client(dev);
     struct as7712_32x_cpld_data *data = i2c_get_clientdata(client);
 	int status = 0;
+	u8 values[ARRAY_SIZE(cpld_reg)];
 
-	switch (attr->index) {
-	case CPLD_VERSION:
-		reg  = 0x1;
-		mask = 0xFF;
-		break;
-	default:
-		break;
-	}
-
-    mutex_lock(&data->update_lock);
-	status = as7712_32x_cpld_read_internal(client, reg);
+	status = accton_hwmon_cache_read(&data->cache, values);
 	if (unlikely(status < 0)) {
-		goto exit;
+		return status;
 	}
-	mutex_unlock(&data->update_lock);
-	return sprintf(buf, "%d\n", (status & mask));
 
-exit:
-	mutex_unlock(&data->update_lock);
-	return status;
+	return sprintf(buf, "%d\n", values[CPLD_VERSION_REG]);
 }
 
 static ssize_t access(struct device *dev, struct device_attribute *da,
@@ -320,17 +316,36 @@ static ssize_t access(struct device *dev, struct device_attribute *da,
 		return -EINVAL;
 	}
 
-	mutex_lock(&data->update_lock);
+	mutex_lock(&data->cache.lock);
 	status = as7712_32x_cpld_write_internal(client, addr, val);
+	mutex_unlock(&data->cache.lock);
 	if (unlikely(status < 0)) {
-		goto exit;
+		return status;
 	}
-	mutex_unlock(&data->update_lock);
+
+	accton_hwmon_cache_invalidate(&data->cache);
 	return count;
+}
 
-exit:
-	mutex_unlock(&data->update_lock);
-	return status;
+static ssize_t show_update_interval(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    struct as7712_32x_cpld_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_show_interval(&data->cache, buf);
+}
+
+static ssize_t set_update_interval(struct device *dev, struct device_attribute *da,
+			const char *buf, size_t count)
+{
+    struct as7712_32x_cpld_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_store_interval(&data->cache, buf, count);
+}
+
+static ssize_t show_update_age(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    struct as7712_32x_cpld_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_show_age(&data->cache, buf);
 }
 
 static int as7712_32x_cpld_read_internal(struct i2c_client *client, u8 reg)
@@ -369,6 +384,43 @@ static int as7712_32x_cpld_write_internal(struct i2c_client *client, u8 reg, u8
     return status;
 }
 
+/* Read the cached registers, called from the refresh work
+ */
+static int as7712_32x_cpld_refresh(void *priv, void *block)
+{
+	struct i2c_client *client = priv;
+	u8 *values = block;
+	int i, status;
+
+	for (i = 0; i < ARRAY_SIZE(cpld_reg); i++) {
+		status = as7712_32x_cpld_read_internal(client, cpld_reg[i]);
+		if (unlikely(status < 0)) {
+			return status;
+		}
+
+		values[i] = status;
+	}
+
+	return 0;
+}
+
+/* Wake up pollers of module_present_all when a module is inserted or removed,
+ * called from the refresh work after the new values are published
+ */
+static void as7712_32x_cpld_changed(void *priv, const void *block)
+{
+	struct i2c_client *client = priv;
+	struct as7712_32x_cpld_data *data = i2c_get_clientdata(client);
+	const u8 *values = block;
+
+	if (memcmp(data->present, &values[MODULE_PRESENT_REG_1], sizeof(data->present)) == 0) {
+		return;
+	}
+
+	memcpy(data->present, &values[MODULE_PRESENT_REG_1], sizeof(data->present));
+	sysfs_notify(&client->dev.kobj, NULL, "module_present_all");
+}
+
 static void as7712_32x_cpld_add_client(struct i2c_client *client)
 {
 	struct cpld_client_node *node = kzalloc(sizeof(struct cpld_client_node), GFP_KERNEL);
@@ -430,13 +482,19 @@ static int as7712_32x_cpld_probe(struct i2c_client *client,
     }
 
     i2c_set_clientdata(client, data);
-    mutex_init(&data->update_lock);
     dev_info(&client->dev, "chip found\n");
 
+	data->cache.changed = as7712_32x_cpld_changed;
+	status = accton_hwmon_cache_init(&data->cache, &client->dev, ARRAY_SIZE(cpld_reg),
+	                                 CPLD_UPDATE_INTERVAL, as7712_32x_cpld_refresh, client);
+	if (status) {
+		goto exit_free;
+	}
+
 	/* Register sysfs hooks */
 	status = sysfs_create_group(&client->dev.kobj, &as7712_32x_cpld_group);
 	if (status) {
-		goto exit_free;
+		goto exit_cache;
 	}
 
     data->hwmon_dev = hwmon_device_register_with_info(&client->dev, "as7712_32x_cpld",
@@ -455,6 +513,8 @@ static int as7712_32x_cpld_probe(struct i2c_client *client,
 
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &as7712_32x_cpld_group);
+exit_cache:
+    accton_hwmon_cache_destroy(&data->cache);
 exit_free:
     kfree(data);
 exit:
@@ -468,6 +528,7 @@ static int as7712_32x_cpld_remove(struct i2c_client *client)
 
     hwmon_device_unregister(data->hwmon_dev);
     sysfs_remove_group(&client->dev.kobj, &as7712_32x_cpld_group);
+    accton_hwmon_cache_destroy(&data->cache);
     kfree(data);
 	as7712_32x_cpld_remove_client(client);
 
@@ -29,13 +29,19 @@
 #include <linux/sysfs.h>
 #include <linux/slab.h>
 #include <linux/dmi.h>
+#include "accton_hwmon_cache.h"
 
 #define DRVNAME "as7712_32x_fan"
 
-static struct as7712_32x_fan_data *as7712_32x_fan_update_device(struct device *dev);                    
+#define FAN_UPDATE_INTERVAL  1500 /* ms */
+
 static ssize_t fan_show_value(struct device *dev, struct device_attribute *da, char *buf);
 static ssize_t set_duty_cycle(struct device *dev, struct device_attribute *da,
             const char *buf, size_t count);
+static ssize_t show_update_interval(struct device *dev, struct device_attribute *da, char *buf);
+static ssize_t set_update_interval(struct device *dev, struct device_attribute *da,
+            const char *buf, size_t count);
+static ssize_t show_update_age(struct device *dev, struct device_attribute *da, char *buf);
 extern int accton_i2c_cpld_read(unsigned short cpld_addr, u8 reg);
 extern int accton_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value);
 
@@ -62,10 +68,7 @@ static const u8 fan_reg[] = {
 /* Each client has this additional data */
 struct as7712_32x_fan_data {
     struct device   *hwmon_dev;
-    struct mutex     update_lock;
-    char             valid;           /* != 0 if registers are valid */
-    unsigned long    last_updated;    /* In jiffies */
-    u8               reg_val[ARRAY_SIZE(fan_reg)]; /* Register value */
+    struct accton_hwmon_cache cache; /* Register values, see fan_reg */
 };
 
 enum fan_id {
@@ -167,6 +170,9 @@ DECLARE_FAN_DIRECTION_SENSOR_DEV_ATTR(5);
 DECLARE_FAN_DIRECTION_SENSOR_DEV_ATTR(6);
 /* 1 fan duty cycle attribute in this platform */
 DECLARE_FAN_DUTY_CYCLE_SENSOR_DEV_ATTR();
+/* Register cache attributes */
+static DEVICE_ATTR(update_interval, S_IWUSR | S_IRUGO, show_update_interval, set_update_interval);
+static DEVICE_ATTR(update_age, S_IRUGO, show_update_age, NULL);
 
 static struct attribute *as7712_32x_fan_attributes[] = {
     /* fan related attributes */
@@ -195,6 +201,8 @@ static struct attribute *as7712_32x_fan_attributes[] = {
     DECLARE_FAN_DIRECTION_ATTR(5),
     DECLARE_FAN_DIRECTION_ATTR(6),
     DECLARE_FAN_DUTY_CYCLE_ATTR(),
+    &dev_attr_update_interval.attr,
+    &dev_attr_update_age.attr,
     NULL
 };
 
@@ -247,7 +255,7 @@ static u8 reg_val_to_is_present(u8 reg_val, enum fan_id id)
     return reg_val ? 0 : 1;
 }
 
-static u8 is_fan_fault(struct as7712_32x_fan_data *data, enum fan_id id)
+static u8 is_fan_fault(u8 *reg_val, enum fan_id id)
 {
     u8 ret = 1;
     int front_fan_index = FAN1_FRONT_SPEED_RPM + id;
@@ -255,8 +263,8 @@ static u8 is_fan_fault(struct as7712_32x_fan_data *data, enum fan_id id)
 
     /* Check if the speed of front or rear fan is ZERO,  
      */
-    if (reg_val_to_speed_rpm(data->reg_val[front_fan_index]) &&
-        reg_val_to_speed_rpm(data->reg_val[rear_fan_index]))  {
+    if (reg_val_to_speed_rpm(reg_val[front_fan_index]) &&
+        reg_val_to_speed_rpm(reg_val[rear_fan_index]))  {
         ret = 0;
     }
 
@@ -279,7 +287,7 @@ static ssize_t set_duty_cycle(struct device *dev, struct device_attribute *da,
 		return -EINVAL;
 	}
 	
-    mutex_lock(&data->update_lock);
+    mutex_lock(&data->cache.lock);
 
 	/* Disable the watchdog timer
 	 */
@@ -287,33 +295,53 @@ static ssize_t set_duty_cycle(struct device *dev, struct device_attribute *da,
 	
 	if (error != 0) {
 		dev_dbg(&client->dev, "Unable to disable the watchdog timer\n");
-		mutex_unlock(&data->update_lock);
+		mutex_unlock(&data->cache.lock);
 		return error;
 	}	
 
 	as7712_32x_fan_write_value(client, fan_reg[FAN_DUTY_CYCLE_PERCENTAGE], duty_cycle_to_reg_val(value));
-	data->valid = 0;
 
-    mutex_unlock(&data->update_lock);
+    mutex_unlock(&data->cache.lock);
+    accton_hwmon_cache_invalidate(&data->cache);
     return count;
 }
 
+static ssize_t show_update_interval(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    struct as7712_32x_fan_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_show_interval(&data->cache, buf);
+}
+
+static ssize_t set_update_interval(struct device *dev, struct device_attribute *da,
+            const char *buf, size_t count)
+{
+    struct as7712_32x_fan_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_store_interval(&data->cache, buf, count);
+}
+
+static ssize_t show_update_age(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    struct as7712_32x_fan_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_show_age(&data->cache, buf);
+}
+
 static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
              char *buf)
 {
     struct i2c_client *client = to_i2c_client(dev);
     struct as7712_32x_fan_data *data = i2c_get_clientdata(client);
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    u8 reg_val[ARRAY_SIZE(fan_reg)];
     ssize_t ret = 0;
-    
-    mutex_lock(&data->update_lock);
 
-    data = as7712_32x_fan_update_device(dev);
-    if (data->valid) {
+    ret = accton_hwmon_cache_read(&data->cache, reg_val);
+    if (ret == 0) {
         switch (attr->index) {
             case FAN_DUTY_CYCLE_PERCENTAGE:
             {
-                u32 duty_cycle = reg_val_to_duty_cycle(data->reg_val[FAN_DUTY_CYCLE_PERCENTAGE]);
+                u32 duty_cycle = reg_val_to_duty_cycle(reg_val[FAN_DUTY_CYCLE_PERCENTAGE]);
                 ret = sprintf(buf, "%u\n", duty_cycle);
                 break;
             }
@@ -329,7 +357,7 @@ static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
             case FAN4_REAR_SPEED_RPM:
             case FAN5_REAR_SPEED_RPM:
             case FAN6_REAR_SPEED_RPM:
-                ret = sprintf(buf, "%u\n", reg_val_to_speed_rpm(data->reg_val[attr->index]));
+                ret = sprintf(buf, "%u\n", reg_val_to_speed_rpm(reg_val[attr->index]));
                 break;
             case FAN1_PRESENT:
             case FAN2_PRESENT:
@@ -338,7 +366,7 @@ static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
             case FAN5_PRESENT:
             case FAN6_PRESENT:
                 ret = sprintf(buf, "%d\n",
-                              reg_val_to_is_present(data->reg_val[FAN_PRESENT_REG],
+                              reg_val_to_is_present(reg_val[FAN_PRESENT_REG],
                               attr->index - FAN1_PRESENT));
                 break;
             case FAN1_FAULT:
@@ -347,7 +375,7 @@ static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
             case FAN4_FAULT:
             case FAN5_FAULT:
             case FAN6_FAULT:
-                ret = sprintf(buf, "%d\n", is_fan_fault(data, attr->index - FAN1_FAULT));
+                ret = sprintf(buf, "%d\n", is_fan_fault(reg_val, attr->index - FAN1_FAULT));
                 break;
             case FAN1_DIRECTION:
             case FAN2_DIRECTION:
@@ -356,7 +384,7 @@ static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
             case FAN5_DIRECTION:
             case FAN6_DIRECTION:
                 ret = sprintf(buf, "%d\n",
-                              reg_val_to_direction(data->reg_val[FAN_DIRECTION_REG],
+                              reg_val_to_direction(reg_val[FAN_DIRECTION_REG],
                               attr->index - FAN1_DIRECTION));
                 break;
             default:
@@ -364,8 +392,6 @@ static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
         }        
     }
 
-    mutex_unlock(&data->update_lock);
-    
     return ret;
 }
 
@@ -373,39 +399,28 @@ static const struct attribute_group as7712_32x_fan_group = {
     .attrs = as7712_32x_fan_attributes,
 };
 
-static struct as7712_32x_fan_data *as7712_32x_fan_update_device(struct device *dev)
+/* Read all fan registers into the cache, called from the refresh work
+ */
+static int as7712_32x_fan_refresh(void *priv, void *block)
 {
-    struct i2c_client *client = to_i2c_client(dev);
-    struct as7712_32x_fan_data *data = i2c_get_clientdata(client);
+    struct i2c_client *client = priv;
+    u8 *reg_val = block;
+    int i;
 
-    if (time_after(jiffies, data->last_updated + HZ + HZ / 2) || 
-        !data->valid) {
-        int i;
-
-        dev_dbg(&client->dev, "Starting as7712_32x_fan update\n");
-        data->valid = 0;
-        
-        /* Update fan data
-         */
-        for (i = 0; i < ARRAY_SIZE(data->reg_val); i++) {
-            int status = as7712_32x_fan_read_value(client, fan_reg[i]);
-            
-            if (status < 0) {
-                data->valid = 0;
-                mutex_unlock(&data->update_lock);
-                dev_dbg(&client->dev, "reg %d, err %d\n", fan_reg[i], status);
-                return data;
-            }
-            else {
-                data->reg_val[i] = status;
-            }
+    dev_dbg(&client->dev, "Starting as7712_32x_fan update\n");
+
+    for (i = 0; i < ARRAY_SIZE(fan_reg); i++) {
+        int status = as7712_32x_fan_read_value(client, fan_reg[i]);
+
+        if (status < 0) {
+            dev_dbg(&client->dev, "reg %d, err %d\n", fan_reg[i], status);
+            return status;
         }
-        
-        data->last_updated = jiffies;
-        data->valid = 1;
+
+        reg_val[i] = status;
     }
 
-    return data;
+    return 0;
 }
 
 static int as7712_32x_fan_probe(struct i2c_client *client,
@@ -426,15 +441,19 @@ static int as7712_32x_fan_probe(struct i2c_client *client,
     }
 
     i2c_set_clientdata(client, data);
-    data->valid = 0;
-    mutex_init(&data->update_lock);
 
     dev_info(&client->dev, "chip found\n");
 
+    status = accton_hwmon_cache_init(&data->cache, &client->dev, ARRAY_SIZE(fan_reg),
+                                     FAN_UPDATE_INTERVAL, as7712_32x_fan_refresh, client);
+    if (status) {
+        goto exit_free;
+    }
+
     /* Register sysfs hooks */
     status = sysfs_create_group(&client->dev.kobj, &as7712_32x_fan_group);
     if (status) {
-        goto exit_free;
+        goto exit_cache;
     }
 
     data->hwmon_dev = hwmon_device_register_with_info(&client->dev, "as7712_32x_fan",
@@ -451,6 +470,8 @@ static int as7712_32x_fan_probe(struct i2c_client *client,
 
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &as7712_32x_fan_group);
+exit_cache:
+    accton_hwmon_cache_destroy(&data->cache);
 exit_free:
     kfree(data);
 exit:
@@ -463,6 +484,8 @@ static int as7712_32x_fan_remove(struct i2c_client *client)
     struct as7712_32x_fan_data *data = i2c_get_clientdata(client);
     hwmon_device_unregister(data->hwmon_dev);
     sysfs_remove_group(&client->dev.kobj, &as7712_32x_fan_group);
+    accton_hwmon_cache_destroy(&data->cache);
+    kfree(data);
     
     return 0;
 }
@@ -33,6 +33,7 @@
 #include <linux/slab.h>
 #include <linux/delay.h>
 #include <linux/dmi.h>
+#include "accton_hwmon_cache.h"
 
 #define MAX_MODEL_NAME          16
 #define MAX_SERIAL_NUMBER       19
@@ -40,6 +41,8 @@
 #define DC12V_FAN_DIR_OFFSET    0x34
 #define DC12V_FAN_DIR_LEN       3
 
+#define PSU_UPDATE_INTERVAL     1500 /* ms */
+
 static ssize_t show_status(struct device *dev, struct device_attribute *da, char *buf);
 static int as7712_32x_psu_read_block(struct i2c_client *client, u8 command, u8 *data,int data_len);
 extern int as7712_32x_cpld_read (unsigned short cpld_addr, u8 reg);
@@ -55,14 +58,9 @@ enum psu_type {
     PSU_TYPE_AC_ACBEL_FSF019,
 };
 
-/* Each client has this additional data 
+/* Values refreshed by the register cache
  */
-struct as7712_32x_psu_data {
-    struct device      *hwmon_dev;
-    struct mutex        update_lock;
-    char                valid;           /* !=0 if registers are valid */
-    unsigned long       last_updated;    /* In jiffies */
-    u8  index;           /* PSU index */
+struct as7712_32x_psu_regs {
     u8  status;          /* Status(present/power_good) register read from CPLD */
     char model_name[MAX_MODEL_NAME]; /* Model name, read from eeprom */
     char fan_dir[DC12V_FAN_DIR_LEN+1]; /* DC12V fan direction */
@@ -70,8 +68,20 @@ struct as7712_32x_psu_data {
     enum psu_type       type;
 };
 
+/* Each client has this additional data 
+ */
+struct as7712_32x_psu_data {
+    struct device      *hwmon_dev;
+    u8  index;           /* PSU index */
+    struct accton_hwmon_cache cache;
+};
+
 static ssize_t show_string(struct device *dev, struct device_attribute *da, char *buf);
-static struct as7712_32x_psu_data *as7712_32x_psu_update_device(struct device *dev);             
+static ssize_t show_update_interval(struct device *dev, struct device_attribute *da, char *buf);
+static ssize_t set_update_interval(struct device *dev, struct device_attribute *da,
+            const char *buf, size_t count);
+static ssize_t show_update_age(struct device *dev, struct device_attribute *da, char *buf);
+static int as7712_32x_psu_refresh(void *priv, void *block);
 
 enum as7712_32x_psu_sysfs_attributes {
     PSU_PRESENT,
@@ -88,6 +98,8 @@ static SENSOR_DEVICE_ATTR(psu_model_name, S_IRUGO, show_string, NULL, PSU_MODEL_
 static SENSOR_DEVICE_ATTR(psu_serial_number, S_IRUGO, show_string, NULL, PSU_SERIAL_NUMBER);
 static SENSOR_DEVICE_ATTR(psu_power_good, S_IRUGO, show_status, NULL, PSU_POWER_GOOD);
 static SENSOR_DEVICE_ATTR(psu_fan_dir,       S_IRUGO, show_string, NULL, PSU_FAN_DIR);
+static DEVICE_ATTR(update_interval, S_IWUSR | S_IRUGO, show_update_interval, set_update_interval);
+static DEVICE_ATTR(update_age, S_IRUGO, show_update_age, NULL);
 
 static struct attribute *as7712_32x_psu_attributes[] = {
     &sensor_dev_attr_psu_present.dev_attr.attr,
@@ -95,6 +107,8 @@ static struct attribute *as7712_32x_psu_attributes[] = {
     &sensor_dev_attr_psu_serial_number.dev_attr.attr,
     &sensor_dev_attr_psu_power_good.dev_attr.attr,
     &sensor_dev_attr_psu_fan_dir.dev_attr.attr,
+    &dev_attr_update_interval.attr,
+    &dev_attr_update_age.attr,
     NULL
 };
 
@@ -104,24 +118,20 @@ static ssize_t show_status(struct device *dev, struct device_attribute *da,
 	struct i2c_client *client = to_i2c_client(dev);
 	struct as7712_32x_psu_data *data = i2c_get_clientdata(client);
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct as7712_32x_psu_regs regs;
     u8 status = 0;
 
-    mutex_lock(&data->update_lock);
-
-    data = as7712_32x_psu_update_device(dev);
-    if (!data->valid) {
-        mutex_unlock(&data->update_lock);
+    if (accton_hwmon_cache_read(&data->cache, &regs) < 0) {
         return sprintf(buf, "0\n");
     }
 
     if (attr->index == PSU_PRESENT) {
-        status = !(data->status >> (1-data->index) & 0x1);
+        status = !(regs.status >> (1-data->index) & 0x1);
     }
     else { /* PSU_POWER_GOOD */
-        status = (data->status >> (3-data->index) & 0x1);
+        status = (regs.status >> (3-data->index) & 0x1);
     }
 
-    mutex_unlock(&data->update_lock);
     return sprintf(buf, "%d\n", status);
 }
 
@@ -131,35 +141,51 @@ static ssize_t show_string(struct device *dev, struct device_attribute *da,
 	struct i2c_client *client = to_i2c_client(dev);
 	struct as7712_32x_psu_data *data = i2c_get_clientdata(client);
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+    struct as7712_32x_psu_regs regs;
     char *ptr = NULL;
 
-    mutex_lock(&data->update_lock);
-
-    data = as7712_32x_psu_update_device(dev);
-    if (!data->valid) {
-        mutex_unlock(&data->update_lock);
+    if (accton_hwmon_cache_read(&data->cache, &regs) < 0) {
         return -EIO;
     }
 
 	switch (attr->index) {
 	case PSU_MODEL_NAME:
-		ptr = data->model_name;
+		ptr = regs.model_name;
 		break;
 	case PSU_SERIAL_NUMBER:
-		ptr = data->serial_number;
+		ptr = regs.serial_number;
 		break;
 	case PSU_FAN_DIR:
-		ptr = data->fan_dir;
+		ptr = regs.fan_dir;
 		break;
 	default:
-	    mutex_unlock(&data->update_lock);
 		return -EINVAL;
 	}
 
-    mutex_unlock(&data->update_lock);
     return sprintf(buf, "%s\n", ptr);
 }
 
+static ssize_t show_update_interval(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    struct as7712_32x_psu_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_show_interval(&data->cache, buf);
+}
+
+static ssize_t set_update_interval(struct device *dev, struct device_attribute *da,
+            const char *buf, size_t count)
+{
+    struct as7712_32x_psu_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_store_interval(&data->cache, buf, count);
+}
+
+static ssize_t show_update_age(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    struct as7712_32x_psu_data *data = i2c_get_clientdata(to_i2c_client(dev));
+    return accton_hwmon_cache_show_age(&data->cache, buf);
+}
+
 static const struct attribute_group as7712_32x_psu_group = {
     .attrs = as7712_32x_psu_attributes,
 };
@@ -182,16 +208,21 @@ static int as7712_32x_psu_probe(struct i2c_client *client,
     }
 
     i2c_set_clientdata(client, data);
-    data->valid = 0;
     data->index = dev_id->driver_data;
-    mutex_init(&data->update_lock);
 
     dev_info(&client->dev, "chip found\n");
 
+    status = accton_hwmon_cache_init(&data->cache, &client->dev,
+                                     sizeof(struct as7712_32x_psu_regs),
+                                     PSU_UPDATE_INTERVAL, as7712_32x_psu_refresh, client);
+    if (status) {
+        goto exit_free;
+    }
+
     /* Register sysfs hooks */
     status = sysfs_create_group(&client->dev.kobj, &as7712_32x_psu_group);
     if (status) {
-        goto exit_free;
+        goto exit_cache;
     }
 
     data->hwmon_dev = hwmon_device_register_with_info(&client->dev, "as7712_32x_psu",
@@ -208,6 +239,8 @@ static int as7712_32x_psu_probe(struct i2c_client *client,
 
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &as7712_32x_psu_group);
+exit_cache:
+    accton_hwmon_cache_destroy(&data->cache);
 exit_free:
     kfree(data);
 exit:
@@ -221,6 +254,7 @@ static int as7712_32x_psu_remove(struct i2c_client *client)
 
     hwmon_device_unregister(data->hwmon_dev);
     sysfs_remove_group(&client->dev.kobj, &as7712_32x_psu_group);
+    accton_hwmon_cache_destroy(&data->cache);
     kfree(data);
     
     return 0;
@@ -286,11 +320,10 @@ struct model_name_info {
     char* model_name;
 };
 
-static int acbel_psu_serial_number_get(struct device *dev)
+static int acbel_psu_serial_number_get(struct i2c_client *client,
+                                       struct as7712_32x_psu_regs *data)
 {
-    struct i2c_client *client = to_i2c_client(dev);
-    struct as7712_32x_psu_data *data = i2c_get_clientdata(client);
-    int i, status;
+    int status;
 
     memset(data->serial_number, 0, sizeof(data->serial_number));
 
@@ -320,10 +353,9 @@ struct model_name_info models[] = {
 {PSU_TYPE_AC_ACBEL_FSF019, 0x15, 7, "FSF019-"},
 };
 
-static int as7712_32x_psu_model_name_get(struct device *dev)
+static int as7712_32x_psu_model_name_get(struct i2c_client *client,
+                                         struct as7712_32x_psu_regs *data)
 {
-    struct i2c_client *client = to_i2c_client(dev);
-    struct as7712_32x_psu_data *data = i2c_get_clientdata(client);
     int i, status;
 
     for (i = 0; i < ARRAY_SIZE(models); i++) {
@@ -368,67 +400,62 @@ static int as7712_32x_psu_model_name_get(struct device *dev)
     return -ENODATA;
 }
 
-static struct as7712_32x_psu_data *as7712_32x_psu_update_device(struct device *dev)
+/* Read the PSU status and eeprom into the cache, called from the refresh work
+ */
+static int as7712_32x_psu_refresh(void *priv, void *block)
 {
-    struct i2c_client *client = to_i2c_client(dev);
+    struct i2c_client *client = priv;
     struct as7712_32x_psu_data *data = i2c_get_clientdata(client);
+    struct as7712_32x_psu_regs *regs = block;
+    int status;
+    int power_good = 0;
 
-    if (time_after(jiffies, data->last_updated + HZ + HZ / 2)
-        || !data->valid) {
-        int status;
-        int power_good = 0;
+    dev_dbg(&client->dev, "Starting as7712_32x update\n");
 
-        data->valid = 0;
-        dev_dbg(&client->dev, "Starting as7712_32x update\n");
+    /* Read psu status */
+    status = as7712_32x_cpld_read(0x60, 0x2);
+    
+    if (status < 0) {
+        dev_dbg(&client->dev, "cpld reg 0x60 err %d\n", status);
+        return status;
+    }
+    else {
+        regs->status = status;
+    }
+    
+    /* Read model name */
+    power_good = (regs->status >> (3-data->index) & 0x1);
 
-        /* Read psu status */
-        status = as7712_32x_cpld_read(0x60, 0x2);
-        
+    if (power_good) {
+        status = as7712_32x_psu_model_name_get(client, regs);
         if (status < 0) {
-            dev_dbg(&client->dev, "cpld reg 0x60 err %d\n", status);
-            goto exit;
-        }
-        else {
-            data->status = status;
+            return status;
         }
-        
-        /* Read model name */
-        memset(data->model_name, 0, sizeof(data->model_name));
-        memset(data->fan_dir, 0, sizeof(data->fan_dir));
-        power_good = (data->status >> (3-data->index) & 0x1);
 
-        if (power_good) {
-            if (as7712_32x_psu_model_name_get(dev) < 0) {
-                goto exit;
-            }
+        if (strncmp(regs->model_name, 
+                    models[PSU_TYPE_DC_12V].model_name,
+                    models[PSU_TYPE_DC_12V].length) == 0) {
+            /* Read fan direction */
+            status = as7712_32x_psu_read_block(client, DC12V_FAN_DIR_OFFSET, 
+                                               regs->fan_dir, DC12V_FAN_DIR_LEN);
 
-            if (strncmp(data->model_name, 
-                        models[PSU_TYPE_DC_12V].model_name,
-                        models[PSU_TYPE_DC_12V].length) == 0) {
-                /* Read fan direction */
-                status = as7712_32x_psu_read_block(client, DC12V_FAN_DIR_OFFSET, 
-                                                   data->fan_dir, DC12V_FAN_DIR_LEN);
-
-                if (status < 0) {
-                    data->fan_dir[0] = '\0';
-                    dev_dbg(&client->dev, "unable to read fan direction from (0x%x) offset(0x%x)\n", 
-                                          client->addr, DC12V_FAN_DIR_OFFSET);
-                    goto exit;
-                }
+            if (status < 0) {
+                regs->fan_dir[0] = '\0';
+                dev_dbg(&client->dev, "unable to read fan direction from (0x%x) offset(0x%x)\n", 
+                                      client->addr, DC12V_FAN_DIR_OFFSET);
+                return status;
             }
+        }
 
-            if (data->type == PSU_TYPE_AC_ACBEL_FSF019 && 
-                acbel_psu_serial_number_get(dev) < 0) {
-                goto exit;
+        if (regs->type == PSU_TYPE_AC_ACBEL_FSF019) {
+            status = acbel_psu_serial_number_get(client, regs);
+            if (status < 0) {
+                return status;
             }
         }
-        
-        data->last_updated = jiffies;
-        data->valid = 1;
     }
 
-exit:
-    return data;
+    return 0;
 }
 
 module_i2c_driver(as7712_32x_psu_driver);
@@ -24,6 +24,7 @@
  *
  ***********************************************************/
 #include <onlp/platformi/sfpi.h>
+#include <fcntl.h>
 
 #include <onlplib/i2c.h>
 #include <onlplib/file.h>
@@ -132,6 +133,17 @@ onlp_sfpi_presence_bitmap_get(onlp_sfp_bitmap_t* dst)
     return ONLP_STATUS_OK;
 }
 
+int
+onlp_sfpi_presence_notify_fd_get(int* fd)
+{
+    /* The CPLD driver notifies module_present_all on presence changes. */
+    *fd = open(MODULE_PRESENT_ALL_ATTR, O_RDONLY | O_CLOEXEC);
+    if(*fd < 0) {
+        return ONLP_STATUS_E_UNSUPPORTED;
+    }
+    return ONLP_STATUS_OK;
+}
+
 int
 onlp_sfpi_eeprom_read(int port, uint8_t data[256])
 {
@@ -11,6 +11,7 @@ class OnlPlatform_x86_64_accton_as7712_32x_r0(OnlPlatformAccton,
         self.insmod('optoe')
         self.insmod('ym2651y')
         self.insmod('accton_i2c_cpld')
+        self.insmod('accton_hwmon_cache')
         for m in [ 'fan', 'cpld1', 'psu', 'leds' ]:
             self.insmod("x86-64-accton-as7712-32x-%s.ko" % m)
 
@@ -0,0 +1,188 @@
+/*
+ * Background register cache for the Accton hwmon drivers
+ *
+ * Copyright (C) 2014 Accton Technology Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <linux/module.h>
+#include <linux/jiffies.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/kernel.h>
+#include "accton_hwmon_cache.h"
+
+static void accton_hwmon_cache_update(struct accton_hwmon_cache *cache)
+{
+    int status;
+    bool changed = false;
+
+    mutex_lock(&cache->lock);
+
+    memset(cache->scratch, 0, cache->size);
+    status = cache->refresh(cache->priv, cache->scratch);
+    if (status < 0) {
+        dev_dbg(cache->dev, "cache refresh failed (%d)\n", status);
+    }
+
+    write_seqlock(&cache->seqlock);
+    if (status >= 0) {
+        changed = memcmp(cache->block, cache->scratch, cache->size) != 0;
+        memcpy(cache->block, cache->scratch, cache->size);
+        cache->last_updated = jiffies;
+    }
+    cache->status = (status < 0) ? status : 0;
+    write_sequnlock(&cache->seqlock);
+
+    if (changed && cache->changed) {
+        cache->changed(cache->priv, cache->block);
+    }
+
+    mutex_unlock(&cache->lock);
+}
+
+static void accton_hwmon_cache_work(struct work_struct *work)
+{
+    struct accton_hwmon_cache *cache =
+        container_of(to_delayed_work(work), struct accton_hwmon_cache, work);
+
+    accton_hwmon_cache_update(cache);
+    schedule_delayed_work(&cache->work,
+                          msecs_to_jiffies(READ_ONCE(cache->interval)));
+}
+
+int accton_hwmon_cache_init(struct accton_hwmon_cache *cache,
+                            struct device *dev, size_t size,
+                            unsigned int interval,
+                            accton_hwmon_cache_refresh_t refresh,
+                            void *priv)
+{
+    cache->dev      = dev;
+    cache->size     = size;
+    cache->refresh  = refresh;
+    cache->priv     = priv;
+    cache->interval = clamp_t(unsigned int, interval,
+                              ACCTON_HWMON_CACHE_INTERVAL_MIN,
+                              ACCTON_HWMON_CACHE_INTERVAL_MAX);
+    cache->status   = -EAGAIN;
+    cache->last_updated = jiffies;
+
+    cache->block   = kzalloc(size, GFP_KERNEL);
+    cache->scratch = kzalloc(size, GFP_KERNEL);
+    if (!cache->block || !cache->scratch) {
+        kfree(cache->block);
+        kfree(cache->scratch);
+        return -ENOMEM;
+    }
+
+    mutex_init(&cache->lock);
+    seqlock_init(&cache->seqlock);
+    INIT_DELAYED_WORK(&cache->work, accton_hwmon_cache_work);
+
+    accton_hwmon_cache_update(cache);
+    schedule_delayed_work(&cache->work, msecs_to_jiffies(cache->interval));
+
+    return 0;
+}
+EXPORT_SYMBOL(accton_hwmon_cache_init);
+
+void accton_hwmon_cache_destroy(struct accton_hwmon_cache *cache)
+{
+    cancel_delayed_work_sync(&cache->work);
+    kfree(cache->block);
+    kfree(cache->scratch);
+    cache->block = cache->scratch = NULL;
+}
+EXPORT_SYMBOL(accton_hwmon_cache_destroy);
+
+int accton_hwmon_cache_read(struct accton_hwmon_cache *cache, void *block)
+{
+    unsigned int seq;
+    int status;
+
+    do {
+        seq = read_seqbegin(&cache->seqlock);
+        memcpy(block, cache->block, cache->size);
+        status = cache->status;
+    } while (read_seqretry(&cache->seqlock, seq));
+
+    return status;
+}
+EXPORT_SYMBOL(accton_hwmon_cache_read);
+
+void accton_hwmon_cache_invalidate(struct accton_hwmon_cache *cache)
+{
+    mod_delayed_work(system_wq, &cache->work, 0);
+}
+EXPORT_SYMBOL(accton_hwmon_cache_invalidate);
+
+ssize_t accton_hwmon_cache_show_interval(struct accton_hwmon_cache *cache, char *buf)
+{
+    return sprintf(buf, "%u\n", READ_ONCE(cache->interval));
+}
+EXPORT_SYMBOL(accton_hwmon_cache_show_interval);
+
+ssize_t accton_hwmon_cache_store_interval(struct accton_hwmon_cache *cache,
+                                          const char *buf, size_t count)
+{
+    unsigned int interval;
+    int error;
+
+    error = kstrtouint(buf, 10, &interval);
+    if (error) {
+        return error;
+    }
+
+    if (interval < ACCTON_HWMON_CACHE_INTERVAL_MIN ||
+        interval > ACCTON_HWMON_CACHE_INTERVAL_MAX) {
+        return -EINVAL;
+    }
+
+    WRITE_ONCE(cache->interval, interval);
+    mod_delayed_work(system_wq, &cache->work, msecs_to_jiffies(interval));
+
+    return count;
+}
+EXPORT_SYMBOL(accton_hwmon_cache_store_interval);
+
+ssize_t accton_hwmon_cache_show_age(struct accton_hwmon_cache *cache, char *buf)
+{
+    unsigned int seq;
+    unsigned long last_updated;
+
+    do {
+        seq = read_seqbegin(&cache->seqlock);
+        last_updated = cache->last_updated;
+    } while (read_seqretry(&cache->seqlock, seq));
+
+    return sprintf(buf, "%u\n", jiffies_to_msecs(jiffies - last_updated));
+}
+EXPORT_SYMBOL(accton_hwmon_cache_show_age);
+
+static int __init accton_hwmon_cache_module_init(void)
+{
+    return 0;
+}
+
+static void __exit accton_hwmon_cache_module_exit(void)
+{
+}
+
+module_init(accton_hwmon_cache_module_init);
+module_exit(accton_hwmon_cache_module_exit);
+
+MODULE_DESCRIPTION("Accton hwmon background register cache");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,98 @@
+/*
+ * Background register cache for the Accton hwmon drivers
+ *
+ * Copyright (C) 2014 Accton Technology Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __ACCTON_HWMON_CACHE_H__
+#define __ACCTON_HWMON_CACHE_H__
+
+#include <linux/device.h>
+#include <linux/mutex.h>
+#include <linux/seqlock.h>
+#include <linux/workqueue.h>
+
+/*
+ * A driver describes its registers as a block of 'size' bytes and
+ * supplies a refresh function which reads the hardware into it.
+ * The block is refreshed from a delayed work item every 'interval'
+ * milliseconds and published under a seqlock, so sysfs show
+ * functions take a consistent snapshot without touching I2C.
+ *
+ * The refresh function is called with 'lock' held. Drivers take the
+ * same lock around register writes and then call
+ * accton_hwmon_cache_invalidate() so the new value is read back
+ * immediately.
+ *
+ * If 'changed' is set before accton_hwmon_cache_init() it is called,
+ * also with 'lock' held, after a refresh which changed the block has
+ * been published. Drivers use it to sysfs_notify() pollable attributes.
+ */
+
+typedef int (*accton_hwmon_cache_refresh_t)(void *priv, void *block);
+typedef void (*accton_hwmon_cache_changed_t)(void *priv, const void *block);
+
+struct accton_hwmon_cache {
+    struct device                *dev;
+    accton_hwmon_cache_refresh_t  refresh;
+    accton_hwmon_cache_changed_t  changed;      /* Optional */
+    void                         *priv;
+    size_t                        size;
+    unsigned int                  interval;     /* In ms */
+
+    struct mutex                  lock;         /* Serializes hardware access */
+    struct delayed_work           work;
+    void                         *scratch;      /* Refresh buffer, under lock */
+
+    seqlock_t                     seqlock;      /* Protects the fields below */
+    void                         *block;
+    int                           status;       /* 0 or the last refresh error */
+    unsigned long                 last_updated; /* In jiffies */
+};
+
+#define ACCTON_HWMON_CACHE_INTERVAL_MIN  100     /* ms */
+#define ACCTON_HWMON_CACHE_INTERVAL_MAX  60000   /* ms */
+
+/*
+ * Initialize the cache, perform the first refresh synchronously
+ * and start the background refresh.
+ */
+extern int accton_hwmon_cache_init(struct accton_hwmon_cache *cache,
+                                   struct device *dev, size_t size,
+                                   unsigned int interval,
+                                   accton_hwmon_cache_refresh_t refresh,
+                                   void *priv);
+
+/* Stop the background refresh and release the cache. */
+extern void accton_hwmon_cache_destroy(struct accton_hwmon_cache *cache);
+
+/*
+ * Copy the most recent register block into 'block'.
+ * Returns 0 or the error from the last refresh.
+ */
+extern int accton_hwmon_cache_read(struct accton_hwmon_cache *cache, void *block);
+
+/* Schedule an immediate refresh. */
+extern void accton_hwmon_cache_invalidate(struct accton_hwmon_cache *cache);
+
+/* update_interval (ms, read/write) and update_age (ms) attributes. */
+extern ssize_t accton_hwmon_cache_show_interval(struct accton_hwmon_cache *cache, char *buf);
+extern ssize_t accton_hwmon_cache_store_interval(struct accton_hwmon_cache *cache,
+                                                 const char *buf, size_t count);
+extern ssize_t accton_hwmon_cache_show_age(struct accton_hwmon_cache *cache, char *buf);
+
+#endif /* __ACCTON_HWMON_CACHE_H__ */
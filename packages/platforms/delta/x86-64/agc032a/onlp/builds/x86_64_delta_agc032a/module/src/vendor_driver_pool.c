@@ -28,6 +28,10 @@
 #include <math.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <linux/ipmi.h>
 #include <AIM/aim.h>
 #include "vendor_driver_pool.h"
 #include "vendor_i2c_device_list.h"
@@ -877,12 +881,372 @@ static i2c_bus_driver_t ipmb_functions = {
     ipmb_writeb,
     ipmb_block_read};
 
+/*
+    IPMB over the kernel IPMI device:
+        Issues the same BMC raw commands as the ipmitool IPMB driver
+        (NetFn 0x3c, 0x01 read / 0x02 write) through /dev/ipmi0 instead
+        of spawning ipmitool for every access. Block reads are split into
+        BMC sized range reads which are kept in flight together.
+*/
+#define IPMB_DEV_PATH "/dev/ipmi0"
+#define IPMB_DEV_NETFN 0x3c
+#define IPMB_DEV_CMD_READ 0x01
+#define IPMB_DEV_CMD_WRITE 0x02
+#define IPMB_DEV_READ_MAX 32      /* bytes per BMC range read */
+#define IPMB_DEV_INFLIGHT_MAX 8   /* outstanding requests */
+#define IPMB_DEV_TIMEOUT_MS 2000
+
+typedef struct ipmb_dev_req_s
+{
+    uint8_t cmd;
+    uint8_t data[8];
+    uint16_t dlen;
+    uint8_t *rsp;      /* response data, completion code removed */
+    uint16_t rsp_len;
+    long msgid;
+    int status;        /* 1 -> in flight; 0 -> done; < 0 -> failed */
+} ipmb_dev_req_t;
+
+static int ipmb_dev_fd = -1;
+static pid_t ipmb_dev_pid = 0;     /* process that opened ipmb_dev_fd */
+static long ipmb_dev_msgid = 0;
+static pthread_mutex_t ipmb_dev_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void ipmb_dev_req_init(ipmb_dev_req_t *req, uint8_t cmd, int bus, uint8_t dev, uint16_t addr, uint8_t len)
+{
+    memset(req, 0, sizeof(*req));
+    req->cmd = cmd;
+    req->data[0] = bus;
+    req->data[1] = dev;
+    req->data[2] = addr;
+    req->data[3] = len;
+    req->dlen = 4;
+}
+
+static int ipmb_dev_send(ipmb_dev_req_t *req)
+{
+    struct ipmi_system_interface_addr bmc_addr;
+    struct ipmi_req ipmi_req;
+
+    memset(&bmc_addr, 0, sizeof(bmc_addr));
+    bmc_addr.addr_type = IPMI_SYSTEM_INTERFACE_ADDR_TYPE;
+    bmc_addr.channel = IPMI_BMC_CHANNEL;
+
+    memset(&ipmi_req, 0, sizeof(ipmi_req));
+    ipmi_req.addr = (unsigned char *)&bmc_addr;
+    ipmi_req.addr_len = sizeof(bmc_addr);
+    ipmi_req.msgid = req->msgid = ++ipmb_dev_msgid;
+    ipmi_req.msg.netfn = IPMB_DEV_NETFN;
+    ipmi_req.msg.cmd = req->cmd;
+    ipmi_req.msg.data = req->data;
+    ipmi_req.msg.data_len = req->dlen;
+
+    if (ioctl(ipmb_dev_fd, IPMICTL_SEND_COMMAND, &ipmi_req) < 0)
+    {
+        AIM_LOG_ERROR("[IPMB-DEV] Send command 0x%02x failed: %s", req->cmd, strerror(errno));
+        req->status = ONLP_STATUS_E_INTERNAL;
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    req->status = 1;
+    return 0;
+}
+
+/*
+    Wait for one response and hand it to the matching request.
+    Returns the request index, -1 for a response nobody is waiting
+    for (e.g. the answer to a request which already timed out) or
+    an ONLP error.
+*/
+static int ipmb_dev_recv(ipmb_dev_req_t *reqs, int count)
+{
+    struct ipmi_addr addr;
+    struct ipmi_recv recv;
+    uint8_t buf[IPMI_MAX_MSG_LENGTH];
+    struct pollfd pfd;
+    int i, rv;
+
+    pfd.fd = ipmb_dev_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    rv = poll(&pfd, 1, IPMB_DEV_TIMEOUT_MS);
+    if (rv == 0)
+    {
+        AIM_LOG_ERROR("[IPMB-DEV] Timeout waiting for the BMC");
+        return ONLP_STATUS_E_INTERNAL;
+    }
+    if (rv < 0)
+    {
+        return (errno == EINTR) ? -1 : ONLP_STATUS_E_INTERNAL;
+    }
+
+    memset(&recv, 0, sizeof(recv));
+    recv.addr = (unsigned char *)&addr;
+    recv.addr_len = sizeof(addr);
+    recv.msg.data = buf;
+    recv.msg.data_len = sizeof(buf);
+
+    if (ioctl(ipmb_dev_fd, IPMICTL_RECEIVE_MSG_TRUNC, &recv) < 0)
+    {
+        return (errno == EAGAIN || errno == EINTR) ? -1 : ONLP_STATUS_E_INTERNAL;
+    }
+
+    if (recv.recv_type != IPMI_RESPONSE_RECV_TYPE)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        ipmb_dev_req_t *req = &reqs[i];
+
+        if (req->status != 1 || req->msgid != recv.msgid)
+        {
+            continue;
+        }
+
+        if (recv.msg.data_len < 1 || buf[0] != 0)
+        {
+            AIM_LOG_ERROR("[IPMB-DEV] bus: %d, dev: 0x%02x, addr: 0x%02x: completion code 0x%02x",
+                          req->data[0], req->data[1], req->data[2], recv.msg.data_len ? buf[0] : 0xff);
+            req->status = ONLP_STATUS_E_INTERNAL;
+        }
+        else if (recv.msg.data_len - 1 < req->rsp_len)
+        {
+            AIM_LOG_ERROR("[IPMB-DEV] bus: %d, dev: 0x%02x, addr: 0x%02x: short response (%d bytes)",
+                          req->data[0], req->data[1], req->data[2], recv.msg.data_len - 1);
+            req->status = ONLP_STATUS_E_INTERNAL;
+        }
+        else
+        {
+            if (req->rsp_len)
+            {
+                memcpy(req->rsp, buf + 1, req->rsp_len);
+            }
+            req->status = 0;
+        }
+        return i;
+    }
+
+    return -1;
+}
+
+/* Run a set of requests, keeping up to IPMB_DEV_INFLIGHT_MAX outstanding. */
+static int ipmb_dev_run(ipmb_dev_req_t *reqs, int count)
+{
+    int sent = 0, pending = 0, done = 0, idx, rv = 0;
+
+    pthread_mutex_lock(&ipmb_dev_lock);
+
+    /*
+     * A descriptor inherited across fork() shares the IPMI user with the
+     * parent, so responses could be delivered to either process.
+     */
+    if (ipmb_dev_fd >= 0 && ipmb_dev_pid != getpid())
+    {
+        close(ipmb_dev_fd);
+        ipmb_dev_fd = -1;
+    }
+
+    if (ipmb_dev_fd < 0 && (ipmb_dev_fd = open(IPMB_DEV_PATH, O_RDWR | O_CLOEXEC)) >= 0)
+    {
+        ipmb_dev_pid = getpid();
+    }
+
+    if (ipmb_dev_fd < 0)
+    {
+        AIM_LOG_ERROR("[IPMB-DEV] Can not open %s: %s", IPMB_DEV_PATH, strerror(errno));
+        pthread_mutex_unlock(&ipmb_dev_lock);
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    while (done < count)
+    {
+        while (sent < count && pending < IPMB_DEV_INFLIGHT_MAX)
+        {
+            if ((rv = ipmb_dev_send(&reqs[sent])) < 0)
+            {
+                goto out;
+            }
+            sent++;
+            pending++;
+        }
+
+        idx = ipmb_dev_recv(reqs, sent);
+        if (idx < -1)
+        {
+            rv = idx;
+            goto out;
+        }
+        if (idx >= 0)
+        {
+            if (reqs[idx].status < 0)
+            {
+                rv = reqs[idx].status;
+                goto out;
+            }
+            pending--;
+            done++;
+        }
+    }
+
+out:
+    pthread_mutex_unlock(&ipmb_dev_lock);
+    return rv;
+}
+
+static int ipmb_dev_readb(int bus, uint8_t dev, uint16_t addr, uint8_t alen, uint16_t *data, uint8_t dlen)
+{
+    ipmb_dev_req_t req;
+    uint8_t rv_data[2] = {0};
+    int rv;
+
+    if (dlen < 1 || dlen > 2)
+    {
+        AIM_LOG_ERROR("[INTERNAL-IPMB][GET] Dlan limitation is 1 to 2");
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    ipmb_dev_req_init(&req, IPMB_DEV_CMD_READ, bus, dev, addr, dlen);
+    req.rsp = rv_data;
+    req.rsp_len = dlen;
+
+    rv = ipmb_dev_run(&req, 1);
+    if (rv < 0)
+    {
+        return rv;
+    }
+
+    *data = rv_data[0] + ((dlen == 2) ? (rv_data[1] << 8) : 0);
+
+    return 0;
+}
+
+static int ipmb_dev_writeb(int bus, uint8_t dev, uint16_t addr, uint8_t alen, uint16_t data, uint8_t dlen)
+{
+    ipmb_dev_req_t req;
+
+    if (dlen < 1 || dlen > 2)
+    {
+        AIM_LOG_ERROR("[INTERNAL-IPMB][SET] Dlan limitation is 1 to 2");
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    ipmb_dev_req_init(&req, IPMB_DEV_CMD_WRITE, bus, dev, addr, dlen);
+    req.data[req.dlen++] = data & 0xff;
+    if (dlen == 2)
+    {
+        req.data[req.dlen++] = (data >> 8) & 0xff;
+    }
+
+    return ipmb_dev_run(&req, 1);
+}
+
+static int ipmb_dev_block_read(int bus, uint8_t dev, uint16_t addr, uint8_t *rdata, uint16_t size)
+{
+    ipmb_dev_req_t req;
+    uint8_t raw[65];
+    int rv;
+
+    if (size > 64)
+    {
+        AIM_LOG_ERROR("The limitation of size is 64.");
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    /*
+        The BMC returns the raw register bytes for every read, as for
+        ipmb_dev_readb() and ipmb_dev_i2c_block_read(). An SMBus block
+        read starts with the byte count, which is dropped here as the
+        ipmitool driver does.
+    */
+    ipmb_dev_req_init(&req, IPMB_DEV_CMD_READ, bus, dev, addr, size + 1);
+    req.rsp = raw;
+    req.rsp_len = size + 1;
+
+    rv = ipmb_dev_run(&req, 1);
+    if (rv < 0)
+    {
+        return rv;
+    }
+
+    memcpy(rdata, raw + 1, size);
+    return 0;
+}
+
+static int ipmb_dev_i2c_block_read(int bus, uint8_t dev, uint16_t daddr, uint8_t *ReplyBuf, uint16_t BufSize)
+{
+    int count = (BufSize + IPMB_DEV_READ_MAX - 1) / IPMB_DEV_READ_MAX;
+    ipmb_dev_req_t *reqs;
+    int idx, rv;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    reqs = (ipmb_dev_req_t *)calloc(count, sizeof(ipmb_dev_req_t));
+    if (!reqs)
+    {
+        return ONLP_STATUS_E_INTERNAL;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        uint16_t offset = idx * IPMB_DEV_READ_MAX;
+        uint16_t len = BufSize - offset;
+
+        if (len > IPMB_DEV_READ_MAX)
+        {
+            len = IPMB_DEV_READ_MAX;
+        }
+
+        ipmb_dev_req_init(&reqs[idx], IPMB_DEV_CMD_READ, bus, dev, daddr + offset, len);
+        reqs[idx].rsp = ReplyBuf + offset;
+        reqs[idx].rsp_len = len;
+    }
+
+    rv = ipmb_dev_run(reqs, count);
+    free(reqs);
+
+    return rv;
+}
+
+static i2c_bus_driver_t ipmb_dev_functions = {
+    ipmb_dev_readb,
+    ipmb_dev_writeb,
+    ipmb_dev_readb,
+    ipmb_dev_writeb,
+    ipmb_dev_block_read,
+    NULL,
+    ipmb_dev_i2c_block_read};
+
+/*
+    "IPMB" uses the in-process transport when the kernel IPMI device is
+    available and falls back to ipmitool otherwise. Both transports are
+    also registered under their own names so a device list can pick one.
+*/
 static int ipmb_driver_init()
 {
     vendor_driver_t *driver = (vendor_driver_t *)calloc(1, sizeof(vendor_driver_t));
+    vendor_driver_t *tool = (vendor_driver_t *)calloc(1, sizeof(vendor_driver_t));
+    vendor_driver_t *dev = (vendor_driver_t *)calloc(1, sizeof(vendor_driver_t));
 
     strncpy(driver->name, "IPMB", VENDOR_MAX_NAME_SIZE);
-    driver->dev_driver = &ipmb_functions;
+    if (access(IPMB_DEV_PATH, R_OK | W_OK) == 0)
+        driver->dev_driver = &ipmb_dev_functions;
+    else
+        driver->dev_driver = &ipmb_functions;
+
+    strncpy(tool->name, "IPMB_TOOL", VENDOR_MAX_NAME_SIZE);
+    tool->dev_driver = &ipmb_functions;
+
+    strncpy(dev->name, "IPMB_DEV", VENDOR_MAX_NAME_SIZE);
+    dev->dev_driver = &ipmb_dev_functions;
+
+    vendor_driver_add(tool);
+    vendor_driver_add(dev);
 
     return vendor_driver_add(driver);
 }
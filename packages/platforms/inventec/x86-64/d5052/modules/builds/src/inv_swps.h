@@ -12,6 +12,8 @@
 #define SWP_RESET_PWD         "inventec"
 #define SWP_POLLING_PERIOD    (300)  /* msec */
 #define SWP_POLLING_ENABLE    (1)
+#define SWP_IRQ_POLLING_PERIOD (5000) /* msec, safety net in interrupt mode */
+#define SWP_IRQ_MAX           (32)
 #define SWP_AUTOCONFIG_ENABLE (1)
 
 /* Module information */
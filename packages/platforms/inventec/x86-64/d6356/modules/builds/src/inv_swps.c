@@ -9,6 +9,8 @@
 #include <linux/workqueue.h>
 #include <linux/jiffies.h>
 #include <linux/dmi.h>
+#include <linux/gpio.h>
+#include <linux/interrupt.h>
 #include <linux/i2c.h>
 #include "inv_swps.h"
 
@@ -29,6 +31,32 @@ static void swp_polling_worker(struct work_struct *work);
 static DECLARE_DELAYED_WORK(swp_polling, swp_polling_worker);
 
 static int reset_i2c_topology(void);
+static void clean_irq_task(void);
+static void _unmask_swp_irqs(void);
+
+/* Interrupt mode
+ * irq_gpio[] is the GPIO of the interrupt line of each IOEXP, in
+ * ioexp_layout order (-1: none). IOEXPs which share a line share the
+ * interrupt. When any interrupt is set up the polling task only runs
+ * every SWP_IRQ_POLLING_PERIOD as a safety net.
+ */
+static int irq_gpio[SWP_IRQ_MAX] = { [0 ... SWP_IRQ_MAX-1] = -1 };
+static int irq_gpio_num;
+module_param_array(irq_gpio, int, &irq_gpio_num, S_IRUGO);
+MODULE_PARM_DESC(irq_gpio, "GPIO of the interrupt line of each IOEXP (-1: none)");
+
+struct swp_irq_s {
+    int irq;
+    int gpio_owner;
+    int masked;
+    struct ioexp_obj_s *ioexp_obj_p;
+};
+
+static int irq_mode;
+static int irq_closing;
+static struct swp_irq_s swp_irq[SWP_IRQ_MAX];
+static int *port_present = NULL;
+static DEFINE_MUTEX(swp_check_lock);
 
 static union {
     unsigned int eeprom_update_32[2];
@@ -149,11 +177,12 @@ static int
 _get_polling_period(void) {
 
     int retval = 0;
+    int period = irq_mode ? SWP_IRQ_POLLING_PERIOD : SWP_POLLING_PERIOD;
 
-    if (SWP_POLLING_PERIOD == 0) {
+    if (period == 0) {
         return 0;
     }
-    retval = ((SWP_POLLING_PERIOD * HZ) / 1000);
+    retval = ((period * HZ) / 1000);
     if (retval == 0) {
         return 1;
     }
@@ -1897,6 +1926,8 @@ clean_swps_common(void){
     dev_t dev_num;
     struct device *device_p;
 
+    /* Free the interrupts first: the handler uses the IOEXP objects */
+    clean_irq_task();
     device_p = get_swpdev_by_name(SWP_DEV_MODCTL);
     if (device_p){
         dev_num = MKDEV(ctl_major, 1);
@@ -1904,6 +1935,8 @@ clean_swps_common(void){
         device_destroy(swp_class_p, dev_num);
     }
     cancel_delayed_work_sync(&swp_polling);
+    kfree(port_present);
+    port_present = NULL;
     if (platform_p) {
         kfree(platform_p);
     }
@@ -2402,6 +2435,31 @@ check_transvr_obj_one(char *dev_name){
 }
 
 
+static void
+_notify_present_change(int minor, char *dev_name){
+    /* Wake up userspace waiting on the present attribute */
+    struct transvr_obj_s *tobj_p = NULL;
+    int present;
+
+    if (!port_present) {
+        return;
+    }
+    tobj_p = _get_transvr_obj(dev_name);
+    if ((!tobj_p) || (!tobj_p->transvr_dev_p)) {
+        return;
+    }
+    present = tobj_p->ioexp_obj_p->get_present(tobj_p->ioexp_obj_p,
+                                               tobj_p->ioexp_virt_offset);
+    if (present == port_present[minor]) {
+        return;
+    }
+    if (port_present[minor] >= 0) {
+        sysfs_notify(&tobj_p->transvr_dev_p->kobj, NULL, "present");
+    }
+    port_present[minor] = present;
+}
+
+
 static int
 check_transvr_objs(void){
 
@@ -2437,6 +2495,7 @@ check_transvr_objs(void){
                         __func__, dev_name, err_code);
                 break;
         }
+        _notify_present_change(minor_curr, dev_name);
     }
     return 0;
 
@@ -2450,6 +2509,7 @@ err_check_transvr_objs:
 static void
 swp_polling_worker(struct work_struct *work){
 
+    mutex_lock(&swp_check_lock);
     /* Reset I2C */
     if (flag_i2c_reset) {
         goto polling_reset_i2c;
@@ -2475,10 +2535,102 @@ polling_reset_i2c:
         flag_i2c_reset = 0;
     }
 polling_schedule_round:
+    if (!flag_i2c_reset) {
+        _unmask_swp_irqs();
+    }
+    mutex_unlock(&swp_check_lock);
     schedule_delayed_work(&swp_polling, _get_polling_period());
 }
 
 
+static int
+check_ioexp_ports(struct ioexp_obj_s *ioexp_obj_p){
+    /* Refresh one IOEXP and the transceivers behind it.
+     * [Return]
+     *    0 : Success
+     *   -1 : I2C topology needs reset
+     */
+    char dev_name[32];
+    int minor_curr;
+
+    if (ioexp_obj_p->check(ioexp_obj_p) < 0) {
+        return -1;
+    }
+    for (minor_curr=0; minor_curr<port_total; minor_curr++) {
+        if (port_layout[minor_curr].ioexp_id != ioexp_obj_p->ioexp_id) {
+            continue;
+        }
+        memset(dev_name, 0, sizeof(dev_name));
+        snprintf(dev_name, sizeof(dev_name), "%s%d",
+                 SWP_DEV_PORT, port_layout[minor_curr].port_id);
+        if (check_transvr_obj_one(dev_name) == -2) {
+            return -1;
+        }
+        _notify_present_change(minor_curr, dev_name);
+    }
+    return 0;
+}
+
+
+
+static void
+_mask_swp_irq(void *dev_id){
+    /* The interrupt line is level triggered and stays asserted until
+     * the IOEXP input port is read. When the handler cannot read it,
+     * mask the line until the polling task has run.
+     * Caller holds swp_check_lock.
+     */
+    int i;
+
+    for (i=0; i<SWP_IRQ_MAX; i++) {
+        if ((swp_irq[i].irq > 0) && (swp_irq[i].ioexp_obj_p == dev_id) &&
+            (!swp_irq[i].masked)) {
+            disable_irq_nosync(swp_irq[i].irq);
+            swp_irq[i].masked = 1;
+        }
+    }
+}
+
+
+static void
+_unmask_swp_irqs(void){
+    /* Caller holds swp_check_lock. */
+    int i;
+
+    if (irq_closing) {
+        return;
+    }
+    for (i=0; i<SWP_IRQ_MAX; i++) {
+        if (swp_irq[i].masked) {
+            swp_irq[i].masked = 0;
+            enable_irq(swp_irq[i].irq);
+        }
+    }
+}
+
+static irqreturn_t
+swp_irq_handler(int irq, void *dev_id){
+
+    struct ioexp_obj_s *ioexp_obj_p = dev_id;
+
+    mutex_lock(&swp_check_lock);
+    if ((flag_i2c_reset) || (block_polling)) {
+        _mask_swp_irq(dev_id);
+        goto irq_handler_out;
+    }
+    if (check_ioexp_ports(ioexp_obj_p) < 0) {
+        SWPS_DEBUG("%s: IOEXP-%d check fail.\n",
+                   __func__, ioexp_obj_p->ioexp_id);
+        flag_i2c_reset = 1;
+        _mask_swp_irq(dev_id);
+        mod_delayed_work(system_wq, &swp_polling, 0);
+    }
+irq_handler_out:
+    mutex_unlock(&swp_check_lock);
+    return IRQ_HANDLED;
+}
+
+
 /* ========== Functions for register something ==========
  */
 static int
@@ -3219,9 +3371,117 @@ err_init_dev_topology:
 }
 
 
+static void
+clean_irq_task(void){
+
+    int i;
+
+    /* Mask every line and keep the polling task from unmasking them,
+     * so nothing fires while the interrupts are freed.
+     */
+    mutex_lock(&swp_check_lock);
+    irq_closing = 1;
+    for (i=0; i<SWP_IRQ_MAX; i++) {
+        if ((swp_irq[i].irq > 0) && (!swp_irq[i].masked)) {
+            disable_irq_nosync(swp_irq[i].irq);
+            swp_irq[i].masked = 1;
+        }
+    }
+    mutex_unlock(&swp_check_lock);
+    for (i=0; i<SWP_IRQ_MAX; i++) {
+        if (swp_irq[i].irq > 0) {
+            free_irq(swp_irq[i].irq, swp_irq[i].ioexp_obj_p);
+        }
+        if (swp_irq[i].gpio_owner) {
+            gpio_free(irq_gpio[i]);
+        }
+    }
+    memset(swp_irq, 0, sizeof(swp_irq));
+    irq_mode = 0;
+}
+
+
+static int
+init_irq_task(void){
+
+    int i, j, irq, err;
+    struct ioexp_obj_s *ioexp_obj_p = NULL;
+
+    irq_closing = 0;
+    if ((!SWP_POLLING_ENABLE) || (irq_gpio_num == 0)) {
+        return 0;
+    }
+    for (i=0; (i<irq_gpio_num) && (i<ioexp_total); i++) {
+        if (irq_gpio[i] < 0) {
+            continue;
+        }
+        ioexp_obj_p = get_ioexp_obj(ioexp_layout[i].ioexp_id);
+        if (!ioexp_obj_p) {
+            SWPS_ERR("%s: IOEXP-%d not exist\n",
+                     __func__, ioexp_layout[i].ioexp_id);
+            goto err_init_irq_task;
+        }
+        /* Request each GPIO once */
+        for (j=0; j<i; j++) {
+            if (irq_gpio[j] == irq_gpio[i]) {
+                break;
+            }
+        }
+        if (j == i) {
+            err = gpio_request_one(irq_gpio[i], GPIOF_IN, SWP_CLS_NAME);
+            if (err < 0) {
+                SWPS_ERR("%s: request GPIO %d fail <err>:%d\n",
+                         __func__, irq_gpio[i], err);
+                goto err_init_irq_task;
+            }
+            swp_irq[i].gpio_owner = 1;
+        }
+        irq = gpio_to_irq(irq_gpio[i]);
+        if (irq < 0) {
+            SWPS_ERR("%s: GPIO %d has no IRQ <err>:%d\n",
+                     __func__, irq_gpio[i], irq);
+            goto err_init_irq_task;
+        }
+        /* The IOEXP interrupt output is asserted until the input port
+         * is read, so trigger on the level; the threaded handler runs
+         * with the line masked (IRQF_ONESHOT).
+         */
+        swp_irq[i].ioexp_obj_p = ioexp_obj_p;
+        err = request_threaded_irq(irq, NULL, swp_irq_handler,
+                                   IRQF_TRIGGER_LOW | IRQF_ONESHOT | IRQF_SHARED,
+                                   SWP_CLS_NAME, ioexp_obj_p);
+        if (err < 0) {
+            SWPS_ERR("%s: request IRQ for GPIO %d fail <err>:%d\n",
+                     __func__, irq_gpio[i], err);
+            goto err_init_irq_task;
+        }
+        swp_irq[i].irq = irq;
+        irq_mode = 1;
+    }
+    if (irq_mode) {
+        SWPS_INFO("%s: interrupt mode, polling every %d ms\n",
+                  __func__, SWP_IRQ_POLLING_PERIOD);
+    }
+    return 0;
+
+err_init_irq_task:
+    clean_irq_task();
+    return -1;
+}
+
+
 static int
 init_polling_task(void){
 
+    int i;
+
+    port_present = kcalloc(port_total, sizeof(int), GFP_KERNEL);
+    if (!port_present) {
+        return -1;
+    }
+    for (i=0; i<port_total; i++) {
+        port_present[i] = -1;
+    }
     if (SWP_POLLING_ENABLE){
         schedule_delayed_work(&swp_polling, _get_polling_period());
     }
@@ -3250,6 +3510,9 @@ init_swps_common(void){
         err_msg = "init_polling_task fail";
         goto err_init_swps_common_1;
     }
+    if (init_irq_task() < 0){
+        SWPS_ERR("%s: init_irq_task fail, polling only\n", __func__);
+    }
     return 0;
 
 err_init_swps_common_1:
@@ -17,6 +17,9 @@
 #include <linux/unistd.h>
 #include <linux/uaccess.h>
 #include <linux/version.h>
+#include <linux/gpio.h>
+#include <linux/interrupt.h>
+#include <linux/mutex.h>
 #include "inv_def.h"
 //#include "sff_spec.h"
 #include "inv_swps.h"
@@ -28,6 +31,15 @@
 
 int io_no_init = 0;
 module_param(io_no_init, int, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+/*GPIO of the transceiver presence interrupt line, -1: polling only*/
+static int irq_gpio = -1;
+module_param(irq_gpio, int, S_IRUGO);
+MODULE_PARM_DESC(irq_gpio, "GPIO of the transceiver presence interrupt line (-1: none)");
+static int swps_irq = 0;
+/*the level triggered line is masked until the polling task has run*/
+static bool swps_irq_masked = false;
+/*serializes the polling task and the interrupt handler*/
+static DEFINE_MUTEX(swps_task_lock);
 u32 logLevel = SWPS_ERR_LEV | SWPS_INFO_LEV;
 //u32 logLevel = ERR_ALL_LEV | INFO_ALL_LEV | DBG_ALL_LEV;
 bool int_flag_monitor_en = false;
@@ -3299,6 +3311,10 @@ static int sff_prs_scan(struct sff_mgr_t *sff)
     //bitmap = ~bitmap;  /*reverse it to be human readable format*/
     prs_change = bitmap ^ prs_bitmap_get(sff);
     prs_bitmap_update(sff, bitmap); //update current prs_bitmap
+    if (prs_change && p_valid(sff->mgr_kobj)) {
+        /*wake up userspace waiting on the prs attribute*/
+        sysfs_notify(&(sff->mgr_kobj->kobj), NULL, "prs");
+    }
 
     for (port = 0; port < port_num; port++) {
         sff_obj = &(sff->obj[port]);
@@ -3314,9 +3330,90 @@ static int sff_prs_scan(struct sff_mgr_t *sff)
 }
 static void swps_polling_task(struct work_struct *work)
 {
+    mutex_lock(&swps_task_lock);
     lcMgr.lc_func->polling_task();
+    if (swps_irq_masked && swps_irq > 0) {
+        swps_irq_masked = false;
+        enable_irq(swps_irq);
+    }
+    mutex_unlock(&swps_task_lock);
     schedule_delayed_work(&swps_polling, SWPS_POLLING_PERIOD);
 }
+/*presence interrupt: only rescan the presence of the ready cards,
+ *the fsm work for the changed ports is left to the polling task.
+ *the line stays asserted until the presence is read, so if a card
+ *could not be scanned mask it until the next polling round*/
+static irqreturn_t swps_irq_handler(int irq, void *dev_id)
+{
+    int lc_id = 0;
+    bool unread = false;
+    struct lc_obj_t *card = NULL;
+
+    mutex_lock(&swps_task_lock);
+    for (lc_id = 0; lc_id < lcMgr.lc_num; lc_id++) {
+        card = &(lcMgr.obj[lc_id]);
+        if (LC_FSM_ST_READY != lc_fsm_st_get(card) ||
+            !p_valid(card->sff.prs_scan)) {
+            unread = true;
+            continue;
+        }
+        if (card->sff.prs_scan(&card->sff) < 0) {
+            SWPS_LOG_ERR("%s prs scan fail\n", card->name);
+            unread = true;
+        }
+    }
+    if (unread && !swps_irq_masked) {
+        disable_irq_nosync(irq);
+        swps_irq_masked = true;
+    }
+    mutex_unlock(&swps_task_lock);
+    return IRQ_HANDLED;
+}
+static int swps_irq_init(void)
+{
+    int ret = 0;
+
+    if (irq_gpio < 0) {
+        return 0;
+    }
+    if ((ret = gpio_request_one(irq_gpio, GPIOF_IN, "swps_irq")) < 0) {
+        SWPS_LOG_ERR("gpio %d request fail:%d\n", irq_gpio, ret);
+        return ret;
+    }
+    if ((ret = gpio_to_irq(irq_gpio)) < 0) {
+        SWPS_LOG_ERR("gpio %d has no irq:%d\n", irq_gpio, ret);
+        gpio_free(irq_gpio);
+        return ret;
+    }
+    swps_irq = ret;
+    /*the interrupt output is asserted until the status is read,
+     *trigger on the level and keep it masked while the handler runs*/
+    swps_irq_masked = false;
+    ret = request_threaded_irq(swps_irq, NULL, swps_irq_handler,
+                               IRQF_TRIGGER_LOW | IRQF_ONESHOT,
+                               "swps", &lcMgr);
+    if (ret < 0) {
+        SWPS_LOG_ERR("irq %d request fail:%d\n", swps_irq, ret);
+        swps_irq = 0;
+        gpio_free(irq_gpio);
+        return ret;
+    }
+    SWPS_LOG_INFO("presence interrupt on gpio %d irq %d\n", irq_gpio, swps_irq);
+    return 0;
+}
+static void swps_irq_deinit(void)
+{
+    int irq = swps_irq;
+
+    if (irq > 0) {
+        /*keep the polling task from unmasking the line being freed*/
+        mutex_lock(&swps_task_lock);
+        swps_irq = 0;
+        mutex_unlock(&swps_task_lock);
+        free_irq(irq, &lcMgr);
+        gpio_free(irq_gpio);
+    }
+}
 
 
 /*fsm functions*/
@@ -4483,6 +4580,9 @@ static int __init swps_init(void)
     if(swps_polling_is_enabled()) {
         swps_polling_task_start();
     }
+    if (swps_irq_init() < 0) {
+        SWPS_LOG_ERR("swps_irq_init fail, polling only\n");
+    }
     SWPS_LOG_INFO("swps:%s  init ok\n", pltfmInfo->name);
     return 0;
 
@@ -4495,6 +4595,7 @@ static void __exit swps_exit(void)
     struct mux_ch_t *mux = NULL;
     int lc_id = 0;
     
+    swps_irq_deinit();
     if(swps_polling_is_enabled()) {
         swps_polling_task_stop();
     }
@@ -23,6 +23,7 @@
  *
  ***********************************************************/
 #include <onlp/platformi/sfpi.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,12 +32,18 @@
 #include <onlplib/i2c.h>
 #include <onlplib/sfp.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
 #include "mlnx_common_log.h"
 #include "mlnx_common_int.h"
 
 #define MAX_SFP_PATH           64
 #define SFP_SYSFS_VALUE_LEN    20
+#define SFP_ETHTOOL_READ_MAX   256
 static char sfp_node_path[MAX_SFP_PATH] = {0};
+static int sfp_ethtool_sock = -1;
 
 int get_sfp_port_num(void);
 
@@ -89,25 +96,136 @@ mc_sfp_get_port_path(int port, char *node_name)
     return sfp_node_path;
 }
 
-static char*
-mc_sfp_convert_i2c_path(int port, int devaddr)
+/*
+ * Module EEPROM access through the ethtool ioctls on the port netdev.
+ * The socket is only used as an ioctl handle and is kept open.
+ */
+static int
+mc_sfp_ethtool(int port, void* cmd)
 {
-    sprintf(sfp_node_path, "%s/sfp%d", SFP_PATH, port);
-    return sfp_node_path;
+    struct ifreq ifr;
+
+    if (sfp_ethtool_sock < 0) {
+        sfp_ethtool_sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (sfp_ethtool_sock < 0) {
+            AIM_LOG_ERROR("Unable to open ethtool socket: %{errno}", errno);
+            return ONLP_STATUS_E_INTERNAL;
+        }
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "sfp%d", port);
+    ifr.ifr_data = cmd;
+
+    if (ioctl(sfp_ethtool_sock, SIOCETHTOOL, &ifr) < 0) {
+        return (errno == ENODEV || errno == EIO) ?
+            ONLP_STATUS_E_MISSING : ONLP_STATUS_E_INTERNAL;
+    }
+
+    return ONLP_STATUS_OK;
 }
 
 static int
-mc_sfp_prepare_eeprom_dump(int port, const char* path)
+mc_sfp_module_info_get(int port, struct ethtool_modinfo* modinfo)
 {
-    char* cmd = aim_fstrdup("ethtool -m sfp%d raw on length 256 > %s", port, path);
+    memset(modinfo, 0, sizeof(*modinfo));
+    modinfo->cmd = ETHTOOL_GMODULEINFO;
+    return mc_sfp_ethtool(port, modinfo);
+}
 
-    if(system(cmd) != 0) {
-        aim_free(cmd);
-        return ONLP_STATUS_E_INTERNAL;
+/*
+ * Read from the linear module EEPROM layout reported by ethtool.
+ * SFF-8472 modules expose A0h at 0-255 and A2h at 256-511. SFF-8436
+ * and SFF-8636 modules expose the lower page and page 0 at 0-255
+ * followed by the upper halves of pages 1, 2 and 3.
+ */
+static int
+mc_sfp_module_eeprom_read(int port, int offset, int len, uint8_t* data)
+{
+    uint8_t raw[sizeof(struct ethtool_eeprom) + SFP_ETHTOOL_READ_MAX] __attribute__((aligned(8)));
+    struct ethtool_eeprom* eeprom = (struct ethtool_eeprom*)raw;
+    int rv;
+
+    if (len <= 0 || len > SFP_ETHTOOL_READ_MAX) {
+        return ONLP_STATUS_E_PARAM;
+    }
+
+    memset(eeprom, 0, sizeof(*eeprom));
+    eeprom->cmd = ETHTOOL_GMODULEEEPROM;
+    eeprom->offset = offset;
+    eeprom->len = len;
+
+    if ((rv = mc_sfp_ethtool(port, eeprom)) < 0) {
+        return rv;
     }
-    aim_free(cmd);
 
-	return ONLP_STATUS_OK;
+    memcpy(data, eeprom->data, len);
+    return ONLP_STATUS_OK;
+}
+
+/*
+ * Translate a device address, page and offset into the linear
+ * ethtool layout.
+ */
+static int
+mc_sfp_linear_offset(struct ethtool_modinfo* modinfo, uint8_t devaddr,
+                     int page, int offset)
+{
+    switch (modinfo->type) {
+        case ETH_MODULE_SFF_8472:
+            if (page > 0 && offset >= 128) {
+                return ONLP_STATUS_E_UNSUPPORTED;
+            }
+            return (devaddr == 0x51) ? 256 + offset : offset;
+
+        case ETH_MODULE_SFF_8079:
+        case ETH_MODULE_SFF_8436:
+        case ETH_MODULE_SFF_8636:
+            if (devaddr != 0x50) {
+                return ONLP_STATUS_E_UNSUPPORTED;
+            }
+            if (page > 0 && offset >= 128) {
+                return 256 + (page - 1) * 128 + (offset - 128);
+            }
+            return offset;
+
+        default:
+            return ONLP_STATUS_E_UNSUPPORTED;
+    }
+}
+
+static int
+mc_sfp_mem_read(int port, uint8_t devaddr, int page, int offset, int len,
+                uint8_t* data)
+{
+    struct ethtool_modinfo modinfo;
+    int rv, linear, count;
+
+    if ((rv = mc_sfp_module_info_get(port, &modinfo)) < 0) {
+        return rv;
+    }
+
+    while (len > 0) {
+        /* Reads through the page boundary at 128 are split. */
+        count = (offset < 128 && offset + len > 128) ? 128 - offset : len;
+
+        linear = mc_sfp_linear_offset(&modinfo, devaddr, page, offset);
+        if (linear < 0) {
+            return linear;
+        }
+        if (linear + count > modinfo.eeprom_len) {
+            return ONLP_STATUS_E_UNSUPPORTED;
+        }
+        if ((rv = mc_sfp_module_eeprom_read(port, linear, count, data)) < 0) {
+            return rv;
+        }
+
+        offset += count;
+        data += count;
+        len -= count;
+    }
+
+    return ONLP_STATUS_OK;
 }
 
 /************************************************************
@@ -174,12 +292,8 @@ onlp_sfpi_presence_bitmap_get(onlp_sfp_bitmap_t* dst)
 int
 onlp_sfpi_eeprom_read(int port, uint8_t data[256])
 {
-    char* path = mc_sfp_get_port_path(port, NULL);
+    int rv;
 
-	if (mc_sfp_prepare_eeprom_dump(port, path) != ONLP_STATUS_OK) {
-            AIM_LOG_ERROR("Unable to prepare sfp%d eeprom dump\r\n", port);
-            return ONLP_STATUS_E_INTERNAL;
-	}
     /*
      * Read the SFP eeprom into data[]
      *
@@ -188,36 +302,45 @@ onlp_sfpi_eeprom_read(int port, uint8_t data[256])
      */
     memset(data, 0, 256);
 
-    if (onlplib_sfp_eeprom_read_file(path, data) != 0) {
+    if ((rv = mc_sfp_mem_read(port, 0x50, -1, 0, 256, data)) < 0) {
         AIM_LOG_ERROR("Unable to read eeprom from port(%d)\r\n", port);
-        return ONLP_STATUS_E_INTERNAL;
+        return rv;
     }
 
     return ONLP_STATUS_OK;
 }
 
 int
-onlp_sfpi_dev_readb(int port, uint8_t devaddr, uint8_t addr)
+onlp_sfpi_dom_read(int port, uint8_t data[256])
 {
-    char* path = mc_sfp_convert_i2c_path(port, devaddr);
-    uint8_t data;
-    int fd;
-    int nrd;
+    memset(data, 0, 256);
+    return mc_sfp_mem_read(port, 0x51, -1, 0, 256, data);
+}
 
-    if (!path)
-		return ONLP_STATUS_E_MISSING;
+int
+onlp_sfpi_mem_read(int port, uint8_t devaddr, int page, int offset,
+                   int len, uint8_t* buf)
+{
+    return mc_sfp_mem_read(port, devaddr, page, offset, len, buf);
+}
 
-    fd = open(path, O_RDONLY);
-    if (fd < 0)
-		return ONLP_STATUS_E_MISSING;
+int
+onlp_sfpi_dev_read(int port, uint8_t devaddr, uint8_t addr, uint8_t* rdata, int size)
+{
+    if (addr + size > 256) {
+        return ONLP_STATUS_E_PARAM;
+    }
+    return mc_sfp_mem_read(port, devaddr, -1, addr, size, rdata);
+}
 
-    lseek(fd, addr, SEEK_SET);
-    nrd = read(fd, &data, 1);
-    close(fd);
+int
+onlp_sfpi_dev_readb(int port, uint8_t devaddr, uint8_t addr)
+{
+    uint8_t data;
+    int rv;
 
-    if (nrd != 1) {
-		AIM_LOG_INTERNAL("Failed to read EEPROM file '%s'", path);
-		return ONLP_STATUS_E_INTERNAL;
+    if ((rv = mc_sfp_mem_read(port, devaddr, -1, addr, 1, &data)) < 0) {
+        return rv;
     }
     return data;
 }
@@ -225,27 +348,14 @@ onlp_sfpi_dev_readb(int port, uint8_t devaddr, uint8_t addr)
 int
 onlp_sfpi_dev_readw(int port, uint8_t devaddr, uint8_t addr)
 {
-    char* path = mc_sfp_convert_i2c_path(port, devaddr);
     uint16_t data;
-    int fd;
-    int nrd;
+    int rv;
 
-    if (!path){
-		return ONLP_STATUS_E_MISSING;
+    if (addr > 254) {
+        return ONLP_STATUS_E_PARAM;
     }
-
-    fd = open(path, O_RDONLY);
-    if (fd < 0) {
-		return ONLP_STATUS_E_MISSING;
-    }
-
-    lseek(fd, addr, SEEK_SET);
-    nrd = read(fd, &data, 2);
-    close(fd);
-
-    if (nrd != 2) {
-		AIM_LOG_INTERNAL("Failed to read EEPROM file '%s'", path);
-		return ONLP_STATUS_E_INTERNAL;
+    if ((rv = mc_sfp_mem_read(port, devaddr, -1, addr, 2, (uint8_t*)&data)) < 0) {
+        return rv;
     }
     return data;
 }
@@ -253,5 +363,9 @@ onlp_sfpi_dev_readw(int port, uint8_t devaddr, uint8_t addr)
 int
 onlp_sfpi_denit(void)
 {
+    if (sfp_ethtool_sock >= 0) {
+        close(sfp_ethtool_sock);
+        sfp_ethtool_sock = -1;
+    }
     return ONLP_STATUS_OK;
 }